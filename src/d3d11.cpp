@@ -1,8 +1,6 @@
 // c++ includes
-#include <iostream>
 #include <vector>
 #include <string>
-#include <fstream>
 #include <unordered_map>
 #include <unordered_set>
 #include <future>
@@ -29,6 +27,7 @@
 #include "ProxyDevice.h"
 #include "ProxyDeviceContext.h"
 #include "ProxyFactory.h"
+#include "ProxyLog.h"
 
 // directx 11 libraries
 #pragma comment(lib, "d3d11.lib")
@@ -62,9 +61,7 @@ HookInfo g_CreateDXGIFactory2Hook = {0};
 
 bool installHooks(HookInfo *specificHook = nullptr)
 {
-#if DEBUG
-    std::cout << "Installing hooks..." << std::endl;
-#endif
+    LOG_INFO(Hooks, "Installing hooks...");
 
     // get the addresses of the original functions
     g_D3D11CreateDeviceHook.originalFunc = (void *)GetProcAddress(GetModuleHandleA("d3d11.dll"), "D3D11CreateDevice");
@@ -78,12 +75,10 @@ bool installHooks(HookInfo *specificHook = nullptr)
     g_CreateDXGIFactoryHook.hookFunc = (void *)CreateDXGIFactory;
     g_CreateDXGIFactory1Hook.hookFunc = (void *)CreateDXGIFactory1;
     g_CreateDXGIFactory2Hook.hookFunc = (void *)CreateDXGIFactory2; // print our original function addresses
-#if DEBUG
-    std::cout << "Original D3D11CreateDevice address: " << g_D3D11CreateDeviceHook.originalFunc << std::endl;
-    std::cout << "Original CreateDXGIFactory address: " << g_CreateDXGIFactoryHook.originalFunc << std::endl;
-    std::cout << "Original CreateDXGIFactory1 address: " << g_CreateDXGIFactory1Hook.originalFunc << std::endl;
-    std::cout << "Original CreateDXGIFactory2 address: " << g_CreateDXGIFactory2Hook.originalFunc << std::endl;
-#endif
+    LOG_DEBUG(Hooks, "Original D3D11CreateDevice address: {}", g_D3D11CreateDeviceHook.originalFunc);
+    LOG_DEBUG(Hooks, "Original CreateDXGIFactory address: {}", g_CreateDXGIFactoryHook.originalFunc);
+    LOG_DEBUG(Hooks, "Original CreateDXGIFactory1 address: {}", g_CreateDXGIFactory1Hook.originalFunc);
+    LOG_DEBUG(Hooks, "Original CreateDXGIFactory2 address: {}", g_CreateDXGIFactory2Hook.originalFunc);
 
     // check if we got valid addresses
     if (!g_D3D11CreateDeviceHook.originalFunc ||
@@ -92,30 +87,24 @@ bool installHooks(HookInfo *specificHook = nullptr)
         !g_CreateDXGIFactory2Hook.originalFunc)
     {
         // if any of the original function addresses are null, we failed to get them
-#if DEBUG
-        std::cerr << "Failed to get original function addresses!" << std::endl;
-#endif
+        LOG_ERROR(Hooks, "Failed to get original function addresses!");
         return false;
     }
 
-#if DEBUG
-    std::cout << "Original function addresses retrieved successfully." << std::endl;
+    LOG_DEBUG(Hooks, "Original function addresses retrieved successfully.");
 
     // print the addresss of our own functions
-    std::cout << "Our D3D11CreateDevice address: " << (void *)D3D11CreateDevice << std::endl;
-    std::cout << "Our CreateDXGIFactory address: " << (void *)CreateDXGIFactory << std::endl;
-    std::cout << "Our CreateDXGIFactory1 address: " << (void *)CreateDXGIFactory1 << std::endl;
-    std::cout << "Our CreateDXGIFactory2 address: " << (void *)CreateDXGIFactory2 << std::endl;
-#endif
+    LOG_DEBUG(Hooks, "Our D3D11CreateDevice address: {}", (void *)D3D11CreateDevice);
+    LOG_DEBUG(Hooks, "Our CreateDXGIFactory address: {}", (void *)CreateDXGIFactory);
+    LOG_DEBUG(Hooks, "Our CreateDXGIFactory1 address: {}", (void *)CreateDXGIFactory1);
+    LOG_DEBUG(Hooks, "Our CreateDXGIFactory2 address: {}", (void *)CreateDXGIFactory2);
 
     // create shellcode to patch the original functions to our own
     auto installHook = [](HookInfo &hook) -> bool
     {
         if (!hook.originalFunc || !hook.hookFunc)
         {
-#if DEBUG
-            std::cerr << "Invalid hook configuration" << std::endl;
-#endif
+            LOG_ERROR(Hooks, "Invalid hook configuration");
             return false;
         }
 
@@ -134,9 +123,7 @@ bool installHooks(HookInfo *specificHook = nullptr)
         // make the memory writable
         if (!VirtualProtect(hook.originalFunc, sizeof(shellcode), PAGE_EXECUTE_READWRITE, &oldProtect))
         {
-#if DEBUG
-            std::cerr << "Failed to change memory protection for hook at " << hook.originalFunc << std::endl;
-#endif
+            LOG_ERROR(Hooks, "Failed to change memory protection for hook at {}", hook.originalFunc);
             return false;
         }
 
@@ -154,9 +141,7 @@ bool installHooks(HookInfo *specificHook = nullptr)
         hook.isPatched = true; // flush instruction cache to ensure CPU picks up the changes
         FlushInstructionCache(GetCurrentProcess(), hook.originalFunc, sizeof(shellcode));
 
-#if DEBUG
-        std::cout << "Successfully installed hook at " << hook.originalFunc << " -> " << hook.hookFunc << std::endl;
-#endif
+        LOG_DEBUG(Hooks, "Successfully installed hook at {} -> {}", hook.originalFunc, hook.hookFunc);
         return true;
     };
 
@@ -165,16 +150,12 @@ bool installHooks(HookInfo *specificHook = nullptr)
     if (specificHook)
     {
         // install only the specified hook
-#if DEBUG
-        std::cout << "Installing specific hook only..." << std::endl;
-#endif
+        LOG_DEBUG(Hooks, "Installing specific hook only...");
         success = installHook(*specificHook);
 
         if (!success)
         {
-#if DEBUG
-            std::cerr << "Failed to install specific hook!" << std::endl;
-#endif
+            LOG_ERROR(Hooks, "Failed to install specific hook!");
             return false;
         }
     }
@@ -188,16 +169,12 @@ bool installHooks(HookInfo *specificHook = nullptr)
 
         if (!success)
         {
-#if DEBUG
-            std::cerr << "Some hooks failed to install!" << std::endl;
-#endif
+            LOG_ERROR(Hooks, "Some hooks failed to install!");
             return false;
         }
     }
 
-#if DEBUG
-    std::cout << "Hooks successfully installed!" << std::endl;
-#endif
+    LOG_INFO(Hooks, "Hooks successfully installed!");
     return true;
 }
 
@@ -206,23 +183,18 @@ bool removeHook(HookInfo *hookToRemove)
     // validate hook parameter
     if (!hookToRemove)
     {
-#if DEBUG
-        std::cerr << "No hook provided for removal!" << std::endl;
-#endif return false;
+        LOG_ERROR(Hooks, "No hook provided for removal!");
+        return false;
     }
 
     // check if the hook is actually patched
     if (!hookToRemove->isPatched)
     {
-#if DEBUG
-        std::cout << "Hook at " << hookToRemove->originalFunc << " is not currently patched, nothing to remove." << std::endl;
-#endif
+        LOG_DEBUG(Hooks, "Hook at {} is not currently patched, nothing to remove.", hookToRemove->originalFunc);
         return true; // not an error, just nothing to do
     }
 
-#if DEBUG
-    std::cout << "Removing hook at address: " << hookToRemove->originalFunc << std::endl;
-#endif
+    LOG_DEBUG(Hooks, "Removing hook at address: {}", hookToRemove->originalFunc);
 
     // save original protection
     DWORD oldProtect;
@@ -230,9 +202,7 @@ bool removeHook(HookInfo *hookToRemove)
     // make the memory writable
     if (!VirtualProtect(hookToRemove->originalFunc, hookToRemove->patchSize, PAGE_EXECUTE_READWRITE, &oldProtect))
     {
-#if DEBUG
-        std::cerr << "Failed to change memory protection for hook removal at " << hookToRemove->originalFunc << std::endl;
-#endif
+        LOG_ERROR(Hooks, "Failed to change memory protection for hook removal at {}", hookToRemove->originalFunc);
         return false;
     }
 
@@ -246,9 +216,7 @@ bool removeHook(HookInfo *hookToRemove)
     hookToRemove->isPatched = false; // flush instruction cache to ensure CPU picks up the changes
     FlushInstructionCache(GetCurrentProcess(), hookToRemove->originalFunc, hookToRemove->patchSize);
 
-#if DEBUG
-    std::cout << "Successfully removed hook at " << hookToRemove->originalFunc << std::endl;
-#endif
+    LOG_DEBUG(Hooks, "Successfully removed hook at {}", hookToRemove->originalFunc);
     return true;
 }
 
@@ -256,34 +224,35 @@ bool removeHook(HookInfo *hookToRemove)
 // code end
 /////////////////////////////////////////////////////////////////////////////////////////
 
-// debug info text file
-#define ENABLE_TIMESTAMP 0 // timestamp disabled by default
-
 #if DEBUG
-// helper function
+// debug info text file (the log's file in DEBUG builds, see ProxyLog.h)
 const char *dbgInfo = "C:\\Users\\hecker\\Desktop\\dxpipe_layer\\src\\dbgInfo.txt";
-void output()
+#endif
+
+#if ENABLE_ALLOC_AUDIT
+// every allocation made by the layer goes through here, see AllocAudit.h
+void *operator new(size_t size)
 {
-    static std::ofstream installFile(dbgInfo, std::ios::app);
-    static std::streambuf *coutBuffer = std::cout.rdbuf();
-    std::cout.rdbuf(installFile.rdbuf());
+    allocAuditNote(size);
+    if (void *p = malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
 }
-#endif
 
-// helper timestamp builder
-static std::string timeStamp()
+void *operator new[](size_t size)
 {
-#if ENABLE_TIMESTAMP
-    auto now = std::chrono::system_clock::now();
-    auto now_time_t = std::chrono::system_clock::to_time_t(now);
-    std::ostringstream oss;
-    oss << "[" << std::put_time(std::localtime(&now_time_t), "%Y-%m-%d %H:%M:%S") << "] ";
-    return oss.str();
-#else
-    return "";
-#endif
+    allocAuditNote(size);
+    if (void *p = malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
 }
 
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+#endif
+
 // --------------------------- D3D11 HOOKS ----------------------------------
 
 // D3D11CreateDevice declaration
@@ -319,17 +288,10 @@ static HMODULE g_realD3D11 = nullptr;
 static D3D11CreateDevice_t g_real_D3D11CreateDevice = nullptr;
 static D3D11CreateDeviceAndSwapChain_t g_real_D3D11CreateDeviceAndSwapChain = nullptr;
 static ID3D11Device *g_Device = nullptr;
-ID3D11Texture2D *g_BackBufferTexture = nullptr; // our back buffer texture
 
-// staging copies
-ID3D11Texture2D *g_BackBufferStaging = nullptr;
-ID3D11Texture2D *g_DepthStaging = nullptr;
-
-// our shareable copies
-ID3D11Texture2D *g_BackBufferShared = nullptr;
-ID3D11Texture2D *g_DepthShared = nullptr;
-HANDLE g_BackBufferSharedHandle = nullptr;
-HANDLE g_DepthSharedHandle = nullptr;
+// one pipeline context per live swap chain (back buffer, staging / shared copies, streams)
+std::mutex g_PipelineLock;
+std::vector<PipelineContext *> g_Pipelines;
 
 // global variable to store the device name
 std::string g_DeviceName;
@@ -337,33 +299,13 @@ std::string g_DeviceName;
 // dual GPU handling - track device creation calls
 static bool g_FirstDeviceCreated = false;
 
-// helper function to replace global pointers
+// helper function to replace global pointers (references on tracked game textures are
+// counted for the leak report)
 void replaceGlobal(ID3D11Texture2D *&dst, ID3D11Texture2D *src)
 {
-    if (dst)
-        dst->Release();
+    dropResource(dst);
     dst = src;
-    if (dst)
-        dst->AddRef();
-}
-
-// helper function to update width and height from back buffer texture
-void updateDimensionsFromBackBuffer()
-{
-    if (g_BackBufferTexture)
-    {
-        D3D11_TEXTURE2D_DESC desc;
-        g_BackBufferTexture->GetDesc(&desc); // Only update if dimensions have changed to avoid unnecessary logs
-        if (g_Width != (int)desc.Width || g_Height != (int)desc.Height)
-        {
-            g_Width = desc.Width;
-            g_Height = desc.Height;
-#if DEBUG
-            std::cout << timeStamp() << "Updated dimensions from back buffer: "
-                      << g_Width << "x" << g_Height << std::endl;
-#endif
-        }
-    }
+    holdResource(dst);
 }
 
 // --------------------------- DXGI HOOKS ------------------------------------
@@ -390,7 +332,58 @@ static CreateDXGIFactory1_t g_real_CreateDXGIFactory1 = nullptr;
 static CreateDXGIFactory2_t g_real_CreateDXGIFactory2 = nullptr;
 
 // depth texture address
-ID3D11Texture2D *g_DepthTexture = nullptr;
+std::atomic<ID3D11Texture2D *> g_DepthTexture{nullptr}; // written on Present / destruction, read anywhere
+std::atomic<ID3D11Texture2D *> g_DepthHeld{nullptr};    // the layer's reference on it, bind / clear to Present
+
+// events of the current frame (immediate context + spliced deferred command lists)
+FrameTimeline g_FrameTimeline;
+
+// game objects known without a reference (destruction sentinels)
+ResourceRegistry g_Resources;
+
+// API call capture stream (opened in DllMain when ENABLE_CAPTURE is set)
+CaptureWriter g_Capture;
+
+// structured log (levels set in DllMain, written once a hook starts it, see ProxyLog.h)
+LayerLog g_Log;
+
+// binary trace of the hot paths (opened at device creation in DEBUG builds, see ProxyTrace.h)
+TraceLog g_Trace;
+
+// frames slow enough to snapshot g_Trace's flight recorder (checked by the primary's Present)
+HitchDetector g_Hitches;
+
+// live statistics, published to "Local\dxpipe_stats" from the primary's first Present
+StatsWriter g_Stats;
+
+// API calls per method and thread, snapshotted into g_Stats by the primary's Present
+ApiCensus g_Census;
+
+// passes of the immediate context on sampled frames, armed / timed by the primary's Present
+PassRecorder g_Passes;
+
+// depth-capable textures, scored every Present to pick g_DepthTexture
+DepthCandidates g_DepthCandidates;
+
+// scene depth copied before the game clears / reuses g_DepthTexture (immediate context)
+DepthSpanTracker g_DepthSpans;
+ID3D11Texture2D *g_DepthSnapshot = nullptr;
+std::atomic<bool> g_DepthWanted{ENABLE_IMGUI != 0}; // the overlay always reads depth
+
+// msaa depth buffers are resolved to one sample (into the primary context) before export
+DepthResolveMode g_DepthResolveMode = DepthResolveMode::Sample0;
+
+// detection results per executable + resolution, persisted across launches
+DepthProfileStore g_DepthProfiles;
+DepthProfile g_DepthProfile = {};
+
+// projection matrices / depth tests seen by the proxies, published as g_DepthProjection
+ProjectionInference g_Projection;
+DepthProjection g_DepthProjection = {};
+
+// camera buffer found in the vertex shader constants, published as g_CameraMatrices
+CameraInference g_Camera;
+CameraMatrices g_CameraMatrices = {};
 
 // other
 int g_Width = 0;
@@ -412,16 +405,18 @@ extern "C" HRESULT WINAPI D3D11CreateDevice(
     D3D_FEATURE_LEVEL *pFeatureLevel,
     ID3D11DeviceContext **ppImmediateContext)
 {
-#if DEBUG
-    output();
-    std::cout << timeStamp() << "D3D11CreateDevice called!" << std::endl;
+    startLog();
+    LOG_INFO(Hooks, "D3D11CreateDevice called!");
+#if DEBUG || ENABLE_TRACE
+    setTraceRecording(true);
+#endif
+#if ENABLE_HITCH_SNAPSHOTS
+    setFlightRecorder(true);
 #endif // dual GPU handling: exclude the second device creation call (display out device)
     // in dual GPU setups, the first call is by the game engine, second is by windows
     if (g_FirstDeviceCreated)
     {
-#if DEBUG
-        std::cout << timeStamp() << "Excluding second D3D11CreateDevice call (dual GPU display device)" << std::endl;
-#endif
+        LOG_INFO(Hooks, "Excluding second D3D11CreateDevice call (dual GPU display device)");
 
         // temporarily remove our hook to prevent infinite recursion
         removeHook(&g_D3D11CreateDeviceHook);
@@ -439,9 +434,7 @@ extern "C" HRESULT WINAPI D3D11CreateDevice(
 
     if (!g_real_D3D11CreateDevice)
     {
-#if DEBUG
-        std::cout << timeStamp() << "Original pointer not set" << std::endl;
-#endif
+        LOG_ERROR(Hooks, "Original pointer not set");
         return E_FAIL;
     }
 
@@ -466,9 +459,14 @@ extern "C" HRESULT WINAPI D3D11CreateDevice(
 
     if (SUCCEEDED(hr) && ppDevice && *ppDevice)
     {
-        // store the real device pointer the first time we see it
+        // store the real device pointer the first time we see it (weak, cleared when the
+        // game destroys it)
         if (!g_Device)
+        {
             g_Device = *ppDevice;
+            trackDevice(g_Device);
+            electPrimaryPipeline(); // a swap chain created before may present with it
+        }
 
         // helper function to convert feature level to string
         auto flToStr = [](D3D_FEATURE_LEVEL lvl) -> std::string
@@ -493,9 +491,7 @@ extern "C" HRESULT WINAPI D3D11CreateDevice(
                 return "Unknown";
             } };
 
-#if DEBUG
-        std::cout << timeStamp() << "g_Device address: " << g_Device << std::endl;
-#endif
+        LOG_DEBUG(Hooks, "g_Device address: {}", g_Device);
 
         // retrieve device name
         IDXGIDevice *pDX = nullptr;
@@ -510,24 +506,18 @@ extern "C" HRESULT WINAPI D3D11CreateDevice(
                     char name[128];
                     WideCharToMultiByte(CP_UTF8, 0, desc.Description, -1,
                                         name, sizeof(name), nullptr, nullptr);
-#if DEBUG
-                    std::cout << timeStamp() << "Device name: " << name << std::endl;
-#endif
+                    LOG_INFO(Hooks, "Device name: {}", name);
                     g_DeviceName = name; // store the device name globally
                 }
                 pAd->Release();
             }
             pDX->Release();
         }
-#if DEBUG
-        std::cout << timeStamp() << "Feature level: " << flToStr((*ppDevice)->GetFeatureLevel()) << std::endl;
-#endif
+        LOG_INFO(Hooks, "Feature level: {}", flToStr((*ppDevice)->GetFeatureLevel()));
 
         // mark that we've successfully created the first device (game engine device)
         g_FirstDeviceCreated = true;
-#if DEBUG
-        std::cout << timeStamp() << "First device created - subsequent calls will be excluded" << std::endl;
-#endif
+        LOG_INFO(Hooks, "First device created - subsequent calls will be excluded");
 
         // wrap the real device with our proxy
         ID3D11Device *realDevice = *ppDevice;
@@ -567,16 +557,12 @@ extern "C" HRESULT WINAPI CreateDXGIFactory(
     REFIID riid,
     void **ppFactory)
 {
-#if DEBUG
-    output();
-    std::cout << timeStamp() << "CreateDXGIFactory called!" << std::endl;
-#endif
+    startLog();
+    LOG_INFO(Hooks, "CreateDXGIFactory called!");
 
     if (!g_real_CreateDXGIFactory)
     {
-#if DEBUG
-        std::cout << timeStamp() << "CreateDXGIFactory original pointer not set!" << std::endl;
-#endif
+        LOG_ERROR(Hooks, "CreateDXGIFactory original pointer not set!");
         return E_FAIL;
     }
     // temporarily remove our hook to prevent infinite recursion
@@ -592,9 +578,7 @@ extern "C" HRESULT WINAPI CreateDXGIFactory(
         IDXGIFactory2 *realFactory2 = nullptr;
         if (SUCCEEDED(((IUnknown *)*ppFactory)->QueryInterface(__uuidof(IDXGIFactory2), (void **)&realFactory2)) && realFactory2)
         {
-#if DEBUG
-            std::cout << timeStamp() << "Wrapping IDXGIFactory2 (via Factory)" << std::endl;
-#endif
+            LOG_INFO(Hooks, "Wrapping IDXGIFactory2 (via Factory)");
             *ppFactory = new ProxyFactory(realFactory2);
             realFactory2->Release();
         }
@@ -607,16 +591,12 @@ extern "C" HRESULT WINAPI CreateDXGIFactory1(
     REFIID riid,
     void **ppFactory)
 {
-#if DEBUG
-    output();
-    std::cout << timeStamp() << "CreateDXGIFactory1 called!" << std::endl;
-#endif
+    startLog();
+    LOG_INFO(Hooks, "CreateDXGIFactory1 called!");
 
     if (!g_real_CreateDXGIFactory1)
     {
-#if DEBUG
-        std::cout << timeStamp() << "CreateDXGIFactory1 original pointer not set!" << std::endl;
-#endif
+        LOG_ERROR(Hooks, "CreateDXGIFactory1 original pointer not set!");
         return E_FAIL;
     }
     // temporarily remove our hook to prevent infinite recursion
@@ -632,9 +612,7 @@ extern "C" HRESULT WINAPI CreateDXGIFactory1(
         IDXGIFactory2 *realFactory2 = nullptr;
         if (SUCCEEDED(((IUnknown *)*ppFactory)->QueryInterface(__uuidof(IDXGIFactory2), (void **)&realFactory2)) && realFactory2)
         {
-#if DEBUG
-            std::cout << timeStamp() << "Wrapping IDXGIFactory2 (via Factory1)" << std::endl;
-#endif
+            LOG_INFO(Hooks, "Wrapping IDXGIFactory2 (via Factory1)");
             *ppFactory = new ProxyFactory(realFactory2);
             realFactory2->Release();
         }
@@ -648,16 +626,13 @@ extern "C" HRESULT WINAPI CreateDXGIFactory2(
     REFIID riid,
     void **ppFactory)
 {
-#if DEBUG
-    output();
-    std::cout << timeStamp() << "CreateDXGIFactory2 called! Flags=" << Flags << std::endl;
-#endif
+    startLog();
+    LOG_INFO(Hooks, "CreateDXGIFactory2 called! Flags={}", Flags);
 
     if (!g_real_CreateDXGIFactory2)
     {
-#if DEBUG
-        std::cout << timeStamp() << "CreateDXGIFactory2 original pointer not set!" << std::endl;
-#endif return E_FAIL;
+        LOG_ERROR(Hooks, "CreateDXGIFactory2 original pointer not set!");
+        return E_FAIL;
     }
     // temporarily remove our hook to prevent infinite recursion
     removeHook(&g_CreateDXGIFactory2Hook);
@@ -672,9 +647,7 @@ extern "C" HRESULT WINAPI CreateDXGIFactory2(
         IDXGIFactory2 *realFactory2 = nullptr;
         if (SUCCEEDED(((IUnknown *)*ppFactory)->QueryInterface(__uuidof(IDXGIFactory2), (void **)&realFactory2)) && realFactory2)
         {
-#if DEBUG
-            std::cout << timeStamp() << "Wrapping IDXGIFactory2 (direct)" << std::endl;
-#endif
+            LOG_INFO(Hooks, "Wrapping IDXGIFactory2 (direct)");
             *ppFactory = new ProxyFactory(realFactory2);
             realFactory2->Release();
         }
@@ -687,9 +660,8 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD ul_reason_for_call, LPVOID lpReserv
 {
     if (ul_reason_for_call == DLL_PROCESS_ATTACH)
     {
-#if DEBUG
-        output();
-#endif
+        configureLog();
+
         // get the process path
         char szProcessPath[MAX_PATH] = {0};
         if (GetModuleFileNameA(nullptr, szProcessPath, MAX_PATH))
@@ -735,18 +707,17 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD ul_reason_for_call, LPVOID lpReserv
         // install our hooks
         if (!installHooks())
         {
-#if DEBUG
-            std::cout << timeStamp() << "Failed to install hooks!" << std::endl;
-#endif
+            LOG_ERROR(Hooks, "Failed to install hooks!");
             return FALSE;
         }
-        // dimensions will be updated dynamically from back buffer texture
-#if DEBUG
-        std::cout << timeStamp() << "Dimensions will be detected from back buffer texture" << std::endl;
-
-        std::cout << timeStamp() << "Hello from DxPipe!" << std::endl;
+#if ENABLE_CAPTURE
+        openCapture();
 #endif
 
+        // dimensions will be updated dynamically from back buffer texture
+        LOG_INFO(Hooks, "Dimensions will be detected from back buffer texture");
+        LOG_INFO(Hooks, "Hello from DxPipe!");
+
         // start our overlay with complete detachment
         char buf[MAX_PATH];
         if (SUCCEEDED(SHGetFolderPathA(NULL, CSIDL_APPDATA, NULL, 0, buf)))
@@ -780,16 +751,12 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD ul_reason_for_call, LPVOID lpReserv
                 // immediately close process handles to prevent resource leaks
                 CloseHandle(pi.hThread);
                 CloseHandle(pi.hProcess);
-#if DEBUG
-                std::cout << timeStamp() << "Started Bloxshade completely detached" << std::endl;
-#endif
+                LOG_INFO(Hooks, "Started Bloxshade completely detached");
             }
-#if DEBUG
             else
             {
-                std::cout << timeStamp() << "Failed to start Bloxshade at: " << appdataBloxshadePath << std::endl;
+                LOG_ERROR(Hooks, "Failed to start Bloxshade at: {}", appdataBloxshadePath);
             }
-#endif
         }
     }
     return TRUE;
@@ -0,0 +1,95 @@
+#pragma once
+
+// c++ includes
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+
+// NOTE: platform independent, used by the layer (ENABLE_ALLOC_AUDIT) and tools/dxpipe_bench
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// allocation audit
+//  • the owner of operator new (d3d11.cpp, the bench) calls allocAuditNote on every allocation
+//  • hot paths open an AllocScope, allocations inside one are "tagged" with the scope stack
+//  • the first tagged allocations since the last drain are kept for the report
+//  • nothing in here allocates, it runs from inside operator new
+///////////////////////////////////////////////////////////////////////////////////////////
+
+static const uint32_t ALLOC_AUDIT_DEPTH = 8;  // nested scopes tracked per thread
+static const uint32_t ALLOC_AUDIT_SITES = 16; // tagged allocations kept per report
+
+struct AllocSite
+{
+    char tag[96]; // "Present/export/staging"
+    uint64_t size;
+};
+
+struct AllocAuditState
+{
+    std::atomic<uint64_t> total{0};  // every allocation seen
+    std::atomic<uint64_t> tagged{0}; // allocations inside an AllocScope
+    std::atomic<uint32_t> sites{0};
+    AllocSite site[ALLOC_AUDIT_SITES];
+};
+
+inline AllocAuditState g_AllocAudit;
+
+// per-thread scope stack (a null entry pauses tagging, e.g. around intended allocations)
+inline thread_local const char *t_allocTags[ALLOC_AUDIT_DEPTH];
+inline thread_local uint32_t t_allocDepth = 0;
+
+inline void allocAuditNote(size_t size)
+{
+    g_AllocAudit.total.fetch_add(1, std::memory_order_relaxed);
+
+    uint32_t depth = t_allocDepth < ALLOC_AUDIT_DEPTH ? t_allocDepth : ALLOC_AUDIT_DEPTH;
+    if (!depth || !t_allocTags[depth - 1])
+        return;
+
+    g_AllocAudit.tagged.fetch_add(1, std::memory_order_relaxed);
+    uint32_t idx = g_AllocAudit.sites.fetch_add(1, std::memory_order_relaxed);
+    if (idx >= ALLOC_AUDIT_SITES)
+        return;
+
+    // join the scope stack by hand, snprintf may allocate on some runtimes
+    AllocSite &s = g_AllocAudit.site[idx];
+    size_t n = 0;
+    for (uint32_t i = 0; i < depth && n + 1 < sizeof(s.tag); i++)
+    {
+        if (!t_allocTags[i])
+            continue;
+        if (n && n + 1 < sizeof(s.tag))
+            s.tag[n++] = '/';
+        for (const char *c = t_allocTags[i]; *c && n + 1 < sizeof(s.tag); c++)
+            s.tag[n++] = *c;
+    }
+    s.tag[n] = '\0';
+    s.size = size;
+}
+
+// report and reset the tagged allocations, fn(const AllocSite &) per kept site
+template <class Fn>
+inline uint64_t allocAuditDrain(Fn fn)
+{
+    uint64_t tagged = g_AllocAudit.tagged.exchange(0, std::memory_order_relaxed);
+    uint32_t sites = g_AllocAudit.sites.exchange(0, std::memory_order_relaxed);
+    for (uint32_t i = 0; i < sites && i < ALLOC_AUDIT_SITES; i++)
+        fn(g_AllocAudit.site[i]);
+    return tagged;
+}
+
+// marks a section that must not allocate once warmed up
+class AllocScope
+{
+public:
+    explicit AllocScope(const char *tag)
+    {
+        if (t_allocDepth < ALLOC_AUDIT_DEPTH)
+            t_allocTags[t_allocDepth] = tag;
+        t_allocDepth++;
+    }
+    ~AllocScope() { t_allocDepth--; }
+
+    AllocScope(const AllocScope &) = delete;
+    AllocScope &operator=(const AllocScope &) = delete;
+};
@@ -0,0 +1,293 @@
+#pragma once
+
+// c++ includes
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+
+// NOTE: platform independent, shared by the layer (ProxyDeviceContext counts, the primary's
+// Present snapshots), the stats page (the per frame counts) and tools/dxpipe_census
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// API call census
+//  • one counter per ID3D11DeviceContext method (stage variants share one: PS / VS / ...
+//    SetShaderResources all count as SetShaderResources, every Get* as StateQuery) plus
+//    the bytes UpdateSubresource / Map move
+//  • every thread counts into its own block (whole cache lines, claimed on its first call
+//    like TraceLog's rings): a relaxed load and store, no lock prefix, no shared line
+//  • off, a call is one relaxed load of the switch; on by default, it is cheap enough
+//  • blocks are never reset, a thread that exits hands its block (totals and all) to the
+//    next new thread, so the sum over all blocks only ever grows
+//  • snapshot() runs on one thread (the primary's Present): it sums the blocks and hands
+//    back the difference to the previous snapshot, i.e. the calls of one frame from
+//    every thread (a count in flight lands in the next frame)
+///////////////////////////////////////////////////////////////////////////////////////////
+
+enum class ApiCall : uint32_t
+{
+    Draw,
+    DrawIndexed,
+    DrawInstanced,
+    DrawIndexedInstanced,
+    DrawIndirect, // both *Indirect draws
+    DrawAuto,
+    Dispatch,
+    DispatchIndirect,
+    Map,
+    Unmap,
+    UpdateSubresource,
+    CopyResource,
+    CopySubresourceRegion,
+    CopyStructureCount,
+    ResolveSubresource,
+    GenerateMips,
+    SetShaderResources,
+    SetConstantBuffers,
+    SetSamplers,
+    SetShader,
+    SetUnorderedAccessViews,
+    SetInputLayout,
+    SetVertexBuffers,
+    SetIndexBuffer,
+    SetPrimitiveTopology,
+    SetRenderTargets, // with or without UAVs
+    SetBlendState,
+    SetDepthStencilState,
+    SetRasterizerState,
+    SetViewports,
+    SetScissorRects,
+    SetStreamOutTargets,
+    SetPredication,
+    SetResourceMinLOD,
+    ClearRenderTargetView,
+    ClearDepthStencilView,
+    ClearUnorderedAccessView, // uint and float
+    Begin,
+    End,
+    GetData,
+    StateQuery, // every Get*, GetType, GetDevice ...
+    ClearState,
+    Flush,
+    ExecuteCommandList,
+    FinishCommandList,
+    Count
+};
+
+// the bytes handed to the driver (UpdateSubresource) / mapped (Map, every map type)
+enum class ApiBytes : uint32_t
+{
+    UpdateSubresource,
+    Map,
+    Count
+};
+
+// how the overlay / dxpipe_stat group the calls
+enum class ApiGroup : uint32_t
+{
+    Draw,     // draws and dispatches
+    Transfer, // map, update, copy, resolve
+    Bind,     // resources, buffers, samplers, views, targets
+    State,    // shaders and fixed function state
+    Clear,
+    Other,    // queries, flush, command lists
+    Count
+};
+
+static const uint32_t CENSUS_CALLS = uint32_t(ApiCall::Count);
+static const uint32_t CENSUS_BYTES = uint32_t(ApiBytes::Count);
+static const uint32_t CENSUS_GROUPS = uint32_t(ApiGroup::Count);
+
+inline const char *apiCallName(uint32_t call)
+{
+    static const char *names[CENSUS_CALLS] = {
+        "Draw", "DrawIndexed", "DrawInstanced", "DrawIndexedInstanced", "DrawIndirect", "DrawAuto", "Dispatch",
+        "DispatchIndirect", "Map", "Unmap", "UpdateSubresource", "CopyResource", "CopySubresourceRegion",
+        "CopyStructureCount", "ResolveSubresource", "GenerateMips", "SetShaderResources", "SetConstantBuffers",
+        "SetSamplers", "SetShader", "SetUnorderedAccessViews", "SetInputLayout", "SetVertexBuffers",
+        "SetIndexBuffer", "SetPrimitiveTopology", "SetRenderTargets", "SetBlendState", "SetDepthStencilState",
+        "SetRasterizerState", "SetViewports", "SetScissorRects", "SetStreamOutTargets", "SetPredication",
+        "SetResourceMinLOD", "ClearRenderTargetView", "ClearDepthStencilView", "ClearUnorderedAccessView", "Begin",
+        "End", "GetData", "StateQuery", "ClearState", "Flush", "ExecuteCommandList", "FinishCommandList"};
+    return call < CENSUS_CALLS ? names[call] : "?";
+}
+
+inline const char *apiBytesName(uint32_t bytes)
+{
+    static const char *names[CENSUS_BYTES] = {"UpdateSubresource", "Map"};
+    return bytes < CENSUS_BYTES ? names[bytes] : "?";
+}
+
+inline const char *apiGroupName(uint32_t group)
+{
+    static const char *names[CENSUS_GROUPS] = {"draw", "transfer", "bind", "state", "clear", "other"};
+    return group < CENSUS_GROUPS ? names[group] : "?";
+}
+
+inline ApiGroup apiCallGroup(uint32_t call)
+{
+    using G = ApiGroup;
+    static const ApiGroup groups[CENSUS_CALLS] = {
+        // Draw .. DispatchIndirect
+        G::Draw, G::Draw, G::Draw, G::Draw, G::Draw, G::Draw, G::Draw, G::Draw,
+        // Map .. GenerateMips
+        G::Transfer, G::Transfer, G::Transfer, G::Transfer, G::Transfer, G::Transfer, G::Transfer, G::Transfer,
+        // SetShaderResources .. SetUnorderedAccessViews
+        G::Bind, G::Bind, G::Bind, G::State, G::Bind,
+        // SetInputLayout .. SetRenderTargets
+        G::State, G::Bind, G::Bind, G::State, G::Bind,
+        // SetBlendState .. SetResourceMinLOD
+        G::State, G::State, G::State, G::State, G::State, G::Bind, G::State, G::State,
+        // Clear*
+        G::Clear, G::Clear, G::Clear,
+        // Begin .. FinishCommandList
+        G::Other, G::Other, G::Other, G::Other, G::Other, G::Other, G::Other, G::Other};
+    return call < CENSUS_CALLS ? groups[call] : ApiGroup::Other;
+}
+
+// the calls of one frame (snapshot() / the stats page)
+struct CensusFrame
+{
+    uint32_t calls[CENSUS_CALLS];
+    uint64_t bytes[CENSUS_BYTES];
+};
+
+// one thread's counters, only ever written by that thread
+struct alignas(64) CensusBlock
+{
+    std::atomic<uint64_t> calls[CENSUS_CALLS];
+    std::atomic<uint64_t> bytes[CENSUS_BYTES];
+
+    // Free → Owned (a thread claimed it) → Free (the thread exited, the totals stay)
+    std::atomic<uint32_t> owned;
+};
+
+static_assert(sizeof(CensusBlock) % 64 == 0, "blocks never share a cache line");
+
+class ApiCensus
+{
+public:
+    static constexpr uint32_t MAX_THREADS = 64; // threads counting at the same time, more share one block
+
+    // the blocks are never freed, an exiting thread may still give its block back after this
+
+    void setEnabled(bool on) { m_enabled.store(on, std::memory_order_relaxed); }
+    bool enabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    // the hot path: a flag test, the thread's block, one load + store
+    inline void count(ApiCall call)
+    {
+        if (!m_enabled.load(std::memory_order_relaxed))
+            return;
+        if (CensusBlock *block = threadBlock())
+            add(block->calls[uint32_t(call)], 1);
+        else
+            m_shared.calls[uint32_t(call)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    inline void addBytes(ApiBytes what, uint64_t n)
+    {
+        if (!m_enabled.load(std::memory_order_relaxed))
+            return;
+        if (CensusBlock *block = threadBlock())
+            add(block->bytes[uint32_t(what)], n);
+        else
+            m_shared.bytes[uint32_t(what)].fetch_add(n, std::memory_order_relaxed);
+    }
+
+    // the calls since the last snapshot, one thread only (the primary's Present)
+    void snapshot(CensusFrame &frame)
+    {
+        uint64_t calls[CENSUS_CALLS], bytes[CENSUS_BYTES];
+        total(calls, bytes);
+        for (uint32_t i = 0; i < CENSUS_CALLS; i++)
+        {
+            uint64_t n = calls[i] - m_previous.calls[i];
+            frame.calls[i] = n > UINT32_MAX ? UINT32_MAX : uint32_t(n);
+        }
+        for (uint32_t i = 0; i < CENSUS_BYTES; i++)
+            frame.bytes[i] = bytes[i] - m_previous.bytes[i];
+        memcpy(m_previous.calls, calls, sizeof(calls));
+        memcpy(m_previous.bytes, bytes, sizeof(bytes));
+    }
+
+    // every count so far (any thread)
+    void total(uint64_t calls[CENSUS_CALLS], uint64_t bytes[CENSUS_BYTES]) const
+    {
+        sum(m_shared, calls, bytes, false);
+        for (const std::atomic<CensusBlock *> &slot : m_blocks)
+            if (const CensusBlock *block = slot.load(std::memory_order_acquire))
+                sum(*block, calls, bytes, true);
+    }
+
+private:
+    // an owned block has one writer, no read-modify-write needed (the shared one has many)
+    static inline void add(std::atomic<uint64_t> &counter, uint64_t n)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    static void sum(const CensusBlock &block, uint64_t calls[CENSUS_CALLS], uint64_t bytes[CENSUS_BYTES], bool add)
+    {
+        for (uint32_t i = 0; i < CENSUS_CALLS; i++)
+            calls[i] = (add ? calls[i] : 0) + block.calls[i].load(std::memory_order_relaxed);
+        for (uint32_t i = 0; i < CENSUS_BYTES; i++)
+            bytes[i] = (add ? bytes[i] : 0) + block.bytes[i].load(std::memory_order_relaxed);
+    }
+
+    // the calling thread's block, claimed on its first count, given back when it exits
+    // (nullptr beyond MAX_THREADS, those count into m_shared)
+    CensusBlock *threadBlock()
+    {
+        struct ThreadSlot
+        {
+            ApiCensus *census = nullptr;
+            CensusBlock *block = nullptr;
+            ~ThreadSlot()
+            {
+                if (block)
+                    block->owned.store(0, std::memory_order_release);
+            }
+        };
+        static thread_local ThreadSlot t_slot;
+        if (t_slot.census != this)
+        {
+            if (t_slot.block)
+                t_slot.block->owned.store(0, std::memory_order_release);
+            t_slot.census = this;
+            t_slot.block = claimBlock();
+        }
+        return t_slot.block;
+    }
+
+    CensusBlock *claimBlock()
+    {
+        for (uint32_t i = 0; i < MAX_THREADS; i++)
+        {
+            CensusBlock *block = m_blocks[i].load(std::memory_order_acquire);
+            if (!block)
+            {
+                // an empty slot, the first thread to publish a block there owns it
+                CensusBlock *fresh = new CensusBlock();
+                fresh->owned.store(1, std::memory_order_relaxed);
+                if (m_blocks[i].compare_exchange_strong(block, fresh, std::memory_order_acq_rel))
+                    return fresh;
+                delete fresh;
+            }
+            uint32_t expected = 0;
+            if (block->owned.compare_exchange_strong(expected, 1, std::memory_order_acq_rel))
+                return block;
+        }
+        return nullptr;
+    }
+
+    std::atomic<bool> m_enabled{true};
+    std::atomic<CensusBlock *> m_blocks[MAX_THREADS] = {};
+    CensusBlock m_shared = {};
+
+    // snapshot()'s thread only
+    struct
+    {
+        uint64_t calls[CENSUS_CALLS];
+        uint64_t bytes[CENSUS_BYTES];
+    } m_previous = {};
+};
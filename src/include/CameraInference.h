@@ -0,0 +1,309 @@
+#pragma once
+
+// c++ includes
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+#include <mutex>
+#include <atomic>
+
+// layer headers (platform independent)
+#include "ProjectionInference.h"
+
+// NOTE: platform independent, fed by the proxies (ProxyDepth.h) or by tools/dxpipe_projection
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// camera matrix extraction
+//  • buffers bound with VSSetConstantBuffers land in a small direct-mapped set, only
+//    writes to those are searched (bounded per frame, like the projection scan)
+//  • a camera buffer holds a perspective projection (scanProjection) and a view matrix in
+//    the same layout: a rigid transform, orthonormal rotation + translation, no scale
+//  • a view × projection product next to them tells the view from the camera's world
+//    matrix (both are rigid), without one the rigid transform closest to the projection wins
+//  • once found the buffer + both offsets are locked for the session, writes to it copy
+//    the two matrices (128 bytes), writes to any other buffer return after one compare
+//  • Present publishes the latest matrices with the frame id, always row-major
+///////////////////////////////////////////////////////////////////////////////////////////
+
+enum CameraFlags : uint32_t
+{
+    CAM_VALID = 0x1,      // view / projection are the locked camera's
+    CAM_CONFIRMED = 0x2,  // view × projection was found next to them
+    CAM_TRANSPOSED = 0x4, // the game stores them column-major (transposed back here)
+    CAM_UPDATED = 0x8     // written during this frame, else the last frame's are repeated
+};
+
+// camera of one frame (sent to the client as is, 144 bytes), row vectors: clip = p · view · proj
+struct CameraMatrices
+{
+    float view[16];
+    float projection[16];
+    uint64_t frame;
+    uint32_t flags;
+    uint32_t reserved;
+};
+
+// camera buffer layout found by scanCamera
+struct CameraMatch
+{
+    ProjectionMatch projection;
+    uint32_t viewOffset; // byte offset of the view matrix
+    bool confirmed;      // view × projection is in the buffer too
+};
+
+// test 16 floats for a view matrix (rigid transform, exact identity excluded: world matrices)
+//  row-major:  | r r r 0 |   transposed: | r r r tx |
+//              | r r r 0 |               | r r r ty |
+//              | r r r 0 |               | r r r tz |
+//              | tx ty tz 1 |            | 0 0 0 1  |
+inline bool matchView(const float *m, bool transposed)
+{
+    if (m[15] != 1.0f)
+        return false;
+    if (transposed ? (m[12] != 0.0f || m[13] != 0.0f || m[14] != 0.0f)
+                   : (m[3] != 0.0f || m[7] != 0.0f || m[11] != 0.0f))
+        return false;
+
+    // the rows of the 3x3 are orthonormal in both layouts (a rotation's transpose is one)
+    const float *r0 = m, *r1 = m + 4, *r2 = m + 8;
+    auto dot = [](const float *a, const float *b)
+    { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; };
+    const float tolerance = 2e-3f;
+    if (std::fabs(dot(r0, r0) - 1.0f) > tolerance || std::fabs(dot(r1, r1) - 1.0f) > tolerance ||
+        std::fabs(dot(r2, r2) - 1.0f) > tolerance)
+        return false;
+    if (std::fabs(dot(r0, r1)) > tolerance || std::fabs(dot(r0, r2)) > tolerance || std::fabs(dot(r1, r2)) > tolerance)
+        return false;
+
+    float tx = transposed ? m[3] : m[12], ty = transposed ? m[7] : m[13], tz = transposed ? m[11] : m[14];
+    if (!std::isfinite(tx) || !std::isfinite(ty) || !std::isfinite(tz))
+        return false;
+    return !(m[0] == 1.0f && m[5] == 1.0f && m[10] == 1.0f);
+}
+
+inline void multiplyMatrix(const float *a, const float *b, float *out)
+{
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++)
+            out[i * 4 + j] = a[i * 4] * b[j] + a[i * 4 + 1] * b[4 + j] + a[i * 4 + 2] * b[8 + j] + a[i * 4 + 3] * b[12 + j];
+}
+
+inline void transposeMatrix(const float *m, float *out)
+{
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++)
+            out[i * 4 + j] = m[j * 4 + i];
+}
+
+// is the product of view and projection (as stored) somewhere in the buffer
+inline bool containsViewProjection(const uint8_t *base, size_t regs, const float *view, const float *proj, bool transposed)
+{
+    // row-major: V · P, column-major stores (V · P)ᵀ = Pᵀ · Vᵀ
+    float vp[16];
+    if (transposed)
+        multiplyMatrix(proj, view, vp);
+    else
+        multiplyMatrix(view, proj, vp);
+
+    for (size_t r = 0; r + 4 <= regs; r++)
+    {
+        float m[16];
+        memcpy(m, base + r * 16, sizeof(m));
+        bool same = true;
+        for (int i = 0; i < 16 && same; i++)
+            same = std::fabs(m[i] - vp[i]) <= 1e-3f * std::fmax(1.0f, std::fabs(vp[i]));
+        if (same)
+            return true;
+    }
+    return false;
+}
+
+// scan a constant buffer for a projection and the view that goes with it
+inline bool scanCamera(const void *data, size_t size, float targetAspect, CameraMatch &out)
+{
+    if (!scanProjection(data, size, targetAspect, out.projection))
+        return false;
+
+    const uint8_t *base = static_cast<const uint8_t *>(data);
+    size_t regs = size / 16;
+    bool transposed = out.projection.transposed;
+    uint32_t projOffset = out.projection.offset;
+    float proj[16];
+    memcpy(proj, base + projOffset, sizeof(proj));
+
+    bool found = false;
+    uint32_t bestDistance = UINT32_MAX;
+    for (size_t r = 0; r + 4 <= regs; r++)
+    {
+        uint32_t offset = uint32_t(r * 16);
+        if (offset + 64 > projOffset && offset < projOffset + 64)
+            continue;
+        float view[16];
+        memcpy(view, base + offset, sizeof(view));
+        if (!matchView(view, transposed))
+            continue;
+
+        bool confirmed = containsViewProjection(base, regs, view, proj, transposed);
+        uint32_t distance = offset > projOffset ? offset - projOffset : projOffset - offset;
+        if (found && (out.confirmed > confirmed || (out.confirmed == confirmed && distance >= bestDistance)))
+            continue;
+        found = true;
+        bestDistance = distance;
+        out.viewOffset = offset;
+        out.confirmed = confirmed;
+    }
+    return found;
+}
+
+class CameraInference
+{
+public:
+    // tuning
+    static constexpr uint32_t SCAN_BUDGET = 256 * 1024; // bytes searched per frame
+    static constexpr uint32_t STALE_FRAMES = 600;       // a camera buffer unwritten this long was recreated
+    static constexpr size_t BOUND_SLOTS = 64;           // vertex shader buffers remembered while searching
+
+    // buffers bound to the vertex shader (any context), only remembered while searching
+    void onBind(const void *const *buffers, uint32_t count)
+    {
+        if (!buffers || m_lockedBuffer.load(std::memory_order_acquire))
+            return;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (buffers[i])
+                m_bound[slotOf(buffers[i])].store(buffers[i], std::memory_order_relaxed);
+        }
+    }
+
+    // the game wrote a constant buffer (any thread), data is only valid during the call
+    void onConstants(const void *buffer, const void *data, size_t size)
+    {
+        if (!buffer || !data)
+            return;
+
+        // locked, shadow the camera buffer and nothing else
+        if (const void *locked = m_lockedBuffer.load(std::memory_order_acquire))
+        {
+            if (buffer == locked)
+                shadow(data, size);
+            return;
+        }
+
+        // searching, vertex shader buffers only, bounded per frame
+        if (size < 128 || m_bound[slotOf(buffer)].load(std::memory_order_relaxed) != buffer)
+            return;
+        if (m_scanned.fetch_add(uint32_t(size), std::memory_order_relaxed) >= SCAN_BUDGET)
+            return;
+
+        CameraMatch match = {};
+        if (!scanCamera(data, size, m_aspect.load(std::memory_order_relaxed), match))
+            return;
+
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_match = match;
+        m_lockedSize = uint32_t(size);
+        m_lockedBuffer.store(buffer, std::memory_order_release);
+        copy(static_cast<const uint8_t *>(data));
+    }
+
+    // the camera of the frame that is being presented
+    CameraMatrices endFrame(uint64_t frame, uint32_t width, uint32_t height)
+    {
+        m_aspect.store(width && height ? float(width) / float(height) : 0.0f, std::memory_order_relaxed);
+        m_scanned.store(0, std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_frame = frame;
+
+        // buffer released / recreated (or the game stopped drawing the scene), search again
+        if (m_lockedBuffer.load(std::memory_order_relaxed) && frame - m_writeFrame > STALE_FRAMES)
+        {
+            m_lockedBuffer.store(nullptr, std::memory_order_release);
+            m_have = false;
+            for (std::atomic<const void *> &slot : m_bound)
+                slot.store(nullptr, std::memory_order_relaxed);
+        }
+
+        CameraMatrices c = m_camera;
+        c.frame = frame;
+        c.flags = 0;
+        if (m_have)
+        {
+            c.flags = CAM_VALID | (m_match.confirmed ? uint32_t(CAM_CONFIRMED) : 0u) |
+                      (m_match.projection.transposed ? uint32_t(CAM_TRANSPOSED) : 0u) |
+                      (m_updated ? uint32_t(CAM_UPDATED) : 0u);
+        }
+        m_updated = false;
+        return c;
+    }
+
+    // the locked buffer and its matrix offsets (nullptr while searching)
+    const void *lockedBuffer(uint32_t &viewOffset, uint32_t &projOffset) const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        viewOffset = m_match.viewOffset;
+        projOffset = m_match.projection.offset;
+        return m_lockedBuffer.load(std::memory_order_relaxed);
+    }
+
+private:
+    static size_t slotOf(const void *buffer)
+    {
+        uintptr_t p = reinterpret_cast<uintptr_t>(buffer);
+        return ((p >> 4) ^ (p >> 12)) & (BOUND_SLOTS - 1);
+    }
+
+    // a write to the locked buffer, skipped when another pass put something else there
+    void shadow(const void *data, size_t size)
+    {
+        const uint8_t *base = static_cast<const uint8_t *>(data);
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (size < m_lockedSize)
+            return;
+
+        float view[16], proj[16];
+        memcpy(view, base + m_match.viewOffset, sizeof(view));
+        memcpy(proj, base + m_match.projection.offset, sizeof(proj));
+        ProjectionMatch match = {};
+        if (!matchProjection(proj, m_aspect.load(std::memory_order_relaxed), match) ||
+            !matchView(view, m_match.projection.transposed))
+            return;
+        copy(base);
+    }
+
+    // caller holds m_lock
+    void copy(const uint8_t *base)
+    {
+        if (m_match.projection.transposed)
+        {
+            float m[16];
+            memcpy(m, base + m_match.viewOffset, sizeof(m));
+            transposeMatrix(m, m_camera.view);
+            memcpy(m, base + m_match.projection.offset, sizeof(m));
+            transposeMatrix(m, m_camera.projection);
+        }
+        else
+        {
+            memcpy(m_camera.view, base + m_match.viewOffset, sizeof(m_camera.view));
+            memcpy(m_camera.projection, base + m_match.projection.offset, sizeof(m_camera.projection));
+        }
+        m_writeFrame = m_frame;
+        m_have = true;
+        m_updated = true;
+    }
+
+    mutable std::mutex m_lock;
+    CameraMatch m_match = {};
+    CameraMatrices m_camera = {};
+    uint32_t m_lockedSize = 0; // the buffer's size when found, smaller writes can't hold both
+    uint64_t m_frame = 0;
+    uint64_t m_writeFrame = 0;
+    bool m_have = false;
+    bool m_updated = false;
+
+    std::atomic<const void *> m_lockedBuffer{nullptr};
+    std::atomic<const void *> m_bound[BOUND_SLOTS] = {};
+    std::atomic<uint32_t> m_scanned{0};
+    std::atomic<float> m_aspect{0.0f};
+};
@@ -0,0 +1,262 @@
+#pragma once
+
+// c++ includes
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <mutex>
+
+// layer event stream
+#include "LayerEvents.h"
+
+// NOTE: platform independent, shared by the layer (writer) and tools/dxpipe_replay (reader)
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// API call capture format
+//  <name>.dxcap       – CaptureHeader followed by fixed 32 byte CaptureRecords
+//  <name>.dxcap.blob  – out-of-line payloads (descs, UpdateSubresource data, Map writes)
+//  resources / views are identified by their handle (the pointer value while alive),
+//  a Create* record re-binds a handle, so reused addresses replay correctly
+///////////////////////////////////////////////////////////////////////////////////////////
+
+static const uint32_t CAPTURE_MAGIC = 0x50414358; // "XCAP"
+static const uint32_t CAPTURE_VERSION = 1;
+
+enum class CaptureOp : uint16_t
+{
+    // device
+    CreateTexture2D = 1, // handle = texture, blob = CaptureTextureDesc
+    CreateBuffer,        // handle = buffer,  blob = CaptureBufferDesc
+    CreateView,          // handle = view, arg = resource, a32 = CaptureViewType
+
+    // swap chain
+    GetBuffer,     // handle = back buffer, blob = CaptureTextureDesc
+    ResizeBuffers, // arg = width | height << 32, a32 = format
+    Present,       // arg = frame id, a32 = sync interval | flags << 16
+
+    // device (appended, older captures simply don't contain it)
+    CreateDepthStencilState, // handle = state, a32 = depth func | depth enable << 8
+
+    // context, one record per LayerEvent (op = ContextBase + EventKind)
+    ContextBase = 0x100,
+};
+
+enum CaptureViewType : uint32_t
+{
+    CaptureViewSRV,
+    CaptureViewRTV,
+    CaptureViewDSV,
+    CaptureViewUAV
+};
+
+struct CaptureHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t reserved;
+};
+
+struct CaptureRecord
+{
+    uint16_t op;
+    uint16_t context; // recorder id for context records
+    uint32_t a32;     // small argument (LayerEvent::arg2 for context records)
+    uint64_t handle;  // resource / view / state handle
+    uint64_t arg;
+    uint64_t blob; // blob offset, 0 = none (offset 0 holds a dummy word)
+};
+
+// portable mirrors of the d3d11 descs we need to rebuild resources
+struct CaptureTextureDesc
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t mipLevels;
+    uint32_t arraySize;
+    uint32_t format;
+    uint32_t sampleCount;
+    uint32_t sampleQuality;
+    uint32_t usage;
+    uint32_t bindFlags;
+    uint32_t cpuAccessFlags;
+    uint32_t miscFlags;
+};
+
+struct CaptureBufferDesc
+{
+    uint32_t byteWidth;
+    uint32_t usage;
+    uint32_t bindFlags;
+    uint32_t cpuAccessFlags;
+    uint32_t miscFlags;
+    uint32_t structureStride;
+};
+
+inline bool isContextOp(uint16_t op)
+{
+    return op >= uint16_t(CaptureOp::ContextBase) &&
+           op < uint16_t(CaptureOp::ContextBase) + uint16_t(EventKind::Count);
+}
+
+// writes the capture, safe to call from any thread (device calls come from worker threads)
+class CaptureWriter
+{
+public:
+    ~CaptureWriter() { close(); }
+
+    bool open(const char *path)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (m_records)
+            return true;
+
+        char blobPath[1024];
+        snprintf(blobPath, sizeof(blobPath), "%s.blob", path);
+        m_records = fopen(path, "wb");
+        m_blob = fopen(blobPath, "wb");
+        if (!m_records || !m_blob)
+        {
+            closeLocked();
+            return false;
+        }
+
+        // large buffers, the capture is written in frame sized bursts
+        setvbuf(m_records, nullptr, _IOFBF, 1 << 20);
+        setvbuf(m_blob, nullptr, _IOFBF, 4 << 20);
+
+        CaptureHeader h = {CAPTURE_MAGIC, CAPTURE_VERSION, sizeof(CaptureRecord), 0};
+        fwrite(&h, sizeof(h), 1, m_records);
+
+        // offset 0 means "no payload"
+        uint64_t dummy = 0;
+        fwrite(&dummy, sizeof(dummy), 1, m_blob);
+        m_blobSize = sizeof(dummy);
+        return true;
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        closeLocked();
+    }
+
+    bool isOpen() const { return m_records != nullptr; }
+
+    void write(const CaptureRecord &r)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (m_records)
+            fwrite(&r, sizeof(r), 1, m_records);
+    }
+
+    // append a payload, returns its offset in the blob stream (0 on failure)
+    uint64_t writeBlob(const void *data, size_t size)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (!m_blob || !data || !size)
+            return 0;
+        uint64_t offset = m_blobSize;
+        fwrite(data, 1, size, m_blob);
+        m_blobSize += size;
+        return offset;
+    }
+
+    // dump a finished frame: every context event followed by the Present marker
+    void writeFrame(const FrameTimeline &timeline, uint32_t syncInterval, uint32_t flags)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (!m_records)
+            return;
+
+        for (const LayerEvent &e : timeline.events)
+        {
+            CaptureRecord r = {uint16_t(uint16_t(CaptureOp::ContextBase) + uint16_t(e.kind)),
+                               e.context, e.arg2,
+                               uint64_t(reinterpret_cast<uintptr_t>(e.object)), e.arg, 0};
+            fwrite(&r, sizeof(r), 1, m_records);
+        }
+
+        CaptureRecord present = {uint16_t(CaptureOp::Present), 0, syncInterval | (flags << 16),
+                                 0, timeline.frame(), 0};
+        fwrite(&present, sizeof(present), 1, m_records);
+
+        // keep the files usable if the game is killed
+        fflush(m_records);
+        fflush(m_blob);
+    }
+
+private:
+    void closeLocked()
+    {
+        if (m_records)
+            fclose(m_records);
+        if (m_blob)
+            fclose(m_blob);
+        m_records = nullptr;
+        m_blob = nullptr;
+        m_blobSize = 0;
+    }
+
+    std::mutex m_lock;
+    FILE *m_records = nullptr;
+    FILE *m_blob = nullptr;
+    uint64_t m_blobSize = 0;
+};
+
+// loads a capture into memory for replay
+class CaptureReader
+{
+public:
+    bool open(const char *path)
+    {
+        std::string blobPath = std::string(path) + ".blob";
+        if (!readFile(path, m_raw) || !readFile(blobPath.c_str(), m_blob))
+            return false;
+        if (m_raw.size() < sizeof(CaptureHeader))
+            return false;
+
+        CaptureHeader h;
+        memcpy(&h, m_raw.data(), sizeof(h));
+        if (h.magic != CAPTURE_MAGIC || h.version != CAPTURE_VERSION ||
+            h.recordSize != sizeof(CaptureRecord))
+            return false;
+
+        size_t count = (m_raw.size() - sizeof(h)) / sizeof(CaptureRecord);
+        m_records.resize(count);
+        if (count)
+            memcpy(m_records.data(), m_raw.data() + sizeof(h), count * sizeof(CaptureRecord));
+        return true;
+    }
+
+    const std::vector<CaptureRecord> &records() const { return m_records; }
+
+    // payload view, nullptr if the offset / size is out of range
+    const uint8_t *blob(uint64_t offset, uint64_t size) const
+    {
+        if (!offset || offset + size > m_blob.size())
+            return nullptr;
+        return m_blob.data() + offset;
+    }
+
+private:
+    static bool readFile(const char *path, std::vector<uint8_t> &out)
+    {
+        FILE *f = fopen(path, "rb");
+        if (!f)
+            return false;
+        fseek(f, 0, SEEK_END);
+        long size = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        out.resize(size > 0 ? size_t(size) : 0);
+        size_t got = out.empty() ? 0 : fread(out.data(), 1, out.size(), f);
+        fclose(f);
+        return got == out.size();
+    }
+
+    std::vector<uint8_t> m_raw;
+    std::vector<uint8_t> m_blob;
+    std::vector<CaptureRecord> m_records;
+};
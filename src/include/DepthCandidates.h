@@ -0,0 +1,400 @@
+#pragma once
+
+// c++ includes
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <iterator>
+#include <atomic>
+
+// layer headers (platform independent)
+#include "LayerTypes.h"
+#include "LayerEvents.h"
+
+// NOTE: platform independent, fed by the proxies (ProxyDepth.h) or by tools/dxpipe_depth
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// depth buffer detection
+//  • every depth-capable texture is a candidate (depth formats or BIND_DEPTH_STENCIL)
+//  • DSVs map back to their texture, the frame's events say how each one was used
+//  • per frame score = draws + clears + binds, weighted by how much the texture looks
+//    like the scene depth (back buffer sized, single slice), smoothed over frames
+//  • the best candidate is promoted with hysteresis so one odd frame can't flip it
+//  • a preferred desc + creation ordinal (DepthProfile.h) promotes a texture the moment
+//    it is created, the scoring still replaces it if it turns out to be wrong
+///////////////////////////////////////////////////////////////////////////////////////////
+
+struct DepthTextureInfo
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t format;
+    uint32_t samples;
+    uint32_t arraySize;
+    uint32_t bindFlags;
+};
+
+struct DepthCandidate
+{
+    const void *texture;
+    DepthTextureInfo info;
+    uint32_t views;   // DSVs created for it
+    uint32_t draws;   // this frame: draws with one of its DSVs bound
+    uint32_t clears;  // this frame: ClearDepthStencilView calls
+    uint32_t binds;   // this frame: OMSetRenderTargets with one of its DSVs
+    float score;      // smoothed score
+    uint64_t lastUsed; // frame id of the last activity
+    uint32_t ordinal;  // textures with the same desc created before it since resetOrdinals
+    bool alive;
+};
+
+class DepthCandidates
+{
+public:
+    // tuning
+    static constexpr float WEIGHT_DRAW = 1.0f;
+    static constexpr float WEIGHT_CLEAR = 8.0f;
+    static constexpr float WEIGHT_BIND = 2.0f;
+    static constexpr float BONUS_VIEW = 4.0f;     // has a DSV at all
+    static constexpr float SIZE_EXACT = 4.0f;     // back buffer sized
+    static constexpr float SIZE_ASPECT = 2.0f;    // same aspect (render scale)
+    static constexpr float SIZE_OTHER = 0.25f;    // shadow maps, half res buffers
+    static constexpr float PENALTY_ARRAY = 0.25f; // cascades / cube maps
+    static constexpr float PENALTY_MSAA = 0.75f;  // still the scene, but needs a resolve
+    static constexpr float SMOOTHING = 0.2f;      // weight of the newest frame
+    static constexpr float MARGIN = 1.25f;        // a challenger has to beat the current by this
+    static constexpr uint32_t HOLD_FRAMES = 5;    // ... for this many frames in a row
+    static constexpr float MIN_SCORE = 1.0f;      // below this nothing is promoted
+
+    static bool isCandidate(const DepthTextureInfo &info)
+    {
+        return (info.bindFlags & BIND_DEPTH_STENCIL) || isDepthFormat(info.format);
+    }
+
+    static bool sameInfo(const DepthTextureInfo &a, const DepthTextureInfo &b)
+    {
+        return a.width == b.width && a.height == b.height && a.format == b.format &&
+               a.samples == b.samples && a.arraySize == b.arraySize && a.bindFlags == b.bindFlags;
+    }
+
+    // a texture was created (or a handle was reused), returns true if it is tracked
+    bool addTexture(const void *texture, const DepthTextureInfo &info)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        removeLocked(texture);
+        if (!texture || !isCandidate(info))
+            return false;
+
+        uint32_t ordinal = nextOrdinal(info);
+
+        uint32_t slot;
+        if (!m_free.empty())
+        {
+            slot = m_free.back();
+            m_free.pop_back();
+        }
+        else
+        {
+            slot = uint32_t(m_candidates.size());
+            m_candidates.push_back({});
+        }
+        m_candidates[slot] = {texture, info, 0, 0, 0, 0, 0.0f, 0, ordinal, true};
+        m_byTexture[texture] = slot;
+        m_epoch++;
+
+        if (m_hasPreferred && !m_preferredSeen && ordinal == m_preferredOrdinal && sameInfo(info, m_preferred))
+        {
+            m_preferredSeen = true;
+            promote(int32_t(slot));
+        }
+        return true;
+    }
+
+    // the swap chain was created / resized, ordinals count from here
+    void resetOrdinals()
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_ordinals.clear();
+        m_preferredSeen = false;
+    }
+
+    // promote the ordinal-th texture created with info as soon as it exists
+    void prefer(const DepthTextureInfo &info, uint32_t ordinal)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_preferred = info;
+        m_preferredOrdinal = ordinal;
+        m_hasPreferred = true;
+        m_preferredSeen = false;
+    }
+
+    void clearPreference()
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_hasPreferred = false;
+    }
+
+    // was the preferred texture created (and promoted) since the last resetOrdinals?
+    bool preferenceHit() const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_hasPreferred && m_preferredSeen;
+    }
+
+    // a DSV was created for a texture
+    void addView(const void *view, const void *texture)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        auto it = m_byTexture.find(texture);
+        if (!view || it == m_byTexture.end())
+        {
+            if (m_byView.erase(view))
+                m_epoch++;
+            return;
+        }
+        m_byView[view] = it->second;
+        m_candidates[it->second].views++;
+        m_epoch++;
+    }
+
+    // the texture is gone (or no longer interesting)
+    void removeTexture(const void *texture)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        removeLocked(texture);
+    }
+
+    // score the finished frame and return the promoted texture (nullptr = none yet)
+    const void *endFrame(const EventBuffer &events, uint64_t frame, uint32_t targetWidth, uint32_t targetHeight)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+
+        // usage of this frame, the bound DSV is tracked per context
+        int32_t boundImmediate = -1;
+        int32_t boundDeferred = -1;
+        uint16_t deferred = 0;
+        for (const LayerEvent &e : events)
+        {
+            // a deferred recording starts with nothing bound
+            if (e.context && e.context != deferred)
+            {
+                deferred = e.context;
+                boundDeferred = -1;
+            }
+            int32_t &bound = e.context ? boundDeferred : boundImmediate;
+
+            switch (e.kind)
+            {
+            case EventKind::SetRenderTargets:
+                bound = lookupView(e.object);
+                if (bound >= 0)
+                    m_candidates[bound].binds++;
+                break;
+            case EventKind::ClearDepthStencil:
+            {
+                int32_t c = lookupView(e.object);
+                if (c >= 0)
+                    m_candidates[c].clears++;
+                break;
+            }
+            case EventKind::Draw:
+            case EventKind::DrawIndexed:
+            case EventKind::DrawInstanced:
+            case EventKind::DrawIndexedInstanced:
+            case EventKind::DrawIndirect:
+                if (bound >= 0)
+                    m_candidates[bound].draws++;
+                break;
+            default:
+                break;
+            }
+        }
+
+        // score + pick the challenger among the candidates used this frame
+        int32_t best = -1;
+        for (uint32_t i = 0; i < m_candidates.size(); i++)
+        {
+            DepthCandidate &c = m_candidates[i];
+            if (!c.alive)
+                continue;
+
+            bool used = c.draws || c.clears || c.binds;
+            float frameScore = used ? frameScoreOf(c, targetWidth, targetHeight) : 0.0f;
+            c.score += (frameScore - c.score) * SMOOTHING;
+            if (used)
+                c.lastUsed = frame;
+            c.draws = c.clears = c.binds = 0;
+
+            if (used && (best < 0 || c.score > m_candidates[best].score))
+                best = int32_t(i);
+        }
+
+        // hysteresis
+        if (best < 0 || best == m_promoted)
+        {
+            m_streak = 0;
+        }
+        else if (m_promoted < 0)
+        {
+            if (m_candidates[best].score >= MIN_SCORE)
+                promote(best);
+        }
+        else if (m_candidates[best].score > m_candidates[m_promoted].score * MARGIN)
+        {
+            if (best != m_challenger)
+            {
+                m_challenger = best;
+                m_streak = 0;
+            }
+            if (++m_streak >= HOLD_FRAMES)
+                promote(best);
+        }
+        else
+        {
+            m_streak = 0;
+        }
+
+        return m_promoted >= 0 ? m_candidates[m_promoted].texture : nullptr;
+    }
+
+    const void *promoted() const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_promoted >= 0 ? m_candidates[m_promoted].texture : nullptr;
+    }
+
+    // the promoted candidate's description + creation ordinal (false if none)
+    bool promotedInfo(DepthTextureInfo &info, uint32_t *ordinal = nullptr) const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (m_promoted < 0)
+            return false;
+        info = m_candidates[m_promoted].info;
+        if (ordinal)
+            *ordinal = m_candidates[m_promoted].ordinal;
+        return true;
+    }
+
+    // the texture behind a DSV, nullptr if it is not a candidate
+    const void *textureOfView(const void *view) const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        auto it = m_byView.find(view);
+        return it != m_byView.end() ? m_candidates[it->second].texture : nullptr;
+    }
+
+    // changes whenever a view / texture mapping or the promotion changes,
+    // callers caching textureOfView results compare it instead of locking per call
+    uint32_t epoch() const { return m_epoch.load(std::memory_order_acquire); }
+
+    // copy of the candidate table, for tools / debugging
+    std::vector<DepthCandidate> snapshot() const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        std::vector<DepthCandidate> out;
+        for (const DepthCandidate &c : m_candidates)
+            if (c.alive)
+                out.push_back(c);
+        return out;
+    }
+
+private:
+    static float frameScoreOf(const DepthCandidate &c, uint32_t w, uint32_t h)
+    {
+        float score = c.draws * WEIGHT_DRAW + c.clears * WEIGHT_CLEAR + c.binds * WEIGHT_BIND;
+        if (c.views)
+            score += BONUS_VIEW;
+
+        if (c.info.width == w && c.info.height == h)
+            score *= SIZE_EXACT;
+        else if (w && h && sameAspect(c.info.width, c.info.height, w, h))
+            score *= SIZE_ASPECT;
+        else
+            score *= SIZE_OTHER;
+
+        if (c.info.arraySize > 1)
+            score *= PENALTY_ARRAY;
+        if (c.info.samples > 1)
+            score *= PENALTY_MSAA;
+        return score;
+    }
+
+    static bool sameAspect(uint32_t w0, uint32_t h0, uint32_t w1, uint32_t h1)
+    {
+        // w0/h0 == w1/h1 within 1%
+        uint64_t a = uint64_t(w0) * h1, b = uint64_t(w1) * h0;
+        uint64_t diff = a > b ? a - b : b - a;
+        return diff * 100 <= b;
+    }
+
+    uint32_t nextOrdinal(const DepthTextureInfo &info)
+    {
+        // few distinct descs per swap chain, a linear scan beats hashing six fields
+        for (OrdinalCount &o : m_ordinals)
+        {
+            if (sameInfo(o.info, info))
+                return o.count++;
+        }
+        m_ordinals.push_back({info, 1});
+        return 0;
+    }
+
+    int32_t lookupView(const void *view) const
+    {
+        if (!view)
+            return -1;
+        auto it = m_byView.find(view);
+        return it != m_byView.end() ? int32_t(it->second) : -1;
+    }
+
+    void promote(int32_t slot)
+    {
+        m_epoch++;
+        m_promoted = slot;
+        m_challenger = -1;
+        m_streak = 0;
+    }
+
+    void removeLocked(const void *texture)
+    {
+        auto it = m_byTexture.find(texture);
+        if (it == m_byTexture.end())
+            return;
+
+        uint32_t slot = it->second;
+        m_byTexture.erase(it);
+        for (auto v = m_byView.begin(); v != m_byView.end();)
+            v = v->second == slot ? m_byView.erase(v) : std::next(v);
+
+        m_candidates[slot].alive = false;
+        m_free.push_back(slot);
+        m_epoch++;
+        if (m_promoted == int32_t(slot))
+            m_promoted = -1;
+        if (m_challenger == int32_t(slot))
+            m_challenger = -1;
+    }
+
+    mutable std::mutex m_lock;
+    std::vector<DepthCandidate> m_candidates;
+    std::vector<uint32_t> m_free;
+    std::unordered_map<const void *, uint32_t> m_byTexture;
+    std::unordered_map<const void *, uint32_t> m_byView;
+    int32_t m_promoted = -1;
+    int32_t m_challenger = -1;
+    uint32_t m_streak = 0;
+    std::atomic<uint32_t> m_epoch{1};
+
+    // creation ordinals + the profile's preference
+    struct OrdinalCount
+    {
+        DepthTextureInfo info;
+        uint32_t count;
+    };
+    std::vector<OrdinalCount> m_ordinals;
+    DepthTextureInfo m_preferred = {};
+    uint32_t m_preferredOrdinal = 0;
+    bool m_hasPreferred = false;
+    bool m_preferredSeen = false;
+};
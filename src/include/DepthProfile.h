@@ -0,0 +1,240 @@
+#pragma once
+
+// c++ includes
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <atomic>
+
+// layer headers (platform independent)
+#include "DepthCandidates.h"
+#include "ProjectionInference.h"
+
+// NOTE: platform independent, the store works on any block of memory: the layer maps the
+// profile file (ProxyProfile.h), tools/dxpipe_depth reads it into a buffer
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// depth profile cache
+//  • one record per executable + back buffer size: which depth texture won (desc + its
+//    creation ordinal since the swap chain was created / resized) and the projection
+//  • the next launch hands the record to DepthCandidates::prefer, so the texture is
+//    promoted the moment it is created instead of after the scoring warm-up
+//  • a wrong record costs nothing extra, the scoring replaces the texture as usual and
+//    the record is rewritten with the new winner
+//  • DepthProfileHeader + DEPTH_PROFILE_SLOTS fixed records, a header that doesn't match
+//    (magic / version / sizes) resets the whole file, the least recently written record
+//    is replaced when the file is full
+//  • records carry a sequence number (odd while written), two games sharing the file
+//    never read a torn record
+///////////////////////////////////////////////////////////////////////////////////////////
+
+static const uint32_t DEPTH_PROFILE_MAGIC = 0x46505844; // "DXPF"
+static const uint32_t DEPTH_PROFILE_VERSION = 1;
+static const uint32_t DEPTH_PROFILE_SLOTS = 64;
+
+struct DepthProfileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t slots;
+    uint64_t generation; // bumped by every store, records keep the value they were written at
+    uint64_t reserved;
+};
+
+struct DepthProfile
+{
+    uint32_t sequence; // odd while being written
+    uint32_t uses;     // launches / resizes that looked the record up
+    uint64_t exe;      // depthProfileHash of the executable name, 0 = empty slot
+    uint32_t width;    // back buffer
+    uint32_t height;
+
+    // the promoted depth texture
+    uint32_t format;
+    uint32_t bindFlags;
+    uint32_t samples;
+    uint32_t arraySize;
+    uint32_t texWidth; // differs from width with a render scale
+    uint32_t texHeight;
+    uint32_t ordinal;  // DepthCandidates creation ordinal
+
+    // inferred projection (projFlags = 0 if none was known)
+    float nearPlane;
+    float farPlane;
+    float fovY;
+    uint32_t projFlags;
+
+    uint32_t reserved;
+    uint64_t generation; // header generation when written (LRU)
+};
+
+static_assert(sizeof(DepthProfileHeader) == 32, "profile header layout is part of the file format");
+static_assert(sizeof(DepthProfile) == 80, "profile record layout is part of the file format");
+
+// FNV-1a over the lower case name, stable across launches and builds
+inline uint64_t depthProfileHash(const char *name)
+{
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (; name && *name; name++)
+    {
+        char c = *name;
+        if (c >= 'A' && c <= 'Z')
+            c = char(c - 'A' + 'a');
+        h = (h ^ uint8_t(c)) * 0x100000001b3ull;
+    }
+    return h ? h : 1;
+}
+
+inline DepthTextureInfo depthProfileTexture(const DepthProfile &p)
+{
+    return {p.texWidth, p.texHeight, p.format, p.samples, p.arraySize, p.bindFlags};
+}
+
+inline DepthProjection depthProfileProjection(const DepthProfile &p)
+{
+    return {p.nearPlane, p.farPlane, p.fovY, p.projFlags, 0};
+}
+
+class DepthProfileStore
+{
+public:
+    static constexpr size_t bytes()
+    {
+        return sizeof(DepthProfileHeader) + sizeof(DepthProfile) * DEPTH_PROFILE_SLOTS;
+    }
+
+    // use base (at least bytes() long) as the store, returns false if it is too small
+    // a block that doesn't hold a store of this version is reset (reset() says so)
+    bool attach(void *base, size_t size)
+    {
+        m_header = nullptr;
+        m_records = nullptr;
+        m_reset = false;
+        if (!base || size < bytes())
+            return false;
+
+        m_header = static_cast<DepthProfileHeader *>(base);
+        m_records = reinterpret_cast<DepthProfile *>(m_header + 1);
+        if (m_header->magic != DEPTH_PROFILE_MAGIC || m_header->version != DEPTH_PROFILE_VERSION ||
+            m_header->recordSize != sizeof(DepthProfile) || m_header->slots != DEPTH_PROFILE_SLOTS)
+        {
+            memset(base, 0, bytes());
+            m_header->magic = DEPTH_PROFILE_MAGIC;
+            m_header->version = DEPTH_PROFILE_VERSION;
+            m_header->recordSize = sizeof(DepthProfile);
+            m_header->slots = DEPTH_PROFILE_SLOTS;
+            m_reset = true;
+        }
+        return true;
+    }
+
+    void detach()
+    {
+        m_header = nullptr;
+        m_records = nullptr;
+    }
+
+    bool attached() const { return m_header != nullptr; }
+    bool reset() const { return m_reset; }
+
+    // copy of the record for exe at width x height
+    bool find(uint64_t exe, uint32_t width, uint32_t height, DepthProfile &out) const
+    {
+        if (!m_header)
+            return false;
+        for (uint32_t i = 0; i < DEPTH_PROFILE_SLOTS; i++)
+        {
+            if (readRecord(i, out) && out.exe == exe && out.width == width && out.height == height)
+                return true;
+        }
+        return false;
+    }
+
+    // insert / replace the record with the same key
+    void store(const DepthProfile &p)
+    {
+        if (!m_header || !p.exe)
+            return;
+
+        // same key, else an empty slot, else the oldest record
+        int32_t slot = -1, empty = -1, oldest = -1;
+        uint64_t oldestGeneration = UINT64_MAX;
+        for (uint32_t i = 0; i < DEPTH_PROFILE_SLOTS; i++)
+        {
+            DepthProfile cur;
+            if (!readRecord(i, cur))
+                continue; // being written by another process, leave it alone
+            if (cur.exe == p.exe && cur.width == p.width && cur.height == p.height)
+            {
+                slot = int32_t(i);
+                break;
+            }
+            if (!cur.exe)
+            {
+                if (empty < 0)
+                    empty = int32_t(i);
+            }
+            else if (cur.generation < oldestGeneration)
+            {
+                oldestGeneration = cur.generation;
+                oldest = int32_t(i);
+            }
+        }
+        if (slot < 0)
+            slot = empty >= 0 ? empty : oldest;
+        if (slot < 0)
+            return;
+
+        DepthProfile &r = m_records[slot];
+        uint32_t seq = sequence(r).load(std::memory_order_relaxed);
+        if (seq & 1)
+            return;
+        if (!sequence(r).compare_exchange_strong(seq, seq + 1, std::memory_order_acquire))
+            return;
+        std::atomic_thread_fence(std::memory_order_release);
+
+        DepthProfile copy = p;
+        copy.generation = ++m_header->generation;
+        memcpy(reinterpret_cast<uint8_t *>(&r) + sizeof(uint32_t), reinterpret_cast<const uint8_t *>(&copy) + sizeof(uint32_t),
+               sizeof(DepthProfile) - sizeof(uint32_t));
+
+        sequence(r).store(seq + 2, std::memory_order_release);
+    }
+
+    // every stored record, for tools
+    uint32_t list(DepthProfile *out, uint32_t max) const
+    {
+        uint32_t n = 0;
+        for (uint32_t i = 0; m_header && i < DEPTH_PROFILE_SLOTS && n < max; i++)
+        {
+            if (readRecord(i, out[n]) && out[n].exe)
+                n++;
+        }
+        return n;
+    }
+
+private:
+    // the sequence word is the first member of the record
+    static std::atomic<uint32_t> &sequence(DepthProfile &r)
+    {
+        static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "sequence must overlay the record's first word");
+        return *reinterpret_cast<std::atomic<uint32_t> *>(&r.sequence);
+    }
+
+    // consistent copy of one record, false while it is being written
+    bool readRecord(uint32_t i, DepthProfile &out) const
+    {
+        DepthProfile &r = m_records[i];
+        uint32_t before = sequence(r).load(std::memory_order_acquire);
+        if (before & 1)
+            return false;
+        memcpy(&out, &r, sizeof(out));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return sequence(r).load(std::memory_order_relaxed) == before;
+    }
+
+    DepthProfileHeader *m_header = nullptr;
+    DepthProfile *m_records = nullptr;
+    bool m_reset = false;
+};
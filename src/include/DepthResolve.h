@@ -0,0 +1,102 @@
+#pragma once
+
+// c++ includes
+#include <cstdint>
+#include <cstring>
+
+// layer headers (platform independent)
+#include "LayerTypes.h"
+
+// NOTE: platform independent, the CPU reference of the depth resolve compute pass
+// (ProxyResolve.h), used by SoftDevice and tools/dxpipe_resolve
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// msaa depth resolve
+//  • a multisampled depth buffer can't be copied into the single-sample export targets
+//  • each texel is reduced to one R32F value: sample 0, the minimum or the maximum
+//  • depth formats are decoded the way an SRV of depthReadFormat() reads them
+///////////////////////////////////////////////////////////////////////////////////////////
+
+enum class DepthResolveMode : uint32_t
+{
+    Sample0, // what a non-msaa renderer would have written, cheapest
+    Min,     // closest surface with standard Z
+    Max,     // closest surface with reversed-Z
+    Count
+};
+
+inline const char *depthResolveModeName(DepthResolveMode mode)
+{
+    switch (mode)
+    {
+    case DepthResolveMode::Sample0:
+        return "sample0";
+    case DepthResolveMode::Min:
+        return "min";
+    case DepthResolveMode::Max:
+        return "max";
+    default:
+        return "?";
+    }
+}
+
+// depth of one sample stored in a depth format, 0 for formats without depth
+inline float decodeDepth(uint32_t fmt, const uint8_t *texel)
+{
+    switch (depthTypelessFormat(fmt))
+    {
+    case FMT_R32G8X24_TYPELESS: // depth is the first 32 bits
+    case FMT_R32_TYPELESS:
+    {
+        float d;
+        memcpy(&d, texel, sizeof(d));
+        return d;
+    }
+    case FMT_R24G8_TYPELESS: // 24 bit unorm in the low bits, stencil on top
+    {
+        uint32_t bits;
+        memcpy(&bits, texel, sizeof(bits));
+        return float(bits & 0xFFFFFFu) / 16777215.0f;
+    }
+    case FMT_R16_TYPELESS:
+    {
+        uint16_t bits;
+        memcpy(&bits, texel, sizeof(bits));
+        return float(bits) / 65535.0f;
+    }
+    default:
+        return 0.0f;
+    }
+}
+
+// one resolved texel, samples are stored back to back (formatSize bytes each)
+inline float resolveDepthTexel(const uint8_t *samples, uint32_t count, uint32_t fmt, DepthResolveMode mode)
+{
+    uint32_t stride = formatSize(fmt);
+    float d = decodeDepth(fmt, samples);
+    if (mode == DepthResolveMode::Sample0)
+        return d;
+
+    for (uint32_t s = 1; s < count; s++)
+    {
+        float v = decodeDepth(fmt, samples + s * stride);
+        if (mode == DepthResolveMode::Min ? v < d : v > d)
+            d = v;
+    }
+    return d;
+}
+
+// resolve a w x h msaa depth image into R32F (pitches in bytes)
+inline void resolveDepthCPU(const uint8_t *src, uint32_t srcPitch, uint32_t fmt, uint32_t samples,
+                            uint32_t width, uint32_t height, DepthResolveMode mode,
+                            uint8_t *dst, uint32_t dstPitch)
+{
+    uint32_t texel = formatSize(fmt) * samples;
+    for (uint32_t y = 0; y < height; y++)
+    {
+        const uint8_t *s = src + uint64_t(y) * srcPitch;
+        float *d = reinterpret_cast<float *>(dst + uint64_t(y) * dstPitch);
+        for (uint32_t x = 0; x < width; x++)
+            d[x] = resolveDepthTexel(s + uint64_t(x) * texel, samples, fmt, mode);
+    }
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+// c++ includes
+#include <cstdint>
+
+// NOTE: platform independent, driven by the immediate context (ProxyDepth.h)
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// depth span tracking
+//  • a span is the run of draws while the tracked depth buffer is bound
+//  • the span with the most draws in a frame is taken to be the scene
+//  • the scene depth is lost when the buffer is cleared or bound again for a later pass,
+//    so that is the moment to snapshot it, and only if the scene span is still live
+//  • at Present the snapshot is exported unless the buffer still holds the scene span
+///////////////////////////////////////////////////////////////////////////////////////////
+
+enum class DepthSource
+{
+    Live,     // the depth buffer itself (nothing overwrote the scene)
+    Snapshot  // the copy taken before the scene depth was destroyed
+};
+
+class DepthSpanTracker
+{
+public:
+    inline void onDraw()
+    {
+        if (m_bound)
+            m_spanDraws++;
+    }
+
+    // OMSetRenderTargets, returns true if the scene depth has to be copied right now
+    inline bool onBind(bool tracked)
+    {
+        bool copy = false;
+        if (m_bound && !tracked)
+            closeSpan();
+        else if (!m_bound && tracked)
+            copy = takeSnapshot(); // about to be reused by a later pass
+        m_bound = tracked;
+        return copy;
+    }
+
+    // ClearDepthStencilView, returns true if the scene depth has to be copied right now
+    inline bool onClear(bool tracked)
+    {
+        if (!tracked)
+            return false;
+        if (m_bound)
+            closeSpan();
+        return takeSnapshot();
+    }
+
+    // the tracked depth buffer changed (promotion, resize), nothing recorded so far applies
+    void reset()
+    {
+        m_bound = false;
+        m_spanDraws = 0;
+        m_bestDraws = 0;
+        m_liveIsBest = false;
+        m_haveSnapshot = false;
+    }
+
+    // which buffer holds the scene depth of the frame that is being presented
+    DepthSource endFrame()
+    {
+        if (m_bound)
+            closeSpan();
+
+        DepthSource source = (!m_liveIsBest && m_haveSnapshot) ? DepthSource::Snapshot : DepthSource::Live;
+
+        // the binding carries over into the next frame, the scores don't
+        m_bestDraws = 0;
+        m_liveIsBest = false;
+        m_haveSnapshot = false;
+        return source;
+    }
+
+    uint32_t bestDraws() const { return m_bestDraws; }
+
+private:
+    void closeSpan()
+    {
+        if (m_spanDraws > m_bestDraws)
+        {
+            m_bestDraws = m_spanDraws;
+            m_liveIsBest = true;
+        }
+        m_spanDraws = 0;
+    }
+
+    bool takeSnapshot()
+    {
+        if (!m_liveIsBest)
+            return false;
+        m_liveIsBest = false;
+        m_haveSnapshot = true;
+        return true;
+    }
+
+    bool m_bound = false;
+    uint32_t m_spanDraws = 0;
+    uint32_t m_bestDraws = 0;
+    bool m_liveIsBest = false;   // the buffer still holds the best span of the frame
+    bool m_haveSnapshot = false; // a copy of an earlier best span exists
+};
@@ -0,0 +1,212 @@
+#pragma once
+
+// c++ includes
+#include <cstdint>
+
+// windows / summaries of the latencies
+#include "FrameHistogram.h"
+
+// NOTE: platform independent, shared by the layer (ProxyStats.h samples DXGI, the primary's
+// transport sends the records over dxpipe_display), the stats page and tools/dxpipe_display
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// present to display
+//  • after every real Present of the primary the layer samples GetFrameStatistics (never
+//    blocks) and remembers the Present's count (GetLastPresentCount) with its frame id
+//  • a sample names the last Present that reached the screen and the vblank it did at;
+//    every frame up to it is resolved then, usually a frame or two after its Present
+//  • a frame resolved by a sample gets its vblank and time (exact when the sample's sync
+//    vblank is the frame's, else extrapolated with the measured refresh period); frames
+//    that went out between two samples are "unseen" (shown briefly or replaced)
+//  • queued = Presents ahead of the frame not on screen yet when it was presented,
+//    missed = vblanks the frame came later than its sync interval asked for
+//  • times are steady clock ns (the glue converts DXGI's QPC times)
+//  • one thread only (the primary's Present); the records ring is read on it too
+///////////////////////////////////////////////////////////////////////////////////////////
+
+static const uint32_t DISPLAY_PENDING = 64; // presented frames waiting for a sample
+static const uint32_t DISPLAY_RECORDS = 64; // resolved frames kept for the transport
+
+enum DisplayFlags : uint32_t
+{
+    DISPLAY_SHOWN = 1u << 0,     // displayNs / refresh are known
+    DISPLAY_ESTIMATED = 1u << 1, // displayNs extrapolated from a later vblank
+    DISPLAY_UNSEEN = 1u << 2,    // left the queue between two samples, no vblank known
+};
+
+// one presented frame of the primary (the dxpipe_display record, 48 bytes)
+struct FrameDisplay
+{
+    uint64_t frame;        // the layer's frame id (CameraMatrices, stats page)
+    uint64_t presentNs;    // the real Present was called
+    uint64_t displayNs;    // the vblank it went on screen at, 0 = unknown
+    uint32_t presentCount; // DXGI's count of that Present
+    uint32_t refresh;      // DXGI's count of that vblank, 0 = unknown
+    uint32_t queued;       // Presents ahead of it not on screen yet at its Present
+    uint32_t missed;       // vblanks later than its sync interval asked for
+    uint32_t inputUs;      // input age at its Present (InputLatency.h), 0 = no input
+    uint32_t flags;        // DisplayFlags
+};
+
+static_assert(sizeof(FrameDisplay) == 48, "the dxpipe_display record layout is fixed");
+
+// GetFrameStatistics, times converted to steady ns
+struct DisplaySample
+{
+    uint32_t presentCount;   // the last Present on screen
+    uint32_t presentRefresh; // the vblank it went on screen at
+    uint32_t syncRefresh;    // a recent vblank
+    uint64_t syncNs;         // and its time
+};
+
+class DisplayTracker
+{
+public:
+    // a GetFrameStatistics sample at nowNs, resolves the pending frames up to its Present;
+    // returns how many were resolved
+    uint32_t sample(const DisplaySample &s, uint64_t nowNs)
+    {
+        // the refresh period from two samples on different vblanks
+        if (m_syncNs && s.syncRefresh != m_syncRefresh && s.syncNs > m_syncNs)
+        {
+            uint32_t refreshes = s.syncRefresh - m_syncRefresh;
+            if (refreshes < 0x80000000u)
+                m_periodNs = (s.syncNs - m_syncNs) / refreshes;
+        }
+        m_syncRefresh = s.syncRefresh;
+        m_syncNs = s.syncNs;
+
+        if (m_shownCount && int32_t(s.presentCount - m_shownCount) <= 0)
+            return 0; // nothing new on screen
+        m_shownCount = s.presentCount;
+
+        uint32_t resolved = 0;
+        while (m_head != m_tail)
+        {
+            FrameDisplay &d = m_pending[m_head % DISPLAY_PENDING];
+            int32_t ahead = int32_t(d.presentCount - s.presentCount);
+            if (ahead > 0)
+                break;
+            if (ahead == 0)
+                show(d, s);
+            else
+                d.flags |= DISPLAY_UNSEEN;
+            resolve(d, nowNs);
+            m_head++;
+            resolved++;
+        }
+        return resolved;
+    }
+
+    // the primary's real Present at presentNs was DXGI's presentCount-th (sync interval,
+    // input age at it); sample() first, so queued is as fresh as it gets
+    void presented(uint64_t frame, uint64_t presentNs, uint32_t presentCount, uint32_t syncInterval, uint32_t inputUs)
+    {
+        if (m_tail - m_head == DISPLAY_PENDING) // no samples coming (windowed blt model), oldest goes
+            m_head++;
+
+        FrameDisplay &d = m_pending[m_tail % DISPLAY_PENDING];
+        d = FrameDisplay{};
+        d.frame = frame;
+        d.presentNs = presentNs;
+        d.presentCount = presentCount;
+        d.inputUs = inputUs;
+        int32_t queued = m_shownCount ? int32_t(presentCount - m_shownCount) - 1 : 0;
+        d.queued = queued > 0 ? uint32_t(queued) : 0;
+        m_interval[m_tail % DISPLAY_PENDING] = syncInterval ? syncInterval : 1;
+        m_queued = d.queued;
+        m_tail++;
+    }
+
+    // the statistics are disjoint (mode change, resize, DXGI_ERROR_FRAME_STATISTICS_DISJOINT):
+    // pending frames are dropped, vblank counts start over
+    void reset()
+    {
+        m_head = m_tail;
+        m_shownCount = 0;
+        m_syncRefresh = 0;
+        m_syncNs = 0;
+        m_last = FrameDisplay{};
+        m_resets++;
+    }
+
+    // resolved frames: records [resolved() - DISPLAY_RECORDS, resolved()) are kept
+    uint64_t resolved() const { return m_resolved; }
+    const FrameDisplay &record(uint64_t i) const { return m_records[i % DISPLAY_RECORDS]; }
+
+    // the last resolved frame that was shown
+    const FrameDisplay &last() const { return m_last; }
+
+    uint64_t periodNs() const { return m_periodNs; }
+    uint32_t queued() const { return m_queued; } // of the last presented()
+    uint64_t shown() const { return m_shown; }
+    uint64_t unseen() const { return m_unseen; }
+    uint64_t missed() const { return m_missed; } // vblanks
+    uint64_t resets() const { return m_resets; }
+
+    // present to display of the shown frames, input to display of those that had input
+    const FrameHistogram &latency() const { return m_latency; }
+    const FrameHistogram &inputLatency() const { return m_inputLatency; }
+
+private:
+    void show(FrameDisplay &d, const DisplaySample &s)
+    {
+        d.flags |= DISPLAY_SHOWN;
+        d.refresh = s.presentRefresh;
+        uint32_t behind = s.syncRefresh - s.presentRefresh; // the sync vblank is usually the frame's own
+        if (!behind)
+            d.displayNs = s.syncNs;
+        else if (m_periodNs && behind < 0x80000000u && uint64_t(behind) * m_periodNs < s.syncNs)
+        {
+            d.displayNs = s.syncNs - uint64_t(behind) * m_periodNs;
+            d.flags |= DISPLAY_ESTIMATED;
+        }
+
+        // late against the previous frame, if that one was shown and seen too
+        if (m_last.flags & DISPLAY_SHOWN && m_last.presentCount + 1 == d.presentCount)
+        {
+            uint32_t interval = m_interval[m_head % DISPLAY_PENDING];
+            uint32_t refreshes = d.refresh - m_last.refresh;
+            d.missed = refreshes > interval && refreshes < 0x80000000u ? refreshes - interval : 0;
+        }
+    }
+
+    void resolve(const FrameDisplay &d, uint64_t nowNs)
+    {
+        m_records[m_resolved % DISPLAY_RECORDS] = d;
+        m_resolved++;
+        if (!(d.flags & DISPLAY_SHOWN))
+        {
+            m_unseen++;
+            m_last = FrameDisplay{}; // the next frame's missed vblanks aren't known
+            return;
+        }
+        m_last = d;
+        m_shown++;
+        m_missed += d.missed;
+        if (d.displayNs > d.presentNs)
+        {
+            uint64_t us = (d.displayNs - d.presentNs) / 1000;
+            m_latency.add(uint32_t(us < FRAME_MAX_US ? us : FRAME_MAX_US), nowNs);
+            if (d.inputUs)
+                m_inputLatency.add(uint32_t(us + d.inputUs < FRAME_MAX_US ? us + d.inputUs : FRAME_MAX_US), nowNs);
+        }
+    }
+
+    FrameDisplay m_pending[DISPLAY_PENDING] = {};
+    uint32_t m_interval[DISPLAY_PENDING] = {}; // sync interval per pending frame (0 counts as 1)
+    uint64_t m_head = 0, m_tail = 0;
+
+    FrameDisplay m_records[DISPLAY_RECORDS] = {};
+    uint64_t m_resolved = 0;
+    FrameDisplay m_last = {};
+
+    uint32_t m_shownCount = 0; // present count of the last sample, 0 = none yet
+    uint32_t m_syncRefresh = 0;
+    uint64_t m_syncNs = 0;
+    uint64_t m_periodNs = 0;
+    uint32_t m_queued = 0;
+    uint64_t m_shown = 0, m_unseen = 0, m_missed = 0, m_resets = 0;
+
+    FrameHistogram m_latency, m_inputLatency;
+};
@@ -0,0 +1,224 @@
+#pragma once
+
+// c++ includes
+#include <cstdint>
+
+// layer headers (platform independent)
+#include "DepthResolve.h"
+#include "MotionVectors.h"
+
+// NOTE: platform independent, the same export code runs on the real device (D3D11Api in
+// ProxySwapChain.h) and on the software reference device (SoftApi in SoftDevice.h)
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// frame export (the copy half of ProxySwapChain::Present)
+//  • staging  – CPU-readable copy of the back buffer / depth (dumping, debugging)
+//  • shared   – GPU copy opened by the client through its shared handle
+//  • resolved – single-sample R32F depth of an msaa depth buffer, or of a single-sample one
+//               that isn't R32 (D24S8, D16, D32S8), exported instead of it
+//  • motion   – half resolution R16G16F camera motion reprojected from the exported depth
+//  • targets are (re)created when the source size or format changes, then copied
+//
+// Api provides
+//  Device / Context / Texture / Desc / Format / Handle  types
+//  UsageDefault, UsageStaging, BindShaderResource,
+//  BindUnorderedAccess, CpuAccessRead, MiscShared,
+//  FormatR32Float, FormatR16G16Float, NullHandle        constants
+//  ok(hr), release(tex), sharedHandle(tex, handle),
+//  resolveDepth(device, ctx, src, dst, mode),
+//  motionVectors(device, ctx, depth, dst, params)       helpers
+///////////////////////////////////////////////////////////////////////////////////////////
+
+enum class ExportResult
+{
+    Skipped,   // no source / device this frame
+    Copied,    // existing target refreshed
+    Recreated, // target (re)created, then refreshed
+    Failed     // target could not be created
+};
+
+template <class Api>
+inline bool exportNeedsTarget(typename Api::Texture *target, const typename Api::Desc &src, bool matchFormat)
+{
+    if (!target)
+        return true;
+
+    typename Api::Desc cur{};
+    target->GetDesc(&cur);
+    return cur.Width != src.Width ||
+           cur.Height != src.Height ||
+           (matchFormat && cur.Format != src.Format);
+}
+
+// copy src into a CPU-readable staging texture of the same format
+template <class Api>
+inline ExportResult exportStaging(typename Api::Device *device, typename Api::Context *ctx,
+                                  typename Api::Texture *src, typename Api::Texture *&staging)
+{
+    if (!src || !device)
+        return ExportResult::Skipped;
+
+    typename Api::Desc d{};
+    src->GetDesc(&d);
+
+    ExportResult result = ExportResult::Copied;
+    if (exportNeedsTarget<Api>(staging, d, true))
+    {
+        Api::release(staging);
+
+        d.BindFlags = 0;
+        d.Usage = Api::UsageStaging;
+        d.CPUAccessFlags = Api::CpuAccessRead;
+        d.MiscFlags = 0;
+        d.ArraySize = 1;
+        d.MipLevels = 1;
+
+        if (!Api::ok(device->CreateTexture2D(&d, nullptr, &staging)))
+        {
+            staging = nullptr;
+            return ExportResult::Failed;
+        }
+        result = ExportResult::Recreated;
+    }
+
+    if (ctx)
+        ctx->CopyResource(staging, src);
+    return result;
+}
+
+// copy src into a shareable texture of the given format, handle is reset on recreation
+template <class Api>
+inline ExportResult exportShared(typename Api::Device *device, typename Api::Context *ctx,
+                                 typename Api::Texture *src, typename Api::Format format,
+                                 typename Api::Texture *&shared, typename Api::Handle &handle)
+{
+    if (!src || !device)
+        return ExportResult::Skipped;
+
+    typename Api::Desc d{};
+    src->GetDesc(&d);
+
+    ExportResult result = ExportResult::Copied;
+    if (exportNeedsTarget<Api>(shared, d, false))
+    {
+        Api::release(shared);
+        handle = Api::NullHandle;
+
+        typename Api::Desc sd{};
+        sd.Width = d.Width;
+        sd.Height = d.Height;
+        sd.MipLevels = 1;
+        sd.ArraySize = 1;
+        sd.Format = format;
+        sd.SampleDesc.Count = 1;                  // no MSAA
+        sd.SampleDesc.Quality = 0;                // no MSAA quality
+        sd.Usage = Api::UsageDefault;             // GPU usage
+        sd.BindFlags = Api::BindShaderResource;   // minimal bind flags for sharing
+        sd.MiscFlags = Api::MiscShared;           // basic sharing without keyed mutex
+
+        if (!Api::ok(device->CreateTexture2D(&sd, nullptr, &shared)))
+        {
+            shared = nullptr;
+            return ExportResult::Failed;
+        }
+
+        // a texture without a handle is still copied, the client just can't open it
+        if (!Api::sharedHandle(shared, handle))
+            handle = Api::NullHandle;
+        result = ExportResult::Recreated;
+    }
+
+    if (ctx)
+        ctx->CopyResource(shared, src);
+    return result;
+}
+
+// resolve an msaa depth buffer into a single-sample R32F texture (one compute pass)
+// Skipped for single-sample sources, those are exported as they are
+template <class Api>
+inline ExportResult exportResolvedDepth(typename Api::Device *device, typename Api::Context *ctx,
+                                        typename Api::Texture *src, DepthResolveMode mode,
+                                        typename Api::Texture *&resolved)
+{
+    if (!src || !device)
+        return ExportResult::Skipped;
+
+    // single-sample R32 depth is copied into the export targets as it is
+    typename Api::Desc d{};
+    src->GetDesc(&d);
+    uint32_t family = depthTypelessFormat(uint32_t(d.Format));
+    if (d.SampleDesc.Count <= 1 && family == FMT_R32_TYPELESS)
+        return ExportResult::Skipped;
+    if (family == FMT_UNKNOWN)
+        return ExportResult::Failed;
+
+    ExportResult result = ExportResult::Copied;
+    if (exportNeedsTarget<Api>(resolved, d, false))
+    {
+        Api::release(resolved);
+
+        typename Api::Desc rd{};
+        rd.Width = d.Width;
+        rd.Height = d.Height;
+        rd.MipLevels = 1;
+        rd.ArraySize = 1;
+        rd.Format = Api::FormatR32Float;
+        rd.SampleDesc.Count = 1;
+        rd.Usage = Api::UsageDefault;
+        rd.BindFlags = Api::BindShaderResource | Api::BindUnorderedAccess;
+
+        if (!Api::ok(device->CreateTexture2D(&rd, nullptr, &resolved)))
+        {
+            resolved = nullptr;
+            return ExportResult::Failed;
+        }
+        result = ExportResult::Recreated;
+    }
+
+    if (!Api::resolveDepth(device, ctx, src, resolved, mode))
+        return ExportResult::Failed;
+    return result;
+}
+
+// camera motion of a single-sample depth texture into a half size R16G16F texture (one
+// compute pass), params from motionReprojection of the last and this frame's camera
+template <class Api>
+inline ExportResult exportMotionVectors(typename Api::Device *device, typename Api::Context *ctx,
+                                        typename Api::Texture *depth, const MotionParams &params,
+                                        typename Api::Texture *&motion)
+{
+    if (!depth || !device)
+        return ExportResult::Skipped;
+
+    typename Api::Desc d{};
+    depth->GetDesc(&d);
+    d.Width = motionExtent(d.Width);
+    d.Height = motionExtent(d.Height);
+
+    ExportResult result = ExportResult::Copied;
+    if (exportNeedsTarget<Api>(motion, d, false))
+    {
+        Api::release(motion);
+
+        typename Api::Desc md{};
+        md.Width = d.Width;
+        md.Height = d.Height;
+        md.MipLevels = 1;
+        md.ArraySize = 1;
+        md.Format = Api::FormatR16G16Float;
+        md.SampleDesc.Count = 1;
+        md.Usage = Api::UsageDefault;
+        md.BindFlags = Api::BindShaderResource | Api::BindUnorderedAccess;
+
+        if (!Api::ok(device->CreateTexture2D(&md, nullptr, &motion)))
+        {
+            motion = nullptr;
+            return ExportResult::Failed;
+        }
+        result = ExportResult::Recreated;
+    }
+
+    if (!Api::motionVectors(device, ctx, depth, motion, params))
+        return ExportResult::Failed;
+    return result;
+}
@@ -0,0 +1,451 @@
+#pragma once
+
+// c++ includes
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <atomic>
+#include <algorithm>
+#include <type_traits>
+
+// bit scan
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// NOTE: platform independent, shared by the layer (StatsWriter, the overlay), the stats
+// page (FrameTimeFields) and tools/dxpipe_frametime (bench / selftest)
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// frame time histogram
+//  • Present to Present intervals in us, log-linear buckets: exact below 128 us, then 64
+//    buckets per power of two (<= 1.6 % wide) up to ~67 s, longer intervals are clamped
+//  • time is cut into 1 s slices (a ring of the last 60), each window (1 s, 10 s, 60 s)
+//    keeps the sum of its slices plus the current one, so a window covers its length and
+//    the running second; a slice leaving a window is subtracted, nothing is ever re-sorted
+//  • a summary walks each window once up (percentiles) and once down (lows), skipping
+//    empty octaves by their totals
+//  • a hitch is an interval over HITCH_FACTOR x the 10 s median (and HITCH_MIN_US), the
+//    median of the last summary, so a hitch can't raise its own threshold
+//  • record() runs on one thread (the primary's Present); every SUMMARY_MS it summarises
+//    the windows (percentiles, lows, hitches) and publishes them under a sequence number,
+//    read() copies them from any thread without a lock
+///////////////////////////////////////////////////////////////////////////////////////////
+
+static const uint32_t FRAME_SUB_BITS = 6;                  // 64 buckets per power of two
+static const uint32_t FRAME_SUB = 1u << FRAME_SUB_BITS;
+static const uint32_t FRAME_RANGE_BITS = 26;               // intervals up to 2^26 us (~67 s)
+static const uint32_t FRAME_MAX_US = (1u << FRAME_RANGE_BITS) - 1;
+static const uint32_t FRAME_OCTAVES = FRAME_RANGE_BITS - FRAME_SUB_BITS + 1; // FRAME_SUB buckets each
+static const uint32_t FRAME_BUCKETS = FRAME_OCTAVES * FRAME_SUB;
+static const uint32_t FRAME_SLICE_MS = 1000;
+static const uint32_t FRAME_WINDOWS = 3;
+static const uint32_t FRAME_WINDOW_SLICES[FRAME_WINDOWS] = {1, 10, 60}; // plus the running one
+static const uint32_t FRAME_RING = 61;                     // the longest window + the running slice
+
+enum class FrameWindow : uint32_t
+{
+    Second,
+    TenSeconds,
+    Minute
+};
+
+inline const char *frameWindowName(uint32_t window)
+{
+    static const char *names[FRAME_WINDOWS] = {"1 s", "10 s", "60 s"};
+    return window < FRAME_WINDOWS ? names[window] : "?";
+}
+
+inline uint32_t frameMsb(uint32_t v) // v != 0
+{
+#if defined(_MSC_VER)
+    unsigned long i;
+    _BitScanReverse(&i, v);
+    return uint32_t(i);
+#else
+    return 31u - uint32_t(__builtin_clz(v));
+#endif
+}
+
+// bucket of an interval: the value itself below 2 * FRAME_SUB, then (octave, top 6 bits)
+inline uint32_t frameBucket(uint32_t us)
+{
+    us = std::min(us, FRAME_MAX_US);
+    if (us < 2 * FRAME_SUB)
+        return us;
+    uint32_t shift = frameMsb(us) - FRAME_SUB_BITS;
+    return (shift << FRAME_SUB_BITS) + (us >> shift);
+}
+
+// smallest interval of a bucket / its width
+inline uint32_t frameBucketLow(uint32_t bucket)
+{
+    if (bucket < 2 * FRAME_SUB)
+        return bucket;
+    uint32_t shift = (bucket >> FRAME_SUB_BITS) - 1;
+    return ((bucket & (FRAME_SUB - 1)) | FRAME_SUB) << shift;
+}
+
+inline uint32_t frameBucketWidth(uint32_t bucket)
+{
+    return bucket < 2 * FRAME_SUB ? 1u : 1u << ((bucket >> FRAME_SUB_BITS) - 1);
+}
+
+// one window, all in us (0 with no frames); fps = 1e6 / us
+struct FrameTimeSummary
+{
+    uint32_t frames;
+    uint32_t hitches;
+    uint32_t meanUs;  // window time / frames (the average fps)
+    uint32_t p50Us;
+    uint32_t p99Us;
+    uint32_t p999Us;
+    uint32_t maxUs;   // exact
+    uint32_t low1Us;  // mean of the slowest 1 % of the frames (the "1 % low")
+    uint32_t low01Us; // mean of the slowest 0.1 %
+};
+
+// the same as atomics, in the histogram's published copy and in the stats page
+struct FrameTimeFields
+{
+    std::atomic<uint32_t> frames;
+    std::atomic<uint32_t> hitches;
+    std::atomic<uint32_t> meanUs;
+    std::atomic<uint32_t> p50Us;
+    std::atomic<uint32_t> p99Us;
+    std::atomic<uint32_t> p999Us;
+    std::atomic<uint32_t> maxUs;
+    std::atomic<uint32_t> low1Us;
+    std::atomic<uint32_t> low01Us;
+
+    void store(const FrameTimeSummary &s, std::memory_order order)
+    {
+        frames.store(s.frames, order);
+        hitches.store(s.hitches, order);
+        meanUs.store(s.meanUs, order);
+        p50Us.store(s.p50Us, order);
+        p99Us.store(s.p99Us, order);
+        p999Us.store(s.p999Us, order);
+        maxUs.store(s.maxUs, order);
+        low1Us.store(s.low1Us, order);
+        low01Us.store(s.low01Us, order);
+    }
+
+    void load(FrameTimeSummary &s, std::memory_order order) const
+    {
+        s.frames = frames.load(order);
+        s.hitches = hitches.load(order);
+        s.meanUs = meanUs.load(order);
+        s.p50Us = p50Us.load(order);
+        s.p99Us = p99Us.load(order);
+        s.p999Us = p999Us.load(order);
+        s.maxUs = maxUs.load(order);
+        s.low1Us = low1Us.load(order);
+        s.low01Us = low01Us.load(order);
+    }
+};
+
+static_assert(std::is_standard_layout<FrameTimeFields>::value, "part of the stats page");
+
+class FrameHistogram
+{
+public:
+    static const uint32_t SUMMARY_MS = 100;       // how often record() publishes
+    static constexpr double HITCH_FACTOR = 2.0;   // x the 10 s median
+    static const uint32_t HITCH_MIN_US = 8000;    // shorter intervals are never hitches
+    static const uint32_t HITCH_MIN_FRAMES = 30;  // a median worth comparing against
+
+    // one Present at nowNs (steady clock), true if its interval was a hitch
+    bool record(uint64_t nowNs)
+    {
+        if (!m_startNs)
+        {
+            m_startNs = m_lastNs = m_summaryNs = nowNs;
+            return false;
+        }
+        if (nowNs <= m_lastNs)
+            return false;
+        uint32_t us = uint32_t(std::min<uint64_t>((nowNs - m_lastNs) / 1000, FRAME_MAX_US));
+        m_lastNs = nowNs;
+        return add(us, nowNs);
+    }
+
+    // any other duration (us) measured at nowNs, same windows / summaries (InputLatency.h);
+    // one histogram takes either record() or add()
+    bool add(uint32_t us, uint64_t nowNs)
+    {
+        if (!m_startNs)
+            m_startNs = m_lastNs = m_summaryNs = nowNs;
+        if (nowNs < m_summaryNs)
+            return false;
+        us = std::min(us, FRAME_MAX_US);
+        m_lastUs = us;
+
+        advance((nowNs - m_startNs) / (uint64_t(FRAME_SLICE_MS) * 1000000));
+        uint32_t median = m_last[uint32_t(FrameWindow::TenSeconds)].p50Us;
+        bool hitch = m_last[uint32_t(FrameWindow::TenSeconds)].frames >= HITCH_MIN_FRAMES && us >= HITCH_MIN_US &&
+                     double(us) > HITCH_FACTOR * double(median);
+
+        uint32_t b = frameBucket(us);
+        Slice &s = m_slices[m_slice % FRAME_RING];
+        s.counts[b]++;
+        s.frames++;
+        s.sumUs += us;
+        s.maxUs = std::max(s.maxUs, us);
+        s.hitches += hitch ? 1 : 0;
+        for (Window &w : m_windows)
+        {
+            w.counts[b]++;
+            w.octaves[b >> FRAME_SUB_BITS]++;
+            w.frames++;
+            w.sumUs += us;
+            w.hitches += hitch ? 1 : 0;
+        }
+        m_frames++;
+        m_hitches += hitch ? 1 : 0;
+
+        if (nowNs - m_summaryNs >= uint64_t(SUMMARY_MS) * 1000000)
+        {
+            m_summaryNs = nowNs;
+            summarize();
+        }
+        return hitch;
+    }
+
+    // nothing to add at nowNs, the windows still move on (and are summarised when due), so
+    // add()'s windows empty out while nothing comes in
+    void idle(uint64_t nowNs)
+    {
+        if (!m_startNs || nowNs < m_summaryNs)
+            return;
+        advance((nowNs - m_startNs) / (uint64_t(FRAME_SLICE_MS) * 1000000));
+        if (nowNs - m_summaryNs >= uint64_t(SUMMARY_MS) * 1000000)
+        {
+            m_summaryNs = nowNs;
+            summarize();
+        }
+    }
+
+    // summarises the windows now (record() does every SUMMARY_MS)
+    void summarize()
+    {
+        for (uint32_t w = 0; w < FRAME_WINDOWS; w++)
+            m_last[w] = summary(w);
+
+        uint32_t seq = m_sequence.load(std::memory_order_relaxed);
+        m_sequence.store(seq + 1, std::memory_order_relaxed);
+        const auto r = std::memory_order_release; // each store publishes the odd sequence before it
+        for (uint32_t w = 0; w < FRAME_WINDOWS; w++)
+            m_published[w].store(m_last[w], r);
+        m_publishedFrames.store(m_frames, r);
+        m_publishedHitches.store(m_hitches, r);
+        m_sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    // the last published summaries, any thread; false if none yet (or the writer kept
+    // publishing while we read, next time then)
+    bool read(FrameTimeSummary out[FRAME_WINDOWS], uint64_t *frames = nullptr, uint64_t *hitches = nullptr) const
+    {
+        for (int attempt = 0; attempt < 16; attempt++)
+        {
+            uint32_t begin = m_sequence.load(std::memory_order_acquire);
+            if (!begin)
+                return false;
+            if (begin & 1)
+                continue;
+
+            const auto r = std::memory_order_acquire;
+            for (uint32_t w = 0; w < FRAME_WINDOWS; w++)
+                m_published[w].load(out[w], r);
+            uint64_t f = m_publishedFrames.load(r), h = m_publishedHitches.load(r);
+
+            if (m_sequence.load(std::memory_order_relaxed) == begin)
+            {
+                if (frames)
+                    *frames = f;
+                if (hitches)
+                    *hitches = h;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // publish count, changes whenever read() would return something new
+    uint32_t version() const { return m_sequence.load(std::memory_order_acquire); }
+
+    // the writer's own copy of the last summary and totals (record()'s thread only)
+    const FrameTimeSummary &last(FrameWindow window) const { return m_last[uint32_t(window)]; }
+    uint64_t frames() const { return m_frames; }
+    uint64_t hitches() const { return m_hitches; }
+    uint32_t lastUs() const { return m_lastUs; } // the last interval / value taken
+
+private:
+    struct Slice
+    {
+        uint32_t counts[FRAME_BUCKETS];
+        uint32_t frames;
+        uint32_t hitches;
+        uint32_t maxUs;
+        uint64_t sumUs;
+    };
+
+    struct Window
+    {
+        uint32_t counts[FRAME_BUCKETS];
+        uint32_t octaves[FRAME_OCTAVES]; // sums of counts, FRAME_SUB buckets each
+        uint32_t frames;
+        uint32_t hitches;
+        uint64_t sumUs;
+    };
+
+    // the running slice becomes `slice`, the ones in between stay empty (a pause)
+    void advance(uint64_t slice)
+    {
+        if (slice <= m_slice)
+            return;
+        if (slice - m_slice >= FRAME_RING) // everything has left every window
+        {
+            memset(m_slices, 0, sizeof(m_slices));
+            memset(m_windows, 0, sizeof(m_windows));
+            m_slice = slice;
+            return;
+        }
+        while (m_slice < slice)
+        {
+            m_slice++;
+            for (uint32_t w = 0; w < FRAME_WINDOWS; w++)
+            {
+                if (m_slice < FRAME_WINDOW_SLICES[w] + 1)
+                    continue;
+                const Slice &old = m_slices[(m_slice - FRAME_WINDOW_SLICES[w] - 1) % FRAME_RING];
+                Window &win = m_windows[w];
+                if (!old.frames)
+                    continue;
+                for (uint32_t b = 0; b < FRAME_BUCKETS; b++)
+                {
+                    win.counts[b] -= old.counts[b];
+                    win.octaves[b >> FRAME_SUB_BITS] -= old.counts[b];
+                }
+                win.frames -= old.frames;
+                win.hitches -= old.hitches;
+                win.sumUs -= old.sumUs;
+            }
+            // the slot the longest window just let go of
+            memset(&m_slices[m_slice % FRAME_RING], 0, sizeof(Slice));
+        }
+    }
+
+    FrameTimeSummary summary(uint32_t w) const
+    {
+        const Window &win = m_windows[w];
+        FrameTimeSummary s = {};
+        if (!win.frames)
+            return s;
+
+        // exact maximum from the slices still in the window
+        uint64_t first = m_slice >= FRAME_WINDOW_SLICES[w] ? m_slice - FRAME_WINDOW_SLICES[w] : 0;
+        for (uint64_t i = first; i <= m_slice; i++)
+            s.maxUs = std::max(s.maxUs, m_slices[i % FRAME_RING].maxUs);
+
+        s.frames = win.frames;
+        s.hitches = win.hitches;
+        s.meanUs = uint32_t(win.sumUs / win.frames);
+
+        static const double quantiles[3] = {0.5, 0.99, 0.999};
+        uint32_t p[3];
+        percentiles(win, quantiles, p, 3, s.maxUs);
+        s.p50Us = p[0];
+        s.p99Us = p[1];
+        s.p999Us = p[2];
+
+        static const double fractions[2] = {0.001, 0.01};
+        uint32_t low[2];
+        slowest(win, fractions, low, 2, s.maxUs);
+        s.low01Us = low[0];
+        s.low1Us = low[1];
+        return s;
+    }
+
+    // ceil(q * frames), at least the first
+    static uint64_t rank(double q, uint32_t frames)
+    {
+        return std::max<uint64_t>(1, uint64_t(std::ceil(q * double(frames))));
+    }
+
+    // middle of a bucket, never past the window's (exact) maximum
+    static uint32_t bucketValue(uint32_t b, uint32_t maxUs)
+    {
+        return std::min(frameBucketLow(b) + frameBucketWidth(b) / 2, maxUs);
+    }
+
+    // the intervals at rank(q[i]) for ascending q, one walk up
+    static void percentiles(const Window &win, const double *q, uint32_t *out, uint32_t n, uint32_t maxUs)
+    {
+        uint32_t i = 0;
+        uint64_t seen = 0;
+        for (uint32_t o = 0; o < FRAME_OCTAVES && i < n; o++)
+        {
+            if (seen + win.octaves[o] < rank(q[i], win.frames))
+            {
+                seen += win.octaves[o];
+                continue;
+            }
+            for (uint32_t b = o * FRAME_SUB; b < (o + 1) * FRAME_SUB && i < n; b++)
+            {
+                seen += win.counts[b];
+                while (i < n && seen >= rank(q[i], win.frames))
+                    out[i++] = bucketValue(b, maxUs);
+            }
+        }
+        while (i < n)
+            out[i++] = maxUs;
+    }
+
+    // mean of the slowest rank(fraction[i]) intervals for ascending fractions, one walk down
+    static void slowest(const Window &win, const double *fraction, uint32_t *out, uint32_t n, uint32_t maxUs)
+    {
+        uint32_t i = 0;
+        uint64_t taken = 0, sum = 0;
+        for (uint32_t o = FRAME_OCTAVES; o-- > 0 && i < n;)
+        {
+            if (!win.octaves[o])
+                continue;
+            for (uint32_t b = (o + 1) * FRAME_SUB; b-- > o * FRAME_SUB && i < n;)
+            {
+                uint64_t count = win.counts[b];
+                uint64_t value = bucketValue(b, maxUs);
+                // the rest of a wanted rank comes from this bucket
+                while (i < n)
+                {
+                    uint64_t want = rank(fraction[i], win.frames);
+                    if (taken + count < want)
+                        break;
+                    out[i++] = uint32_t((sum + (want - taken) * value) / want);
+                }
+                sum += count * value;
+                taken += count;
+            }
+        }
+        while (i < n)
+            out[i++] = maxUs;
+    }
+
+    // record()'s thread only
+    Slice m_slices[FRAME_RING] = {};
+    Window m_windows[FRAME_WINDOWS] = {};
+    FrameTimeSummary m_last[FRAME_WINDOWS] = {};
+    uint64_t m_slice = 0;    // running slice, counted from the first Present
+    uint64_t m_startNs = 0;
+    uint64_t m_lastNs = 0;
+    uint32_t m_lastUs = 0;
+    uint64_t m_summaryNs = 0;
+    uint64_t m_frames = 0;
+    uint64_t m_hitches = 0;
+
+    // published, any thread
+    std::atomic<uint32_t> m_sequence{0}; // 0 = nothing published yet, odd = publishing
+    FrameTimeFields m_published[FRAME_WINDOWS] = {};
+    std::atomic<uint64_t> m_publishedFrames{0};
+    std::atomic<uint64_t> m_publishedHitches{0};
+};
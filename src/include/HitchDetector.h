@@ -0,0 +1,94 @@
+#pragma once
+
+// c++ includes
+#include <cstdint>
+#include <atomic>
+#include <algorithm>
+
+// the 10 s median, the hitch floor
+#include "FrameHistogram.h"
+
+// NOTE: platform independent, shared by the layer (ProxyStats.h asks it after every primary
+// Present, g_Trace writes the snapshots) and tools/dxpipe_trace (--hitch)
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// hitch snapshots
+//  • a frame is a hitch when it takes longer than a fixed limit (0 = off) or factor x the
+//    10 s median (0 = off, needs FrameHistogram::HITCH_MIN_FRAMES frames and is never
+//    below HITCH_MIN_US), the lower of the two when both are set
+//  • a hitch asks TraceLog's flight recorder for a snapshot: the last FLIGHT_SECONDS of
+//    Present phases, pipe writes, resizes, copies and census counts, written by the trace
+//    writer thread, never the game's
+//  • after a snapshot the detector cools down (a loading screen is one snapshot, not a
+//    hundred) and it stops after maxSnapshots per session so the disk doesn't fill up
+//  • check() / taken() on one thread (the primary's Present), the settings from any
+///////////////////////////////////////////////////////////////////////////////////////////
+
+class HitchDetector
+{
+public:
+    static const uint32_t FLIGHT_SECONDS = 5;    // what a snapshot covers
+    static constexpr float DEFAULT_FACTOR = 3.0f; // x the 10 s median
+    static const uint32_t COOLDOWN_MS = 10000;   // after a snapshot
+    static const uint32_t MAX_SNAPSHOTS = 16;    // per session
+
+    // the frame that just ended took frameUs (at nowNs, steady clock), tenSeconds is the
+    // frame times' last 10 s summary: the limit in us it broke if a snapshot is due, else 0
+    uint32_t check(uint32_t frameUs, const FrameTimeSummary &tenSeconds, uint64_t nowNs)
+    {
+        uint32_t limit = limitUs(tenSeconds);
+        if (!limit || frameUs <= limit)
+            return 0;
+        m_hitches.fetch_add(1, std::memory_order_relaxed);
+        uint64_t cooldownNs = uint64_t(m_cooldownMs.load(std::memory_order_relaxed)) * 1000000;
+        if (m_snapshots.load(std::memory_order_relaxed) >= m_maxSnapshots.load(std::memory_order_relaxed) ||
+            (m_lastNs && nowNs - m_lastNs < cooldownNs))
+            return 0;
+        return limit;
+    }
+
+    // the snapshot check() asked for was taken at nowNs (the recorder may refuse one)
+    void taken(uint64_t frame, uint64_t nowNs)
+    {
+        m_lastNs = nowNs;
+        m_lastFrame.store(frame, std::memory_order_relaxed);
+        m_snapshots.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // the limit a frame has to break right now, 0 = none (off, or no median yet)
+    uint32_t limitUs(const FrameTimeSummary &tenSeconds) const
+    {
+        uint32_t limit = m_thresholdUs.load(std::memory_order_relaxed);
+        float factor = m_factor.load(std::memory_order_relaxed);
+        if (factor > 0.0f && tenSeconds.frames >= FrameHistogram::HITCH_MIN_FRAMES)
+        {
+            double relative = std::max(double(factor) * double(tenSeconds.p50Us), double(FrameHistogram::HITCH_MIN_US));
+            uint32_t us = uint32_t(std::min(relative, double(FRAME_MAX_US)));
+            limit = limit ? std::min(limit, us) : us;
+        }
+        return limit;
+    }
+
+    void setThresholdUs(uint32_t us) { m_thresholdUs.store(us, std::memory_order_relaxed); }
+    void setFactor(float factor) { m_factor.store(factor, std::memory_order_relaxed); }
+    void setCooldownMs(uint32_t ms) { m_cooldownMs.store(ms, std::memory_order_relaxed); }
+    void setMaxSnapshots(uint32_t n) { m_maxSnapshots.store(n, std::memory_order_relaxed); }
+    uint32_t thresholdUs() const { return m_thresholdUs.load(std::memory_order_relaxed); }
+    float factor() const { return m_factor.load(std::memory_order_relaxed); }
+    uint32_t maxSnapshots() const { return m_maxSnapshots.load(std::memory_order_relaxed); }
+
+    uint64_t hitches() const { return m_hitches.load(std::memory_order_relaxed); } // over the limit
+    uint64_t snapshots() const { return m_snapshots.load(std::memory_order_relaxed); }
+    uint64_t lastFrame() const { return m_lastFrame.load(std::memory_order_relaxed); } // of the last snapshot
+
+private:
+    std::atomic<uint32_t> m_thresholdUs{0};
+    std::atomic<float> m_factor{DEFAULT_FACTOR};
+    std::atomic<uint32_t> m_cooldownMs{COOLDOWN_MS};
+    std::atomic<uint32_t> m_maxSnapshots{MAX_SNAPSHOTS};
+
+    std::atomic<uint64_t> m_hitches{0};
+    std::atomic<uint64_t> m_snapshots{0};
+    std::atomic<uint64_t> m_lastFrame{0};
+    uint64_t m_lastNs = 0; // check()'s thread only
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+// c++ includes
+#include <cstdint>
+#include <atomic>
+
+// windows / summaries of the ages
+#include "FrameHistogram.h"
+
+// NOTE: platform independent, shared by the layer (the subclassed window stamps input,
+// the primary's Present takes it, StatsWriter publishes), the stats page and
+// tools/dxpipe_input
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// input age at present
+//  • the game window's procedure stamps every mouse / keyboard message (raw input too)
+//    as it is dispatched, only the oldest one since the last Present is kept
+//  • the primary's Present takes it right before handing the frame to DXGI, so the age
+//    covers the game's frame and the layer's own Present work; the frame that consumed
+//    the input may be the next one (input read before it arrived), so this is a lower
+//    bound of input to present
+//  • ages go into a FrameHistogram (the same 1 s / 10 s / 60 s windows as the frame
+//    times, a "hitch" is an age over twice the 10 s median)
+//  • arrived() is lock free from any thread, presented() runs on one (the primary's Present)
+///////////////////////////////////////////////////////////////////////////////////////////
+
+enum class InputKind : uint32_t
+{
+    Mouse,    // moves, buttons, wheel, raw mouse
+    Keyboard, // key down / up, raw keyboard
+    Count
+};
+
+static const uint32_t INPUT_KINDS = uint32_t(InputKind::Count);
+
+inline const char *inputKindName(uint32_t kind)
+{
+    static const char *names[INPUT_KINDS] = {"mouse", "keyboard"};
+    return kind < INPUT_KINDS ? names[kind] : "?";
+}
+
+class InputLatency
+{
+public:
+    // an input message at nowNs (steady clock), the window's thread
+    void arrived(InputKind kind, uint64_t nowNs)
+    {
+        m_inputs[uint32_t(kind)].fetch_add(1, std::memory_order_relaxed);
+        // mouse moves come in floods, only the first one since the last Present stores
+        uint64_t none = 0;
+        if (!m_oldest.load(std::memory_order_relaxed))
+            m_oldest.compare_exchange_strong(none, nowNs, std::memory_order_relaxed);
+    }
+
+    // the primary hands a frame to DXGI at nowNs: age in us of the oldest input since the
+    // previous one (0 = no input this frame)
+    uint32_t presented(uint64_t nowNs)
+    {
+        uint64_t oldest = m_oldest.exchange(0, std::memory_order_relaxed);
+        m_lastUs = 0;
+        if (!oldest)
+        {
+            m_ages.idle(nowNs);
+            return 0;
+        }
+        uint64_t us = nowNs > oldest ? (nowNs - oldest) / 1000 : 0;
+        m_lastUs = uint32_t(us < 1 ? 1 : (us > FRAME_MAX_US ? FRAME_MAX_US : us));
+        m_ages.add(m_lastUs, nowNs);
+        return m_lastUs;
+    }
+
+    // the last presented() (its thread only)
+    uint32_t lastUs() const { return m_lastUs; }
+
+    // frames with input, summaries / read() like the frame times
+    const FrameHistogram &ages() const { return m_ages; }
+
+    uint64_t inputs(InputKind kind) const { return m_inputs[uint32_t(kind)].load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> m_oldest{0}; // steady ns of the oldest pending input, 0 = none
+    std::atomic<uint64_t> m_inputs[INPUT_KINDS] = {};
+
+    // presented()'s thread only
+    FrameHistogram m_ages;
+    uint32_t m_lastUs = 0;
+};
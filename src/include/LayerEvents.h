@@ -0,0 +1,251 @@
+#pragma once
+
+// c++ includes
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cstdlib>
+#include <atomic>
+
+// allocation audit (growth is the only allocation on the record path)
+#include "AllocAudit.h"
+
+// NOTE: this header is platform independent on purpose (no Windows / d3d11 types)
+// so the same event stream can be fed from the proxies or from the offline tools
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// layer event stream
+//  • every intercepted context call becomes one fixed-size record
+//  • each context records into its own buffer (d3d11 contexts are single threaded)
+//  • deferred recordings are spliced into the frame timeline on ExecuteCommandList
+///////////////////////////////////////////////////////////////////////////////////////////
+
+enum class EventKind : uint16_t
+{
+    Draw,
+    DrawIndexed,
+    DrawInstanced,
+    DrawIndexedInstanced,
+    DrawIndirect,
+    Dispatch,
+    ClearRenderTarget,
+    ClearDepthStencil,
+    SetRenderTargets,
+    SetDepthStencilState,
+    SetShader,
+    SetShaderResources,
+    SetConstantBuffers,
+    Map,
+    Unmap,
+    UpdateSubresource,
+    CopyResource,
+    CopySubresourceRegion,
+    ResolveSubresource,
+    ExecuteCommandList,
+    Payload, // capture only: out-of-line data of the previous upload (arg = blob offset, arg2 = size)
+    Count
+};
+
+// pipeline stage of a *SetShader / *SetShaderResources / *SetConstantBuffers call (arg2)
+enum ShaderStage : uint32_t
+{
+    StageVS,
+    StageHS,
+    StageDS,
+    StageGS,
+    StagePS,
+    StageCS
+};
+
+// one intercepted call (24 bytes)
+//  object – primary resource / view / state the call operates on
+//  arg    – call specific payload (index count, byte size, slot range, ...)
+//  arg2   – secondary payload (instance count, flags, ...)
+struct LayerEvent
+{
+    const void *object;
+    uint64_t arg;
+    uint32_t arg2;
+    EventKind kind;
+    uint16_t context; // 0 = immediate, otherwise deferred recorder id
+};
+
+// per-context call counters, merged into the frame on splice
+struct ContextCounters
+{
+    uint32_t draws;
+    uint32_t dispatches;
+    uint32_t clears;
+    uint32_t maps;
+    uint32_t updates;
+    uint32_t copies;
+    uint32_t stateChanges;
+    uint32_t commandLists;
+    uint64_t bytesUploaded; // UpdateSubresource payload
+
+    void merge(const ContextCounters &o)
+    {
+        draws += o.draws;
+        dispatches += o.dispatches;
+        clears += o.clears;
+        maps += o.maps;
+        updates += o.updates;
+        copies += o.copies;
+        stateChanges += o.stateChanges;
+        commandLists += o.commandLists;
+        bytesUploaded += o.bytesUploaded;
+    }
+};
+
+// append-only event storage
+//  • the hot path is a bounds check and a pointer bump
+//  • storage only grows, clear() keeps the capacity so steady state never allocates
+class EventBuffer
+{
+public:
+    explicit EventBuffer(size_t reserve = 1024)
+    {
+        grow(reserve ? reserve : 1);
+    }
+    ~EventBuffer() { std::free(m_begin); }
+
+    EventBuffer(const EventBuffer &) = delete;
+    EventBuffer &operator=(const EventBuffer &) = delete;
+
+    inline void push(const LayerEvent &e)
+    {
+        if (m_cur == m_end)
+            grow(capacity() * 2);
+        *m_cur++ = e;
+    }
+
+    // bulk append another buffer (used when splicing command lists)
+    void append(const EventBuffer &o)
+    {
+        size_t n = o.size();
+        if (!n)
+            return;
+        if (size() + n > capacity())
+            grow((size() + n) * 2);
+        memcpy(m_cur, o.m_begin, n * sizeof(LayerEvent));
+        m_cur += n;
+    }
+
+    void clear() { m_cur = m_begin; }
+
+    const LayerEvent *begin() const { return m_begin; }
+    const LayerEvent *end() const { return m_cur; }
+    size_t size() const { return size_t(m_cur - m_begin); }
+    size_t capacity() const { return size_t(m_end - m_begin); }
+
+private:
+    void grow(size_t cap)
+    {
+        allocAuditNote(cap * sizeof(LayerEvent));
+        size_t n = size();
+        LayerEvent *p = static_cast<LayerEvent *>(std::realloc(m_begin, cap * sizeof(LayerEvent)));
+        if (!p)
+            return; // keep the old storage, push() will retry next call
+        m_begin = p;
+        m_cur = p + n;
+        m_end = p + cap;
+    }
+
+    LayerEvent *m_begin = nullptr;
+    LayerEvent *m_cur = nullptr;
+    LayerEvent *m_end = nullptr;
+};
+
+// events + counters of a single context
+struct EventRecorder
+{
+    explicit EventRecorder(size_t reserve = 1024, uint16_t id = 0)
+        : events(reserve), counters{}, id(id) {}
+
+    // record one call and bump the matching counter
+    inline void record(EventKind kind, const void *object, uint64_t arg = 0, uint32_t arg2 = 0)
+    {
+        switch (kind)
+        {
+        case EventKind::Draw:
+        case EventKind::DrawIndexed:
+        case EventKind::DrawInstanced:
+        case EventKind::DrawIndexedInstanced:
+        case EventKind::DrawIndirect:
+            counters.draws++;
+            break;
+        case EventKind::Dispatch:
+            counters.dispatches++;
+            break;
+        case EventKind::ClearRenderTarget:
+        case EventKind::ClearDepthStencil:
+            counters.clears++;
+            break;
+        case EventKind::SetRenderTargets:
+        case EventKind::SetDepthStencilState:
+        case EventKind::SetShader:
+        case EventKind::SetShaderResources:
+        case EventKind::SetConstantBuffers:
+            counters.stateChanges++;
+            break;
+        case EventKind::Map:
+            counters.maps++;
+            break;
+        case EventKind::UpdateSubresource:
+            counters.updates++;
+            counters.bytesUploaded += arg;
+            break;
+        case EventKind::CopyResource:
+        case EventKind::CopySubresourceRegion:
+        case EventKind::ResolveSubresource:
+            counters.copies++;
+            break;
+        default:
+            break;
+        }
+        events.push({object, arg, arg2, kind, id});
+    }
+
+    // append a finished command list at the current position
+    void splice(const EventRecorder &recorded)
+    {
+        record(EventKind::ExecuteCommandList, &recorded, recorded.events.size(), recorded.id);
+        events.append(recorded.events);
+        counters.merge(recorded.counters);
+        counters.commandLists++;
+    }
+
+    void clear()
+    {
+        events.clear();
+        counters = {};
+    }
+
+    EventBuffer events;
+    ContextCounters counters;
+    uint16_t id;
+};
+
+// the per-frame view of everything the game submitted
+//  • the immediate context records straight into it
+//  • deferred recordings are appended in ExecuteCommandList order
+//  • reset once per Present after all consumers have looked at it
+class FrameTimeline : public EventRecorder
+{
+public:
+    explicit FrameTimeline(size_t reserve = 16384)
+        : EventRecorder(reserve, 0) {}
+
+    // close the current frame, returns the id of the frame that just ended
+    uint64_t endFrame()
+    {
+        clear();
+        return m_frame.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // readable from any thread (resource creation stamps its frame)
+    uint64_t frame() const { return m_frame.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> m_frame{0};
+};
@@ -0,0 +1,602 @@
+#pragma once
+
+// c++ includes
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <type_traits>
+
+// NOTE: platform independent, the layer's sink lives in ProxyLog.h, tools/dxpipe_log measures it
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// structured log
+//  • LOG_ERROR / LOG_WARN / LOG_INFO / LOG_DEBUG (Category, "text {} more {:x}", args...)
+//  • levels above LOG_LEVEL (CMake -DLOG_LEVEL) are not compiled, arguments included
+//  • the rest test their category's runtime level first (one relaxed load), a disabled
+//    call never evaluates its arguments
+//  • an enabled call copies its arguments (numbers, pointers, strings as far as the
+//    record has room) into a fixed record of a lock-free queue, no formatting, no lock,
+//    no syscall: the writer thread formats and writes every few milliseconds, or sooner
+//    when the call that fills another half of the queue wakes it
+//  • a full queue drops the record and counts it, the game's threads never wait on the
+//    disk
+///////////////////////////////////////////////////////////////////////////////////////////
+
+// 0 = nothing ... 4 = debug, normally set by CMake
+#ifndef LOG_LEVEL
+#define LOG_LEVEL 4
+#endif
+
+enum class LogLevel : uint8_t
+{
+    Off,
+    Error,
+    Warn,
+    Info,
+    Debug,
+    Count
+};
+
+enum class LogCategory : uint8_t
+{
+    Hooks,     // DllMain, the export hooks, the layer's own files
+    Device,    // device / context wrappers, resource tracking, depth detection
+    SwapChain, // Present, ResizeBuffers, the export passes
+    Ipc,       // pipes, shared handles, the client, the stats page
+    Overlay,   // ImGui
+    Count
+};
+
+inline const char *logLevelName(uint32_t level)
+{
+    static const char *const names[] = {"off", "error", "warn", "info", "debug"};
+    static_assert(sizeof(names) / sizeof(names[0]) == size_t(LogLevel::Count), "one name per level");
+    return level < uint32_t(LogLevel::Count) ? names[level] : "?";
+}
+
+inline const char *logCategoryName(uint32_t category)
+{
+    static const char *const names[] = {"hooks", "device", "swapchain", "ipc", "overlay"};
+    static_assert(sizeof(names) / sizeof(names[0]) == size_t(LogCategory::Count), "one name per category");
+    return category < uint32_t(LogCategory::Count) ? names[category] : "?";
+}
+
+enum class LogArg : uint8_t
+{
+    Int,
+    Uint,
+    Float,
+    Pointer,
+    String, // offset into LogRecord::text
+    Bool
+};
+
+struct LogRecord
+{
+    static constexpr uint32_t MAX_ARGS = 8; // further arguments are dropped
+    static constexpr uint32_t TEXT = 168;   // string argument space
+
+    int64_t time;       // system clock us
+    const char *format; // a literal (it outlives the record)
+    uint8_t level;
+    uint8_t category;
+    uint8_t count;
+    uint8_t textUsed;
+    uint8_t types[MAX_ARGS]; // LogArg
+    uint64_t args[MAX_ARGS];
+    char text[TEXT]; // NUL terminated strings back to back, the last byte stays 0
+};
+
+// strings are cut to what's left of the record, an argument past the end reads ""
+inline void logText(LogRecord &r, uint64_t &slot, const char *s, size_t len)
+{
+    if (r.textUsed >= LogRecord::TEXT - 1)
+    {
+        slot = LogRecord::TEXT - 1;
+        return;
+    }
+    size_t room = LogRecord::TEXT - 1 - r.textUsed;
+    size_t n = len < room ? len : room;
+    memcpy(r.text + r.textUsed, s, n);
+    r.text[r.textUsed + n] = '\0';
+    slot = r.textUsed;
+    r.textUsed = uint8_t(r.textUsed + n + 1);
+}
+
+template <class T>
+inline void logCapture(LogRecord &r, const T &value)
+{
+    if (r.count >= LogRecord::MAX_ARGS)
+        return;
+    uint8_t &type = r.types[r.count];
+    uint64_t &slot = r.args[r.count];
+    r.count++;
+
+    using V = std::decay_t<T>;
+    if constexpr (std::is_same_v<V, bool>)
+    {
+        type = uint8_t(LogArg::Bool);
+        slot = value ? 1 : 0;
+    }
+    else if constexpr (std::is_enum_v<V>)
+    {
+        type = uint8_t(LogArg::Int);
+        slot = uint64_t(int64_t(std::underlying_type_t<V>(value)));
+    }
+    else if constexpr (std::is_integral_v<V> && std::is_signed_v<V>)
+    {
+        type = uint8_t(LogArg::Int);
+        slot = uint64_t(int64_t(value));
+    }
+    else if constexpr (std::is_integral_v<V>)
+    {
+        type = uint8_t(LogArg::Uint);
+        slot = uint64_t(value);
+    }
+    else if constexpr (std::is_floating_point_v<V>)
+    {
+        type = uint8_t(LogArg::Float);
+        double d = double(value);
+        memcpy(&slot, &d, sizeof(d));
+    }
+    else if constexpr (std::is_same_v<V, std::string>)
+    {
+        type = uint8_t(LogArg::String);
+        logText(r, slot, value.data(), value.size());
+    }
+    else if constexpr (std::is_same_v<V, char *> || std::is_same_v<V, const char *>)
+    {
+        type = uint8_t(LogArg::String);
+        const char *s = value ? value : "(null)";
+        logText(r, slot, s, strlen(s));
+    }
+    else if constexpr (std::is_pointer_v<V>)
+    {
+        type = uint8_t(LogArg::Pointer);
+        slot = uint64_t(uintptr_t(value));
+    }
+    else
+    {
+        static_assert(!sizeof(T), "log arguments are numbers, enums, pointers or strings");
+    }
+}
+
+// bounded multi producer / single consumer queue (a slot's sequence says whose turn it is)
+class LogQueue
+{
+public:
+    static constexpr uint32_t CAPACITY = 1u << 10; // records (~270KB), a power of two
+
+    // touch every page now, not on the first log call
+    LogQueue()
+    {
+        for (uint32_t i = 0; i < CAPACITY; i++)
+        {
+            memset(&m_cells[i].record, 0, sizeof(LogRecord));
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // any thread, fill writes the claimed record in place, false when full. wake is set on
+    // every CAPACITY / 2 th record, the writer should drain before the queue fills
+    template <class Fill>
+    inline bool push(Fill &&fill, bool &wake)
+    {
+        uint32_t pos = m_head.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell &cell = m_cells[pos & (CAPACITY - 1)];
+            int32_t diff = int32_t(cell.sequence.load(std::memory_order_acquire) - pos);
+            if (diff == 0)
+            {
+                if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    fill(cell.record);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    wake = ((pos + 1) & (CAPACITY / 2 - 1)) == 0;
+                    return true;
+                }
+            }
+            else if (diff < 0)
+                return false; // the writer hasn't freed this slot yet
+            else
+                pos = m_head.load(std::memory_order_relaxed);
+        }
+    }
+
+    // writer only, in queue order, stops at a record still being filled
+    template <class Sink>
+    uint32_t drain(Sink &&out)
+    {
+        uint32_t n = 0;
+        for (;;)
+        {
+            Cell &cell = m_cells[m_tail & (CAPACITY - 1)];
+            if (cell.sequence.load(std::memory_order_acquire) != m_tail + 1)
+                return n;
+            out(cell.record);
+            cell.sequence.store(m_tail + CAPACITY, std::memory_order_release);
+            m_tail++;
+            n++;
+        }
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<uint32_t> sequence;
+        LogRecord record;
+    };
+
+    alignas(64) std::atomic<uint32_t> m_head{0};
+    alignas(64) uint32_t m_tail = 0;
+    alignas(64) Cell m_cells[CAPACITY];
+};
+
+class LayerLog
+{
+public:
+    static constexpr uint32_t DRAIN_MS = 10; // writer period, shorter when woken
+
+    ~LayerLog() { close(); }
+
+    // the hot path when disabled: one relaxed load and a compare
+    inline bool enabled(LogLevel level, LogCategory category) const
+    {
+        return uint8_t(level) <= m_levels[uint8_t(category)].load(std::memory_order_relaxed);
+    }
+
+    // clamped to LOG_LEVEL (a higher level would have nothing compiled to show)
+    void setLevel(LogCategory category, LogLevel level)
+    {
+        uint8_t l = uint8_t(level) < uint8_t(LOG_LEVEL) ? uint8_t(level) : uint8_t(LOG_LEVEL);
+        m_levels[uint8_t(category)].store(l, std::memory_order_relaxed);
+    }
+
+    LogLevel level(LogCategory category) const
+    {
+        return LogLevel(m_levels[uint8_t(category)].load(std::memory_order_relaxed));
+    }
+
+    bool anyEnabled() const
+    {
+        for (const std::atomic<uint8_t> &l : m_levels)
+            if (l.load(std::memory_order_relaxed))
+                return true;
+        return false;
+    }
+
+    // "ipc=debug,device=info", "all=warn" or a bare level for every category, applied left
+    // to right, false if a part wasn't understood (the rest still applies)
+    bool configure(const char *spec)
+    {
+        bool ok = true;
+        while (spec && *spec)
+        {
+            const char *end = strchr(spec, ',');
+            size_t len = end ? size_t(end - spec) : strlen(spec);
+            std::string part(spec, len);
+            spec = end ? end + 1 : nullptr;
+            if (part.empty())
+                continue;
+
+            size_t eq = part.find('=');
+            std::string name = eq == std::string::npos ? "all" : part.substr(0, eq);
+            std::string value = eq == std::string::npos ? part : part.substr(eq + 1);
+
+            uint32_t level = 0;
+            while (level < uint32_t(LogLevel::Count) && value != logLevelName(level))
+                level++;
+            if (level == uint32_t(LogLevel::Count))
+            {
+                ok = false;
+                continue;
+            }
+
+            bool matched = false;
+            for (uint32_t c = 0; c < uint32_t(LogCategory::Count); c++)
+            {
+                if (name == "all" || name == logCategoryName(c))
+                {
+                    setLevel(LogCategory(c), LogLevel(level));
+                    matched = true;
+                }
+            }
+            ok = ok && matched;
+        }
+        return ok;
+    }
+
+    // enabled() already checked (the LOG_ macros do), arguments are copied, not formatted
+    template <class... Args>
+    void write(LogLevel level, LogCategory category, const char *format, const Args &...args)
+    {
+        const int64_t time = std::chrono::duration_cast<std::chrono::microseconds>(
+                                 std::chrono::system_clock::now().time_since_epoch())
+                                 .count();
+        bool wake = false;
+        bool queued = m_queue.push([&](LogRecord &r)
+                                   {
+                                       r.time = time;
+                                       r.format = format;
+                                       r.level = uint8_t(level);
+                                       r.category = uint8_t(category);
+                                       r.count = 0;
+                                       r.textUsed = 0;
+                                       r.text[LogRecord::TEXT - 1] = '\0';
+                                       (logCapture(r, args), ...); }, wake);
+        if (!queued)
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+        else if (wake) // half a queue since the last one, a burst: drain now, not at the next period
+        {
+            m_wakeup.store(true, std::memory_order_release);
+            m_wake.notify_one();
+        }
+    }
+
+    // appends to path, starts the writer (not from DllMain, the writer is a thread)
+    bool open(const char *path)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (m_file)
+            return true;
+        FILE *file = fopen(path, "a");
+        if (!file)
+            return false;
+        startLocked(file, true);
+        return true;
+    }
+
+    // an already open stream (tools), left open by close()
+    void open(FILE *file)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (!m_file)
+            startLocked(file, false);
+    }
+
+    bool isOpen()
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_file != nullptr;
+    }
+
+    // stops the writer after a last pass
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (!m_file)
+            return;
+        {
+            std::lock_guard<std::mutex> wakeLock(m_wakeLock);
+            m_stop.store(true, std::memory_order_release);
+        }
+        m_wake.notify_one();
+        if (m_writer.joinable())
+            m_writer.join();
+        if (m_owned)
+            fclose(m_file);
+        else
+            fflush(m_file);
+        m_file = nullptr;
+    }
+
+    uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+    uint64_t written() const { return m_written.load(std::memory_order_relaxed); }
+
+    // one line, "[hh:mm:ss.mmm] level category: message\n", cut to size
+    static size_t format(const LogRecord &r, char *out, size_t size)
+    {
+        size_t n = 0;
+        auto put = [&](const char *s, size_t len)
+        {
+            size_t room = n + 1 < size ? size - 1 - n : 0;
+            len = len < room ? len : room;
+            memcpy(out + n, s, len);
+            n += len;
+        };
+
+        time_t seconds = time_t(r.time / 1000000);
+        struct tm local = {};
+#ifdef _WIN32
+        localtime_s(&local, &seconds);
+#else
+        localtime_r(&seconds, &local);
+#endif
+        char head[64];
+        int len = snprintf(head, sizeof(head), "[%02d:%02d:%02d.%03d] %-5s %-9s ", local.tm_hour, local.tm_min,
+                           local.tm_sec, int(r.time / 1000 % 1000), logLevelName(r.level),
+                           logCategoryName(r.category));
+        put(head, len > 0 ? size_t(len) : 0);
+
+        uint32_t arg = 0;
+        for (const char *f = r.format; *f;)
+        {
+            if ((f[0] == '{' && f[1] == '{') || (f[0] == '}' && f[1] == '}'))
+            {
+                put(f, 1);
+                f += 2;
+                continue;
+            }
+            const char *close = f[0] == '{' ? strchr(f, '}') : nullptr;
+            if (!close)
+            {
+                put(f, 1);
+                f++;
+                continue;
+            }
+
+            char value[256];
+            const char *spec = f[1] == ':' ? f + 2 : close;
+            len = arg < r.count ? formatArg(r, arg++, spec, size_t(close - spec), value, sizeof(value))
+                                : snprintf(value, sizeof(value), "{?}");
+            put(value, len > 0 ? (size_t(len) < sizeof(value) ? size_t(len) : sizeof(value) - 1) : 0);
+            f = close + 1;
+        }
+        put("\n", 1);
+        if (size)
+            out[n] = '\0';
+        return n;
+    }
+
+private:
+    // spec is a printf spec without the '%' ("x", "08x", ".3f", "-12"), anything else is ignored
+    static int formatArg(const LogRecord &r, uint32_t i, const char *spec, size_t specLen, char *out, size_t size)
+    {
+        char conv = specLen && strchr("xXdufgeE", spec[specLen - 1]) ? spec[specLen - 1] : 0;
+        size_t flags = conv ? specLen - 1 : specLen;
+        if (flags > 16 || strspn(spec, "0123456789.-+ #") < flags)
+        {
+            flags = 0;
+            conv = 0;
+        }
+        const bool hex = conv == 'x' || conv == 'X';
+        const uint64_t v = r.args[i];
+
+        // the printf conversion for the argument's type
+        const char *type = "s";
+        unsigned long long u = v;
+        double d = 0.0;
+        switch (LogArg(r.types[i]))
+        {
+        case LogArg::Int:
+            if (hex) // narrow signed values (HRESULTs) print as their 32 bits
+                u = int64_t(v) >= INT32_MIN && int64_t(v) <= INT32_MAX ? uint32_t(v) : v;
+            type = hex ? (conv == 'X' ? "llX" : "llx") : "lld";
+            break;
+        case LogArg::Uint:
+            type = hex ? (conv == 'X' ? "llX" : "llx") : "llu";
+            break;
+        case LogArg::Float:
+            memcpy(&d, &v, sizeof(d));
+            type = conv == 'f' ? "f" : conv == 'e' ? "e" : conv == 'E' ? "E" : "g";
+            break;
+        case LogArg::Pointer:
+            return snprintf(out, size, "0x%llx", u);
+        case LogArg::Bool:
+            return snprintf(out, size, "%s", v ? "true" : "false");
+        case LogArg::String:
+            break;
+        default:
+            return snprintf(out, size, "{?}");
+        }
+
+        char fmt[32] = "%";
+        memcpy(fmt + 1, spec, flags);
+        memcpy(fmt + 1 + flags, type, strlen(type) + 1);
+        switch (LogArg(r.types[i]))
+        {
+        case LogArg::Float:
+            return snprintf(out, size, fmt, d);
+        case LogArg::String:
+            return snprintf(out, size, fmt, r.text + (v < LogRecord::TEXT ? v : LogRecord::TEXT - 1));
+        case LogArg::Int:
+            return hex ? snprintf(out, size, fmt, u) : snprintf(out, size, fmt, (long long)v);
+        default:
+            return snprintf(out, size, fmt, u);
+        }
+    }
+
+    void startLocked(FILE *file, bool owned)
+    {
+        m_file = file;
+        m_owned = owned;
+        m_stop.store(false, std::memory_order_relaxed);
+        m_writer = std::thread([this]
+                               { writerLoop(); });
+    }
+
+    void writerLoop()
+    {
+        while (!m_stop.load(std::memory_order_acquire))
+        {
+            drainAll();
+            std::unique_lock<std::mutex> lock(m_wakeLock);
+            m_wake.wait_for(lock, std::chrono::milliseconds(DRAIN_MS), [this]
+                            { return m_wakeup.exchange(false, std::memory_order_acq_rel) ||
+                                     m_stop.load(std::memory_order_acquire); });
+        }
+        drainAll(); // whatever was logged before close()
+    }
+
+    // writer thread only
+    void drainAll()
+    {
+        char line[1024];
+        uint32_t n = m_queue.drain([&](const LogRecord &r)
+                                   { fwrite(line, 1, format(r, line, sizeof(line)), m_file); });
+
+        uint64_t dropped = m_dropped.load(std::memory_order_relaxed);
+        if (dropped != m_reported)
+        {
+            fprintf(m_file, "[log] %llu record(s) dropped (queue full)\n", (unsigned long long)(dropped - m_reported));
+            m_reported = dropped;
+        }
+        if (n)
+        {
+            m_written.fetch_add(n, std::memory_order_relaxed);
+            fflush(m_file); // keep the file usable if the game is killed
+        }
+    }
+
+    std::atomic<uint8_t> m_levels[uint32_t(LogCategory::Count)] = {}; // all off
+    LogQueue m_queue;
+    std::atomic<uint64_t> m_dropped{0};
+    std::atomic<uint64_t> m_written{0};
+    uint64_t m_reported = 0; // writer's last dropped count
+
+    std::mutex m_lock; // open / close
+    FILE *m_file = nullptr;
+    bool m_owned = false;
+    std::atomic<bool> m_stop{false};
+    std::atomic<bool> m_wakeup{false}; // a caller crossed half the queue
+    std::mutex m_wakeLock;             // the writer's wait only, callers never take it
+    std::condition_variable m_wake;
+    std::thread m_writer;
+};
+
+// the layer's log (d3d11.cpp, tools define their own)
+extern LayerLog g_Log;
+
+// compiled in up to LOG_LEVEL, otherwise the arguments aren't even compiled
+#define LOG_AT(level, category, ...)                                               \
+    do                                                                             \
+    {                                                                              \
+        if (g_Log.enabled(LogLevel::level, LogCategory::category))                 \
+            g_Log.write(LogLevel::level, LogCategory::category, __VA_ARGS__);      \
+    } while (0)
+
+// for work done only to be logged (constant false when the level isn't compiled)
+#define LOG_ENABLED(level, category) \
+    (LOG_LEVEL >= int(LogLevel::level) && g_Log.enabled(LogLevel::level, LogCategory::category))
+
+#if LOG_LEVEL >= 1
+#define LOG_ERROR(category, ...) LOG_AT(Error, category, __VA_ARGS__)
+#else
+#define LOG_ERROR(category, ...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= 2
+#define LOG_WARN(category, ...) LOG_AT(Warn, category, __VA_ARGS__)
+#else
+#define LOG_WARN(category, ...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= 3
+#define LOG_INFO(category, ...) LOG_AT(Info, category, __VA_ARGS__)
+#else
+#define LOG_INFO(category, ...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= 4
+#define LOG_DEBUG(category, ...) LOG_AT(Debug, category, __VA_ARGS__)
+#else
+#define LOG_DEBUG(category, ...) ((void)0)
+#endif
@@ -0,0 +1,207 @@
+#pragma once
+
+// c++ includes
+#include <cstdint>
+
+// NOTE: platform independent mirrors of the dxgi / d3d11 constants the layer cores use
+// the numeric values match the Windows SDK, so a DXGI_FORMAT or D3D11_BIND_FLAG can be
+// passed straight through as uint32_t
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// formats
+///////////////////////////////////////////////////////////////////////////////////////////
+
+enum LayerFormat : uint32_t
+{
+    FMT_UNKNOWN = 0,
+    FMT_R32G32B32A32_FLOAT = 2,
+    FMT_R16G16B16A16_FLOAT = 10,
+    FMT_R32G8X24_TYPELESS = 19,
+    FMT_D32_FLOAT_S8X24_UINT = 20,
+    FMT_R32_FLOAT_X8X24_TYPELESS = 21,
+    FMT_R10G10B10A2_UNORM = 24,
+    FMT_R11G11B10_FLOAT = 26,
+    FMT_R8G8B8A8_TYPELESS = 27,
+    FMT_R8G8B8A8_UNORM = 28,
+    FMT_R8G8B8A8_UNORM_SRGB = 29,
+    FMT_R16G16_FLOAT = 34,
+    FMT_R32_TYPELESS = 39,
+    FMT_D32_FLOAT = 40,
+    FMT_R32_FLOAT = 41,
+    FMT_R24G8_TYPELESS = 44,
+    FMT_D24_UNORM_S8_UINT = 45,
+    FMT_R24_UNORM_X8_TYPELESS = 46,
+    FMT_R16_TYPELESS = 53,
+    FMT_R16_FLOAT = 54,
+    FMT_D16_UNORM = 55,
+    FMT_R16_UNORM = 56,
+    FMT_B8G8R8A8_UNORM = 87,
+    FMT_B8G8R8A8_TYPELESS = 90,
+    FMT_B8G8R8A8_UNORM_SRGB = 91,
+};
+
+// bytes per texel, 0 for formats the layer does not handle
+inline uint32_t formatSize(uint32_t fmt)
+{
+    switch (fmt)
+    {
+    case FMT_R32G32B32A32_FLOAT:
+        return 16;
+    case FMT_R16G16B16A16_FLOAT:
+    case FMT_R32G8X24_TYPELESS:
+    case FMT_D32_FLOAT_S8X24_UINT:
+    case FMT_R32_FLOAT_X8X24_TYPELESS:
+        return 8;
+    case FMT_R10G10B10A2_UNORM:
+    case FMT_R11G11B10_FLOAT:
+    case FMT_R8G8B8A8_TYPELESS:
+    case FMT_R8G8B8A8_UNORM:
+    case FMT_R8G8B8A8_UNORM_SRGB:
+    case FMT_R16G16_FLOAT:
+    case FMT_R32_TYPELESS:
+    case FMT_D32_FLOAT:
+    case FMT_R32_FLOAT:
+    case FMT_R24G8_TYPELESS:
+    case FMT_D24_UNORM_S8_UINT:
+    case FMT_R24_UNORM_X8_TYPELESS:
+    case FMT_B8G8R8A8_UNORM:
+    case FMT_B8G8R8A8_TYPELESS:
+    case FMT_B8G8R8A8_UNORM_SRGB:
+        return 4;
+    case FMT_R16_TYPELESS:
+    case FMT_R16_FLOAT:
+    case FMT_D16_UNORM:
+    case FMT_R16_UNORM:
+        return 2;
+    default:
+        return 0;
+    }
+}
+
+// formats a depth buffer can be created with (typeless families + depth views)
+inline bool isDepthFormat(uint32_t fmt)
+{
+    switch (fmt)
+    {
+    case FMT_R32G8X24_TYPELESS:
+    case FMT_D32_FLOAT_S8X24_UINT:
+    case FMT_R32_TYPELESS:
+    case FMT_D32_FLOAT:
+    case FMT_R24G8_TYPELESS:
+    case FMT_D24_UNORM_S8_UINT:
+    case FMT_R16_TYPELESS:
+    case FMT_D16_UNORM:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// typeless family of a depth format (a copy target that can also get an SRV)
+inline uint32_t depthTypelessFormat(uint32_t fmt)
+{
+    switch (fmt)
+    {
+    case FMT_R32G8X24_TYPELESS:
+    case FMT_D32_FLOAT_S8X24_UINT:
+    case FMT_R32_FLOAT_X8X24_TYPELESS:
+        return FMT_R32G8X24_TYPELESS;
+    case FMT_R32_TYPELESS:
+    case FMT_D32_FLOAT:
+    case FMT_R32_FLOAT:
+        return FMT_R32_TYPELESS;
+    case FMT_R24G8_TYPELESS:
+    case FMT_D24_UNORM_S8_UINT:
+    case FMT_R24_UNORM_X8_TYPELESS:
+        return FMT_R24G8_TYPELESS;
+    case FMT_R16_TYPELESS:
+    case FMT_D16_UNORM:
+    case FMT_R16_UNORM:
+        return FMT_R16_TYPELESS;
+    default:
+        return FMT_UNKNOWN;
+    }
+}
+
+// format a shader reads the depth of a depth format through (SRV format)
+inline uint32_t depthReadFormat(uint32_t fmt)
+{
+    switch (depthTypelessFormat(fmt))
+    {
+    case FMT_R32G8X24_TYPELESS:
+        return FMT_R32_FLOAT_X8X24_TYPELESS;
+    case FMT_R32_TYPELESS:
+        return FMT_R32_FLOAT;
+    case FMT_R24G8_TYPELESS:
+        return FMT_R24_UNORM_X8_TYPELESS;
+    case FMT_R16_TYPELESS:
+        return FMT_R16_UNORM;
+    default:
+        return FMT_UNKNOWN;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// usage / bind / cpu access / misc flags
+///////////////////////////////////////////////////////////////////////////////////////////
+
+enum LayerUsage : uint32_t
+{
+    USAGE_DEFAULT = 0,
+    USAGE_IMMUTABLE = 1,
+    USAGE_DYNAMIC = 2,
+    USAGE_STAGING = 3
+};
+
+enum LayerBind : uint32_t
+{
+    BIND_VERTEX_BUFFER = 0x1,
+    BIND_INDEX_BUFFER = 0x2,
+    BIND_CONSTANT_BUFFER = 0x4,
+    BIND_SHADER_RESOURCE = 0x8,
+    BIND_RENDER_TARGET = 0x20,
+    BIND_DEPTH_STENCIL = 0x40,
+    BIND_UNORDERED_ACCESS = 0x80
+};
+
+enum LayerCpuAccess : uint32_t
+{
+    CPU_ACCESS_WRITE = 0x10000,
+    CPU_ACCESS_READ = 0x20000
+};
+
+enum LayerMisc : uint32_t
+{
+    MISC_SHARED = 0x2
+};
+
+enum LayerMap : uint32_t
+{
+    MAP_READ = 1,
+    MAP_WRITE = 2,
+    MAP_READ_WRITE = 3,
+    MAP_WRITE_DISCARD = 4,
+    MAP_WRITE_NO_OVERWRITE = 5
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// depth test / clear
+///////////////////////////////////////////////////////////////////////////////////////////
+
+enum LayerComparison : uint32_t
+{
+    CMP_NEVER = 1,
+    CMP_LESS = 2,
+    CMP_EQUAL = 3,
+    CMP_LESS_EQUAL = 4,
+    CMP_GREATER = 5,
+    CMP_NOT_EQUAL = 6,
+    CMP_GREATER_EQUAL = 7,
+    CMP_ALWAYS = 8
+};
+
+enum LayerClear : uint32_t
+{
+    CLEAR_DEPTH = 0x1,
+    CLEAR_STENCIL = 0x2
+};
@@ -0,0 +1,222 @@
+#pragma once
+
+// c++ includes
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+// layer headers (platform independent)
+#include "LayerTypes.h"
+#include "DepthResolve.h"
+#include "CameraInference.h"
+
+// NOTE: platform independent, the CPU reference of the camera motion compute pass
+// (ProxyMotion.h), used by SoftDevice and tools/dxpipe_motion
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// camera motion vectors
+//  • the exported depth plus this and the last frame's view × projection give every
+//    pixel's screen position one frame ago, the difference is the motion the camera
+//    caused (objects moving on their own are not seen, their transforms never reach us)
+//  • half resolution R16G16F, each texel reprojects the closest of its 2x2 depth texels
+//    so silhouettes move with the foreground
+//  • motion = uv now - uv last frame in texture coordinates (+x right, +y down), the last
+//    frame's texel is at uv - motion
+//  • texels without a last position (w <= 0, behind the old camera) get 0
+///////////////////////////////////////////////////////////////////////////////////////////
+
+enum MotionFlags : uint32_t
+{
+    MOTION_REVERSED_Z = 0x1 // closest = largest depth
+};
+
+// per dispatch constants (cbuffer MotionParams in ProxyMotion.h, 80 bytes)
+struct MotionParams
+{
+    float reprojection[16]; // clip now → clip last frame, row vectors
+    uint32_t flags;
+    uint32_t padding[3];
+};
+
+// size of the motion texture for a w x h depth buffer
+inline uint32_t motionExtent(uint32_t depthExtent)
+{
+    return (depthExtent + 1) / 2;
+}
+
+// 4x4 inverse by cofactors, false if singular
+inline bool invertMatrix(const double *m, double *out)
+{
+    double inv[16];
+    inv[0] = m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15] + m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+    inv[4] = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15] - m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+    inv[8] = m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15] + m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+    inv[12] = -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14] - m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+    inv[1] = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15] - m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+    inv[5] = m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15] + m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+    inv[9] = -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15] - m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+    inv[13] = m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14] + m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+    inv[2] = m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15] + m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+    inv[6] = -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15] - m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+    inv[10] = m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15] + m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+    inv[14] = -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14] - m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+    inv[3] = -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11] - m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+    inv[7] = m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11] + m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+    inv[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11] - m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+    inv[15] = m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10] + m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+
+    double det = m[0] * inv[0] + m[1] * inv[4] + m[2] * inv[8] + m[3] * inv[12];
+    if (det == 0.0 || !std::isfinite(det))
+        return false;
+    for (int i = 0; i < 16; i++)
+        out[i] = inv[i] / det;
+    return true;
+}
+
+// clip now → clip last frame: inverse(view · proj now) · view · proj last frame, in double,
+// the far plane makes the inverse of a float view-projection lose most of its digits
+inline bool motionReprojection(const CameraMatrices &last, const CameraMatrices &now, float *out)
+{
+    double vpLast[16], vpNow[16], inv[16];
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++)
+        {
+            double a = 0.0, b = 0.0;
+            for (int k = 0; k < 4; k++)
+            {
+                a += double(last.view[i * 4 + k]) * last.projection[k * 4 + j];
+                b += double(now.view[i * 4 + k]) * now.projection[k * 4 + j];
+            }
+            vpLast[i * 4 + j] = a;
+            vpNow[i * 4 + j] = b;
+        }
+    if (!invertMatrix(vpNow, inv))
+        return false;
+
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++)
+        {
+            double r = 0.0;
+            for (int k = 0; k < 4; k++)
+                r += inv[i * 4 + k] * vpLast[k * 4 + j];
+            out[i * 4 + j] = float(r);
+        }
+    return true;
+}
+
+// float → half, round to nearest even (what a UAV store to R16G16_FLOAT does)
+inline uint16_t floatToHalf(float f)
+{
+    uint32_t x;
+    memcpy(&x, &f, sizeof(x));
+    uint32_t sign = (x >> 16) & 0x8000u;
+    uint32_t mag = x & 0x7FFFFFFFu;
+
+    if (mag >= 0x7F800000u) // inf / nan
+        return uint16_t(sign | 0x7C00u | (mag > 0x7F800000u ? 0x200u : 0u));
+    if (mag >= 0x477FF000u) // rounds past the largest half
+        return uint16_t(sign | 0x7C00u);
+    if (mag < 0x38800000u) // half denormal (or zero)
+    {
+        if (mag < 0x33000000u)
+            return uint16_t(sign);
+        uint32_t shift = 113 - (mag >> 23) + 13;
+        uint32_t mant = (mag & 0x7FFFFFu) | 0x800000u;
+        uint32_t half = mant >> shift;
+        uint32_t rest = mant & ((1u << shift) - 1);
+        uint32_t midpoint = 1u << (shift - 1);
+        if (rest > midpoint || (rest == midpoint && (half & 1)))
+            half++;
+        return uint16_t(sign | half);
+    }
+
+    uint32_t half = ((mag >> 13) - (112u << 10));
+    uint32_t rest = mag & 0x1FFFu;
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1)))
+        half++;
+    return uint16_t(sign | half);
+}
+
+inline float halfToFloat(uint16_t h)
+{
+    uint32_t sign = uint32_t(h & 0x8000u) << 16;
+    uint32_t exp = (h >> 10) & 0x1Fu;
+    uint32_t mant = h & 0x3FFu;
+    uint32_t x;
+    if (exp == 0x1F)
+        x = sign | 0x7F800000u | (mant << 13);
+    else if (exp)
+        x = sign | ((exp + 112) << 23) | (mant << 13);
+    else if (mant)
+    {
+        // denormal, normalise
+        exp = 113;
+        while (!(mant & 0x400u))
+        {
+            mant <<= 1;
+            exp--;
+        }
+        x = sign | (exp << 23) | ((mant & 0x3FFu) << 13);
+    }
+    else
+        x = sign;
+    float f;
+    memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+// motion of the texel centred at uv with this depth, 0 without a last position
+inline void motionVector(float u, float v, float depth, const float *r, float &mx, float &my)
+{
+    float x = u * 2.0f - 1.0f, y = 1.0f - v * 2.0f;
+    float cx = x * r[0] + y * r[4] + depth * r[8] + r[12];
+    float cy = x * r[1] + y * r[5] + depth * r[9] + r[13];
+    float cw = x * r[3] + y * r[7] + depth * r[11] + r[15];
+    if (!(cw > 1e-6f))
+    {
+        mx = my = 0.0f;
+        return;
+    }
+    mx = u - (cx / cw * 0.5f + 0.5f);
+    my = v - (0.5f - cy / cw * 0.5f);
+}
+
+// motion vectors of a w x h depth image into a half size R16G16F image (pitches in bytes)
+inline void motionVectorsCPU(const uint8_t *src, uint32_t srcPitch, uint32_t fmt, uint32_t width, uint32_t height,
+                             const MotionParams &params, uint8_t *dst, uint32_t dstPitch)
+{
+    uint32_t texel = formatSize(fmt);
+    bool reversed = (params.flags & MOTION_REVERSED_Z) != 0;
+    auto depthAt = [&](uint32_t x, uint32_t y)
+    { return decodeDepth(fmt, src + uint64_t(y) * srcPitch + uint64_t(x) * texel); };
+
+    for (uint32_t y = 0; y < motionExtent(height); y++)
+    {
+        uint16_t *d = reinterpret_cast<uint16_t *>(dst + uint64_t(y) * dstPitch);
+        for (uint32_t x = 0; x < motionExtent(width); x++)
+        {
+            // closest of the 2x2 footprint, same order as the shader
+            uint32_t bx = x * 2, by = y * 2;
+            float depth = depthAt(bx, by);
+            for (uint32_t i = 1; i < 4; i++)
+            {
+                uint32_t sx = x * 2 + (i & 1), sy = y * 2 + (i >> 1);
+                sx = sx < width ? sx : width - 1;
+                sy = sy < height ? sy : height - 1;
+                float v = depthAt(sx, sy);
+                if (reversed ? v > depth : v < depth)
+                {
+                    depth = v;
+                    bx = sx;
+                    by = sy;
+                }
+            }
+
+            float mx, my;
+            motionVector((float(bx) + 0.5f) / float(width), (float(by) + 0.5f) / float(height), depth,
+                         params.reprojection, mx, my);
+            d[x * 2] = floatToHalf(mx);
+            d[x * 2 + 1] = floatToHalf(my);
+        }
+    }
+}
@@ -0,0 +1,605 @@
+#pragma once
+
+// c++ includes
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <atomic>
+#include <vector>
+#include <utility>
+
+// ShaderStage
+#include "LayerEvents.h"
+
+// NOTE: platform independent, shared by the layer (ProxyDeviceContext feeds the recorder on
+// sampled frames, ProxyPasses.h times and shows the graph) and tools/dxpipe_passes
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// frame pass graph
+//  • a sampled frame is cut into passes where the game binds other render targets or
+//    clears one, and around every executed command list; a boundary before the pass has
+//    drawn or dispatched anything joins the pass instead (set targets, clear, draw is
+//    one pass, binding the same targets again is none)
+//  • a pass reads the shader resources bound when it draws / dispatches and writes its
+//    targets, UAVs, clears and copy destinations; reading what an earlier pass wrote is
+//    an edge of the graph (from its last writer)
+//  • the recorder hands back the index of every pass it opens, the layer brackets each
+//    with a GPU timestamp there, so a pass' GPU time runs up to the next one's
+//  • the immediate context only, and only while a sampled frame is recorded (every N
+//    frames), otherwise the context proxy pays one relaxed load per call
+///////////////////////////////////////////////////////////////////////////////////////////
+
+static const uint32_t PASS_MAX = 256;       // passes per frame, later boundaries join the last one
+static const uint32_t PASS_STAGES = 6;      // ShaderStage
+static const uint32_t PASS_SRV_SLOTS = 128; // D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT
+static const uint32_t PASS_UAV_SLOTS = 64;  // D3D11_1_UAV_SLOT_COUNT
+static const uint32_t PASS_TARGETS = 8;     // D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT
+static const uint32_t PASS_NONE = UINT32_MAX;
+
+// what opened a pass
+enum class PassOpen : uint8_t
+{
+    Start,       // the frame's first work, before any boundary
+    Targets,     // OMSetRenderTargets*
+    Clear,       // ClearRenderTargetView
+    CommandList, // ExecuteCommandList (the whole list is one pass)
+    Resume,      // the first work after a command list
+    Count
+};
+
+// what a pass did (the first that applies)
+enum class PassKind : uint8_t
+{
+    CommandList,
+    Render,
+    Compute,
+    Copy,
+    Clear,
+    Empty,
+    Count
+};
+
+inline const char *passOpenName(uint32_t open)
+{
+    static const char *names[uint32_t(PassOpen::Count)] = {"start", "targets", "clear", "command list", "resume"};
+    return open < uint32_t(PassOpen::Count) ? names[open] : "?";
+}
+
+inline const char *passKindName(uint32_t kind)
+{
+    static const char *names[uint32_t(PassKind::Count)] = {"cmdlist", "render", "compute", "copy", "clear", "empty"};
+    return kind < uint32_t(PassKind::Count) ? names[kind] : "?";
+}
+
+// D3D11_RESOURCE_DIMENSION order
+inline const char *passDimensionName(uint32_t dimension)
+{
+    static const char *names[] = {"unknown", "buffer", "texture1d", "texture2d", "texture3d"};
+    return dimension < 5 ? names[dimension] : "?";
+}
+
+// a resource the frame touched, described by the layer while it was bound
+struct PassResource
+{
+    const void *object;
+    uint32_t dimension; // D3D11_RESOURCE_DIMENSION, 0 until described
+    uint32_t width;     // bytes for buffers
+    uint32_t height;
+    uint32_t format;    // DXGI_FORMAT
+    uint32_t samples;
+};
+
+struct Pass
+{
+    PassOpen opened;
+    uint32_t firstRead, reads;   // PassGraph::refs
+    uint32_t firstWrite, writes; // PassGraph::refs
+    uint32_t draws;
+    uint32_t dispatches;
+    uint32_t clears;
+    uint32_t copies;
+    uint64_t gpuNs; // 0 until the timestamps came back (or when they didn't)
+};
+
+// pass `to` reads `resource` as pass `from` left it
+struct PassEdge
+{
+    uint32_t from;
+    uint32_t to;
+    uint32_t resource;
+};
+
+inline PassKind passKind(const Pass &p)
+{
+    if (p.opened == PassOpen::CommandList)
+        return PassKind::CommandList;
+    if (p.draws)
+        return PassKind::Render;
+    if (p.dispatches)
+        return PassKind::Compute;
+    if (p.copies)
+        return PassKind::Copy;
+    return p.clears ? PassKind::Clear : PassKind::Empty;
+}
+
+struct PassGraph
+{
+    uint64_t frame = 0;
+    uint64_t gpuNs = 0;  // sum over the passes
+    bool timed = false;  // the pass timestamps came back
+    uint32_t joined = 0; // boundaries past PASS_MAX, folded into the last pass
+
+    std::vector<Pass> passes;
+    std::vector<uint32_t> refs; // resource indices, every pass' reads then writes
+    std::vector<PassResource> resources;
+    std::vector<PassEdge> edges;
+
+    void clear()
+    {
+        frame = gpuNs = 0;
+        timed = false;
+        joined = 0;
+        passes.clear();
+        refs.clear();
+        resources.clear();
+        edges.clear();
+    }
+
+    const uint32_t *reads(const Pass &p) const { return refs.data() + p.firstRead; }
+    const uint32_t *writes(const Pass &p) const { return refs.data() + p.firstWrite; }
+
+    // edges from the last writer of every read (writes of the same pass come after its reads)
+    void link()
+    {
+        edges.clear();
+        std::vector<uint32_t> writer(resources.size(), PASS_NONE);
+        for (uint32_t p = 0; p < passes.size(); p++)
+        {
+            const Pass &pass = passes[p];
+            for (uint32_t i = 0; i < pass.reads; i++)
+            {
+                uint32_t r = reads(pass)[i];
+                if (writer[r] != PASS_NONE)
+                    edges.push_back({writer[r], p, r});
+            }
+            for (uint32_t i = 0; i < pass.writes; i++)
+                writer[writes(pass)[i]] = p;
+        }
+    }
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// recorder (the context proxy's side)
+//  • bindings are kept as plain pointers and folded into the pass' reads / writes at the
+//    next draw or dispatch after they changed, so unused binds never become reads
+//  • every call that may open a pass returns its index (PASS_NONE if it didn't)
+//  • a resource seen for the first time is appended to the graph, the layer describes it
+//    right away through nextUndescribed() (it is bound, so alive)
+///////////////////////////////////////////////////////////////////////////////////////////
+
+class PassRecorder
+{
+public:
+    bool active() const { return m_active.load(std::memory_order_relaxed); }
+
+    // start recording a frame, the bindings are unknown until bind / seedTargets
+    void begin(uint64_t frame)
+    {
+        m_graph.clear();
+        m_graph.frame = frame;
+        m_reads.clear();
+        m_writes.clear();
+        m_readStamp.clear();
+        m_writeStamp.clear();
+        if (m_map.empty())
+            m_map.resize(1024);
+        else
+            memset(m_map.data(), 0, m_map.size() * sizeof(MapSlot));
+        m_mapUsed = 0;
+        m_described = 0;
+        clearState();
+        m_sealed = false;
+        m_active.store(true, std::memory_order_relaxed);
+    }
+
+    // close the last pass and hand the linked graph over (out's storage is reused)
+    void end(PassGraph &out)
+    {
+        if (!active())
+            return;
+        m_active.store(false, std::memory_order_relaxed);
+        close();
+        m_graph.link();
+        std::swap(out, m_graph);
+    }
+
+    // passes opened so far (the layer's timestamps)
+    uint32_t passes() const { return uint32_t(m_graph.passes.size()); }
+
+    // resources added since the last call, one at a time (nullptr when described)
+    PassResource *nextUndescribed()
+    {
+        return m_described < m_graph.resources.size() ? &m_graph.resources[m_described++] : nullptr;
+    }
+
+    // -------- bindings (never open a pass) --------
+
+    // the targets bound before recording started
+    void seedTargets(const void *const *rts, uint32_t n, const void *dsv)
+    {
+        setTargets(rts, n, dsv);
+    }
+
+    void bind(ShaderStage stage, uint32_t start, uint32_t n, const void *const *resources)
+    {
+        if (stage >= PASS_STAGES || start >= PASS_SRV_SLOTS)
+            return;
+        Slots &s = m_srv[stage];
+        setSlots(s.items, s.high, PASS_SRV_SLOTS, start, n, resources);
+        dirty(stage == StageCS);
+    }
+
+    // compute = CSSetUnorderedAccessViews, otherwise the OM's UAVs
+    void bindUavs(bool compute, uint32_t start, uint32_t n, const void *const *resources)
+    {
+        if (start >= PASS_UAV_SLOTS)
+            return;
+        Uavs &u = compute ? m_csUav : m_omUav;
+        setSlots(u.items, u.high, PASS_UAV_SLOTS, start, n, resources);
+        dirty(compute);
+    }
+
+    void clearState()
+    {
+        memset(m_srv, 0, sizeof(m_srv));
+        memset(&m_csUav, 0, sizeof(m_csUav));
+        memset(&m_omUav, 0, sizeof(m_omUav));
+        setTargets(nullptr, 0, nullptr);
+    }
+
+    // -------- boundaries --------
+
+    uint32_t targets(const void *const *rts, uint32_t n, const void *dsv)
+    {
+        if (n > PASS_TARGETS)
+            n = PASS_TARGETS;
+        bool same = n == m_targetCount && dsv == m_dsv;
+        for (uint32_t i = 0; same && i < n; i++)
+            same = (rts ? rts[i] : nullptr) == m_targets[i];
+        if (same && open())
+            return PASS_NONE;
+        setTargets(rts, n, dsv);
+        return boundary(PassOpen::Targets);
+    }
+
+    uint32_t clearTarget(const void *resource)
+    {
+        uint32_t opened = boundary(PassOpen::Clear);
+        write(resource);
+        current().clears++;
+        return opened;
+    }
+
+    uint32_t commandList(bool restore, uint32_t draws, uint32_t dispatches, uint32_t clears, uint32_t copies)
+    {
+        // a list always stands alone, an untouched pass just becomes it
+        uint32_t opened = PASS_NONE;
+        if (open() && idle())
+            current().opened = PassOpen::CommandList;
+        else
+            opened = start(PassOpen::CommandList);
+        Pass &p = current();
+        p.draws += draws;
+        p.dispatches += dispatches;
+        p.clears += clears;
+        p.copies += copies;
+        m_sealed = true;
+        if (!restore)
+            clearState(); // the list leaves the context in its default state
+        return opened;
+    }
+
+    // -------- work (opens the first pass / the one after a command list) --------
+
+    uint32_t draw()
+    {
+        uint32_t opened = ensure();
+        if (m_gfxDirty)
+        {
+            for (uint32_t s = 0; s < PASS_STAGES; s++)
+                if (s != StageCS)
+                    readSlots(m_srv[s].items, m_srv[s].high);
+            writeSlots(m_omUav.items, m_omUav.high);
+            m_gfxDirty = false;
+        }
+        if (!m_targetsWritten)
+        {
+            for (uint32_t i = 0; i < m_targetCount; i++)
+                write(m_targets[i]);
+            write(m_dsv);
+            m_targetsWritten = true;
+        }
+        current().draws++;
+        return opened;
+    }
+
+    uint32_t dispatch()
+    {
+        uint32_t opened = ensure();
+        if (m_csDirty)
+        {
+            readSlots(m_srv[StageCS].items, m_srv[StageCS].high);
+            writeSlots(m_csUav.items, m_csUav.high);
+            m_csDirty = false;
+        }
+        current().dispatches++;
+        return opened;
+    }
+
+    // copies, resolves, uploads (src nullptr) and mip generation (src == dst)
+    uint32_t copy(const void *dst, const void *src)
+    {
+        uint32_t opened = ensure();
+        read(src);
+        write(dst);
+        current().copies++;
+        return opened;
+    }
+
+    // depth / UAV clears write without opening a pass of their own
+    uint32_t clear(const void *resource)
+    {
+        uint32_t opened = ensure();
+        write(resource);
+        current().clears++;
+        return opened;
+    }
+
+private:
+    struct Slots
+    {
+        const void *items[PASS_SRV_SLOTS];
+        uint32_t high; // slots below are the only ones that may be set
+    };
+
+    struct Uavs
+    {
+        const void *items[PASS_UAV_SLOTS];
+        uint32_t high;
+    };
+
+    struct MapSlot
+    {
+        const void *object;
+        uint32_t index;
+    };
+
+    bool open() const { return !m_graph.passes.empty() && !m_sealed; }
+    Pass &current() { return m_graph.passes.back(); }
+
+    // nothing drawn or dispatched yet, a boundary joins the pass
+    bool idle() const
+    {
+        const Pass &p = m_graph.passes.back();
+        return !p.draws && !p.dispatches;
+    }
+
+    uint32_t boundary(PassOpen why)
+    {
+        if (open() && idle())
+        {
+            m_targetsWritten = false; // (re)targeted before the first draw
+            return PASS_NONE;
+        }
+        return start(why);
+    }
+
+    uint32_t ensure()
+    {
+        if (open())
+            return PASS_NONE;
+        return start(m_graph.passes.empty() ? PassOpen::Start : PassOpen::Resume);
+    }
+
+    uint32_t start(PassOpen why)
+    {
+        if (m_graph.passes.size() == PASS_MAX)
+        {
+            m_graph.joined++;
+            m_sealed = false;
+            return PASS_NONE;
+        }
+        close();
+        Pass p = {};
+        p.opened = why;
+        m_graph.passes.push_back(p);
+        m_sealed = false;
+        m_targetsWritten = false;
+        m_gfxDirty = m_csDirty = true; // the bindings become the new pass' reads
+        return uint32_t(m_graph.passes.size() - 1);
+    }
+
+    // moves the open pass' reads / writes into the graph
+    void close()
+    {
+        if (m_graph.passes.empty())
+            return;
+        Pass &p = current();
+        p.firstRead = uint32_t(m_graph.refs.size());
+        p.reads = uint32_t(m_reads.size());
+        m_graph.refs.insert(m_graph.refs.end(), m_reads.begin(), m_reads.end());
+        p.firstWrite = uint32_t(m_graph.refs.size());
+        p.writes = uint32_t(m_writes.size());
+        m_graph.refs.insert(m_graph.refs.end(), m_writes.begin(), m_writes.end());
+        m_reads.clear();
+        m_writes.clear();
+    }
+
+    void dirty(bool compute)
+    {
+        if (compute)
+            m_csDirty = true;
+        else
+            m_gfxDirty = true;
+    }
+
+    void setTargets(const void *const *rts, uint32_t n, const void *dsv)
+    {
+        m_targetCount = n < PASS_TARGETS ? n : PASS_TARGETS;
+        for (uint32_t i = 0; i < PASS_TARGETS; i++)
+            m_targets[i] = (rts && i < m_targetCount) ? rts[i] : nullptr;
+        m_dsv = dsv;
+        m_targetsWritten = false;
+    }
+
+    static void setSlots(const void **items, uint32_t &high, uint32_t slots, uint32_t start, uint32_t n,
+                         const void *const *resources)
+    {
+        if (n > slots - start)
+            n = slots - start;
+        for (uint32_t i = 0; i < n; i++)
+            items[start + i] = resources ? resources[i] : nullptr;
+        if (start + n > high)
+            high = start + n;
+    }
+
+    void readSlots(const void *const *items, uint32_t high)
+    {
+        for (uint32_t i = 0; i < high; i++)
+            read(items[i]);
+    }
+
+    void writeSlots(const void *const *items, uint32_t high)
+    {
+        for (uint32_t i = 0; i < high; i++)
+            write(items[i]);
+    }
+
+    // once per pass and resource (stamped with the pass index + 1)
+    void read(const void *object)
+    {
+        if (!object)
+            return;
+        uint32_t r = intern(object);
+        if (m_readStamp[r] != m_graph.passes.size())
+        {
+            m_readStamp[r] = uint32_t(m_graph.passes.size());
+            m_reads.push_back(r);
+        }
+    }
+
+    void write(const void *object)
+    {
+        if (!object)
+            return;
+        uint32_t r = intern(object);
+        if (m_writeStamp[r] != m_graph.passes.size())
+        {
+            m_writeStamp[r] = uint32_t(m_graph.passes.size());
+            m_writes.push_back(r);
+        }
+    }
+
+    // resource index of an object (open addressing, grown at half full)
+    uint32_t intern(const void *object)
+    {
+        size_t mask = m_map.size() - 1;
+        size_t i = hash(object) & mask;
+        while (m_map[i].object)
+        {
+            if (m_map[i].object == object)
+                return m_map[i].index;
+            i = (i + 1) & mask;
+        }
+        uint32_t index = uint32_t(m_graph.resources.size());
+        m_graph.resources.push_back({object, 0, 0, 0, 0, 0});
+        m_readStamp.push_back(0);
+        m_writeStamp.push_back(0);
+        m_map[i] = {object, index};
+        if (++m_mapUsed * 2 > m_map.size())
+            rehash();
+        return index;
+    }
+
+    void rehash()
+    {
+        std::vector<MapSlot> old(m_map.size() * 2);
+        old.swap(m_map);
+        size_t mask = m_map.size() - 1;
+        for (const MapSlot &s : old)
+        {
+            if (!s.object)
+                continue;
+            size_t i = hash(s.object) & mask;
+            while (m_map[i].object)
+                i = (i + 1) & mask;
+            m_map[i] = s;
+        }
+    }
+
+    static size_t hash(const void *object)
+    {
+        uint64_t v = uint64_t(reinterpret_cast<uintptr_t>(object));
+        return size_t(v * 0x9E3779B97F4A7C15ull >> 32); // the product's high half mixes every address bit
+    }
+
+    std::atomic<bool> m_active{false};
+    PassGraph m_graph;
+
+    // the open pass
+    std::vector<uint32_t> m_reads, m_writes;
+    std::vector<uint32_t> m_readStamp, m_writeStamp; // per resource
+    bool m_sealed = false;                           // the last pass was a command list
+    bool m_targetsWritten = false;
+    bool m_gfxDirty = false, m_csDirty = false;
+
+    // bindings
+    Slots m_srv[PASS_STAGES] = {};
+    Uavs m_csUav = {}, m_omUav = {};
+    const void *m_targets[PASS_TARGETS] = {};
+    uint32_t m_targetCount = 0;
+    const void *m_dsv = nullptr;
+
+    std::vector<MapSlot> m_map;
+    size_t m_mapUsed = 0;
+    size_t m_described = 0;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// json export (dxpipe_passes.json from the overlay, dxpipe_passes --json)
+///////////////////////////////////////////////////////////////////////////////////////////
+
+inline bool writePassGraphJson(const PassGraph &g, FILE *file)
+{
+    fprintf(file, "{\"frame\":%llu,\"timed\":%s,\"gpu_ms\":%.4f,\"joined\":%u,\n\"resources\":[\n",
+            (unsigned long long)g.frame, g.timed ? "true" : "false", g.gpuNs / 1e6, g.joined);
+    for (size_t i = 0; i < g.resources.size(); i++)
+    {
+        const PassResource &r = g.resources[i];
+        fprintf(file, "{\"id\":%zu,\"object\":\"0x%llx\",\"dimension\":\"%s\",\"width\":%u,\"height\":%u,"
+                      "\"format\":%u,\"samples\":%u}%s\n",
+                i, (unsigned long long)reinterpret_cast<uintptr_t>(r.object), passDimensionName(r.dimension),
+                r.width, r.height, r.format, r.samples, i + 1 < g.resources.size() ? "," : "");
+    }
+    fprintf(file, "],\n\"passes\":[\n");
+    for (size_t i = 0; i < g.passes.size(); i++)
+    {
+        const Pass &p = g.passes[i];
+        fprintf(file, "{\"id\":%zu,\"kind\":\"%s\",\"opened\":\"%s\",\"draws\":%u,\"dispatches\":%u,\"clears\":%u,"
+                      "\"copies\":%u,\"gpu_ms\":%.4f,\"reads\":[",
+                i, passKindName(uint32_t(passKind(p))), passOpenName(uint32_t(p.opened)), p.draws, p.dispatches,
+                p.clears, p.copies, p.gpuNs / 1e6);
+        for (uint32_t r = 0; r < p.reads; r++)
+            fprintf(file, "%s%u", r ? "," : "", g.reads(p)[r]);
+        fprintf(file, "],\"writes\":[");
+        for (uint32_t w = 0; w < p.writes; w++)
+            fprintf(file, "%s%u", w ? "," : "", g.writes(p)[w]);
+        fprintf(file, "]}%s\n", i + 1 < g.passes.size() ? "," : "");
+    }
+    fprintf(file, "],\n\"edges\":[\n");
+    for (size_t i = 0; i < g.edges.size(); i++)
+        fprintf(file, "{\"from\":%u,\"to\":%u,\"resource\":%u}%s\n", g.edges[i].from, g.edges[i].to,
+                g.edges[i].resource, i + 1 < g.edges.size() ? "," : "");
+    fprintf(file, "]}\n");
+    return !ferror(file);
+}
@@ -0,0 +1,400 @@
+#pragma once
+
+// c++ includes
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+
+// sse2 quick reject (x64 always has it)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PROJECTION_SCAN_SSE2 1
+#else
+#define PROJECTION_SCAN_SSE2 0
+#endif
+
+// layer headers (platform independent)
+#include "LayerTypes.h"
+#include "LayerEvents.h"
+
+// NOTE: platform independent, fed by the proxies (ProxyDepth.h) or by tools/dxpipe_projection
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// projection inference
+//  • constant buffer writes (discard maps, UpdateSubresource) are scanned for perspective
+//    projection matrices, in both row-major and transposed layouts, jittered or not
+//  • near / far / reversed-Z / infinite far follow from the matrix's z row
+//  • once a matrix is found only its buffer + offset is checked until it goes stale
+//  • without a matrix, reversed-Z is voted from the depth test of the draws and the
+//    clear values that hit the exported depth buffer
+///////////////////////////////////////////////////////////////////////////////////////////
+
+enum DepthProjectionFlags : uint32_t
+{
+    PROJ_VALID = 0x1,       // nearPlane / farPlane are known
+    PROJ_REVERSED_Z = 0x2,  // near maps to depth 1
+    PROJ_INFINITE = 0x4,    // no far plane (farPlane = 0)
+    PROJ_FROM_MATRIX = 0x8, // taken from a projection matrix
+    PROJ_FROM_STATE = 0x10,  // reversed-Z voted from depth tests / clears
+    PROJ_FROM_PROFILE = 0x20 // last launch's result (DepthProfile.h), until this one has its own
+};
+
+// inferred depth parameters of one frame (sent to the client as is, 24 bytes)
+struct DepthProjection
+{
+    float nearPlane;
+    float farPlane;
+    float fovY; // radians, 0 if unknown
+    uint32_t flags;
+    uint64_t frame;
+};
+
+// one projection matrix found in a constant buffer
+struct ProjectionMatch
+{
+    float nearPlane;
+    float farPlane; // 0 = infinite
+    float fovY;
+    float aspect; // width / height
+    bool reversedZ;
+    bool transposed; // column-vector layout (w row at the bottom)
+    uint32_t offset; // byte offset in the buffer
+};
+
+// test 16 floats for a perspective projection
+//  row-major:  | xs 0  0  0 |   transposed: | xs 0  ox 0 |
+//              | 0  ys 0  0 |               | 0  ys oy 0 |
+//              | ox oy A  s |               | 0  0  A  B |
+//              | 0  0  B  0 |               | 0  0  s  0 |
+//  s = ±1 (left / right handed), ox / oy = off-centre or TAA jitter
+inline bool matchProjection(const float *m, float targetAspect, ProjectionMatch &out)
+{
+    float xs = m[0], ys = m[5], A = m[10], B, s, ox, oy;
+    bool transposed;
+
+    if (m[1] != 0.0f || m[3] != 0.0f || m[4] != 0.0f || m[7] != 0.0f)
+        return false;
+
+    if (m[2] == 0.0f && m[6] == 0.0f && m[12] == 0.0f && m[13] == 0.0f && m[15] == 0.0f &&
+        (m[11] == 1.0f || m[11] == -1.0f))
+    {
+        transposed = false;
+        s = m[11];
+        B = m[14];
+        ox = m[8];
+        oy = m[9];
+    }
+    else if (m[8] == 0.0f && m[9] == 0.0f && m[12] == 0.0f && m[13] == 0.0f && m[15] == 0.0f &&
+             (m[14] == 1.0f || m[14] == -1.0f))
+    {
+        transposed = true;
+        s = m[14];
+        B = m[11];
+        ox = m[2];
+        oy = m[6];
+    }
+    else
+    {
+        return false;
+    }
+
+    // plausible lens (fov between ~1° and ~179°, sane aspect, small jitter)
+    float ay = std::fabs(ys);
+    if (!(xs > 0.01f && xs < 100.0f && ay > 0.01f && ay < 100.0f))
+        return false;
+    float aspect = ay / xs;
+    if (aspect < 0.2f || aspect > 5.0f)
+        return false;
+    if (targetAspect > 0.0f && std::fabs(aspect - targetAspect) > targetAspect * 0.05f)
+        return false;
+    if (!(std::fabs(ox) < 1.0f && std::fabs(oy) < 1.0f))
+        return false;
+    if (!std::isfinite(A) || !std::isfinite(B) || B == 0.0f)
+        return false;
+
+    // with t the view distance (z = s * t): depth(t) = a + B / t, a = s * A
+    //  depth 0 at t0 = -B / a, depth 1 at t1 = B / (1 - a)
+    float a = s * A;
+    float t0 = a != 0.0f ? -B / a : INFINITY;
+    float t1 = a != 1.0f ? B / (1.0f - a) : INFINITY;
+
+    float nearPlane, farPlane;
+    bool reversed;
+    if (t0 > 0.0f && t1 > t0)
+    {
+        nearPlane = t0;
+        farPlane = t1;
+        reversed = false;
+    }
+    else if (t1 > 0.0f && t0 > t1)
+    {
+        nearPlane = t1;
+        farPlane = t0;
+        reversed = true;
+    }
+    else
+    {
+        return false;
+    }
+
+    if (nearPlane < 1e-4f || !std::isfinite(nearPlane))
+        return false;
+    if (std::isfinite(farPlane) && farPlane < nearPlane * 1.5f)
+        return false;
+
+    out.nearPlane = nearPlane;
+    out.farPlane = std::isfinite(farPlane) ? farPlane : 0.0f;
+    out.fovY = 2.0f * std::atan(1.0f / ay);
+    out.aspect = aspect;
+    out.reversedZ = reversed;
+    out.transposed = transposed;
+    return true;
+}
+
+// scan a constant buffer for the first projection matrix (matrices sit on 16 byte registers)
+// each register is compared against zero once, only registers whose zero pattern fits the
+// first two rows of a projection reach matchProjection
+inline bool scanProjection(const void *data, size_t size, float targetAspect, ProjectionMatch &out)
+{
+    if (!data || size < 64)
+        return false;
+
+    const uint8_t *base = static_cast<const uint8_t *>(data);
+    size_t regs = size / 16;
+
+    // bit i set = lane i is zero, row 0 needs (x≠0, y=0, w=0), row 1 (x=0, y≠0, w=0)
+    auto zeroMask = [&](size_t r) -> int
+    {
+#if PROJECTION_SCAN_SSE2
+        __m128 v = _mm_loadu_ps(reinterpret_cast<const float *>(base + r * 16));
+        return _mm_movemask_ps(_mm_cmpeq_ps(v, _mm_setzero_ps()));
+#else
+        float f[4];
+        memcpy(f, base + r * 16, sizeof(f));
+        return (f[0] == 0.0f) | ((f[1] == 0.0f) << 1) | ((f[2] == 0.0f) << 2) | ((f[3] == 0.0f) << 3);
+#endif
+    };
+
+    int prev = zeroMask(0);
+    for (size_t r = 0; r + 4 <= regs; r++)
+    {
+        int next = zeroMask(r + 1);
+        if ((prev & 0xB) == 0xA && (next & 0xB) == 0x9)
+        {
+            float m[16];
+            memcpy(m, base + r * 16, sizeof(m));
+            if (matchProjection(m, targetAspect, out))
+            {
+                out.offset = uint32_t(r * 16);
+                return true;
+            }
+        }
+        prev = next;
+    }
+    return false;
+}
+
+class ProjectionInference
+{
+public:
+    // tuning
+    static constexpr uint32_t SCAN_BUDGET = 256 * 1024; // bytes scanned per frame while searching
+    static constexpr uint32_t STALE_FRAMES = 60;        // a matrix not seen for this long is dropped
+    static constexpr float CLEAR_WEIGHT = 16.0f;        // a clear counts as this many draws
+    static constexpr float SMOOTHING = 0.1f;            // weight of the newest frame's vote
+    static constexpr float VOTE_ON = 0.65f;             // reversed-Z set above this share ...
+    static constexpr float VOTE_OFF = 0.35f;            // ... and cleared below this one
+
+    // a depth-stencil state was created
+    void addDepthState(const void *state, bool depthEnable, uint32_t func)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_states[state] = depthEnable ? func : 0;
+    }
+
+    // the game wrote a constant buffer (any thread), data is only valid during the call
+    void onConstants(const void *buffer, const void *data, size_t size)
+    {
+        if (!buffer || !data || size < 64)
+            return;
+
+        float aspect = m_aspect.load(std::memory_order_relaxed);
+        ProjectionMatch match = {};
+
+        // locked onto a buffer, only its matrix slot is checked
+        if (const void *locked = m_lockedBuffer.load(std::memory_order_acquire))
+        {
+            if (buffer != locked)
+                return;
+            uint32_t offset = m_lockedOffset.load(std::memory_order_relaxed);
+            if (size_t(offset) + 64 > size)
+                return;
+            float m[16];
+            memcpy(m, static_cast<const uint8_t *>(data) + offset, sizeof(m));
+            if (!matchProjection(m, aspect, match))
+                return; // another pass reused the slot, the lock goes stale if this persists
+            match.offset = offset;
+            publish(buffer, match);
+            return;
+        }
+
+        // searching, bounded per frame
+        if (m_scanned.fetch_add(uint32_t(size), std::memory_order_relaxed) >= SCAN_BUDGET)
+            return;
+        if (scanProjection(data, size, aspect, match))
+            publish(buffer, match);
+    }
+
+    // combine this frame's votes with the matrix lock, events must not be spliced into yet
+    // isTracked(view) says whether a DSV belongs to the exported depth buffer
+    template <class IsTracked>
+    DepthProjection endFrame(const EventBuffer &events, uint64_t frame, uint32_t width, uint32_t height, IsTracked isTracked)
+    {
+        m_aspect.store(width && height ? float(width) / float(height) : 0.0f, std::memory_order_relaxed);
+        m_scanned.store(0, std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_frame = frame;
+
+        // depth test votes of the draws into the exported depth buffer, per context
+        float reversedVotes = 0.0f, standardVotes = 0.0f;
+        struct Bound
+        {
+            bool tracked;
+            uint32_t func;
+        };
+        Bound immediate = {false, CMP_LESS}, deferredBound = {false, CMP_LESS};
+        uint16_t deferred = 0;
+        for (const LayerEvent &e : events)
+        {
+            if (e.context && e.context != deferred)
+            {
+                deferred = e.context;
+                deferredBound = {false, CMP_LESS};
+            }
+            Bound &bound = e.context ? deferredBound : immediate;
+
+            switch (e.kind)
+            {
+            case EventKind::SetRenderTargets:
+                bound.tracked = e.object && isTracked(e.object);
+                break;
+            case EventKind::SetDepthStencilState:
+            {
+                // nullptr = default state (depth enabled, LESS)
+                auto it = e.object ? m_states.find(e.object) : m_states.end();
+                bound.func = !e.object ? uint32_t(CMP_LESS) : (it != m_states.end() ? it->second : 0);
+                break;
+            }
+            case EventKind::ClearDepthStencil:
+            {
+                if (!(e.arg2 & CLEAR_DEPTH) || !e.object || !isTracked(e.object))
+                    break;
+                uint32_t bits = uint32_t(e.arg);
+                float depth;
+                memcpy(&depth, &bits, sizeof(depth));
+                if (depth == 0.0f)
+                    reversedVotes += CLEAR_WEIGHT;
+                else if (depth == 1.0f)
+                    standardVotes += CLEAR_WEIGHT;
+                break;
+            }
+            case EventKind::Draw:
+            case EventKind::DrawIndexed:
+            case EventKind::DrawInstanced:
+            case EventKind::DrawIndexedInstanced:
+            case EventKind::DrawIndirect:
+                if (!bound.tracked)
+                    break;
+                if (bound.func == CMP_GREATER || bound.func == CMP_GREATER_EQUAL)
+                    reversedVotes += 1.0f;
+                else if (bound.func == CMP_LESS || bound.func == CMP_LESS_EQUAL)
+                    standardVotes += 1.0f;
+                break;
+            default:
+                break;
+            }
+        }
+
+        float total = reversedVotes + standardVotes;
+        if (total > 0.0f)
+        {
+            m_reversedShare += (reversedVotes / total - m_reversedShare) * SMOOTHING;
+            m_haveVotes = true;
+        }
+        if (m_reversedShare > VOTE_ON)
+            m_votedReversed = true;
+        else if (m_reversedShare < VOTE_OFF)
+            m_votedReversed = false;
+
+        // drop a matrix that stopped showing up (camera buffer recreated, scene change)
+        if (m_lockedBuffer.load(std::memory_order_relaxed) && frame - m_matchFrame > STALE_FRAMES)
+        {
+            m_lockedBuffer.store(nullptr, std::memory_order_release);
+            m_haveMatch = false;
+        }
+
+        DepthProjection p = {0.0f, 0.0f, 0.0f, 0, frame};
+        if (m_haveMatch)
+        {
+            p.nearPlane = m_match.nearPlane;
+            p.farPlane = m_match.farPlane;
+            p.fovY = m_match.fovY;
+            p.flags = PROJ_VALID | PROJ_FROM_MATRIX;
+            if (m_match.reversedZ)
+                p.flags |= PROJ_REVERSED_Z;
+            if (m_match.farPlane == 0.0f)
+                p.flags |= PROJ_INFINITE;
+        }
+        else if (m_haveVotes)
+        {
+            p.flags = PROJ_FROM_STATE | (m_votedReversed ? uint32_t(PROJ_REVERSED_Z) : 0u);
+        }
+        m_current = p;
+        return p;
+    }
+
+    DepthProjection current() const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_current;
+    }
+
+    // the buffer / offset the matrix was found at (nullptr while searching)
+    const void *lockedBuffer(uint32_t &offset) const
+    {
+        offset = m_lockedOffset.load(std::memory_order_relaxed);
+        return m_lockedBuffer.load(std::memory_order_acquire);
+    }
+
+private:
+    void publish(const void *buffer, const ProjectionMatch &match)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_match = match;
+        m_matchFrame = m_frame;
+        m_haveMatch = true;
+        m_lockedOffset.store(match.offset, std::memory_order_relaxed);
+        m_lockedBuffer.store(buffer, std::memory_order_release);
+    }
+
+    mutable std::mutex m_lock;
+    std::unordered_map<const void *, uint32_t> m_states; // state → depth func (0 = depth off)
+    ProjectionMatch m_match = {};
+    uint64_t m_matchFrame = 0;
+    uint64_t m_frame = 0;
+    bool m_haveMatch = false;
+    float m_reversedShare = 0.0f;
+    bool m_votedReversed = false;
+    bool m_haveVotes = false;
+    DepthProjection m_current = {};
+
+    std::atomic<const void *> m_lockedBuffer{nullptr};
+    std::atomic<uint32_t> m_lockedOffset{0};
+    std::atomic<uint32_t> m_scanned{0};
+    std::atomic<float> m_aspect{0.0f};
+};
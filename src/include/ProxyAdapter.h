@@ -14,9 +14,8 @@
 #include <dxgi.h>
 #include <dxgi1_2.h>
 
-// helpers from d3d11.cpp
-extern std::string timeStamp();
-extern void output();
+// structured log (g_Log, the LOG_ macros)
+#include "LayerLog.h"
 
 // include our factory proxy
 #include "ProxyFactory.h"
@@ -68,12 +67,7 @@ public:
              riid == __uuidof(IDXGIFactory1) ||
              riid == __uuidof(IDXGIFactory2)))
         {
-#if DEBUG
-            output();
-#endif
-#if DEBUG
-            std::cout << timeStamp() << "IDXGIAdapter::GetParent → wrapping factory" << std::endl;
-#endif
+            LOG_INFO(Device, "IDXGIAdapter::GetParent → wrapping factory");
 
             IDXGIFactory2 *f2 = nullptr;
             if (SUCCEEDED(((IUnknown *)*ppParent)->QueryInterface(__uuidof(IDXGIFactory2), (void **)&f2)))
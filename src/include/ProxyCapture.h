@@ -0,0 +1,101 @@
+#pragma once
+
+// enable/disable API call capture (writes <game dir>\dxpipe_capture.dxcap)
+#define ENABLE_CAPTURE 0
+
+// c++ includes
+#include <iostream>
+#include <string>
+
+// windows headers
+#define NOMINMAX // disable min/max macros
+#include <Windows.h>
+
+// directx 11 headers
+#include <d3d11.h>
+
+// capture format + writer
+#include "CaptureLog.h"
+
+// structured log (g_Log, the LOG_ macros)
+#include "LayerLog.h"
+
+// the capture stream (closed unless ENABLE_CAPTURE)
+extern CaptureWriter g_Capture;
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// helpers to translate d3d11 calls into capture records
+///////////////////////////////////////////////////////////////////////////////////////////
+
+inline uint64_t captureHandle(const void *p)
+{
+    return uint64_t(reinterpret_cast<uintptr_t>(p));
+}
+
+// open the capture next to the game executable
+inline void openCapture()
+{
+    char path[MAX_PATH];
+    GetModuleFileNameA(GetModuleHandle(NULL), path, MAX_PATH);
+    char *lastSlash = strrchr(path, '\\');
+    if (lastSlash)
+        lastSlash[1] = '\0';
+    strncat_s(path, "dxpipe_capture.dxcap", _TRUNCATE);
+
+    if (g_Capture.open(path))
+    {
+        LOG_INFO(Hooks, "Capturing API calls to: {}", path);
+    }
+    else
+    {
+        LOG_ERROR(Hooks, "Failed to open capture file: {}", path);
+    }
+}
+
+inline void captureTexture2D(CaptureOp op, ID3D11Texture2D *tex, const D3D11_TEXTURE2D_DESC &d)
+{
+    if (!g_Capture.isOpen() || !tex)
+        return;
+
+    CaptureTextureDesc cd = {d.Width, d.Height, d.MipLevels, d.ArraySize, uint32_t(d.Format),
+                             d.SampleDesc.Count, d.SampleDesc.Quality, uint32_t(d.Usage),
+                             d.BindFlags, d.CPUAccessFlags, d.MiscFlags};
+    uint64_t blob = g_Capture.writeBlob(&cd, sizeof(cd));
+    g_Capture.write({uint16_t(op), 0, 0, captureHandle(tex), 0, blob});
+}
+
+inline void captureBuffer(ID3D11Buffer *buf, const D3D11_BUFFER_DESC &d)
+{
+    if (!g_Capture.isOpen() || !buf)
+        return;
+
+    CaptureBufferDesc cd = {d.ByteWidth, uint32_t(d.Usage), d.BindFlags,
+                            d.CPUAccessFlags, d.MiscFlags, d.StructureByteStride};
+    uint64_t blob = g_Capture.writeBlob(&cd, sizeof(cd));
+    g_Capture.write({uint16_t(CaptureOp::CreateBuffer), 0, 0, captureHandle(buf), 0, blob});
+}
+
+inline void captureView(CaptureViewType type, const void *view, ID3D11Resource *res)
+{
+    if (!g_Capture.isOpen() || !view)
+        return;
+    g_Capture.write({uint16_t(CaptureOp::CreateView), 0, uint32_t(type),
+                     captureHandle(view), captureHandle(res), 0});
+}
+
+inline void captureDepthState(ID3D11DepthStencilState *state, const D3D11_DEPTH_STENCIL_DESC &d)
+{
+    if (!g_Capture.isOpen() || !state)
+        return;
+    g_Capture.write({uint16_t(CaptureOp::CreateDepthStencilState), 0,
+                     uint32_t(d.DepthFunc) | (uint32_t(d.DepthEnable ? 1 : 0) << 8),
+                     captureHandle(state), 0, 0});
+}
+
+inline void captureResize(UINT w, UINT h, DXGI_FORMAT fmt)
+{
+    if (!g_Capture.isOpen())
+        return;
+    g_Capture.write({uint16_t(CaptureOp::ResizeBuffers), 0, uint32_t(fmt), 0,
+                     uint64_t(w) | (uint64_t(h) << 32), 0});
+}
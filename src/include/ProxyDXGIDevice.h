@@ -14,9 +14,8 @@
 #include <dxgi.h>
 #include <dxgi1_2.h>
 
-// helpers from d3d11.cpp
-extern std::string timeStamp();
-extern void output();
+// structured log (g_Log, the LOG_ macros)
+#include "LayerLog.h"
 
 // forward declare adapter proxy (pointer only)
 class ProxyAdapter;
@@ -71,12 +70,7 @@ public:
         HRESULT hr = m_real->GetAdapter(ppAdapter);
         if (SUCCEEDED(hr) && ppAdapter && *ppAdapter)
         {
-#if DEBUG
-            output();
-#endif
-#if DEBUG
-            std::cout << timeStamp() << "IDXGIDevice::GetAdapter → wrapping adapter" << std::endl;
-#endif
+            LOG_INFO(Device, "IDXGIDevice::GetAdapter → wrapping adapter");
 
             IDXGIAdapter *realAdapter = *ppAdapter;
             *ppAdapter = new ProxyAdapter(realAdapter);
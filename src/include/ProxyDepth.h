@@ -0,0 +1,316 @@
+#pragma once
+
+// c++ includes
+#include <iostream>
+#include <string>
+#include <atomic>
+
+// windows headers
+#define NOMINMAX // disable min/max macros
+#include <Windows.h>
+
+// directx 11 headers
+#include <d3d11.h>
+
+// scoring core + clear time snapshots + projection inference + camera matrices
+#include "DepthCandidates.h"
+#include "DepthSnapshot.h"
+#include "ProjectionInference.h"
+#include "CameraInference.h"
+
+// destruction notifications (candidates are tracked weakly)
+#include "ProxyTracking.h"
+
+// structured log (g_Log, the LOG_ macros)
+#include "LayerLog.h"
+
+// helper decls (implemented in d3d11.cpp)
+extern int g_Width;                                   // target width
+extern int g_Height;                                  // target height
+extern std::atomic<ID3D11Texture2D *> g_DepthTexture; // live depth RT (exported, weak)
+extern std::atomic<ID3D11Texture2D *> g_DepthHeld;    // the layer's counted reference on it
+extern FrameTimeline g_FrameTimeline;                 // events of the current frame
+
+// every depth-capable texture the game created
+extern DepthCandidates g_DepthCandidates;
+
+// scene depth copied on the immediate context before a clear / reuse destroys it
+extern DepthSpanTracker g_DepthSpans;
+extern ID3D11Texture2D *g_DepthSnapshot;
+
+// set while someone reads the exported depth (client connected, overlay), snapshots are
+// only taken then
+extern std::atomic<bool> g_DepthWanted;
+
+// near / far / reversed-Z of the exported depth, inferred every Present
+extern ProjectionInference g_Projection;
+extern DepthProjection g_DepthProjection;
+
+// view / projection of the scene camera, published every Present
+extern CameraInference g_Camera;
+extern CameraMatrices g_CameraMatrices;
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// depth candidate glue
+//  • ProxyDevice registers depth-capable textures and their DSVs
+//  • Present scores the frame and swaps g_DepthTexture when the winner changes
+//  • candidates are weak, a destroyed one leaves the table (and g_DepthTexture) through
+//    its destruction sentinel, on the thread that released it
+//  • the promoted texture is referenced when the game binds / clears one of its views
+//    (the view holds it for the call), until the end of that frame's Present (g_DepthHeld)
+///////////////////////////////////////////////////////////////////////////////////////////
+
+inline void trackDepthCandidate(ID3D11Texture2D *tex, const D3D11_TEXTURE2D_DESC &d)
+{
+    DepthTextureInfo info = {d.Width, d.Height, uint32_t(d.Format), d.SampleDesc.Count,
+                             d.ArraySize, d.BindFlags};
+    if (g_DepthCandidates.addTexture(tex, info))
+    {
+        trackTexture(tex, TrackedKind::DepthCandidate);
+        LOG_INFO(Device, "Depth candidate {} ({}x{} format {} samples {})", tex, d.Width, d.Height, d.Format,
+                 d.SampleDesc.Count);
+    }
+}
+
+inline void trackDepthView(ID3D11DepthStencilView *dsv, ID3D11Resource *res)
+{
+    g_DepthCandidates.addView(dsv, res);
+}
+
+// score the frame that is being presented, swap g_DepthTexture if another candidate won
+// the winner may be destroyed on another thread right after scoring: publish it first,
+// then take it back if its notification already ran (it cleared nothing then)
+inline void promoteDepthCandidate()
+{
+    ID3D11Texture2D *best = static_cast<ID3D11Texture2D *>(const_cast<void *>(
+        g_DepthCandidates.endFrame(g_FrameTimeline.events, g_FrameTimeline.frame(),
+                                   uint32_t(g_Width), uint32_t(g_Height))));
+    if (!best || best == g_DepthTexture.load())
+        return;
+
+    g_DepthTexture.store(best); // weak until its next bind / clear takes g_DepthHeld
+    g_DepthSpans.reset();       // spans / snapshot belonged to the old buffer
+    releaseDepthHold();         // the old buffer's reference
+    if (!g_Resources.alive(best))
+    {
+        g_DepthTexture.compare_exchange_strong(best, nullptr);
+        return;
+    }
+
+    if (LOG_ENABLED(Info, Device))
+    {
+        D3D11_TEXTURE2D_DESC d{};
+        best->GetDesc(&d);
+        LOG_INFO(Device, "Depth texture promoted: {} ({}x{} format {})", best, d.Width, d.Height, d.Format);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// clear time snapshots (immediate context only, and only while g_DepthWanted)
+///////////////////////////////////////////////////////////////////////////////////////////
+
+// is dsv a view of g_DepthTexture? the answer is cached per candidate epoch (and per
+// thread, deferred contexts record anywhere) so the bind path only takes the candidate
+// lock when a view / promotion changed
+inline bool isTrackedDepthView(const void *dsv)
+{
+    struct Entry
+    {
+        const void *view;
+        const void *depth;
+        uint32_t epoch;
+        bool tracked;
+    };
+    static thread_local Entry s_cache[4] = {};
+    static thread_local uint32_t s_next = 0;
+
+    const ID3D11Texture2D *depth = g_DepthTexture.load(std::memory_order_acquire);
+    if (!dsv || !depth)
+        return false;
+
+    uint32_t epoch = g_DepthCandidates.epoch();
+    for (const Entry &e : s_cache)
+    {
+        if (e.view == dsv && e.depth == depth && e.epoch == epoch)
+            return e.tracked;
+    }
+
+    Entry &e = s_cache[s_next++ & 3];
+    e = {dsv, depth, epoch, g_DepthCandidates.textureOfView(dsv) == depth};
+    return e.tracked;
+}
+
+// the game binds / clears dsv (any context): if it is a view of the promoted texture and
+// that isn't held yet, take the layer's reference through the view, which is alive for the
+// call and holds its texture, unlike the weak g_DepthTexture
+inline void holdDepthFromView(ID3D11DepthStencilView *dsv)
+{
+    ID3D11Texture2D *depth = g_DepthTexture.load(std::memory_order_acquire);
+    if (!dsv || !depth || g_DepthHeld.load(std::memory_order_acquire) || !isTrackedDepthView(dsv))
+        return;
+
+    ID3D11Resource *res = nullptr;
+    dsv->GetResource(&res);
+    if (res != depth)
+    {
+        if (res)
+            res->Release(); // promoted again meanwhile
+        return;
+    }
+
+    // counted before it is published, Present may drop it right away
+    g_Resources.hold(depth);
+    ID3D11Texture2D *expected = nullptr;
+    if (!g_DepthHeld.compare_exchange_strong(expected, depth))
+        dropResource(depth); // another context took it first, else GetResource's reference is held
+}
+
+// copy g_DepthTexture into g_DepthSnapshot (recreated when the depth buffer changes), the
+// game just bound / cleared a view of it, so the view keeps it alive for the copy
+inline void snapshotDepth(ID3D11DeviceContext *real)
+{
+    ID3D11Texture2D *depth = g_DepthTexture.load(std::memory_order_acquire);
+    if (!depth)
+        return;
+
+    D3D11_TEXTURE2D_DESC d{};
+    depth->GetDesc(&d);
+
+    if (g_DepthSnapshot)
+    {
+        D3D11_TEXTURE2D_DESC cur{};
+        g_DepthSnapshot->GetDesc(&cur);
+        if (cur.Width != d.Width || cur.Height != d.Height || cur.Format != d.Format ||
+            cur.SampleDesc.Count != d.SampleDesc.Count || cur.ArraySize != d.ArraySize ||
+            cur.MipLevels != d.MipLevels)
+        {
+            g_DepthSnapshot->Release();
+            g_DepthSnapshot = nullptr;
+        }
+    }
+
+    if (!g_DepthSnapshot)
+    {
+        ID3D11Device *device = nullptr;
+        real->GetDevice(&device);
+        if (!device)
+            return;
+
+        // same layout, no depth binding (CopyResource only needs matching format / size)
+        d.Usage = D3D11_USAGE_DEFAULT;
+        d.BindFlags &= D3D11_BIND_SHADER_RESOURCE;
+        d.CPUAccessFlags = 0;
+        d.MiscFlags = 0;
+        HRESULT hr = device->CreateTexture2D(&d, nullptr, &g_DepthSnapshot);
+        device->Release();
+        if (FAILED(hr))
+        {
+            LOG_ERROR(Device, "Failed to create depth snapshot texture! HRESULT: {:x}", hr);
+            g_DepthSnapshot = nullptr;
+            return;
+        }
+        LOG_INFO(Device, "Depth snapshot texture created ({}x{})", d.Width, d.Height);
+    }
+
+    real->CopyResource(g_DepthSnapshot, depth);
+}
+
+// OMSetRenderTargets on the immediate context (before forwarding)
+inline void depthOnBind(ID3D11DeviceContext *real, const void *dsv)
+{
+    if (g_DepthSpans.onBind(isTrackedDepthView(dsv)))
+        snapshotDepth(real);
+}
+
+// ClearDepthStencilView on the immediate context (before forwarding)
+inline void depthOnClear(ID3D11DeviceContext *real, const void *dsv)
+{
+    if (g_DepthSpans.onClear(isTrackedDepthView(dsv)))
+        snapshotDepth(real);
+}
+
+// the texture holding this frame's scene depth, called once per Present with the frame's
+// reference on g_DepthTexture (acquireDepthTexture, nullptr while it isn't held)
+inline ID3D11Texture2D *depthExportSource(ID3D11Texture2D *depth)
+{
+    if (!depth || !g_DepthWanted.load(std::memory_order_relaxed))
+    {
+        g_DepthSpans.reset(); // also drops the snapshot of a destroyed depth buffer
+        return depth;
+    }
+
+    if (g_DepthSpans.endFrame() == DepthSource::Snapshot && g_DepthSnapshot)
+        return g_DepthSnapshot;
+    return depth;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// projection inference (scans only while g_DepthWanted)
+///////////////////////////////////////////////////////////////////////////////////////////
+
+inline void trackDepthState(ID3D11DepthStencilState *state, const D3D11_DEPTH_STENCIL_DESC &d)
+{
+    g_Projection.addDepthState(state, d.DepthEnable != FALSE, uint32_t(d.DepthFunc));
+}
+
+inline bool isConstantBuffer(ID3D11Resource *r)
+{
+    D3D11_RESOURCE_DIMENSION dim = D3D11_RESOURCE_DIMENSION_UNKNOWN;
+    r->GetType(&dim);
+    if (dim != D3D11_RESOURCE_DIMENSION_BUFFER)
+        return false;
+    D3D11_BUFFER_DESC d{};
+    static_cast<ID3D11Buffer *>(r)->GetDesc(&d);
+    return (d.BindFlags & D3D11_BIND_CONSTANT_BUFFER) != 0;
+}
+
+// new constant buffer contents (Unmap after a discard, UpdateSubresource), any context
+inline void scanConstants(ID3D11Resource *r, const void *data, size_t size)
+{
+    g_Projection.onConstants(r, data, size);
+    g_Camera.onConstants(r, data, size);
+}
+
+// called once per Present, before the frame's events are dropped
+inline void inferProjection()
+{
+    if (!g_DepthWanted.load(std::memory_order_relaxed))
+        return;
+
+    DepthProjection prev = g_DepthProjection;
+    g_DepthProjection = g_Projection.endFrame(g_FrameTimeline.events, g_FrameTimeline.frame(),
+                                              uint32_t(g_Width), uint32_t(g_Height), isTrackedDepthView);
+    if (g_DepthProjection.flags != prev.flags || g_DepthProjection.nearPlane != prev.nearPlane ||
+        g_DepthProjection.farPlane != prev.farPlane)
+    {
+        LOG_INFO(Device, "Depth projection: near {} far {} flags 0x{:x}", g_DepthProjection.nearPlane,
+                 g_DepthProjection.farPlane, g_DepthProjection.flags);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// camera matrices (only while g_DepthWanted, shadows nothing but the locked camera buffer)
+///////////////////////////////////////////////////////////////////////////////////////////
+
+// VSSetConstantBuffers, any context (a single compare once the camera buffer is locked)
+inline void trackCameraBuffers(ID3D11Buffer *const *buffers, UINT count)
+{
+    g_Camera.onBind(reinterpret_cast<const void *const *>(buffers), count);
+}
+
+// called once per Present, after inferProjection
+inline void inferCamera()
+{
+    if (!g_DepthWanted.load(std::memory_order_relaxed))
+        return;
+
+    uint32_t prev = g_CameraMatrices.flags;
+    g_CameraMatrices = g_Camera.endFrame(g_FrameTimeline.frame(), uint32_t(g_Width), uint32_t(g_Height));
+    if (((g_CameraMatrices.flags ^ prev) & (CAM_VALID | CAM_CONFIRMED)) && LOG_ENABLED(Info, Device))
+    {
+        uint32_t viewOffset = 0, projOffset = 0;
+        const void *buffer = g_Camera.lockedBuffer(viewOffset, projOffset);
+        LOG_INFO(Device, "Camera buffer: {} (view +{} projection +{} flags 0x{:x})", buffer, viewOffset, projOffset,
+                 g_CameraMatrices.flags);
+    }
+}
@@ -18,17 +18,25 @@
 #include "ProxyDeviceContext.h"
 #include "ProxyDXGIDevice.h" // lets us wrap IDXGIDevice
 
+// depth buffer detection (candidate registration)
+#include "ProxyDepth.h"
+
+// binary trace of the hot paths (records in DEBUG builds or once switched on)
+#include "TraceLog.h"
+
+// structured log (g_Log, the LOG_ macros)
+#include "LayerLog.h"
+
 // forward decls for helpers implemented in d3d11.cpp
-extern std::string timeStamp();
-extern void output();
+extern TraceLog g_Trace;
 extern int g_Width;  // target width
 extern int g_Height; // target height
 
 // depth texture address
-extern ID3D11Texture2D *g_DepthTexture;
+extern std::atomic<ID3D11Texture2D *> g_DepthTexture;
 
 // ID3D11Device proxy wrapper
-// logs every CreateTexture2D call, forwards everything else unaltered
+// traces every CreateTexture2D call, forwards everything else unaltered
 class ProxyDevice : public ID3D11Device
 {
 public:
@@ -56,14 +64,7 @@ public:
             IDXGIDevice *realDX = nullptr;
             if (SUCCEEDED(m_real->QueryInterface(__uuidof(IDXGIDevice), (void **)&realDX)) && realDX)
             {
-#if DEBUG
-                output();
-#endif
-#if DEBUG
-                std::cout << timeStamp()
-                          << "ID3D11Device::QueryInterface → wrapping IDXGIDevice"
-                          << std::endl;
-#endif
+                LOG_INFO(Device, "ID3D11Device::QueryInterface → wrapping IDXGIDevice");
 
                 *ppv = static_cast<IDXGIDevice *>(new ProxyDXGIDevice(realDX));
                 realDX->Release();
@@ -93,84 +94,22 @@ public:
         const D3D11_SUBRESOURCE_DATA *pInitialData,
         ID3D11Texture2D **ppTexture2D) override
     {
-#if DEBUG
-        output();
-#endif
-        // log the call if the width, height, and format match
-        if (pDesc && pDesc->Height == g_Height && pDesc->Width == g_Width &&
-            pDesc->Format == DXGI_FORMAT_R32_TYPELESS)
-        {
-#if DEBUG
-            std::cout << timeStamp() << "CreateTexture2D called!" << std::endl;
-#endif
-#if DEBUG
-            std::cout << timeStamp() << "Width: " << pDesc->Width << std::endl;
-#endif
-#if DEBUG
-            std::cout << timeStamp() << "Height: " << pDesc->Height << std::endl;
-#endif
-#if DEBUG
-            std::cout << timeStamp() << "Format: " << pDesc->Format << std::endl;
-#endif
-#if DEBUG
-            std::cout << timeStamp() << "MipLevels: " << pDesc->MipLevels << std::endl;
-#endif
-#if DEBUG
-            std::cout << timeStamp() << "ArraySize: " << pDesc->ArraySize << std::endl;
-#endif
-#if DEBUG
-            std::cout << timeStamp() << "Sample.Count: " << pDesc->SampleDesc.Count << std::endl;
-#endif
-#if DEBUG
-            std::cout << timeStamp() << "Sample.Quality: " << pDesc->SampleDesc.Quality << std::endl;
-#endif
-#if DEBUG
-            std::cout << timeStamp() << "Usage: " << pDesc->Usage << std::endl;
-#endif
-#if DEBUG
-            std::cout << timeStamp() << "BindFlags: " << pDesc->BindFlags << std::endl;
-#endif
-#if DEBUG
-            std::cout << timeStamp() << "CPUAccessFlags: " << pDesc->CPUAccessFlags << std::endl;
-#endif
-#if DEBUG
-            std::cout << timeStamp() << "MiscFlags: " << pDesc->MiscFlags << std::endl;
-#endif
-
-            // calculate the size of the depth texture in bytes
-            size_t bytesPerPixel = (pDesc->Format == DXGI_FORMAT_R16_TYPELESS ||
-                                    pDesc->Format == DXGI_FORMAT_R16_FLOAT ||
-                                    pDesc->Format == DXGI_FORMAT_D16_UNORM)
-                                       ? 2
-                                       : 4;
-
-            size_t memorySize = static_cast<size_t>(pDesc->Width) * pDesc->Height *
-                                pDesc->ArraySize * bytesPerPixel;
-#if DEBUG
-            std::cout << timeStamp() << "Memory Size: " << memorySize << " bytes" << std::endl;
-#endif
-        }
+        if (pDesc)
+            g_Trace.log(TraceEvent::CreateTexture2D, uint32_t(pDesc->Format),
+                        uint64_t(pDesc->Width) | (uint64_t(pDesc->Height) << 32),
+                        uint64_t(pDesc->BindFlags) | (uint64_t(pDesc->SampleDesc.Count) << 32));
 
         // forward the call to the real device
         HRESULT hr = m_real->CreateTexture2D(pDesc, pInitialData, ppTexture2D);
 
-        // intercept the call & log the address of the target texture
-        if (SUCCEEDED(hr) && ppTexture2D && *ppTexture2D &&
-            pDesc && pDesc->SampleDesc.Count == 1 &&
-            pDesc->Width == g_Width &&
-            pDesc->Height == g_Height &&
-            pDesc->Format == DXGI_FORMAT_R32_TYPELESS)
-        {
-            // release previous depth surface (if any)
-            if (g_DepthTexture)
-                g_DepthTexture->Release();
-
-            g_DepthTexture = *ppTexture2D;
-            g_DepthTexture->AddRef(); // avoid premature release
-#if DEBUG
-            std::cout << timeStamp() << "Depth texture address: " << g_DepthTexture << std::endl;
+#if ENABLE_CAPTURE
+        if (SUCCEEDED(hr) && pDesc && ppTexture2D && *ppTexture2D)
+            captureTexture2D(CaptureOp::CreateTexture2D, *ppTexture2D, *pDesc);
 #endif
-        }
+
+        // every depth-capable texture becomes a candidate, Present picks the scene depth
+        if (SUCCEEDED(hr) && ppTexture2D && *ppTexture2D && pDesc)
+            trackDepthCandidate(*ppTexture2D, *pDesc);
 
         return hr;
     }
@@ -181,7 +120,12 @@ public:
         const D3D11_SUBRESOURCE_DATA *pInitialData,
         ID3D11Buffer **ppBuffer) override
     {
-        return m_real->CreateBuffer(pDesc, pInitialData, ppBuffer);
+        HRESULT hr = m_real->CreateBuffer(pDesc, pInitialData, ppBuffer);
+#if ENABLE_CAPTURE
+        if (SUCCEEDED(hr) && pDesc && ppBuffer && *ppBuffer)
+            captureBuffer(*ppBuffer, *pDesc);
+#endif
+        return hr;
     }
 
     HRESULT STDMETHODCALLTYPE CreateTexture1D(
@@ -205,7 +149,12 @@ public:
         const D3D11_SHADER_RESOURCE_VIEW_DESC *pDesc,
         ID3D11ShaderResourceView **ppSRView) override
     {
-        return m_real->CreateShaderResourceView(pResource, pDesc, ppSRView);
+        HRESULT hr = m_real->CreateShaderResourceView(pResource, pDesc, ppSRView);
+#if ENABLE_CAPTURE
+        if (SUCCEEDED(hr) && ppSRView)
+            captureView(CaptureViewSRV, *ppSRView, pResource);
+#endif
+        return hr;
     }
 
     HRESULT STDMETHODCALLTYPE CreateUnorderedAccessView(
@@ -213,7 +162,12 @@ public:
         const D3D11_UNORDERED_ACCESS_VIEW_DESC *pDesc,
         ID3D11UnorderedAccessView **ppUAView) override
     {
-        return m_real->CreateUnorderedAccessView(pResource, pDesc, ppUAView);
+        HRESULT hr = m_real->CreateUnorderedAccessView(pResource, pDesc, ppUAView);
+#if ENABLE_CAPTURE
+        if (SUCCEEDED(hr) && ppUAView)
+            captureView(CaptureViewUAV, *ppUAView, pResource);
+#endif
+        return hr;
     }
 
     HRESULT STDMETHODCALLTYPE CreateRenderTargetView(
@@ -221,7 +175,12 @@ public:
         const D3D11_RENDER_TARGET_VIEW_DESC *pDesc,
         ID3D11RenderTargetView **ppRTView) override
     {
-        return m_real->CreateRenderTargetView(pResource, pDesc, ppRTView);
+        HRESULT hr = m_real->CreateRenderTargetView(pResource, pDesc, ppRTView);
+#if ENABLE_CAPTURE
+        if (SUCCEEDED(hr) && ppRTView)
+            captureView(CaptureViewRTV, *ppRTView, pResource);
+#endif
+        return hr;
     }
 
     HRESULT STDMETHODCALLTYPE CreateDepthStencilView(
@@ -229,7 +188,14 @@ public:
         const D3D11_DEPTH_STENCIL_VIEW_DESC *pDesc,
         ID3D11DepthStencilView **ppDSView) override
     {
-        return m_real->CreateDepthStencilView(pResource, pDesc, ppDSView);
+        HRESULT hr = m_real->CreateDepthStencilView(pResource, pDesc, ppDSView);
+        if (SUCCEEDED(hr) && ppDSView && *ppDSView)
+            trackDepthView(*ppDSView, pResource);
+#if ENABLE_CAPTURE
+        if (SUCCEEDED(hr) && ppDSView)
+            captureView(CaptureViewDSV, *ppDSView, pResource);
+#endif
+        return hr;
     }
 
     HRESULT STDMETHODCALLTYPE CreateInputLayout(
@@ -337,7 +303,16 @@ public:
         const D3D11_DEPTH_STENCIL_DESC *pDesc,
         ID3D11DepthStencilState **ppDepthStencilState) override
     {
-        return m_real->CreateDepthStencilState(pDesc, ppDepthStencilState);
+        HRESULT hr = m_real->CreateDepthStencilState(pDesc, ppDepthStencilState);
+        if (SUCCEEDED(hr) && pDesc && ppDepthStencilState && *ppDepthStencilState)
+        {
+            // depth func feeds the reversed-Z vote
+            trackDepthState(*ppDepthStencilState, *pDesc);
+#if ENABLE_CAPTURE
+            captureDepthState(*ppDepthStencilState, *pDesc);
+#endif
+        }
+        return hr;
     }
 
     HRESULT STDMETHODCALLTYPE CreateRasterizerState(
@@ -379,7 +354,16 @@ public:
         UINT ContextFlags,
         ID3D11DeviceContext **ppDeferredContext) override
     {
-        return m_real->CreateDeferredContext(ContextFlags, ppDeferredContext);
+        HRESULT hr = m_real->CreateDeferredContext(ContextFlags, ppDeferredContext);
+
+        // wrap deferred contexts so worker-thread recordings reach the frame timeline
+        if (SUCCEEDED(hr) && ppDeferredContext && *ppDeferredContext)
+        {
+            ID3D11DeviceContext *realContext = *ppDeferredContext;
+            *ppDeferredContext = new ProxyDeviceContext(realContext);
+            realContext->Release();
+        }
+        return hr;
     }
 
     HRESULT STDMETHODCALLTYPE OpenSharedResource(
@@ -6,6 +6,7 @@
 #include <sstream>
 #include <string>
 #include <atomic>
+#include <mutex>
 
 // windows headers
 #define NOMINMAX // disable min/max macros
@@ -15,24 +16,306 @@
 #include <d3d11.h>
 #include <dxgi1_2.h>
 
+// per-context event recording
+#include "LayerEvents.h"
+
+// API call capture (ENABLE_CAPTURE)
+#include "ProxyCapture.h"
+
+// binary trace of the hot paths (records in DEBUG builds or once switched on)
+#include "TraceLog.h"
+
+// depth detection + clear time snapshots
+#include "ProxyDepth.h"
+
+// structured log (g_Log, the LOG_ macros)
+#include "LayerLog.h"
+
+// per-thread API call counters
+#include "ApiCensus.h"
+
+// pass graph of the sampled frames
+#include "ProxyPasses.h"
+
 // forward decls for helpers implemented in d3d11.cpp
-extern std::string timeStamp();
-extern void output();
+extern TraceLog g_Trace;
 extern int g_Width;  // target width
 extern int g_Height; // target height
 
 // depth texture address
-extern ID3D11Texture2D *g_DepthTexture;
+extern std::atomic<ID3D11Texture2D *> g_DepthTexture;
+
+// events of the current frame (immediate context + spliced command lists)
+extern FrameTimeline g_FrameTimeline;
+
+// calls per method, every thread (snapshotted by the primary's Present)
+extern ApiCensus g_Census;
+
+// passes of the sampled frame (immediate context)
+extern PassRecorder g_Passes;
+
+// private data slot used to hand a deferred recording over to its command list
+// {8F1B31AA-6440-4331-B10F-F74B0A018538}
+static const GUID IID_DxPipeRecording =
+    {0x8f1b31aa, 0x6440, 0x4331, {0xb1, 0x0f, 0xf7, 0x4b, 0x0a, 0x01, 0x85, 0x38}};
+
+// memory layout of a format: bytes per element and the element's size in texels (4 x 4
+// blocks for BC, 2 x 1 for the packed 4:2:2 formats, 8 x 1 for R1, one texel otherwise),
+// 0 bytes for planar video formats and unknown ones
+struct FormatBlock
+{
+    uint32_t bytes;
+    uint32_t width;
+    uint32_t height;
+};
+
+inline FormatBlock formatBlock(DXGI_FORMAT fmt)
+{
+    if (fmt == DXGI_FORMAT_UNKNOWN)
+        return {0, 1, 1};
+    if (fmt <= DXGI_FORMAT_R32G32B32A32_SINT)
+        return {16, 1, 1};
+    if (fmt <= DXGI_FORMAT_R32G32B32_SINT)
+        return {12, 1, 1};
+    if (fmt <= DXGI_FORMAT_X32_TYPELESS_G8X24_UINT) // R16G16B16A16, R32G32, R32G8X24
+        return {8, 1, 1};
+    if (fmt <= DXGI_FORMAT_X24_TYPELESS_G8_UINT) // R10G10B10A2 .. R24G8
+        return {4, 1, 1};
+    if (fmt <= DXGI_FORMAT_R16_SINT) // R8G8, R16
+        return {2, 1, 1};
+    if (fmt <= DXGI_FORMAT_A8_UNORM) // R8, A8
+        return {1, 1, 1};
+    switch (fmt)
+    {
+    case DXGI_FORMAT_R1_UNORM:
+        return {1, 8, 1};
+    case DXGI_FORMAT_R9G9B9E5_SHAREDEXP:
+        return {4, 1, 1};
+    case DXGI_FORMAT_R8G8_B8G8_UNORM:
+    case DXGI_FORMAT_G8R8_G8B8_UNORM:
+        return {4, 2, 1};
+    case DXGI_FORMAT_BC1_TYPELESS:
+    case DXGI_FORMAT_BC1_UNORM:
+    case DXGI_FORMAT_BC1_UNORM_SRGB:
+    case DXGI_FORMAT_BC4_TYPELESS:
+    case DXGI_FORMAT_BC4_UNORM:
+    case DXGI_FORMAT_BC4_SNORM:
+        return {8, 4, 4};
+    case DXGI_FORMAT_BC2_TYPELESS:
+    case DXGI_FORMAT_BC2_UNORM:
+    case DXGI_FORMAT_BC2_UNORM_SRGB:
+    case DXGI_FORMAT_BC3_TYPELESS:
+    case DXGI_FORMAT_BC3_UNORM:
+    case DXGI_FORMAT_BC3_UNORM_SRGB:
+    case DXGI_FORMAT_BC5_TYPELESS:
+    case DXGI_FORMAT_BC5_UNORM:
+    case DXGI_FORMAT_BC5_SNORM:
+    case DXGI_FORMAT_BC6H_TYPELESS:
+    case DXGI_FORMAT_BC6H_UF16:
+    case DXGI_FORMAT_BC6H_SF16:
+    case DXGI_FORMAT_BC7_TYPELESS:
+    case DXGI_FORMAT_BC7_UNORM:
+    case DXGI_FORMAT_BC7_UNORM_SRGB:
+        return {16, 4, 4};
+    case DXGI_FORMAT_B5G6R5_UNORM:
+    case DXGI_FORMAT_B5G5R5A1_UNORM:
+    case DXGI_FORMAT_A8P8:
+    case DXGI_FORMAT_B4G4R4A4_UNORM:
+        return {2, 1, 1};
+    case DXGI_FORMAT_B8G8R8A8_UNORM:
+    case DXGI_FORMAT_B8G8R8X8_UNORM:
+    case DXGI_FORMAT_R10G10B10_XR_BIAS_A2_UNORM:
+    case DXGI_FORMAT_B8G8R8A8_TYPELESS:
+    case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+    case DXGI_FORMAT_B8G8R8X8_TYPELESS:
+    case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+    case DXGI_FORMAT_AYUV:
+    case DXGI_FORMAT_Y410:
+        return {4, 1, 1};
+    case DXGI_FORMAT_Y416:
+        return {8, 1, 1};
+    case DXGI_FORMAT_YUY2:
+        return {4, 2, 1};
+    case DXGI_FORMAT_Y210:
+    case DXGI_FORMAT_Y216:
+        return {8, 2, 1};
+    case DXGI_FORMAT_AI44:
+    case DXGI_FORMAT_IA44:
+    case DXGI_FORMAT_P8:
+        return {1, 1, 1};
+    default: // NV12, P010, P016, 420_OPAQUE, NV11 (planar) and newer formats
+        return {0, 1, 1};
+    }
+}
+
+// bytes a width x height x depth region (texels) of fmt spans with the given pitches: the
+// last row and slice only as long as their data; 0 for formats without a layout
+inline uint64_t regionBytes(DXGI_FORMAT fmt, uint32_t width, uint32_t height, uint32_t depth, uint64_t rowPitch,
+                            uint64_t depthPitch)
+{
+    FormatBlock b = formatBlock(fmt);
+    if (!b.bytes || !width || !height || !depth)
+        return 0;
+    uint64_t columns = (width + b.width - 1) / b.width;
+    uint64_t rows = (height + b.height - 1) / b.height;
+    return uint64_t(depth - 1) * depthPitch + (rows - 1) * rowPitch + columns * b.bytes;
+}
+
+// format and size in texels of one subresource (its mip level), buffers: width in bytes
+struct SubresourceExtent
+{
+    D3D11_RESOURCE_DIMENSION dim;
+    DXGI_FORMAT format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t depth;
+};
+
+inline SubresourceExtent subresourceExtent(ID3D11Resource *r, UINT sub)
+{
+    SubresourceExtent e = {D3D11_RESOURCE_DIMENSION_UNKNOWN, DXGI_FORMAT_UNKNOWN, 0, 1, 1};
+    r->GetType(&e.dim);
+    UINT mips = 1;
+    switch (e.dim)
+    {
+    case D3D11_RESOURCE_DIMENSION_BUFFER:
+    {
+        D3D11_BUFFER_DESC d{};
+        static_cast<ID3D11Buffer *>(r)->GetDesc(&d);
+        e.width = d.ByteWidth;
+        return e;
+    }
+    case D3D11_RESOURCE_DIMENSION_TEXTURE1D:
+    {
+        D3D11_TEXTURE1D_DESC d{};
+        static_cast<ID3D11Texture1D *>(r)->GetDesc(&d);
+        e.format = d.Format;
+        e.width = d.Width;
+        mips = d.MipLevels;
+        break;
+    }
+    case D3D11_RESOURCE_DIMENSION_TEXTURE2D:
+    {
+        D3D11_TEXTURE2D_DESC d{};
+        static_cast<ID3D11Texture2D *>(r)->GetDesc(&d);
+        e.format = d.Format;
+        e.width = d.Width;
+        e.height = d.Height;
+        mips = d.MipLevels;
+        break;
+    }
+    case D3D11_RESOURCE_DIMENSION_TEXTURE3D:
+    {
+        D3D11_TEXTURE3D_DESC d{};
+        static_cast<ID3D11Texture3D *>(r)->GetDesc(&d);
+        e.format = d.Format;
+        e.width = d.Width;
+        e.height = d.Height;
+        e.depth = d.Depth;
+        mips = d.MipLevels;
+        break;
+    }
+    default:
+        return e;
+    }
+    UINT mip = mips ? sub % mips : 0;
+    e.width = (e.width >> mip) ? (e.width >> mip) : 1;
+    e.height = (e.height >> mip) ? (e.height >> mip) : 1;
+    e.depth = (e.depth >> mip) ? (e.depth >> mip) : 1;
+    return e;
+}
+
+// owns the events recorded into a command list
+// attached with SetPrivateDataInterface so it is released together with the command list
+// recycled through a small free list, busy games finish command lists every frame
+class RecordedCommandList : public IUnknown
+{
+public:
+    static RecordedCommandList *acquire(uint16_t id)
+    {
+        RecordedCommandList *list = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(s_poolLock);
+            if (s_poolCount)
+                list = s_pool[--s_poolCount];
+        }
+        if (!list)
+            list = new RecordedCommandList();
+        list->m_rec.id = id;
+        return list;
+    }
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void **ppv) override
+    {
+        if (riid == __uuidof(IUnknown) || riid == IID_DxPipeRecording)
+        {
+            *ppv = static_cast<IUnknown *>(this);
+            AddRef();
+            return S_OK;
+        }
+        *ppv = nullptr;
+        return E_NOINTERFACE;
+    }
+    ULONG STDMETHODCALLTYPE AddRef() override { return static_cast<ULONG>(++m_ref); }
+    ULONG STDMETHODCALLTYPE Release() override
+    {
+        ULONG cnt = static_cast<ULONG>(--m_ref);
+        if (!cnt)
+            recycle();
+        return cnt;
+    }
+
+    EventRecorder &recorder() { return m_rec; }
+
+private:
+    RecordedCommandList() : m_ref(1) {}
+
+    // keeps the event storage, the next recording starts warm
+    void recycle()
+    {
+        m_rec.clear();
+        m_ref = 1;
+        {
+            std::lock_guard<std::mutex> lock(s_poolLock);
+            if (s_poolCount < POOL_SIZE)
+            {
+                s_pool[s_poolCount++] = this;
+                return;
+            }
+        }
+        delete this;
+    }
+
+    static const size_t POOL_SIZE = 64;
+    static inline std::mutex s_poolLock;
+    static inline RecordedCommandList *s_pool[POOL_SIZE] = {};
+    static inline size_t s_poolCount = 0;
+
+    EventRecorder m_rec;
+    std::atomic<uint32_t> m_ref;
+};
 
 // ID3D11DeviceContext proxy wrapper
-// intercepts DrawIndexed (called every frame), forwards everything else unaltered
+//  • records every draw / clear / bind / upload into an event buffer
+//  • immediate context → g_FrameTimeline, deferred context → its own buffer
+//  • deferred buffers are spliced into the frame on ExecuteCommandList
 class ProxyDeviceContext : public ID3D11DeviceContext
 {
 public:
     explicit ProxyDeviceContext(ID3D11DeviceContext *real)
-        : m_real(real), m_ref(1)
+        : m_real(real), m_ref(1), m_rec(&g_FrameTimeline), m_list(nullptr), m_deferred(false)
     {
         m_real->AddRef();
+
+        // deferred contexts are used from worker threads, give each one a private recorder
+        if (m_real->GetType() == D3D11_DEVICE_CONTEXT_DEFERRED)
+        {
+            static std::atomic<uint16_t> s_nextId{1};
+            m_deferred = true;
+            m_list = RecordedCommandList::acquire(s_nextId++);
+            m_rec = &m_list->recorder();
+            LOG_INFO(Device, "Wrapped deferred context (recorder {})", m_rec->id);
+        }
     }
 
     // IUnknown
@@ -53,6 +336,8 @@ public:
         ULONG cnt = static_cast<ULONG>(--m_ref);
         if (!cnt)
         {
+            if (m_list)
+                m_list->Release();
             m_real->Release();
             delete this;
         }
@@ -60,149 +345,434 @@ public:
     }
 
     // -------- ID3D11DeviceChild --------
-    void STDMETHODCALLTYPE GetDevice(ID3D11Device **ppDevice) override { m_real->GetDevice(ppDevice); }
+    void STDMETHODCALLTYPE GetDevice(ID3D11Device **ppDevice) override { g_Census.count(ApiCall::StateQuery); m_real->GetDevice(ppDevice); }
     HRESULT STDMETHODCALLTYPE GetPrivateData(REFGUID guid, UINT *pDataSize, void *pData) override { return m_real->GetPrivateData(guid, pDataSize, pData); }
     HRESULT STDMETHODCALLTYPE SetPrivateData(REFGUID guid, UINT DataSize, const void *pData) override { return m_real->SetPrivateData(guid, DataSize, pData); }
     HRESULT STDMETHODCALLTYPE SetPrivateDataInterface(REFGUID guid, const IUnknown *pData) override { return m_real->SetPrivateDataInterface(guid, pData); }
 
-    // -------- our single intercepted call --------
+    // -------- intercepted calls --------
     void STDMETHODCALLTYPE DrawIndexed(UINT IndexCount, UINT StartIndexLocation, INT BaseVertexLocation) override
     {
-#if DEBUG
-        output();
-#endif
-#if DEBUG
-// std::cout << timeStamp() << "DrawIndexed called!" << std::endl;
-#endif
-#if DEBUG
-// std::cout << "IndexCount: " << IndexCount << std::endl;
-#endif
-#if DEBUG
-// std::cout << "StartIndexLocation: " << StartIndexLocation << std::endl;
-#endif
-#if DEBUG
-// std::cout << "BaseVertexLocation: " << BaseVertexLocation << std::endl;
-#endif
+        g_Census.count(ApiCall::DrawIndexed);
+        onDraw(EventKind::DrawIndexed, IndexCount);
+        g_Trace.log(TraceEvent::DrawIndexed, IndexCount, StartIndexLocation, uint64_t(int64_t(BaseVertexLocation)));
         m_real->DrawIndexed(IndexCount, StartIndexLocation, BaseVertexLocation);
     }
 
     // -------- block of pure-virtuals, all forwarded --------
     // *** stage setters ***
-    void VSSetConstantBuffers(UINT s, UINT n, ID3D11Buffer *const *b) override { m_real->VSSetConstantBuffers(s, n, b); }
-    void PSSetShaderResources(UINT s, UINT n, ID3D11ShaderResourceView *const *v) override { m_real->PSSetShaderResources(s, n, v); }
-    void PSSetShader(ID3D11PixelShader *sh, ID3D11ClassInstance *const *ci, UINT nci) override { m_real->PSSetShader(sh, ci, nci); }
-    void PSSetSamplers(UINT s, UINT n, ID3D11SamplerState *const *ss) override { m_real->PSSetSamplers(s, n, ss); }
-    void VSSetShader(ID3D11VertexShader *sh, ID3D11ClassInstance *const *ci, UINT nci) override { m_real->VSSetShader(sh, ci, nci); }
-    void Draw(UINT vc, UINT sv) override { m_real->Draw(vc, sv); }
-    HRESULT Map(ID3D11Resource *r, UINT sub, D3D11_MAP t, UINT f, D3D11_MAPPED_SUBRESOURCE *m) override { return m_real->Map(r, sub, t, f, m); }
-    void Unmap(ID3D11Resource *r, UINT sub) override { m_real->Unmap(r, sub); }
-    void PSSetConstantBuffers(UINT s, UINT n, ID3D11Buffer *const *b) override { m_real->PSSetConstantBuffers(s, n, b); }
-    void IASetInputLayout(ID3D11InputLayout *l) override { m_real->IASetInputLayout(l); }
-    void IASetVertexBuffers(UINT s, UINT n, ID3D11Buffer *const *v, const UINT *st, const UINT *o) override { m_real->IASetVertexBuffers(s, n, v, st, o); }
-    void IASetIndexBuffer(ID3D11Buffer *ib, DXGI_FORMAT f, UINT o) override { m_real->IASetIndexBuffer(ib, f, o); }
-    void DrawIndexedInstanced(UINT ic, UINT i, UINT si, INT bv, UINT si2) override { m_real->DrawIndexedInstanced(ic, i, si, bv, si2); }
-    void DrawInstanced(UINT vc, UINT ic, UINT sv, UINT si) override { m_real->DrawInstanced(vc, ic, sv, si); }
-    void GSSetConstantBuffers(UINT s, UINT n, ID3D11Buffer *const *b) override { m_real->GSSetConstantBuffers(s, n, b); }
-    void GSSetShader(ID3D11GeometryShader *sh, ID3D11ClassInstance *const *ci, UINT nci) override { m_real->GSSetShader(sh, ci, nci); }
-    void IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY t) override { m_real->IASetPrimitiveTopology(t); }
-    void VSSetShaderResources(UINT s, UINT n, ID3D11ShaderResourceView *const *v) override { m_real->VSSetShaderResources(s, n, v); }
-    void VSSetSamplers(UINT s, UINT n, ID3D11SamplerState *const *ss) override { m_real->VSSetSamplers(s, n, ss); }
-    void Begin(ID3D11Asynchronous *a) override { m_real->Begin(a); }
-    void End(ID3D11Asynchronous *a) override { m_real->End(a); }
-    HRESULT GetData(ID3D11Asynchronous *a, void *d, UINT sz, UINT fl) override { return m_real->GetData(a, d, sz, fl); }
-    void SetPredication(ID3D11Predicate *p, BOOL v) override { m_real->SetPredication(p, v); }
-    void GSSetShaderResources(UINT s, UINT n, ID3D11ShaderResourceView *const *v) override { m_real->GSSetShaderResources(s, n, v); }
-    void GSSetSamplers(UINT s, UINT n, ID3D11SamplerState *const *ss) override { m_real->GSSetSamplers(s, n, ss); }
-    void OMSetRenderTargets(UINT n, ID3D11RenderTargetView *const *rt, ID3D11DepthStencilView *dsv) override { m_real->OMSetRenderTargets(n, rt, dsv); }
-    void OMSetRenderTargetsAndUnorderedAccessViews(UINT nrt, ID3D11RenderTargetView *const *rt, ID3D11DepthStencilView *dsv, UINT uavStart, UINT nuav, ID3D11UnorderedAccessView *const *uav, const UINT *init) override { m_real->OMSetRenderTargetsAndUnorderedAccessViews(nrt, rt, dsv, uavStart, nuav, uav, init); }
-    void OMSetBlendState(ID3D11BlendState *bs, const FLOAT bf[4], UINT sm) override { m_real->OMSetBlendState(bs, bf, sm); }
-    void OMSetDepthStencilState(ID3D11DepthStencilState *ds, UINT sr) override { m_real->OMSetDepthStencilState(ds, sr); }
-    void SOSetTargets(UINT n, ID3D11Buffer *const *t, const UINT *o) override { m_real->SOSetTargets(n, t, o); }
-    void DrawAuto() override { m_real->DrawAuto(); }
-    void DrawIndexedInstancedIndirect(ID3D11Buffer *b, UINT off) override { m_real->DrawIndexedInstancedIndirect(b, off); }
-    void DrawInstancedIndirect(ID3D11Buffer *b, UINT off) override { m_real->DrawInstancedIndirect(b, off); }
-    void Dispatch(UINT X, UINT Y, UINT Z) override { m_real->Dispatch(X, Y, Z); }
-    void DispatchIndirect(ID3D11Buffer *b, UINT off) override { m_real->DispatchIndirect(b, off); }
-    void RSSetState(ID3D11RasterizerState *rs) override { m_real->RSSetState(rs); }
-    void RSSetViewports(UINT n, const D3D11_VIEWPORT *vp) override { m_real->RSSetViewports(n, vp); }
-    void RSSetScissorRects(UINT n, const D3D11_RECT *rc) override { m_real->RSSetScissorRects(n, rc); }
-    void CopySubresourceRegion(ID3D11Resource *dst, UINT dsub, UINT dx, UINT dy, UINT dz, ID3D11Resource *src, UINT ssub, const D3D11_BOX *box) override { m_real->CopySubresourceRegion(dst, dsub, dx, dy, dz, src, ssub, box); }
-    void CopyResource(ID3D11Resource *dst, ID3D11Resource *src) override { m_real->CopyResource(dst, src); }
-    void UpdateSubresource(ID3D11Resource *dst, UINT dsub, const D3D11_BOX *box, const void *src, UINT rp, UINT dp) override { m_real->UpdateSubresource(dst, dsub, box, src, rp, dp); }
-    void CopyStructureCount(ID3D11Buffer *dst, UINT off, ID3D11UnorderedAccessView *src) override { m_real->CopyStructureCount(dst, off, src); }
-    void ClearRenderTargetView(ID3D11RenderTargetView *rt, const FLOAT c[4]) override { m_real->ClearRenderTargetView(rt, c); }
-    void ClearUnorderedAccessViewUint(ID3D11UnorderedAccessView *uav, const UINT v[4]) override { m_real->ClearUnorderedAccessViewUint(uav, v); }
-    void ClearUnorderedAccessViewFloat(ID3D11UnorderedAccessView *uav, const FLOAT v[4]) override { m_real->ClearUnorderedAccessViewFloat(uav, v); }
-    void ClearDepthStencilView(ID3D11DepthStencilView *dsv, UINT f, FLOAT d, UINT8 s) override { m_real->ClearDepthStencilView(dsv, f, d, s); }
-    void GenerateMips(ID3D11ShaderResourceView *srv) override { m_real->GenerateMips(srv); }
-    void SetResourceMinLOD(ID3D11Resource *r, FLOAT l) override { m_real->SetResourceMinLOD(r, l); }
-    FLOAT GetResourceMinLOD(ID3D11Resource *r) override { return m_real->GetResourceMinLOD(r); }
-    void ResolveSubresource(ID3D11Resource *dst, UINT dsub, ID3D11Resource *src, UINT ssub, DXGI_FORMAT f) override { m_real->ResolveSubresource(dst, dsub, src, ssub, f); }
-    void ExecuteCommandList(ID3D11CommandList *cl, BOOL rst) override { m_real->ExecuteCommandList(cl, rst); }
+    void VSSetConstantBuffers(UINT s, UINT n, ID3D11Buffer *const *b) override
+    {
+        g_Census.count(ApiCall::SetConstantBuffers);
+        onBind(EventKind::SetConstantBuffers, StageVS, s, n, b);
+        // camera matrices are only searched for in vertex shader constants
+        if (g_DepthWanted.load(std::memory_order_relaxed))
+            trackCameraBuffers(b, n);
+        m_real->VSSetConstantBuffers(s, n, b);
+    }
+    void PSSetShaderResources(UINT s, UINT n, ID3D11ShaderResourceView *const *v) override { g_Census.count(ApiCall::SetShaderResources); onBind(EventKind::SetShaderResources, StagePS, s, n, v); m_real->PSSetShaderResources(s, n, v); }
+    void PSSetShader(ID3D11PixelShader *sh, ID3D11ClassInstance *const *ci, UINT nci) override { g_Census.count(ApiCall::SetShader); onState(EventKind::SetShader, sh, 0, StagePS); m_real->PSSetShader(sh, ci, nci); }
+    void PSSetSamplers(UINT s, UINT n, ID3D11SamplerState *const *ss) override { g_Census.count(ApiCall::SetSamplers); m_real->PSSetSamplers(s, n, ss); }
+    void VSSetShader(ID3D11VertexShader *sh, ID3D11ClassInstance *const *ci, UINT nci) override { g_Census.count(ApiCall::SetShader); onState(EventKind::SetShader, sh, 0, StageVS); m_real->VSSetShader(sh, ci, nci); }
+    void Draw(UINT vc, UINT sv) override { g_Census.count(ApiCall::Draw); onDraw(EventKind::Draw, vc); m_real->Draw(vc, sv); }
+    HRESULT Map(ID3D11Resource *r, UINT sub, D3D11_MAP t, UINT f, D3D11_MAPPED_SUBRESOURCE *m) override
+    {
+        g_Census.count(ApiCall::Map);
+        m_rec->record(EventKind::Map, r, t, sub);
+        HRESULT hr = m_real->Map(r, sub, t, f, m);
+        if (SUCCEEDED(hr) && m && g_Census.enabled())
+            g_Census.addBytes(ApiBytes::Map, mappedSize(r, sub, *m));
+        if (SUCCEEDED(hr) && m && t != D3D11_MAP_READ)
+        {
+#if ENABLE_CAPTURE
+            bool capture = g_Capture.isOpen();
+#else
+            bool capture = false;
+#endif
+            // discarded constant buffers hold fresh constants, scanned for the projection at Unmap
+            bool constants = t == D3D11_MAP_WRITE_DISCARD && g_DepthWanted.load(std::memory_order_relaxed) &&
+                             isConstantBuffer(r);
+            if (capture || constants)
+                trackMap(r, sub, *m, capture, constants);
+        }
+        return hr;
+    }
+    void Unmap(ID3D11Resource *r, UINT sub) override
+    {
+        g_Census.count(ApiCall::Unmap);
+        m_rec->record(EventKind::Unmap, r, 0, sub);
+        // the written bytes are only final at Unmap, read them before the driver takes over
+        if (m_pendingMaps)
+            finishMap(r, sub);
+        m_real->Unmap(r, sub);
+    }
+    void PSSetConstantBuffers(UINT s, UINT n, ID3D11Buffer *const *b) override { g_Census.count(ApiCall::SetConstantBuffers); onBind(EventKind::SetConstantBuffers, StagePS, s, n, b); m_real->PSSetConstantBuffers(s, n, b); }
+    void IASetInputLayout(ID3D11InputLayout *l) override { g_Census.count(ApiCall::SetInputLayout); m_real->IASetInputLayout(l); }
+    void IASetVertexBuffers(UINT s, UINT n, ID3D11Buffer *const *v, const UINT *st, const UINT *o) override { g_Census.count(ApiCall::SetVertexBuffers); m_real->IASetVertexBuffers(s, n, v, st, o); }
+    void IASetIndexBuffer(ID3D11Buffer *ib, DXGI_FORMAT f, UINT o) override { g_Census.count(ApiCall::SetIndexBuffer); m_real->IASetIndexBuffer(ib, f, o); }
+    void DrawIndexedInstanced(UINT ic, UINT i, UINT si, INT bv, UINT si2) override { g_Census.count(ApiCall::DrawIndexedInstanced); onDraw(EventKind::DrawIndexedInstanced, ic, i); m_real->DrawIndexedInstanced(ic, i, si, bv, si2); }
+    void DrawInstanced(UINT vc, UINT ic, UINT sv, UINT si) override { g_Census.count(ApiCall::DrawInstanced); onDraw(EventKind::DrawInstanced, vc, ic); m_real->DrawInstanced(vc, ic, sv, si); }
+    void GSSetConstantBuffers(UINT s, UINT n, ID3D11Buffer *const *b) override { g_Census.count(ApiCall::SetConstantBuffers); onBind(EventKind::SetConstantBuffers, StageGS, s, n, b); m_real->GSSetConstantBuffers(s, n, b); }
+    void GSSetShader(ID3D11GeometryShader *sh, ID3D11ClassInstance *const *ci, UINT nci) override { g_Census.count(ApiCall::SetShader); onState(EventKind::SetShader, sh, 0, StageGS); m_real->GSSetShader(sh, ci, nci); }
+    void IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY t) override { g_Census.count(ApiCall::SetPrimitiveTopology); m_real->IASetPrimitiveTopology(t); }
+    void VSSetShaderResources(UINT s, UINT n, ID3D11ShaderResourceView *const *v) override { g_Census.count(ApiCall::SetShaderResources); onBind(EventKind::SetShaderResources, StageVS, s, n, v); m_real->VSSetShaderResources(s, n, v); }
+    void VSSetSamplers(UINT s, UINT n, ID3D11SamplerState *const *ss) override { g_Census.count(ApiCall::SetSamplers); m_real->VSSetSamplers(s, n, ss); }
+    void Begin(ID3D11Asynchronous *a) override { g_Census.count(ApiCall::Begin); m_real->Begin(a); }
+    void End(ID3D11Asynchronous *a) override { g_Census.count(ApiCall::End); m_real->End(a); }
+    HRESULT GetData(ID3D11Asynchronous *a, void *d, UINT sz, UINT fl) override { g_Census.count(ApiCall::GetData); return m_real->GetData(a, d, sz, fl); }
+    void SetPredication(ID3D11Predicate *p, BOOL v) override { g_Census.count(ApiCall::SetPredication); m_real->SetPredication(p, v); }
+    void GSSetShaderResources(UINT s, UINT n, ID3D11ShaderResourceView *const *v) override { g_Census.count(ApiCall::SetShaderResources); onBind(EventKind::SetShaderResources, StageGS, s, n, v); m_real->GSSetShaderResources(s, n, v); }
+    void GSSetSamplers(UINT s, UINT n, ID3D11SamplerState *const *ss) override { g_Census.count(ApiCall::SetSamplers); m_real->GSSetSamplers(s, n, ss); }
+    void OMSetRenderTargets(UINT n, ID3D11RenderTargetView *const *rt, ID3D11DepthStencilView *dsv) override { g_Census.count(ApiCall::SetRenderTargets); onSetTargets(n, rt, dsv); m_real->OMSetRenderTargets(n, rt, dsv); }
+    void OMSetRenderTargetsAndUnorderedAccessViews(UINT nrt, ID3D11RenderTargetView *const *rt, ID3D11DepthStencilView *dsv, UINT uavStart, UINT nuav, ID3D11UnorderedAccessView *const *uav, const UINT *init) override
+    {
+        g_Census.count(ApiCall::SetRenderTargets);
+        if (nrt != D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL)
+            onSetTargets(nrt, rt, dsv);
+        if (nuav != D3D11_KEEP_UNORDERED_ACCESS_VIEWS && passes())
+            passUavs(false, uavStart, nuav, uav);
+        m_real->OMSetRenderTargetsAndUnorderedAccessViews(nrt, rt, dsv, uavStart, nuav, uav, init);
+    }
+    void OMSetBlendState(ID3D11BlendState *bs, const FLOAT bf[4], UINT sm) override { g_Census.count(ApiCall::SetBlendState); m_real->OMSetBlendState(bs, bf, sm); }
+    void OMSetDepthStencilState(ID3D11DepthStencilState *ds, UINT sr) override { g_Census.count(ApiCall::SetDepthStencilState); onState(EventKind::SetDepthStencilState, ds, 0, sr); m_real->OMSetDepthStencilState(ds, sr); }
+    void SOSetTargets(UINT n, ID3D11Buffer *const *t, const UINT *o) override { g_Census.count(ApiCall::SetStreamOutTargets); m_real->SOSetTargets(n, t, o); }
+    void DrawAuto() override { g_Census.count(ApiCall::DrawAuto); onDraw(EventKind::Draw, 0); m_real->DrawAuto(); }
+    void DrawIndexedInstancedIndirect(ID3D11Buffer *b, UINT off) override { g_Census.count(ApiCall::DrawIndirect); onDraw(EventKind::DrawIndirect, off, 0, b); m_real->DrawIndexedInstancedIndirect(b, off); }
+    void DrawInstancedIndirect(ID3D11Buffer *b, UINT off) override { g_Census.count(ApiCall::DrawIndirect); onDraw(EventKind::DrawIndirect, off, 0, b); m_real->DrawInstancedIndirect(b, off); }
+    void Dispatch(UINT X, UINT Y, UINT Z) override { g_Census.count(ApiCall::Dispatch); onDispatch(nullptr, uint64_t(X) * Y * Z); m_real->Dispatch(X, Y, Z); }
+    void DispatchIndirect(ID3D11Buffer *b, UINT off) override { g_Census.count(ApiCall::DispatchIndirect); onDispatch(b, off); m_real->DispatchIndirect(b, off); }
+    void RSSetState(ID3D11RasterizerState *rs) override { g_Census.count(ApiCall::SetRasterizerState); m_real->RSSetState(rs); }
+    void RSSetViewports(UINT n, const D3D11_VIEWPORT *vp) override { g_Census.count(ApiCall::SetViewports); m_real->RSSetViewports(n, vp); }
+    void RSSetScissorRects(UINT n, const D3D11_RECT *rc) override { g_Census.count(ApiCall::SetScissorRects); m_real->RSSetScissorRects(n, rc); }
+    void CopySubresourceRegion(ID3D11Resource *dst, UINT dsub, UINT dx, UINT dy, UINT dz, ID3D11Resource *src, UINT ssub, const D3D11_BOX *box) override { g_Census.count(ApiCall::CopySubresourceRegion); onCopy(EventKind::CopySubresourceRegion, dst, src); m_real->CopySubresourceRegion(dst, dsub, dx, dy, dz, src, ssub, box); }
+    void CopyResource(ID3D11Resource *dst, ID3D11Resource *src) override { g_Census.count(ApiCall::CopyResource); onCopy(EventKind::CopyResource, dst, src); m_real->CopyResource(dst, src); }
+    void UpdateSubresource(ID3D11Resource *dst, UINT dsub, const D3D11_BOX *box, const void *src, UINT rp, UINT dp) override
+    {
+        g_Census.count(ApiCall::UpdateSubresource);
+        uint64_t bytes = updateSize(dst, dsub, box, rp, dp);
+        if (g_Census.enabled())
+            g_Census.addBytes(ApiBytes::UpdateSubresource, bytes);
+        m_rec->record(EventKind::UpdateSubresource, dst, bytes, dsub);
+        if (passes())
+            passMark(m_real, g_Passes.copy(dst, nullptr));
+#if ENABLE_CAPTURE
+        if (g_Capture.isOpen())
+            m_rec->record(EventKind::Payload, dst, g_Capture.writeBlob(src, size_t(bytes)), uint32_t(bytes));
+#endif
+        if (!box && src && g_DepthWanted.load(std::memory_order_relaxed) && isConstantBuffer(dst))
+            scanConstants(dst, src, size_t(bytes));
+        m_real->UpdateSubresource(dst, dsub, box, src, rp, dp);
+    }
+    void CopyStructureCount(ID3D11Buffer *dst, UINT off, ID3D11UnorderedAccessView *src) override { g_Census.count(ApiCall::CopyStructureCount); m_real->CopyStructureCount(dst, off, src); }
+    void ClearRenderTargetView(ID3D11RenderTargetView *rt, const FLOAT c[4]) override { g_Census.count(ApiCall::ClearRenderTargetView); onClearTarget(rt); m_real->ClearRenderTargetView(rt, c); }
+    void ClearUnorderedAccessViewUint(ID3D11UnorderedAccessView *uav, const UINT v[4]) override { g_Census.count(ApiCall::ClearUnorderedAccessView); onClearUav(uav); m_real->ClearUnorderedAccessViewUint(uav, v); }
+    void ClearUnorderedAccessViewFloat(ID3D11UnorderedAccessView *uav, const FLOAT v[4]) override { g_Census.count(ApiCall::ClearUnorderedAccessView); onClearUav(uav); m_real->ClearUnorderedAccessViewFloat(uav, v); }
+    void ClearDepthStencilView(ID3D11DepthStencilView *dsv, UINT f, FLOAT d, UINT8 s) override { g_Census.count(ApiCall::ClearDepthStencilView); onClearDepth(dsv, f, d, s); m_real->ClearDepthStencilView(dsv, f, d, s); }
+    void GenerateMips(ID3D11ShaderResourceView *srv) override
+    {
+        g_Census.count(ApiCall::GenerateMips);
+        if (passes())
+        {
+            const void *res = passResource(srv);
+            passMark(m_real, g_Passes.copy(res, res));
+        }
+        m_real->GenerateMips(srv);
+    }
+    void SetResourceMinLOD(ID3D11Resource *r, FLOAT l) override { g_Census.count(ApiCall::SetResourceMinLOD); m_real->SetResourceMinLOD(r, l); }
+    FLOAT GetResourceMinLOD(ID3D11Resource *r) override { g_Census.count(ApiCall::StateQuery); return m_real->GetResourceMinLOD(r); }
+    void ResolveSubresource(ID3D11Resource *dst, UINT dsub, ID3D11Resource *src, UINT ssub, DXGI_FORMAT f) override { g_Census.count(ApiCall::ResolveSubresource); onCopy(EventKind::ResolveSubresource, dst, src); m_real->ResolveSubresource(dst, dsub, src, ssub, f); }
+    void ExecuteCommandList(ID3D11CommandList *cl, BOOL rst) override
+    {
+        g_Census.count(ApiCall::ExecuteCommandList);
+        // pull the recording back out of the command list and splice it in
+        ContextCounters listed = {};
+        if (cl)
+        {
+            IUnknown *data = nullptr;
+            UINT size = sizeof(data);
+            if (SUCCEEDED(cl->GetPrivateData(IID_DxPipeRecording, &size, &data)) && data)
+            {
+                const EventRecorder &recorded = static_cast<RecordedCommandList *>(data)->recorder();
+                listed = recorded.counters;
+                m_rec->splice(recorded);
+                data->Release();
+            }
+        }
+        // the whole list is one pass (its own bindings aren't broken down)
+        if (passes())
+            passMark(m_real, g_Passes.commandList(rst != FALSE, listed.draws, listed.dispatches, listed.clears,
+                                                  listed.copies));
+        m_real->ExecuteCommandList(cl, rst);
+    }
 
     // Hull-, domain-, compute-stage setters we missed last time
-    void HSSetShaderResources(UINT s, UINT n, ID3D11ShaderResourceView *const *v) override { m_real->HSSetShaderResources(s, n, v); }
-    void HSSetShader(ID3D11HullShader *sh, ID3D11ClassInstance *const *ci, UINT nci) override { m_real->HSSetShader(sh, ci, nci); }
-    void HSSetSamplers(UINT s, UINT n, ID3D11SamplerState *const *ss) override { m_real->HSSetSamplers(s, n, ss); }
-    void HSSetConstantBuffers(UINT s, UINT n, ID3D11Buffer *const *b) override { m_real->HSSetConstantBuffers(s, n, b); }
-    void DSSetShaderResources(UINT s, UINT n, ID3D11ShaderResourceView *const *v) override { m_real->DSSetShaderResources(s, n, v); }
-    void DSSetShader(ID3D11DomainShader *sh, ID3D11ClassInstance *const *ci, UINT nci) override { m_real->DSSetShader(sh, ci, nci); }
-    void DSSetSamplers(UINT s, UINT n, ID3D11SamplerState *const *ss) override { m_real->DSSetSamplers(s, n, ss); }
-    void DSSetConstantBuffers(UINT s, UINT n, ID3D11Buffer *const *b) override { m_real->DSSetConstantBuffers(s, n, b); }
-    void CSSetShaderResources(UINT s, UINT n, ID3D11ShaderResourceView *const *v) override { m_real->CSSetShaderResources(s, n, v); }
-    void CSSetUnorderedAccessViews(UINT s, UINT n, ID3D11UnorderedAccessView *const *uav, const UINT *init) override { m_real->CSSetUnorderedAccessViews(s, n, uav, init); }
-    void CSSetShader(ID3D11ComputeShader *sh, ID3D11ClassInstance *const *ci, UINT nci) override { m_real->CSSetShader(sh, ci, nci); }
-    void CSSetSamplers(UINT s, UINT n, ID3D11SamplerState *const *ss) override { m_real->CSSetSamplers(s, n, ss); }
-    void CSSetConstantBuffers(UINT s, UINT n, ID3D11Buffer *const *b) override { m_real->CSSetConstantBuffers(s, n, b); }
+    void HSSetShaderResources(UINT s, UINT n, ID3D11ShaderResourceView *const *v) override { g_Census.count(ApiCall::SetShaderResources); onBind(EventKind::SetShaderResources, StageHS, s, n, v); m_real->HSSetShaderResources(s, n, v); }
+    void HSSetShader(ID3D11HullShader *sh, ID3D11ClassInstance *const *ci, UINT nci) override { g_Census.count(ApiCall::SetShader); onState(EventKind::SetShader, sh, 0, StageHS); m_real->HSSetShader(sh, ci, nci); }
+    void HSSetSamplers(UINT s, UINT n, ID3D11SamplerState *const *ss) override { g_Census.count(ApiCall::SetSamplers); m_real->HSSetSamplers(s, n, ss); }
+    void HSSetConstantBuffers(UINT s, UINT n, ID3D11Buffer *const *b) override { g_Census.count(ApiCall::SetConstantBuffers); onBind(EventKind::SetConstantBuffers, StageHS, s, n, b); m_real->HSSetConstantBuffers(s, n, b); }
+    void DSSetShaderResources(UINT s, UINT n, ID3D11ShaderResourceView *const *v) override { g_Census.count(ApiCall::SetShaderResources); onBind(EventKind::SetShaderResources, StageDS, s, n, v); m_real->DSSetShaderResources(s, n, v); }
+    void DSSetShader(ID3D11DomainShader *sh, ID3D11ClassInstance *const *ci, UINT nci) override { g_Census.count(ApiCall::SetShader); onState(EventKind::SetShader, sh, 0, StageDS); m_real->DSSetShader(sh, ci, nci); }
+    void DSSetSamplers(UINT s, UINT n, ID3D11SamplerState *const *ss) override { g_Census.count(ApiCall::SetSamplers); m_real->DSSetSamplers(s, n, ss); }
+    void DSSetConstantBuffers(UINT s, UINT n, ID3D11Buffer *const *b) override { g_Census.count(ApiCall::SetConstantBuffers); onBind(EventKind::SetConstantBuffers, StageDS, s, n, b); m_real->DSSetConstantBuffers(s, n, b); }
+    void CSSetShaderResources(UINT s, UINT n, ID3D11ShaderResourceView *const *v) override { g_Census.count(ApiCall::SetShaderResources); onBind(EventKind::SetShaderResources, StageCS, s, n, v); m_real->CSSetShaderResources(s, n, v); }
+    void CSSetUnorderedAccessViews(UINT s, UINT n, ID3D11UnorderedAccessView *const *uav, const UINT *init) override
+    {
+        g_Census.count(ApiCall::SetUnorderedAccessViews);
+        if (passes())
+            passUavs(true, s, n, uav);
+        m_real->CSSetUnorderedAccessViews(s, n, uav, init);
+    }
+    void CSSetShader(ID3D11ComputeShader *sh, ID3D11ClassInstance *const *ci, UINT nci) override { g_Census.count(ApiCall::SetShader); onState(EventKind::SetShader, sh, 0, StageCS); m_real->CSSetShader(sh, ci, nci); }
+    void CSSetSamplers(UINT s, UINT n, ID3D11SamplerState *const *ss) override { g_Census.count(ApiCall::SetSamplers); m_real->CSSetSamplers(s, n, ss); }
+    void CSSetConstantBuffers(UINT s, UINT n, ID3D11Buffer *const *b) override { g_Census.count(ApiCall::SetConstantBuffers); onBind(EventKind::SetConstantBuffers, StageCS, s, n, b); m_real->CSSetConstantBuffers(s, n, b); }
 
     // State-query / getter group we missed
-    void VSGetConstantBuffers(UINT s, UINT n, ID3D11Buffer **b) override { m_real->VSGetConstantBuffers(s, n, b); }
-    void PSGetShaderResources(UINT s, UINT n, ID3D11ShaderResourceView **v) override { m_real->PSGetShaderResources(s, n, v); }
-    void PSGetShader(ID3D11PixelShader **sh, ID3D11ClassInstance **ci, UINT *nci) override { m_real->PSGetShader(sh, ci, nci); }
-    void PSGetSamplers(UINT s, UINT n, ID3D11SamplerState **ss) override { m_real->PSGetSamplers(s, n, ss); }
-    void VSGetShader(ID3D11VertexShader **sh, ID3D11ClassInstance **ci, UINT *nci) override { m_real->VSGetShader(sh, ci, nci); }
-    void PSGetConstantBuffers(UINT s, UINT n, ID3D11Buffer **b) override { m_real->PSGetConstantBuffers(s, n, b); }
-    void IAGetInputLayout(ID3D11InputLayout **l) override { m_real->IAGetInputLayout(l); }
-    void IAGetVertexBuffers(UINT s, UINT n, ID3D11Buffer **v, UINT *st, UINT *o) override { m_real->IAGetVertexBuffers(s, n, v, st, o); }
-    void IAGetIndexBuffer(ID3D11Buffer **ib, DXGI_FORMAT *f, UINT *o) override { m_real->IAGetIndexBuffer(ib, f, o); }
-    void GSGetConstantBuffers(UINT s, UINT n, ID3D11Buffer **b) override { m_real->GSGetConstantBuffers(s, n, b); }
-    void GSGetShader(ID3D11GeometryShader **sh, ID3D11ClassInstance **ci, UINT *nci) override { m_real->GSGetShader(sh, ci, nci); }
-    void IAGetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY *t) override { m_real->IAGetPrimitiveTopology(t); }
-    void VSGetShaderResources(UINT s, UINT n, ID3D11ShaderResourceView **v) override { m_real->VSGetShaderResources(s, n, v); }
-    void VSGetSamplers(UINT s, UINT n, ID3D11SamplerState **ss) override { m_real->VSGetSamplers(s, n, ss); }
-    void GetPredication(ID3D11Predicate **p, BOOL *v) override { m_real->GetPredication(p, v); }
-    void GSGetShaderResources(UINT s, UINT n, ID3D11ShaderResourceView **v) override { m_real->GSGetShaderResources(s, n, v); }
-    void GSGetSamplers(UINT s, UINT n, ID3D11SamplerState **ss) override { m_real->GSGetSamplers(s, n, ss); }
-    void OMGetRenderTargets(UINT n, ID3D11RenderTargetView **rt, ID3D11DepthStencilView **dsv) override { m_real->OMGetRenderTargets(n, rt, dsv); }
-    void OMGetRenderTargetsAndUnorderedAccessViews(UINT nrt, ID3D11RenderTargetView **rt, ID3D11DepthStencilView **dsv, UINT uavStart, UINT nuav, ID3D11UnorderedAccessView **uav) override { m_real->OMGetRenderTargetsAndUnorderedAccessViews(nrt, rt, dsv, uavStart, nuav, uav); }
-    void OMGetBlendState(ID3D11BlendState **bs, FLOAT bf[4], UINT *sm) override { m_real->OMGetBlendState(bs, bf, sm); }
-    void OMGetDepthStencilState(ID3D11DepthStencilState **ds, UINT *sr) override { m_real->OMGetDepthStencilState(ds, sr); }
-    void SOGetTargets(UINT n, ID3D11Buffer **t) override { m_real->SOGetTargets(n, t); }
-    void RSGetState(ID3D11RasterizerState **rs) override { m_real->RSGetState(rs); }
-    void RSGetViewports(UINT *n, D3D11_VIEWPORT *vp) override { m_real->RSGetViewports(n, vp); }
-    void RSGetScissorRects(UINT *n, D3D11_RECT *rc) override { m_real->RSGetScissorRects(n, rc); }
-    void HSGetShaderResources(UINT s, UINT n, ID3D11ShaderResourceView **v) override { m_real->HSGetShaderResources(s, n, v); }
-    void HSGetShader(ID3D11HullShader **sh, ID3D11ClassInstance **ci, UINT *nci) override { m_real->HSGetShader(sh, ci, nci); }
-    void HSGetSamplers(UINT s, UINT n, ID3D11SamplerState **ss) override { m_real->HSGetSamplers(s, n, ss); }
-    void HSGetConstantBuffers(UINT s, UINT n, ID3D11Buffer **b) override { m_real->HSGetConstantBuffers(s, n, b); }
-    void DSGetShaderResources(UINT s, UINT n, ID3D11ShaderResourceView **v) override { m_real->DSGetShaderResources(s, n, v); }
-    void DSGetShader(ID3D11DomainShader **sh, ID3D11ClassInstance **ci, UINT *nci) override { m_real->DSGetShader(sh, ci, nci); }
-    void DSGetSamplers(UINT s, UINT n, ID3D11SamplerState **ss) override { m_real->DSGetSamplers(s, n, ss); }
-    void DSGetConstantBuffers(UINT s, UINT n, ID3D11Buffer **b) override { m_real->DSGetConstantBuffers(s, n, b); }
-    void CSGetShaderResources(UINT s, UINT n, ID3D11ShaderResourceView **v) override { m_real->CSGetShaderResources(s, n, v); }
-    void CSGetUnorderedAccessViews(UINT s, UINT n, ID3D11UnorderedAccessView **uav) override { m_real->CSGetUnorderedAccessViews(s, n, uav); }
-    void CSGetShader(ID3D11ComputeShader **sh, ID3D11ClassInstance **ci, UINT *nci) override { m_real->CSGetShader(sh, ci, nci); }
-    void CSGetSamplers(UINT s, UINT n, ID3D11SamplerState **ss) override { m_real->CSGetSamplers(s, n, ss); }
-    void CSGetConstantBuffers(UINT s, UINT n, ID3D11Buffer **b) override { m_real->CSGetConstantBuffers(s, n, b); }
+    void VSGetConstantBuffers(UINT s, UINT n, ID3D11Buffer **b) override { g_Census.count(ApiCall::StateQuery); m_real->VSGetConstantBuffers(s, n, b); }
+    void PSGetShaderResources(UINT s, UINT n, ID3D11ShaderResourceView **v) override { g_Census.count(ApiCall::StateQuery); m_real->PSGetShaderResources(s, n, v); }
+    void PSGetShader(ID3D11PixelShader **sh, ID3D11ClassInstance **ci, UINT *nci) override { g_Census.count(ApiCall::StateQuery); m_real->PSGetShader(sh, ci, nci); }
+    void PSGetSamplers(UINT s, UINT n, ID3D11SamplerState **ss) override { g_Census.count(ApiCall::StateQuery); m_real->PSGetSamplers(s, n, ss); }
+    void VSGetShader(ID3D11VertexShader **sh, ID3D11ClassInstance **ci, UINT *nci) override { g_Census.count(ApiCall::StateQuery); m_real->VSGetShader(sh, ci, nci); }
+    void PSGetConstantBuffers(UINT s, UINT n, ID3D11Buffer **b) override { g_Census.count(ApiCall::StateQuery); m_real->PSGetConstantBuffers(s, n, b); }
+    void IAGetInputLayout(ID3D11InputLayout **l) override { g_Census.count(ApiCall::StateQuery); m_real->IAGetInputLayout(l); }
+    void IAGetVertexBuffers(UINT s, UINT n, ID3D11Buffer **v, UINT *st, UINT *o) override { g_Census.count(ApiCall::StateQuery); m_real->IAGetVertexBuffers(s, n, v, st, o); }
+    void IAGetIndexBuffer(ID3D11Buffer **ib, DXGI_FORMAT *f, UINT *o) override { g_Census.count(ApiCall::StateQuery); m_real->IAGetIndexBuffer(ib, f, o); }
+    void GSGetConstantBuffers(UINT s, UINT n, ID3D11Buffer **b) override { g_Census.count(ApiCall::StateQuery); m_real->GSGetConstantBuffers(s, n, b); }
+    void GSGetShader(ID3D11GeometryShader **sh, ID3D11ClassInstance **ci, UINT *nci) override { g_Census.count(ApiCall::StateQuery); m_real->GSGetShader(sh, ci, nci); }
+    void IAGetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY *t) override { g_Census.count(ApiCall::StateQuery); m_real->IAGetPrimitiveTopology(t); }
+    void VSGetShaderResources(UINT s, UINT n, ID3D11ShaderResourceView **v) override { g_Census.count(ApiCall::StateQuery); m_real->VSGetShaderResources(s, n, v); }
+    void VSGetSamplers(UINT s, UINT n, ID3D11SamplerState **ss) override { g_Census.count(ApiCall::StateQuery); m_real->VSGetSamplers(s, n, ss); }
+    void GetPredication(ID3D11Predicate **p, BOOL *v) override { g_Census.count(ApiCall::StateQuery); m_real->GetPredication(p, v); }
+    void GSGetShaderResources(UINT s, UINT n, ID3D11ShaderResourceView **v) override { g_Census.count(ApiCall::StateQuery); m_real->GSGetShaderResources(s, n, v); }
+    void GSGetSamplers(UINT s, UINT n, ID3D11SamplerState **ss) override { g_Census.count(ApiCall::StateQuery); m_real->GSGetSamplers(s, n, ss); }
+    void OMGetRenderTargets(UINT n, ID3D11RenderTargetView **rt, ID3D11DepthStencilView **dsv) override { g_Census.count(ApiCall::StateQuery); m_real->OMGetRenderTargets(n, rt, dsv); }
+    void OMGetRenderTargetsAndUnorderedAccessViews(UINT nrt, ID3D11RenderTargetView **rt, ID3D11DepthStencilView **dsv, UINT uavStart, UINT nuav, ID3D11UnorderedAccessView **uav) override { g_Census.count(ApiCall::StateQuery); m_real->OMGetRenderTargetsAndUnorderedAccessViews(nrt, rt, dsv, uavStart, nuav, uav); }
+    void OMGetBlendState(ID3D11BlendState **bs, FLOAT bf[4], UINT *sm) override { g_Census.count(ApiCall::StateQuery); m_real->OMGetBlendState(bs, bf, sm); }
+    void OMGetDepthStencilState(ID3D11DepthStencilState **ds, UINT *sr) override { g_Census.count(ApiCall::StateQuery); m_real->OMGetDepthStencilState(ds, sr); }
+    void SOGetTargets(UINT n, ID3D11Buffer **t) override { g_Census.count(ApiCall::StateQuery); m_real->SOGetTargets(n, t); }
+    void RSGetState(ID3D11RasterizerState **rs) override { g_Census.count(ApiCall::StateQuery); m_real->RSGetState(rs); }
+    void RSGetViewports(UINT *n, D3D11_VIEWPORT *vp) override { g_Census.count(ApiCall::StateQuery); m_real->RSGetViewports(n, vp); }
+    void RSGetScissorRects(UINT *n, D3D11_RECT *rc) override { g_Census.count(ApiCall::StateQuery); m_real->RSGetScissorRects(n, rc); }
+    void HSGetShaderResources(UINT s, UINT n, ID3D11ShaderResourceView **v) override { g_Census.count(ApiCall::StateQuery); m_real->HSGetShaderResources(s, n, v); }
+    void HSGetShader(ID3D11HullShader **sh, ID3D11ClassInstance **ci, UINT *nci) override { g_Census.count(ApiCall::StateQuery); m_real->HSGetShader(sh, ci, nci); }
+    void HSGetSamplers(UINT s, UINT n, ID3D11SamplerState **ss) override { g_Census.count(ApiCall::StateQuery); m_real->HSGetSamplers(s, n, ss); }
+    void HSGetConstantBuffers(UINT s, UINT n, ID3D11Buffer **b) override { g_Census.count(ApiCall::StateQuery); m_real->HSGetConstantBuffers(s, n, b); }
+    void DSGetShaderResources(UINT s, UINT n, ID3D11ShaderResourceView **v) override { g_Census.count(ApiCall::StateQuery); m_real->DSGetShaderResources(s, n, v); }
+    void DSGetShader(ID3D11DomainShader **sh, ID3D11ClassInstance **ci, UINT *nci) override { g_Census.count(ApiCall::StateQuery); m_real->DSGetShader(sh, ci, nci); }
+    void DSGetSamplers(UINT s, UINT n, ID3D11SamplerState **ss) override { g_Census.count(ApiCall::StateQuery); m_real->DSGetSamplers(s, n, ss); }
+    void DSGetConstantBuffers(UINT s, UINT n, ID3D11Buffer **b) override { g_Census.count(ApiCall::StateQuery); m_real->DSGetConstantBuffers(s, n, b); }
+    void CSGetShaderResources(UINT s, UINT n, ID3D11ShaderResourceView **v) override { g_Census.count(ApiCall::StateQuery); m_real->CSGetShaderResources(s, n, v); }
+    void CSGetUnorderedAccessViews(UINT s, UINT n, ID3D11UnorderedAccessView **uav) override { g_Census.count(ApiCall::StateQuery); m_real->CSGetUnorderedAccessViews(s, n, uav); }
+    void CSGetShader(ID3D11ComputeShader **sh, ID3D11ClassInstance **ci, UINT *nci) override { g_Census.count(ApiCall::StateQuery); m_real->CSGetShader(sh, ci, nci); }
+    void CSGetSamplers(UINT s, UINT n, ID3D11SamplerState **ss) override { g_Census.count(ApiCall::StateQuery); m_real->CSGetSamplers(s, n, ss); }
+    void CSGetConstantBuffers(UINT s, UINT n, ID3D11Buffer **b) override { g_Census.count(ApiCall::StateQuery); m_real->CSGetConstantBuffers(s, n, b); }
 
     // -------- context-wide operations --------
-    void ClearState() override { m_real->ClearState(); }
-    void Flush() override { m_real->Flush(); }
-    D3D11_DEVICE_CONTEXT_TYPE GetType() override { return m_real->GetType(); }
-    UINT GetContextFlags() override { return m_real->GetContextFlags(); }
-    HRESULT FinishCommandList(BOOL restore, ID3D11CommandList **cl) override { return m_real->FinishCommandList(restore, cl); }
+    void ClearState() override
+    {
+        g_Census.count(ApiCall::ClearState);
+        if (passes())
+            g_Passes.clearState();
+        m_real->ClearState();
+    }
+    void Flush() override { g_Census.count(ApiCall::Flush); m_real->Flush(); }
+    D3D11_DEVICE_CONTEXT_TYPE GetType() override { g_Census.count(ApiCall::StateQuery); return m_real->GetType(); }
+    UINT GetContextFlags() override { g_Census.count(ApiCall::StateQuery); return m_real->GetContextFlags(); }
+    HRESULT FinishCommandList(BOOL restore, ID3D11CommandList **cl) override
+    {
+        g_Census.count(ApiCall::FinishCommandList);
+        HRESULT hr = m_real->FinishCommandList(restore, cl);
+        if (SUCCEEDED(hr) && m_deferred && cl && *cl)
+        {
+            // the command list takes over the recording, we start a fresh (pooled) one
+            (*cl)->SetPrivateDataInterface(IID_DxPipeRecording, m_list);
+            m_list->Release();
+            m_list = RecordedCommandList::acquire(m_rec->id);
+            m_rec = &m_list->recorder();
+        }
+        return hr;
+    }
 
 private:
+    // -------- event helpers (hot path, no locks, no allocation in steady state) --------
+    inline void onDraw(EventKind k, uint64_t count, uint32_t instances = 1, const void *obj = nullptr)
+    {
+        m_rec->record(k, obj, count, instances);
+        if (depthSpans())
+            g_DepthSpans.onDraw();
+        if (passes())
+            passMark(m_real, g_Passes.draw());
+    }
+
+    inline void onDispatch(const void *obj, uint64_t arg)
+    {
+        m_rec->record(EventKind::Dispatch, obj, arg);
+        if (passes())
+            passMark(m_real, g_Passes.dispatch());
+    }
+
+    inline void onState(EventKind k, const void *obj, uint64_t arg = 0, uint32_t arg2 = 0)
+    {
+        m_rec->record(k, obj, arg, arg2);
+    }
+
+    // slot range packed as (start << 32 | count), object is the first bound view/buffer
+    template <typename T>
+    inline void onBind(EventKind k, ShaderStage stage, UINT start, UINT n, T *const *items)
+    {
+        onState(k, (n && items) ? items[0] : nullptr, (uint64_t(start) << 32) | n, stage);
+        if (passes())
+            passBind(stage, start, n, items);
+    }
+
+    // object is the depth view, arg the first render target
+    inline void onSetTargets(UINT n, ID3D11RenderTargetView *const *rt, ID3D11DepthStencilView *dsv)
+    {
+        onState(EventKind::SetRenderTargets, dsv,
+                reinterpret_cast<uintptr_t>((n && rt) ? rt[0] : nullptr), n);
+        holdDepthFromView(dsv); // the promoted depth's reference for this frame
+        if (depthSpans())
+            depthOnBind(m_real, dsv); // may copy the scene depth before the next pass reuses it
+        if (passes())
+            passTargets(m_real, n, rt, dsv);
+    }
+
+    // a clear of a target is a pass boundary, depth / UAV clears are writes of the pass
+    inline void onClearTarget(ID3D11RenderTargetView *rt)
+    {
+        m_rec->record(EventKind::ClearRenderTarget, rt);
+        if (passes())
+            passMark(m_real, g_Passes.clearTarget(passResource(rt)));
+    }
+
+    inline void onClearUav(ID3D11UnorderedAccessView *uav)
+    {
+        if (passes())
+            passMark(m_real, g_Passes.clear(passResource(uav)));
+    }
+
+    // arg carries the raw bits of the clear depth, arg2 the clear flags and stencil value
+    inline void onClearDepth(ID3D11DepthStencilView *dsv, UINT flags, FLOAT depth, UINT8 stencil)
+    {
+        holdDepthFromView(dsv);
+        if (depthSpans())
+            depthOnClear(m_real, dsv); // runs before the clear is forwarded
+
+        uint32_t bits = 0;
+        memcpy(&bits, &depth, sizeof(bits));
+        m_rec->record(EventKind::ClearDepthStencil, dsv, bits, flags | (uint32_t(stencil) << 8));
+        if (passes())
+            passMark(m_real, g_Passes.clear(passResource(dsv)));
+    }
+
+    // clear time depth snapshots, immediate context only and only with a consumer attached
+    inline bool depthSpans() const
+    {
+        return !m_deferred && g_DepthWanted.load(std::memory_order_relaxed);
+    }
+
+    // pass graph recording, immediate context only and only on sampled frames
+    inline bool passes() const
+    {
+        return !m_deferred && g_Passes.active();
+    }
+
+    inline void onCopy(EventKind k, ID3D11Resource *dst, ID3D11Resource *src)
+    {
+        m_rec->record(k, dst, reinterpret_cast<uintptr_t>(src));
+        if (passes())
+            passMark(m_real, g_Passes.copy(dst, src));
+    }
+
+    // size of an UpdateSubresource payload in bytes
+    static uint64_t updateSize(ID3D11Resource *dst, UINT sub, const D3D11_BOX *box, UINT rp, UINT dp)
+    {
+        if (box)
+        {
+            // an empty box updates nothing, a buffer's box is in bytes, a texture's in texels
+            if (box->right <= box->left || box->bottom <= box->top || box->back <= box->front)
+                return 0;
+            SubresourceExtent e = subresourceExtent(dst, sub);
+            if (e.dim == D3D11_RESOURCE_DIMENSION_BUFFER)
+                return box->right - box->left;
+            return regionBytes(e.format, box->right - box->left, box->bottom - box->top, box->back - box->front, rp,
+                               dp);
+        }
+
+        // whole subresource – buffers report their width, textures the rows / slices of its mip
+        SubresourceExtent e = subresourceExtent(dst, sub);
+        if (e.dim == D3D11_RESOURCE_DIMENSION_BUFFER)
+            return e.width;
+        return regionBytes(e.format, e.width, e.height, e.depth, rp, dp);
+    }
+
+    // bytes the game can write through a mapping of one subresource: block rows of the format,
+    // the last row / slice only as long as its data (0 for planar formats, nothing is read)
+    static uint64_t mappedSize(ID3D11Resource *r, UINT sub, const D3D11_MAPPED_SUBRESOURCE &m)
+    {
+        SubresourceExtent e = subresourceExtent(r, sub);
+        if (e.dim == D3D11_RESOURCE_DIMENSION_BUFFER)
+            return e.width;
+        return regionBytes(e.format, e.width, e.height, e.depth, m.RowPitch, m.DepthPitch);
+    }
+
+    // outstanding write mappings of this context (captured and / or scanned at Unmap)
+    struct PendingMap
+    {
+        ID3D11Resource *res;
+        UINT sub;
+        const void *data;
+        uint64_t size;
+        bool capture;
+        bool constants;
+    };
+
+    void trackMap(ID3D11Resource *r, UINT sub, const D3D11_MAPPED_SUBRESOURCE &m, bool capture, bool constants)
+    {
+        for (PendingMap &p : m_maps)
+        {
+            if (!p.res)
+            {
+                p = {r, sub, m.pData, mappedSize(r, sub, m), capture, constants};
+                m_pendingMaps++;
+                return;
+            }
+        }
+
+        // all slots taken: this one goes uncaptured / unscanned, said once per context
+        if (!m_mapOverflows++)
+            LOG_WARN(Device, "More than {} outstanding maps on a context, the rest go uncaptured",
+                     sizeof(m_maps) / sizeof(m_maps[0]));
+    }
+
+    void finishMap(ID3D11Resource *r, UINT sub)
+    {
+        for (PendingMap &p : m_maps)
+        {
+            if (p.res == r && p.sub == sub)
+            {
+#if ENABLE_CAPTURE
+                if (p.capture)
+                {
+                    uint64_t blob = g_Capture.writeBlob(p.data, size_t(p.size));
+                    m_rec->record(EventKind::Payload, r, blob, uint32_t(p.size));
+                }
+#endif
+                if (p.constants)
+                    scanConstants(r, p.data, size_t(p.size));
+                p = {};
+                m_pendingMaps--;
+                return;
+            }
+        }
+    }
+
+    PendingMap m_maps[8] = {};
+    uint32_t m_pendingMaps = 0;
+    uint64_t m_mapOverflows = 0; // maps that found no free slot
+
     ID3D11DeviceContext *m_real;
     std::atomic<uint32_t> m_ref;
+    EventRecorder *m_rec;        // g_FrameTimeline for the immediate context
+    RecordedCommandList *m_list; // owner of m_rec for deferred contexts
+    bool m_deferred;
 };
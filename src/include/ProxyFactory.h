@@ -13,9 +13,8 @@
 // directx headers
 #include <dxgi1_3.h> // IDXGIFactory2 / SwapChain2
 
-// helper decls
-extern std::string timeStamp();
-extern void output();
+// structured log (g_Log, the LOG_ macros)
+#include "LayerLog.h"
 
 // include our swap-chain proxy
 #include "ProxySwapChain.h"
@@ -72,12 +71,7 @@ public:
                                               DXGI_SWAP_CHAIN_DESC *d,
                                               IDXGISwapChain **ppSwapChain) override
     {
-#if DEBUG
-        output();
-#endif
-#if DEBUG
-        std::cout << timeStamp() << "IDXGIFactory::CreateSwapChain" << std::endl;
-#endif
+        LOG_INFO(SwapChain, "IDXGIFactory::CreateSwapChain");
 
         HRESULT hr = m_real->CreateSwapChain(pDev, d, ppSwapChain);
         if (SUCCEEDED(hr) && ppSwapChain && *ppSwapChain)
@@ -104,12 +98,7 @@ public:
                                                      IDXGIOutput *out,
                                                      IDXGISwapChain1 **ppSwapChain) override
     {
-#if DEBUG
-        output();
-#endif
-#if DEBUG
-        std::cout << timeStamp() << "IDXGIFactory2::CreateSwapChainForHwnd" << std::endl;
-#endif
+        LOG_INFO(SwapChain, "IDXGIFactory2::CreateSwapChainForHwnd");
 
         HRESULT hr = m_real->CreateSwapChainForHwnd(pDev, hwnd, d, fd, out, ppSwapChain);
         if (SUCCEEDED(hr) && ppSwapChain && *ppSwapChain)
@@ -124,12 +113,7 @@ public:
                                                            IDXGIOutput *out,
                                                            IDXGISwapChain1 **ppSwapChain) override
     {
-#if DEBUG
-        output();
-#endif
-#if DEBUG
-        std::cout << timeStamp() << "IDXGIFactory2::CreateSwapChainForCoreWindow" << std::endl;
-#endif
+        LOG_INFO(SwapChain, "IDXGIFactory2::CreateSwapChainForCoreWindow");
 
         HRESULT hr = m_real->CreateSwapChainForCoreWindow(pDev, pWin, d, out, ppSwapChain);
         if (SUCCEEDED(hr) && ppSwapChain && *ppSwapChain)
@@ -144,12 +128,7 @@ public:
                                                             IDXGIOutput *out,
                                                             IDXGISwapChain1 **ppSwapChain) override
     {
-#if DEBUG
-        output();
-#endif
-#if DEBUG
-        std::cout << timeStamp() << "IDXGIFactory2::CreateSwapChainForComposition" << std::endl;
-#endif
+        LOG_INFO(SwapChain, "IDXGIFactory2::CreateSwapChainForComposition");
 
         HRESULT hr = m_real->CreateSwapChainForComposition(pDev, d, out, ppSwapChain);
         if (SUCCEEDED(hr) && ppSwapChain && *ppSwapChain)
@@ -0,0 +1,57 @@
+#pragma once
+
+// c++ includes
+#include <cstring>
+
+// windows headers
+#define NOMINMAX // disable min/max macros
+#include <Windows.h>
+
+// log format + writer
+#include "LayerLog.h"
+
+#if DEBUG
+// the developer's log file (d3d11.cpp)
+extern const char *dbgInfo;
+#endif
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// log glue
+//  • levels: every category at debug in DEBUG builds, off otherwise, then DXPIPE_LOG
+//    (e.g. "ipc=info" or "all=warn,swapchain=debug") and the overlay's Log settings
+//  • the file is dbgInfo in DEBUG builds, dxpipe_log.txt next to the game otherwise, opened
+//    on the first hook call with anything enabled (not from DllMain, the writer is a
+//    thread), records logged before wait in the queue
+///////////////////////////////////////////////////////////////////////////////////////////
+
+// DllMain, before the first record
+inline void configureLog()
+{
+#if DEBUG
+    g_Log.configure("all=debug");
+#endif
+    char spec[256];
+    DWORD len = GetEnvironmentVariableA("DXPIPE_LOG", spec, sizeof(spec));
+    if (len && len < sizeof(spec))
+        g_Log.configure(spec);
+}
+
+// starts the writer once something is enabled, later calls are a flag test
+inline void startLog()
+{
+    if (!g_Log.anyEnabled() || g_Log.isOpen())
+        return;
+
+#if DEBUG
+    const char *path = dbgInfo;
+#else
+    char path[MAX_PATH];
+    GetModuleFileNameA(GetModuleHandle(NULL), path, MAX_PATH);
+    char *lastSlash = strrchr(path, '\\');
+    if (lastSlash)
+        lastSlash[1] = '\0';
+    strncat_s(path, "dxpipe_log.txt", _TRUNCATE);
+#endif
+    if (g_Log.open(path))
+        LOG_INFO(Hooks, "Logging to: {}", path);
+}
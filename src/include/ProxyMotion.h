@@ -0,0 +1,278 @@
+#pragma once
+
+// c++ includes
+#include <iostream>
+
+// windows headers
+#define NOMINMAX // disable min/max macros
+#include <Windows.h>
+
+// directx 11 headers
+#include <d3d11.h>
+#include <d3dcompiler.h> // shader compilation
+
+// reprojection + CPU reference (MotionVectors.h mirrors the shader below)
+#include "MotionVectors.h"
+#include "ProjectionInference.h"
+
+// structured log (g_Log, the LOG_ macros)
+#include "LayerLog.h"
+
+// the camera / depth parameters of the frame being presented (ProxyDepth.h)
+extern CameraMatrices g_CameraMatrices;
+extern DepthProjection g_DepthProjection;
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// camera motion pass
+//  • one compute dispatch, exported depth (R32F SRV) → half size R16G16F UAV, 8x8 threads
+//  • reads the shared depth copy (pc.depthShared), so the vectors belong to exactly the
+//    depth the client got, and the SRV never pins a game texture
+//  • needs the camera of two consecutive frames, any gap (camera lost, depth not wanted)
+//    skips the pass until the next pair
+//  • the game's compute bindings are saved and restored around the dispatch
+///////////////////////////////////////////////////////////////////////////////////////////
+
+// keep in sync with motionVectorsCPU (MotionVectors.h)
+static const char *s_cameraMotionCS = R"(
+Texture2D<float> depth : register(t0);
+RWTexture2D<float2> motion : register(u0);
+
+cbuffer MotionParams : register(b0)
+{
+    row_major float4x4 REPROJECT; // clip now -> clip last frame
+    uint FLAGS;                   // 1 = reversed-Z
+    uint3 padding;
+};
+
+[numthreads(8, 8, 1)]
+void main(uint3 id : SV_DispatchThreadID)
+{
+    uint w, h;
+    depth.GetDimensions(w, h);
+    if (id.x >= (w + 1) / 2 || id.y >= (h + 1) / 2)
+        return;
+
+    // closest of the 2x2 footprint
+    int2 best = int2(id.xy * 2);
+    float d = depth.Load(int3(best, 0));
+    for (uint i = 1; i < 4; i++)
+    {
+        int2 p = min(int2(id.xy * 2 + uint2(i & 1, i >> 1)), int2(w - 1, h - 1));
+        float v = depth.Load(int3(p, 0));
+        if ((FLAGS & 1) ? v > d : v < d)
+        {
+            d = v;
+            best = p;
+        }
+    }
+
+    float2 uv = (float2(best) + 0.5) / float2(w, h);
+    float4 last = mul(float4(uv.x * 2.0 - 1.0, 1.0 - uv.y * 2.0, d, 1.0), REPROJECT);
+    float2 m = 0;
+    if (last.w > 1e-6)
+        m = uv - float2(last.x / last.w * 0.5 + 0.5, 0.5 - last.y / last.w * 0.5);
+    motion[id.xy] = m;
+}
+)";
+
+struct CameraMotionPass
+{
+    ID3D11ComputeShader *cs;
+    ID3D11Buffer *params;
+    bool compileFailed;
+
+    ID3D11Texture2D *source; // depth the SRV reads (kept alive by the srv)
+    ID3D11ShaderResourceView *srv;
+
+    ID3D11Texture2D *target; // R16G16F texture the UAV writes
+    ID3D11UnorderedAccessView *uav;
+
+    CameraMatrices last; // the previous frame's camera
+};
+
+static CameraMotionPass g_CameraMotionPass = {};
+
+// reprojection from the last to this frame's camera, false without two consecutive frames
+inline bool cameraMotionParams(MotionParams &out)
+{
+    CameraMatrices &last = g_CameraMotionPass.last;
+    const CameraMatrices &now = g_CameraMatrices;
+    bool ok = (now.flags & CAM_VALID) && (last.flags & CAM_VALID) && now.frame == last.frame + 1 &&
+              motionReprojection(last, now, out.reprojection);
+    last = now;
+    if (!ok)
+        return false;
+
+    out.flags = (g_DepthProjection.flags & PROJ_REVERSED_Z) ? uint32_t(MOTION_REVERSED_Z) : 0u;
+    out.padding[0] = out.padding[1] = out.padding[2] = 0;
+    return true;
+}
+
+inline bool ensureMotionShader(ID3D11Device *device)
+{
+    CameraMotionPass &p = g_CameraMotionPass;
+    if (p.cs)
+        return true;
+    if (p.compileFailed)
+        return false;
+
+    UINT flags = 0;
+#if defined(_DEBUG)
+    flags |= D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
+#endif
+
+    ID3DBlob *shaderBlob = nullptr;
+    ID3DBlob *errorBlob = nullptr;
+    HRESULT hr = D3DCompile(s_cameraMotionCS, strlen(s_cameraMotionCS),
+                            "CameraMotionCS", nullptr, nullptr,
+                            "main", "cs_5_0", flags, 0,
+                            &shaderBlob, &errorBlob);
+    if (FAILED(hr))
+    {
+        LOG_ERROR(SwapChain, "Camera motion shader compile failed: {}",
+                  (char *)(errorBlob ? errorBlob->GetBufferPointer() : ""));
+        if (errorBlob)
+            errorBlob->Release();
+        p.compileFailed = true; // don't retry every frame
+        return false;
+    }
+
+    hr = device->CreateComputeShader(shaderBlob->GetBufferPointer(), shaderBlob->GetBufferSize(), nullptr, &p.cs);
+    shaderBlob->Release();
+    if (FAILED(hr))
+    {
+        LOG_ERROR(SwapChain, "CreateComputeShader(camera motion) failed! HRESULT: {:x}", hr);
+        p.cs = nullptr;
+        p.compileFailed = true;
+        return false;
+    }
+
+    D3D11_BUFFER_DESC bd = {};
+    bd.ByteWidth = sizeof(MotionParams);
+    bd.Usage = D3D11_USAGE_DEFAULT;
+    bd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    if (FAILED(device->CreateBuffer(&bd, nullptr, &p.params)))
+    {
+        p.params = nullptr;
+        p.cs->Release();
+        p.cs = nullptr;
+        p.compileFailed = true;
+        return false;
+    }
+    return true;
+}
+
+// SRV over the exported depth (the layer's own texture, the srv may keep it)
+inline bool ensureMotionSource(ID3D11Device *device, ID3D11Texture2D *depth)
+{
+    CameraMotionPass &p = g_CameraMotionPass;
+    if (p.source == depth && p.srv)
+        return true;
+    if (p.srv)
+        p.srv->Release();
+    p.srv = nullptr;
+    p.source = nullptr;
+
+    D3D11_TEXTURE2D_DESC d{};
+    depth->GetDesc(&d);
+    D3D11_SHADER_RESOURCE_VIEW_DESC sd = {};
+    sd.Format = DXGI_FORMAT(depthReadFormat(d.Format));
+    sd.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+    sd.Texture2D.MipLevels = 1;
+    if (sd.Format == DXGI_FORMAT_UNKNOWN || FAILED(device->CreateShaderResourceView(depth, &sd, &p.srv)))
+    {
+        LOG_ERROR(SwapChain, "CreateShaderResourceView(camera motion) failed!");
+        p.srv = nullptr;
+        return false;
+    }
+    p.source = depth;
+    return true;
+}
+
+inline bool ensureMotionTarget(ID3D11Device *device, ID3D11Texture2D *dst)
+{
+    CameraMotionPass &p = g_CameraMotionPass;
+    if (p.target == dst && p.uav)
+        return true;
+    if (p.uav)
+        p.uav->Release();
+    p.uav = nullptr;
+    p.target = nullptr;
+
+    D3D11_UNORDERED_ACCESS_VIEW_DESC ud = {};
+    ud.Format = DXGI_FORMAT_R16G16_FLOAT;
+    ud.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE2D;
+    if (FAILED(device->CreateUnorderedAccessView(dst, &ud, &p.uav)))
+    {
+        p.uav = nullptr;
+        return false;
+    }
+    p.target = dst;
+    return true;
+}
+
+// views over textures a context is about to release (ResizeBuffers, context destroyed)
+inline void releaseMotionViews(const ID3D11Texture2D *depth, const ID3D11Texture2D *motion)
+{
+    CameraMotionPass &p = g_CameraMotionPass;
+    if (p.srv && p.source == depth)
+    {
+        p.srv->Release();
+        p.srv = nullptr;
+        p.source = nullptr;
+    }
+    if (p.uav && p.target == motion)
+    {
+        p.uav->Release();
+        p.uav = nullptr;
+        p.target = nullptr;
+    }
+}
+
+// camera motion of depth (single sample) into dst (R16G16F, SRV | UAV), D3D11Api::motionVectors
+inline bool dispatchCameraMotion(ID3D11Device *device, ID3D11DeviceContext *ctx, ID3D11Texture2D *depth,
+                                 ID3D11Texture2D *dst, const MotionParams &params)
+{
+    if (!device || !ctx || !depth || !dst)
+        return false;
+    if (!ensureMotionShader(device) || !ensureMotionSource(device, depth) || !ensureMotionTarget(device, dst))
+        return false;
+
+    CameraMotionPass &p = g_CameraMotionPass;
+    D3D11_TEXTURE2D_DESC d{};
+    dst->GetDesc(&d);
+
+    // the camera moves every frame
+    ctx->UpdateSubresource(p.params, 0, nullptr, &params, 0, 0);
+
+    // save the game's compute bindings
+    ID3D11ComputeShader *oldCS = nullptr;
+    ID3D11ShaderResourceView *oldSRV = nullptr;
+    ID3D11UnorderedAccessView *oldUAV = nullptr;
+    ID3D11Buffer *oldCB = nullptr;
+    ctx->CSGetShader(&oldCS, nullptr, nullptr);
+    ctx->CSGetShaderResources(0, 1, &oldSRV);
+    ctx->CSGetUnorderedAccessViews(0, 1, &oldUAV);
+    ctx->CSGetConstantBuffers(0, 1, &oldCB);
+
+    ctx->CSSetShader(p.cs, nullptr, 0);
+    ctx->CSSetShaderResources(0, 1, &p.srv);
+    ctx->CSSetUnorderedAccessViews(0, 1, &p.uav, nullptr);
+    ctx->CSSetConstantBuffers(0, 1, &p.params);
+    ctx->Dispatch((d.Width + 7) / 8, (d.Height + 7) / 8, 1);
+
+    // restore (this also unbinds our views)
+    ctx->CSSetShader(oldCS, nullptr, 0);
+    ctx->CSSetShaderResources(0, 1, &oldSRV);
+    ctx->CSSetUnorderedAccessViews(0, 1, &oldUAV, nullptr);
+    ctx->CSSetConstantBuffers(0, 1, &oldCB);
+    if (oldCS)
+        oldCS->Release();
+    if (oldSRV)
+        oldSRV->Release();
+    if (oldUAV)
+        oldUAV->Release();
+    if (oldCB)
+        oldCB->Release();
+    return true;
+}
@@ -0,0 +1,340 @@
+#pragma once
+
+// c++ includes
+#include <cstdio>
+#include <cstring>
+#include <atomic>
+
+// windows headers
+#define NOMINMAX // disable min/max macros
+#include <Windows.h>
+
+// directx 11 headers
+#include <d3d11.h>
+
+// pass recorder + graph
+#include "PassGraph.h"
+
+// structured log (g_Log, the LOG_ macros)
+#include "LayerLog.h"
+
+// the immediate context's passes while a sampled frame is recorded
+extern PassRecorder g_Passes;
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// pass graph glue
+//  • the primary's Present arms the recorder every N frames once its own GPU work is
+//    issued and closes it on the next Present before issuing any, so the layer's passes
+//    never show up in the game's graph
+//  • every pass the recorder opens gets a timestamp on the real immediate context, one
+//    more closes the frame; they are read back on later Presents without flushing, a
+//    graph whose queries aren't ready after LATENCY Presents is kept without times
+//  • bound views are resolved to their resources (GetResource) only on sampled frames
+///////////////////////////////////////////////////////////////////////////////////////////
+
+class PassSampler
+{
+public:
+    static const uint32_t LATENCY = 8;        // Presents to wait for the timestamps
+    static const uint32_t DEFAULT_EVERY = 60; // frames between samples (0 = off)
+
+    // every Present of the primary, before the layer's own GPU work
+    void endFrame(ID3D11DeviceContext *ctx)
+    {
+        if (g_Passes.active() && ctx)
+        {
+            g_Passes.end(m_pending);
+            if (m_disjoint)
+            {
+                ctx->End(m_stamps[m_pending.passes.size()]);
+                ctx->End(m_disjoint);
+            }
+            m_waiting = true;
+            m_age = 0;
+        }
+        else if (m_waiting)
+            collect(ctx);
+    }
+
+    // every Present of the primary, after its GPU work: arms the next frame when due
+    void beginFrame(ID3D11Device *device, ID3D11DeviceContext *ctx, uint64_t frame)
+    {
+        uint32_t every = m_every.load(std::memory_order_relaxed);
+        if (!device || !ctx || !every || m_waiting || ++m_frames < every)
+            return;
+        m_frames = 0;
+
+        if (device != m_device)
+        {
+            release();
+            m_device = device;
+            m_failed = false;
+        }
+        if (!m_failed && !m_disjoint && !create(device))
+        {
+            LOG_ERROR(Device, "Pass graph: CreateQuery failed, passes are recorded without GPU times");
+            release();
+            m_device = device;
+            m_failed = true;
+        }
+        if (m_disjoint)
+            ctx->Begin(m_disjoint);
+
+        g_Passes.begin(frame);
+        seedTargets(ctx);
+    }
+
+    // a pass opened (the game's thread, sampled frames only)
+    void mark(ID3D11DeviceContext *ctx, uint32_t pass)
+    {
+        if (m_disjoint && pass <= PASS_MAX)
+            ctx->End(m_stamps[pass]);
+    }
+
+    // the last graph that came back (Present thread)
+    const PassGraph &latest() const { return m_latest; }
+
+    uint32_t every() const { return m_every.load(std::memory_order_relaxed); }
+    void setEvery(uint32_t frames) { m_every.store(frames, std::memory_order_relaxed); }
+
+    // dxpipe_passes.json next to the game
+    bool exportJson() const
+    {
+        if (m_latest.passes.empty())
+            return false;
+
+        char path[MAX_PATH];
+        GetModuleFileNameA(GetModuleHandle(NULL), path, MAX_PATH);
+        char *lastSlash = strrchr(path, '\\');
+        if (lastSlash)
+            lastSlash[1] = '\0';
+        strncat_s(path, "dxpipe_passes.json", _TRUNCATE);
+
+        FILE *file = nullptr;
+        if (fopen_s(&file, path, "wb") || !file)
+        {
+            LOG_ERROR(Overlay, "Failed to open pass graph export: {}", path);
+            return false;
+        }
+        bool ok = writePassGraphJson(m_latest, file);
+        ok = fclose(file) == 0 && ok;
+        LOG_INFO(Overlay, "Pass graph of frame {} ({} passes) exported to: {}", m_latest.frame,
+                 m_latest.passes.size(), path);
+        return ok;
+    }
+
+    void release()
+    {
+        if (m_disjoint)
+            m_disjoint->Release();
+        m_disjoint = nullptr;
+        for (ID3D11Query *&q : m_stamps)
+        {
+            if (q)
+                q->Release();
+            q = nullptr;
+        }
+        m_device = nullptr;
+        m_waiting = false;
+    }
+
+private:
+    bool create(ID3D11Device *device)
+    {
+        D3D11_QUERY_DESC qd = {D3D11_QUERY_TIMESTAMP_DISJOINT, 0};
+        if (FAILED(device->CreateQuery(&qd, &m_disjoint)))
+            return false;
+        qd.Query = D3D11_QUERY_TIMESTAMP;
+        for (ID3D11Query *&q : m_stamps)
+            if (FAILED(device->CreateQuery(&qd, &q)))
+                return false;
+        return true;
+    }
+
+    // never waits, the graph moves to latest() with or without its times
+    void collect(ID3D11DeviceContext *ctx)
+    {
+        if (m_disjoint && ctx)
+        {
+            D3D11_QUERY_DATA_TIMESTAMP_DISJOINT dj = {};
+            HRESULT hr = ctx->GetData(m_disjoint, &dj, sizeof(dj), D3D11_ASYNC_GETDATA_DONOTFLUSH);
+            if (hr == S_FALSE && ++m_age < LATENCY)
+                return;
+            if (hr == S_OK && !dj.Disjoint && dj.Frequency)
+                readTimes(ctx, dj.Frequency);
+        }
+        m_waiting = false;
+        std::swap(m_latest, m_pending);
+    }
+
+    void readTimes(ID3D11DeviceContext *ctx, uint64_t frequency)
+    {
+        PassGraph &g = m_pending;
+        UINT64 prev = 0;
+        for (uint32_t i = 0; i <= g.passes.size(); i++)
+        {
+            UINT64 t = 0;
+            if (ctx->GetData(m_stamps[i], &t, sizeof(t), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+                return;
+            if (i && t >= prev)
+            {
+                g.passes[i - 1].gpuNs = uint64_t(double(t - prev) * 1e9 / double(frequency));
+                g.gpuNs += g.passes[i - 1].gpuNs;
+            }
+            prev = t;
+        }
+        g.timed = true;
+    }
+
+    // the targets the frame starts with (usually rebound before the first draw anyway)
+    void seedTargets(ID3D11DeviceContext *ctx);
+
+    ID3D11Query *m_disjoint = nullptr;
+    ID3D11Query *m_stamps[PASS_MAX + 1] = {};
+    ID3D11Device *m_device = nullptr;
+    bool m_failed = false;
+    bool m_waiting = false; // m_pending holds a graph whose times are outstanding
+    uint32_t m_age = 0;
+    uint32_t m_frames = 0;
+    std::atomic<uint32_t> m_every{DEFAULT_EVERY};
+
+    PassGraph m_pending, m_latest;
+};
+
+// primary device only (the queries belong to g_Device)
+static PassSampler g_PassSampler;
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// context proxy hooks (immediate context, g_Passes.active() checked by the caller)
+///////////////////////////////////////////////////////////////////////////////////////////
+
+// the resource behind a view, the reference GetResource adds is dropped right away (the
+// bound view keeps the resource alive)
+inline const void *passResource(ID3D11View *view)
+{
+    if (!view)
+        return nullptr;
+    ID3D11Resource *res = nullptr;
+    view->GetResource(&res);
+    if (res)
+        res->Release();
+    return res;
+}
+
+// size / format of the resources seen for the first time
+inline void passDescribe()
+{
+    while (PassResource *r = g_Passes.nextUndescribed())
+    {
+        ID3D11Resource *res = static_cast<ID3D11Resource *>(const_cast<void *>(r->object));
+        D3D11_RESOURCE_DIMENSION dim = D3D11_RESOURCE_DIMENSION_UNKNOWN;
+        res->GetType(&dim);
+        r->dimension = uint32_t(dim);
+        r->samples = 1;
+        switch (dim)
+        {
+        case D3D11_RESOURCE_DIMENSION_BUFFER:
+        {
+            D3D11_BUFFER_DESC d{};
+            static_cast<ID3D11Buffer *>(res)->GetDesc(&d);
+            r->width = d.ByteWidth;
+            break;
+        }
+        case D3D11_RESOURCE_DIMENSION_TEXTURE1D:
+        {
+            D3D11_TEXTURE1D_DESC d{};
+            static_cast<ID3D11Texture1D *>(res)->GetDesc(&d);
+            r->width = d.Width;
+            r->format = uint32_t(d.Format);
+            break;
+        }
+        case D3D11_RESOURCE_DIMENSION_TEXTURE2D:
+        {
+            D3D11_TEXTURE2D_DESC d{};
+            static_cast<ID3D11Texture2D *>(res)->GetDesc(&d);
+            r->width = d.Width;
+            r->height = d.Height;
+            r->format = uint32_t(d.Format);
+            r->samples = d.SampleDesc.Count;
+            break;
+        }
+        case D3D11_RESOURCE_DIMENSION_TEXTURE3D:
+        {
+            D3D11_TEXTURE3D_DESC d{};
+            static_cast<ID3D11Texture3D *>(res)->GetDesc(&d);
+            r->width = d.Width;
+            r->height = d.Height;
+            r->format = uint32_t(d.Format);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+// after every recorder call that may open a pass / meet a new resource
+inline void passMark(ID3D11DeviceContext *ctx, uint32_t pass)
+{
+    if (pass != PASS_NONE)
+        g_PassSampler.mark(ctx, pass);
+    passDescribe();
+}
+
+template <typename V>
+inline void passViews(V *const *views, UINT n, const void **out)
+{
+    for (UINT i = 0; i < n; i++)
+        out[i] = views ? passResource(views[i]) : nullptr;
+}
+
+inline void passTargets(ID3D11DeviceContext *ctx, UINT n, ID3D11RenderTargetView *const *rt, ID3D11DepthStencilView *dsv)
+{
+    const void *targets[PASS_TARGETS];
+    n = n < PASS_TARGETS ? n : PASS_TARGETS;
+    passViews(rt, n, targets);
+    passMark(ctx, g_Passes.targets(targets, n, passResource(dsv)));
+}
+
+inline void passBind(ShaderStage stage, UINT start, UINT n, ID3D11ShaderResourceView *const *views)
+{
+    const void *resources[PASS_SRV_SLOTS];
+    if (start >= PASS_SRV_SLOTS)
+        return;
+    n = n < PASS_SRV_SLOTS - start ? n : PASS_SRV_SLOTS - start;
+    passViews(views, n, resources);
+    g_Passes.bind(stage, start, n, resources);
+}
+
+// constant buffers are no pass inputs
+inline void passBind(ShaderStage, UINT, UINT, ID3D11Buffer *const *) {}
+
+inline void passUavs(bool compute, UINT start, UINT n, ID3D11UnorderedAccessView *const *uavs)
+{
+    const void *resources[PASS_UAV_SLOTS];
+    if (start >= PASS_UAV_SLOTS)
+        return;
+    n = n < PASS_UAV_SLOTS - start ? n : PASS_UAV_SLOTS - start;
+    passViews(uavs, n, resources);
+    g_Passes.bindUavs(compute, start, n, resources);
+}
+
+inline void PassSampler::seedTargets(ID3D11DeviceContext *ctx)
+{
+    ID3D11RenderTargetView *rt[PASS_TARGETS] = {};
+    ID3D11DepthStencilView *dsv = nullptr;
+    ctx->OMGetRenderTargets(PASS_TARGETS, rt, &dsv);
+
+    const void *targets[PASS_TARGETS];
+    passViews(rt, PASS_TARGETS, targets);
+    uint32_t n = PASS_TARGETS;
+    while (n && !targets[n - 1])
+        n--;
+    g_Passes.seedTargets(targets, n, passResource(dsv));
+
+    for (ID3D11RenderTargetView *v : rt)
+        if (v)
+            v->Release();
+    if (dsv)
+        dsv->Release();
+}
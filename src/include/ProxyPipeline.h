@@ -0,0 +1,298 @@
+#pragma once
+
+// c++ includes
+#include <cstdio>
+#include <iostream>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+
+// windows headers
+#define NOMINMAX // disable min/max macros
+#include <Windows.h>
+
+// directx headers
+#include <d3d11.h>
+#include <dxgi.h>
+
+// back buffers are tracked like every other game texture, the depth params stream
+// carries the DepthProjection, the camera stream the CameraMatrices
+#include "ProxyTracking.h"
+#include "ProjectionInference.h"
+#include "CameraInference.h"
+
+// the motion pass keeps views over the exported depth / motion textures
+#include "ProxyMotion.h"
+
+// structured log (g_Log, the LOG_ macros)
+#include "LayerLog.h"
+
+// helper decls (implemented in d3d11.cpp)
+extern int g_Width;            // target width (primary context)
+extern int g_Height;           // target height (primary context)
+extern ID3D11Device *g_Device; // the device depth detection runs on (weak)
+extern void replaceGlobal(ID3D11Texture2D *&dst, ID3D11Texture2D *src);
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// per swap chain pipeline contexts
+//  • every ProxySwapChain owns one from construction to its final Release: the back
+//    buffer, the staging / shared copies, the size and the client transport
+//  • the primary context presents with the device depth detection runs on (g_Device), it
+//    alone exports depth, ends the frame timeline and drives g_Width / g_Height, the
+//    overlay and the depth profile
+//  • auxiliary contexts (other windows, the display device of a hybrid-GPU laptop) export
+//    colour with their own device, their streams are tagged with the context id
+//    (dxpipe_backbuffer_<id>), the primary keeps the untagged names the client opens
+///////////////////////////////////////////////////////////////////////////////////////////
+
+// Structure to send texture information with dimensions
+struct TextureInfo
+{
+    HANDLE handle;
+    UINT width;
+    UINT height;
+    DXGI_FORMAT format;
+};
+
+// client transport state of one context (pipes + what was last sent over them)
+struct PipelineTransport
+{
+    DWORD lastFoundPID = 0;
+    HANDLE backBufferPipe = INVALID_HANDLE_VALUE;
+    HANDLE depthBufferPipe = INVALID_HANDLE_VALUE;
+    HANDLE confirmationPipe = INVALID_HANDLE_VALUE;
+    HANDLE depthParamsPipe = INVALID_HANDLE_VALUE; // inferred near / far / reversed-Z (DepthProjection)
+    HANDLE cameraPipe = INVALID_HANDLE_VALUE;      // view / projection per frame (CameraMatrices)
+    HANDLE motionPipe = INVALID_HANDLE_VALUE;      // camera motion texture (TextureInfo)
+    HANDLE displayPipe = INVALID_HANDLE_VALUE;     // frames on screen, primary only (FrameDisplay)
+    DWORD searchCooldown = 0;                      // wait a few frames between searches to avoid high CPU usage
+    TextureInfo lastSentBackInfo = {nullptr, 0, 0, DXGI_FORMAT_UNKNOWN};
+    TextureInfo lastSentDepthInfo = {nullptr, 0, 0, DXGI_FORMAT_UNKNOWN};
+    TextureInfo lastSentMotionInfo = {nullptr, 0, 0, DXGI_FORMAT_UNKNOWN};
+    DepthProjection lastSentProjection = {};
+    uint64_t lastSentCameraFrame = 0;
+    uint32_t lastSentCameraFlags = 0;
+    uint64_t lastSentDisplay = 0; // DisplayTracker::resolved() as of the last record sent
+    DWORD lastSendTime = 0;
+    bool waitingForConfirmation = false;
+
+    // close every pipe, the next call recreates them (under the context's current tag)
+    void close()
+    {
+        for (HANDLE pipe : {backBufferPipe, depthBufferPipe, confirmationPipe, depthParamsPipe, cameraPipe, motionPipe,
+                            displayPipe})
+        {
+            if (pipe != INVALID_HANDLE_VALUE)
+                CloseHandle(pipe);
+        }
+        *this = PipelineTransport{};
+    }
+};
+
+struct PipelineContext
+{
+    uint32_t id = 0;                     // stream tag, unique for the process lifetime
+    IDXGISwapChain *swapChain = nullptr; // the real swap chain (owns this context)
+    ID3D11Device *device = nullptr;      // device the swap chain presents with (the swap chain holds it)
+    std::atomic<bool> primary{false};    // set by electPrimaryPipeline
+    std::atomic<bool> retag{false};      // primary changed, the owner resets its streams on Present
+    std::atomic<uint32_t> statsStreams{0}; // shared textures | client found << 8, as of the last Present
+    int width = 0;
+    int height = 0;
+
+    ID3D11Texture2D *backBuffer = nullptr;        // colour RT (GetBuffer-0, held)
+    ID3D11Texture2D *backBufferStaging = nullptr; // CPU-readable copy (colour)
+    ID3D11Texture2D *depthStaging = nullptr;      // CPU-readable copy (depth)
+
+    // shared copies + their handles
+    ID3D11Texture2D *backBufferShared = nullptr;
+    HANDLE backBufferSharedHandle = nullptr;
+    ID3D11Texture2D *depthShared = nullptr;
+    HANDLE depthSharedHandle = nullptr;
+
+    // single-sample R32F resolve of an msaa depth buffer (exported in its place)
+    ID3D11Texture2D *depthResolved = nullptr;
+
+    // half size R16G16F camera motion (compute target) + its shared copy
+    ID3D11Texture2D *motion = nullptr;
+    ID3D11Texture2D *motionShared = nullptr;
+    HANDLE motionSharedHandle = nullptr;
+
+    PipelineTransport transport;
+};
+
+// every live context, guarded by g_PipelineLock (the contexts' fields belong to their owner)
+extern std::mutex g_PipelineLock;
+extern std::vector<PipelineContext *> g_Pipelines;
+
+// pipe name of a stream, tagged with the context id unless it is the primary
+inline void pipelinePipeName(const PipelineContext &pc, const char *stream, char *out, size_t size)
+{
+    if (pc.primary.load(std::memory_order_relaxed))
+        snprintf(out, size, "%s", stream);
+    else
+        snprintf(out, size, "%s_%u", stream, pc.id);
+}
+
+// (re)pick the primary: keep a live one on g_Device, else the oldest context on g_Device,
+// else the oldest context at all (no detection device yet / any more), caller holds the lock
+inline void electPrimaryPipelineLocked()
+{
+    PipelineContext *current = nullptr;
+    for (PipelineContext *pc : g_Pipelines)
+        if (pc->primary.load(std::memory_order_relaxed))
+            current = pc;
+
+    if (current && (!g_Device || current->device == g_Device))
+        return;
+
+    PipelineContext *next = nullptr;
+    for (PipelineContext *pc : g_Pipelines)
+    {
+        if (g_Device && pc->device == g_Device)
+        {
+            next = pc;
+            break;
+        }
+    }
+    if (!next && !g_Device && !g_Pipelines.empty())
+        next = g_Pipelines.front();
+    if (next == current)
+        return;
+
+    if (current)
+    {
+        current->primary = false;
+        current->retag = true;
+    }
+    if (next)
+    {
+        next->primary = true;
+        next->retag = true;
+        if (next->width && next->height)
+        {
+            g_Width = next->width;
+            g_Height = next->height;
+        }
+    }
+    LOG_INFO(SwapChain, "Primary pipeline context: {}", (next ? int(next->id) : -1));
+}
+
+inline void electPrimaryPipeline()
+{
+    std::lock_guard<std::mutex> lock(g_PipelineLock);
+    electPrimaryPipelineLocked();
+}
+
+// this context's size changed, the primary's is the depth detection target
+inline void setPipelineSize(PipelineContext &pc, int w, int h)
+{
+    if (pc.width == w && pc.height == h)
+        return;
+    pc.width = w;
+    pc.height = h;
+    if (pc.primary.load(std::memory_order_relaxed))
+    {
+        g_Width = w;
+        g_Height = h;
+    }
+    LOG_INFO(SwapChain, "Pipeline context {} size: {}x{}", pc.id, w, h);
+}
+
+// size from the back buffer (covers ResizeBuffers(0, 0) = window size)
+inline void updatePipelineSize(PipelineContext &pc)
+{
+    if (!pc.backBuffer)
+        return;
+    D3D11_TEXTURE2D_DESC desc;
+    pc.backBuffer->GetDesc(&desc);
+    setPipelineSize(pc, int(desc.Width), int(desc.Height));
+}
+
+// new back buffer (GetBuffer(0) / after ResizeBuffers), it also tells the device
+inline void setPipelineBackBuffer(PipelineContext &pc, ID3D11Texture2D *bb)
+{
+    trackTexture(bb, TrackedKind::BackBuffer);
+    replaceGlobal(pc.backBuffer, bb);
+    if (!bb)
+        return;
+
+    // the real texture reports the real device, even when the game created the swap chain
+    // with our proxy
+    ID3D11Device *device = nullptr;
+    bb->GetDevice(&device);
+    if (device)
+        device->Release(); // the swap chain keeps it alive
+    if (device != pc.device)
+    {
+        pc.device = device;
+        electPrimaryPipeline();
+    }
+    updatePipelineSize(pc);
+}
+
+// everything sized to the back buffer (ResizeBuffers), depth staging follows the depth
+inline void releasePipelineBuffers(PipelineContext &pc)
+{
+    replaceGlobal(pc.backBuffer, nullptr);
+    replaceGlobal(pc.backBufferStaging, nullptr);
+
+    replaceGlobal(pc.backBufferShared, nullptr);
+    pc.backBufferSharedHandle = nullptr;
+    releaseMotionViews(pc.depthShared, pc.motion);
+    replaceGlobal(pc.depthShared, nullptr);
+    pc.depthSharedHandle = nullptr;
+    replaceGlobal(pc.motion, nullptr);
+    replaceGlobal(pc.motionShared, nullptr);
+    pc.motionSharedHandle = nullptr;
+}
+
+// depth exports of a context that stopped being the primary
+inline void releasePipelineDepth(PipelineContext &pc)
+{
+    releaseMotionViews(pc.depthShared, pc.motion);
+    replaceGlobal(pc.depthStaging, nullptr);
+    replaceGlobal(pc.depthShared, nullptr);
+    pc.depthSharedHandle = nullptr;
+    replaceGlobal(pc.depthResolved, nullptr);
+    replaceGlobal(pc.motion, nullptr);
+    replaceGlobal(pc.motionShared, nullptr);
+    pc.motionSharedHandle = nullptr;
+}
+
+inline PipelineContext *createPipelineContext(IDXGISwapChain *swapChain)
+{
+    static std::atomic<uint32_t> s_nextId{1};
+
+    PipelineContext *pc = new PipelineContext();
+    pc->id = s_nextId++;
+    pc->swapChain = swapChain;
+    {
+        std::lock_guard<std::mutex> lock(g_PipelineLock);
+        g_Pipelines.push_back(pc);
+    }
+    LOG_INFO(SwapChain, "Pipeline context {} created for swap chain {}", pc->id, swapChain);
+    return pc;
+}
+
+// the swap chain is going away, its streams close with it
+inline void destroyPipelineContext(PipelineContext *pc)
+{
+    {
+        std::lock_guard<std::mutex> lock(g_PipelineLock);
+        g_Pipelines.erase(std::remove(g_Pipelines.begin(), g_Pipelines.end(), pc), g_Pipelines.end());
+        if (pc->primary.load(std::memory_order_relaxed))
+        {
+            releaseDepthHold(); // before another primary presents with it
+            pc->primary = false;
+            electPrimaryPipelineLocked();
+        }
+    }
+
+    releasePipelineBuffers(*pc);
+    releasePipelineDepth(*pc);
+    pc->transport.close();
+    LOG_INFO(SwapChain, "Pipeline context {} destroyed", pc->id);
+    delete pc;
+}
@@ -0,0 +1,177 @@
+#pragma once
+
+// c++ includes
+#include <iostream>
+#include <string>
+
+// windows headers
+#define NOMINMAX // disable min/max macros
+#include <Windows.h>
+
+// directx 11 headers
+#include <d3d11.h>
+
+// profile store + candidate / projection state it is filled from
+#include "DepthProfile.h"
+#include "ProxyDepth.h"
+
+// structured log (g_Log, the LOG_ macros)
+#include "LayerLog.h"
+
+// the mapped profile file (%LOCALAPPDATA%\dxpipe\depth_profiles.dxprof)
+extern DepthProfileStore g_DepthProfiles;
+
+// record for this exe at the current back buffer size (exe = 0 until one exists)
+extern DepthProfile g_DepthProfile;
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// depth profile glue
+//  • the swap chain looks its size up on creation / ResizeBuffers and hands the record to
+//    DepthCandidates (preferred texture) and g_DepthProjection (fallback projection)
+//  • Present writes the record back whenever the promotion or the projection changed
+///////////////////////////////////////////////////////////////////////////////////////////
+
+// map the profile file once, the store stays detached if that fails (no caching then)
+inline bool openDepthProfiles()
+{
+    static bool s_tried = false;
+    if (s_tried)
+        return g_DepthProfiles.attached();
+    s_tried = true;
+
+    char path[MAX_PATH];
+    DWORD n = GetEnvironmentVariableA("LOCALAPPDATA", path, MAX_PATH);
+    if (!n || n >= MAX_PATH)
+        return false;
+    strncat_s(path, "\\dxpipe", _TRUNCATE);
+    CreateDirectoryA(path, nullptr); // fails harmlessly if it exists
+    strncat_s(path, "\\depth_profiles.dxprof", _TRUNCATE);
+
+    HANDLE file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                              nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        LOG_ERROR(Device, "Failed to open depth profiles: {}", path);
+        return false;
+    }
+
+    // the mapping grows the file to the store size, the view keeps it alive after this
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, 0, DWORD(DepthProfileStore::bytes()), nullptr);
+    CloseHandle(file);
+    if (!mapping)
+        return false;
+    void *view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, DepthProfileStore::bytes());
+    CloseHandle(mapping);
+    if (!view)
+        return false;
+
+    g_DepthProfiles.attach(view, DepthProfileStore::bytes());
+    LOG_INFO(Device, "Depth profiles: {}{}", path, (g_DepthProfiles.reset() ? " (new)" : ""));
+    return true;
+}
+
+inline uint64_t depthProfileExe()
+{
+    static uint64_t s_exe = 0;
+    if (!s_exe)
+    {
+        char path[MAX_PATH] = {0};
+        GetModuleFileNameA(nullptr, path, MAX_PATH);
+        const char *name = strrchr(path, '\\');
+        s_exe = depthProfileHash(name ? name + 1 : path);
+    }
+    return s_exe;
+}
+
+// the swap chain was created / resized to w x h (before the game recreates its targets)
+inline void applyDepthProfile(UINT w, UINT h)
+{
+    g_DepthCandidates.resetOrdinals();
+    g_DepthProfile = {};
+    if (!w || !h || !openDepthProfiles())
+    {
+        g_DepthCandidates.clearPreference();
+        return;
+    }
+
+    DepthProfile p;
+    if (!g_DepthProfiles.find(depthProfileExe(), w, h, p))
+    {
+        g_DepthCandidates.clearPreference();
+        g_DepthProfile.exe = depthProfileExe();
+        g_DepthProfile.width = w;
+        g_DepthProfile.height = h;
+        return;
+    }
+
+    p.uses++;
+    g_DepthProfiles.store(p);
+    g_DepthProfile = p;
+    g_DepthCandidates.prefer(depthProfileTexture(p), p.ordinal);
+    LOG_INFO(Device, "Depth profile {}x{}: {}x{} format {} ordinal {} near {} far {} (used {} times)", w, h,
+             p.texWidth, p.texHeight, p.format, p.ordinal, p.nearPlane, p.farPlane, p.uses);
+}
+
+// stand in for the projection until this launch has inferred its own, after inferProjection
+inline void applyProfileProjection()
+{
+    if (g_DepthProjection.flags & PROJ_VALID)
+        return;
+    if (!g_DepthProfile.exe || !(g_DepthProfile.projFlags & PROJ_VALID))
+        return;
+
+    uint64_t frame = g_DepthProjection.frame;
+    g_DepthProjection = depthProfileProjection(g_DepthProfile);
+    g_DepthProjection.flags |= PROJ_FROM_PROFILE;
+    g_DepthProjection.frame = frame;
+}
+
+// write the record back when this launch learned something new, called once per Present
+inline void updateDepthProfile()
+{
+    if (!g_DepthProfile.exe)
+        return;
+
+    // only look when the promotion or the projection may have changed
+    static uint32_t s_epoch = 0;
+    static DepthProjection s_projection = {};
+    uint32_t epoch = g_DepthCandidates.epoch();
+    const DepthProjection &proj = g_DepthProjection;
+    if (epoch == s_epoch && proj.flags == s_projection.flags && proj.nearPlane == s_projection.nearPlane &&
+        proj.farPlane == s_projection.farPlane)
+        return;
+    s_epoch = epoch;
+    s_projection = proj;
+
+    DepthTextureInfo info;
+    uint32_t ordinal = 0;
+    if (!g_DepthCandidates.promotedInfo(info, &ordinal))
+        return;
+
+    DepthProfile p = g_DepthProfile;
+    p.texWidth = info.width;
+    p.texHeight = info.height;
+    p.format = info.format;
+    p.samples = info.samples;
+    p.arraySize = info.arraySize;
+    p.bindFlags = info.bindFlags;
+    p.ordinal = ordinal;
+
+    // this launch's own inference, a stored matrix result is only replaced by another one
+    bool own = !(proj.flags & PROJ_FROM_PROFILE);
+    if (own && ((proj.flags & PROJ_VALID) || ((proj.flags & PROJ_FROM_STATE) && !(p.projFlags & PROJ_VALID))))
+    {
+        p.nearPlane = proj.nearPlane;
+        p.farPlane = proj.farPlane;
+        p.fovY = proj.fovY;
+        p.projFlags = proj.flags;
+    }
+
+    if (!memcmp(&p.format, &g_DepthProfile.format, offsetof(DepthProfile, reserved) - offsetof(DepthProfile, format)))
+        return;
+
+    g_DepthProfiles.store(p);
+    g_DepthProfile = p;
+    LOG_INFO(Device, "Depth profile {}x{} saved: {}x{} format {} ordinal {} projection 0x{:x}", p.width, p.height,
+             p.texWidth, p.texHeight, p.format, p.ordinal, p.projFlags);
+}
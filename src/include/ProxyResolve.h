@@ -0,0 +1,327 @@
+#pragma once
+
+// c++ includes
+#include <iostream>
+
+// windows headers
+#define NOMINMAX // disable min/max macros
+#include <Windows.h>
+
+// directx 11 headers
+#include <d3d11.h>
+#include <d3dcompiler.h> // shader compilation
+
+// resolve modes + CPU reference (DepthResolve.h mirrors the shader below)
+#include "DepthResolve.h"
+
+// tells game textures (never pinned by a cached view) from the layer's own
+#include "ProxyTracking.h"
+
+// structured log (g_Log, the LOG_ macros)
+#include "LayerLog.h"
+
+// resolve mode used for msaa depth buffers
+extern DepthResolveMode g_DepthResolveMode;
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// depth resolve pass
+//  • one compute dispatch, Texture2DMS → R32F UAV, 8x8 threads per group
+//  • single-sample depth that isn't R32 (D24S8, D16, D32S8) goes through the same pass,
+//    built with SINGLE_SAMPLE (Texture2D source), to convert it to R32F
+//  • the depth buffer is read through an SRV, buffers created without SHADER_RESOURCE are
+//    first copied into an srv-capable msaa texture of the same typeless family
+//  • the game's compute bindings are saved and restored around the dispatch
+//  • an SRV over a game texture would keep it alive, those are dropped after the dispatch,
+//    views over the layer's own textures (snapshot, copy) are kept
+///////////////////////////////////////////////////////////////////////////////////////////
+
+// keep in sync with resolveDepthTexel (DepthResolve.h)
+static const char *s_depthResolveCS = R"(
+#if SINGLE_SAMPLE
+Texture2D<float> src : register(t0);
+#else
+Texture2DMS<float> src : register(t0);
+#endif
+RWTexture2D<float> dst : register(u0);
+
+cbuffer ResolveParams : register(b0)
+{
+    uint MODE;    // DepthResolveMode: 0 sample 0, 1 min, 2 max
+    uint SAMPLES;
+    uint2 padding;
+};
+
+[numthreads(8, 8, 1)]
+void main(uint3 id : SV_DispatchThreadID)
+{
+#if SINGLE_SAMPLE
+    uint w, h;
+    src.GetDimensions(w, h);
+    if (id.x >= w || id.y >= h)
+        return;
+
+    dst[id.xy] = src.Load(int3(id.xy, 0));
+#else
+    uint w, h, n;
+    src.GetDimensions(w, h, n);
+    if (id.x >= w || id.y >= h)
+        return;
+
+    float d = src.Load(int2(id.xy), 0);
+    if (MODE != 0)
+    {
+        for (uint s = 1; s < SAMPLES; s++)
+        {
+            float v = src.Load(int2(id.xy), s);
+            d = MODE == 1 ? min(d, v) : max(d, v);
+        }
+    }
+    dst[id.xy] = d;
+#endif
+}
+)";
+
+struct ResolveParams
+{
+    UINT MODE;
+    UINT SAMPLES;
+    UINT padding[2];
+};
+
+struct DepthResolvePass
+{
+    ID3D11ComputeShader *cs[2];     // [0] msaa source, [1] single-sample source (SINGLE_SAMPLE)
+    ID3D11Buffer *params;
+    ResolveParams current;
+    bool compileFailed[2];
+
+    ID3D11Texture2D *source;        // depth buffer the SRV reads (kept alive by srv / copy)
+    ID3D11Texture2D *copy;          // srv-capable copy, when the source can't have an SRV
+    ID3D11ShaderResourceView *srv;
+
+    ID3D11Texture2D *target;        // resolved R32F texture the UAV writes
+    ID3D11UnorderedAccessView *uav;
+};
+
+static DepthResolvePass g_DepthResolvePass = {};
+
+inline bool ensureResolveShader(ID3D11Device *device, bool singleSample)
+{
+    DepthResolvePass &p = g_DepthResolvePass;
+    ID3D11ComputeShader *&cs = p.cs[singleSample];
+    if (cs)
+        return true;
+    if (p.compileFailed[singleSample])
+        return false;
+
+    UINT flags = 0;
+#if defined(_DEBUG)
+    flags |= D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
+#endif
+
+    const D3D_SHADER_MACRO defines[] = {{"SINGLE_SAMPLE", singleSample ? "1" : "0"}, {nullptr, nullptr}};
+    ID3DBlob *shaderBlob = nullptr;
+    ID3DBlob *errorBlob = nullptr;
+    HRESULT hr = D3DCompile(s_depthResolveCS, strlen(s_depthResolveCS),
+                            "DepthResolveCS", defines, nullptr,
+                            "main", "cs_5_0", flags, 0,
+                            &shaderBlob, &errorBlob);
+    if (FAILED(hr))
+    {
+        LOG_ERROR(SwapChain, "Depth resolve shader compile failed: {}",
+                  (char *)(errorBlob ? errorBlob->GetBufferPointer() : ""));
+        if (errorBlob)
+            errorBlob->Release();
+        p.compileFailed[singleSample] = true; // don't retry every frame
+        return false;
+    }
+
+    hr = device->CreateComputeShader(shaderBlob->GetBufferPointer(), shaderBlob->GetBufferSize(), nullptr, &cs);
+    shaderBlob->Release();
+    if (FAILED(hr))
+    {
+        LOG_ERROR(SwapChain, "CreateComputeShader(depth resolve) failed! HRESULT: {:x}", hr);
+        cs = nullptr;
+        p.compileFailed[singleSample] = true;
+        return false;
+    }
+
+    // the constant buffer is shared by both variants
+    if (p.params)
+        return true;
+    D3D11_BUFFER_DESC bd = {};
+    bd.ByteWidth = sizeof(ResolveParams);
+    bd.Usage = D3D11_USAGE_DEFAULT;
+    bd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    if (FAILED(device->CreateBuffer(&bd, nullptr, &p.params)))
+    {
+        p.params = nullptr;
+        cs->Release();
+        cs = nullptr;
+        p.compileFailed[singleSample] = true;
+        return false;
+    }
+    p.current = {UINT_MAX, 0, {0, 0}};
+    return true;
+}
+
+inline void releaseResolveSource()
+{
+    DepthResolvePass &p = g_DepthResolvePass;
+    if (p.srv)
+        p.srv->Release();
+    if (p.copy)
+        p.copy->Release();
+    p.srv = nullptr;
+    p.copy = nullptr;
+    p.source = nullptr;
+}
+
+// SRV over the depth buffer (or over a copy of it), Texture2DMS or Texture2D by sample count
+inline bool ensureResolveSource(ID3D11Device *device, ID3D11Texture2D *src)
+{
+    DepthResolvePass &p = g_DepthResolvePass;
+    D3D11_TEXTURE2D_DESC d{};
+    src->GetDesc(&d);
+
+    // the srv holds src alive, the copy doesn't, so a reused address is caught by its desc
+    if (p.source == src && p.srv)
+    {
+        if (!p.copy)
+            return true;
+        D3D11_TEXTURE2D_DESC cd{};
+        p.copy->GetDesc(&cd);
+        if (cd.Width == d.Width && cd.Height == d.Height && cd.SampleDesc.Count == d.SampleDesc.Count &&
+            cd.SampleDesc.Quality == d.SampleDesc.Quality && cd.Format == DXGI_FORMAT(depthTypelessFormat(d.Format)))
+            return true;
+    }
+    releaseResolveSource();
+    DXGI_FORMAT readFormat = DXGI_FORMAT(depthReadFormat(d.Format));
+    if (readFormat == DXGI_FORMAT_UNKNOWN)
+        return false;
+
+    ID3D11Texture2D *readable = src;
+    if (!(d.BindFlags & D3D11_BIND_SHADER_RESOURCE))
+    {
+        D3D11_TEXTURE2D_DESC cd = d;
+        cd.Format = DXGI_FORMAT(depthTypelessFormat(d.Format));
+        cd.MipLevels = 1;
+        cd.ArraySize = 1;
+        cd.Usage = D3D11_USAGE_DEFAULT;
+        cd.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+        cd.CPUAccessFlags = 0;
+        cd.MiscFlags = 0;
+        if (FAILED(device->CreateTexture2D(&cd, nullptr, &p.copy)))
+        {
+            LOG_ERROR(SwapChain, "CreateTexture2D(depth resolve copy) failed!");
+            p.copy = nullptr;
+            return false;
+        }
+        readable = p.copy;
+    }
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC sd = {};
+    sd.Format = readFormat;
+    if (d.SampleDesc.Count > 1)
+        sd.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DMS;
+    else
+    {
+        sd.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+        sd.Texture2D.MostDetailedMip = 0;
+        sd.Texture2D.MipLevels = 1;
+    }
+    if (FAILED(device->CreateShaderResourceView(readable, &sd, &p.srv)))
+    {
+        LOG_ERROR(SwapChain, "CreateShaderResourceView(depth resolve) failed!");
+        p.srv = nullptr;
+        releaseResolveSource();
+        return false;
+    }
+
+    p.source = src;
+    LOG_INFO(SwapChain, "Depth resolve source: {} ({}x{} format {} samples {}{})", src, d.Width, d.Height, d.Format,
+             d.SampleDesc.Count, (p.copy ? ", via copy" : ""));
+    return true;
+}
+
+inline bool ensureResolveTarget(ID3D11Device *device, ID3D11Texture2D *dst)
+{
+    DepthResolvePass &p = g_DepthResolvePass;
+    if (p.target == dst && p.uav)
+        return true;
+    if (p.uav)
+        p.uav->Release();
+    p.uav = nullptr;
+    p.target = nullptr;
+
+    D3D11_UNORDERED_ACCESS_VIEW_DESC ud = {};
+    ud.Format = DXGI_FORMAT_R32_FLOAT;
+    ud.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE2D;
+    if (FAILED(device->CreateUnorderedAccessView(dst, &ud, &p.uav)))
+    {
+        p.uav = nullptr;
+        return false;
+    }
+    p.target = dst;
+    return true;
+}
+
+// resolve src (msaa depth) or convert it (single-sample depth) into dst (R32F, SRV | UAV),
+// D3D11Api::resolveDepth
+inline bool dispatchDepthResolve(ID3D11Device *device, ID3D11DeviceContext *ctx, ID3D11Texture2D *src,
+                                 ID3D11Texture2D *dst, DepthResolveMode mode)
+{
+    if (!device || !ctx || !src || !dst)
+        return false;
+    D3D11_TEXTURE2D_DESC d{};
+    src->GetDesc(&d);
+    bool singleSample = d.SampleDesc.Count <= 1;
+    if (!ensureResolveShader(device, singleSample) || !ensureResolveSource(device, src) ||
+        !ensureResolveTarget(device, dst))
+        return false;
+
+    DepthResolvePass &p = g_DepthResolvePass;
+
+    ResolveParams params = {UINT(mode), d.SampleDesc.Count, {0, 0}};
+    if (params.MODE != p.current.MODE || params.SAMPLES != p.current.SAMPLES)
+    {
+        ctx->UpdateSubresource(p.params, 0, nullptr, &params, 0, 0);
+        p.current = params;
+    }
+
+    if (p.copy)
+        ctx->CopyResource(p.copy, src);
+
+    // save the game's compute bindings
+    ID3D11ComputeShader *oldCS = nullptr;
+    ID3D11ShaderResourceView *oldSRV = nullptr;
+    ID3D11UnorderedAccessView *oldUAV = nullptr;
+    ID3D11Buffer *oldCB = nullptr;
+    ctx->CSGetShader(&oldCS, nullptr, nullptr);
+    ctx->CSGetShaderResources(0, 1, &oldSRV);
+    ctx->CSGetUnorderedAccessViews(0, 1, &oldUAV);
+    ctx->CSGetConstantBuffers(0, 1, &oldCB);
+
+    ctx->CSSetShader(p.cs[singleSample], nullptr, 0);
+    ctx->CSSetShaderResources(0, 1, &p.srv);
+    ctx->CSSetUnorderedAccessViews(0, 1, &p.uav, nullptr);
+    ctx->CSSetConstantBuffers(0, 1, &p.params);
+    ctx->Dispatch((d.Width + 7) / 8, (d.Height + 7) / 8, 1);
+
+    // restore (this also unbinds our views)
+    ctx->CSSetShader(oldCS, nullptr, 0);
+    ctx->CSSetShaderResources(0, 1, &oldSRV);
+    ctx->CSSetUnorderedAccessViews(0, 1, &oldUAV, nullptr);
+    ctx->CSSetConstantBuffers(0, 1, &oldCB);
+    if (!p.copy && g_Resources.alive(src))
+        releaseResolveSource();
+    if (oldCS)
+        oldCS->Release();
+    if (oldSRV)
+        oldSRV->Release();
+    if (oldUAV)
+        oldUAV->Release();
+    if (oldCB)
+        oldCB->Release();
+    return true;
+}
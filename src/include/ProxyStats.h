@@ -0,0 +1,356 @@
+#pragma once
+
+// c++ includes
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+
+// windows headers
+#define NOMINMAX // disable min/max macros
+#include <Windows.h>
+
+// directx 11 headers
+#include <d3d11.h>
+#include <dxgi.h> // frame statistics
+
+// page layout + writer, trace phases, the contexts' streams
+#include "StatsPage.h"
+#include "ProxyTrace.h"
+#include "ProxyPipeline.h"
+
+// structured log (g_Log, the LOG_ macros)
+#include "LayerLog.h"
+
+// the live statistics (published to "Local\dxpipe_stats" once mapped)
+extern StatsWriter g_Stats;
+
+// API calls per method, every thread (ProxyDeviceContext counts)
+extern ApiCensus g_Census;
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// live statistics glue
+//  • the page is mapped on the primary's first Present (release builds too), a second
+//    game with the layer leaves the existing page alone
+//  • PresentStages times every Present stage once for the trace, the CPU cost and (on
+//    the primary) the GPU cost
+//  • GPU cost comes from timestamp queries read back GpuStageTimer::LATENCY frames
+//    later without flushing, a frame whose queries aren't ready is skipped
+//  • frame statistics are sampled after every real Present of the primary
+//    (DisplayTiming.h), a swap chain without them (windowed blt model) just never
+//    resolves a frame
+//  • hitches are checked against the frame times right after the primary's frame is
+//    published (HitchDetector.h)
+///////////////////////////////////////////////////////////////////////////////////////////
+
+inline void openStatsPage()
+{
+    static bool s_tried = false;
+    if (s_tried)
+        return;
+    s_tried = true;
+
+    char name[64];
+    snprintf(name, sizeof(name), "Local\\%s", STATS_NAME);
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, DWORD(sizeof(StatsPage)), name);
+    if (!mapping)
+        return;
+    if (GetLastError() == ERROR_ALREADY_EXISTS)
+    {
+        LOG_INFO(Ipc, "Stats page already published by another process");
+        CloseHandle(mapping);
+        return;
+    }
+
+    // the view keeps the mapping alive (and readers can open it) for the process lifetime
+    void *view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(StatsPage));
+    if (!view)
+    {
+        CloseHandle(mapping);
+        return;
+    }
+    g_Stats.attach(static_cast<StatsPage *>(view), uint32_t(GetCurrentProcessId()));
+    LOG_INFO(Ipc, "Stats page: {}", name);
+}
+
+// stages with GPU work of the layer's own (the rest are CPU only)
+inline bool gpuStage(TracePhase stage)
+{
+    return stage == TracePhase::Resolve || stage == TracePhase::Staging || stage == TracePhase::Shared ||
+           stage == TracePhase::Motion || stage == TracePhase::Overlay;
+}
+
+class GpuStageTimer
+{
+public:
+    static const uint32_t LATENCY = 4; // frames between issuing and reading the queries
+
+    // start of the primary's GPU work, collects the frame LATENCY Presents ago first
+    bool beginFrame(ID3D11Device *device, ID3D11DeviceContext *ctx)
+    {
+        if (device != m_device)
+        {
+            release();
+            m_device = device;
+            m_failed = false;
+        }
+        if (!device || !ctx || m_failed)
+            return false;
+
+        Slot &s = m_slots[m_frame % LATENCY];
+        if (s.pending)
+            collect(ctx, s);
+        if (!s.disjoint && !create(device, s))
+        {
+            LOG_ERROR(Ipc, "GPU stage timer: CreateQuery failed, GPU stage costs disabled");
+            release();
+            m_failed = true;
+            return false;
+        }
+
+        memset(s.used, 0, sizeof(s.used));
+        ctx->Begin(s.disjoint);
+        m_active = &s;
+        return true;
+    }
+
+    void begin(ID3D11DeviceContext *ctx, TracePhase stage)
+    {
+        if (m_active && gpuStage(stage))
+            ctx->End(m_active->begin[uint32_t(stage)]);
+    }
+
+    void end(ID3D11DeviceContext *ctx, TracePhase stage)
+    {
+        if (m_active && gpuStage(stage))
+        {
+            ctx->End(m_active->end[uint32_t(stage)]);
+            m_active->used[uint32_t(stage)] = true;
+        }
+    }
+
+    void endFrame(ID3D11DeviceContext *ctx)
+    {
+        if (!m_active)
+            return;
+        ctx->End(m_active->disjoint);
+        m_active->pending = true;
+        m_active = nullptr;
+        m_frame++;
+    }
+
+    void release()
+    {
+        auto drop = [](ID3D11Query *&q)
+        {
+            if (q)
+                q->Release();
+            q = nullptr;
+        };
+        for (Slot &s : m_slots)
+        {
+            drop(s.disjoint);
+            for (uint32_t i = 0; i < STATS_STAGES; i++)
+            {
+                drop(s.begin[i]);
+                drop(s.end[i]);
+            }
+            s.pending = false;
+        }
+        m_active = nullptr;
+        m_device = nullptr;
+    }
+
+private:
+    struct Slot
+    {
+        ID3D11Query *disjoint = nullptr;
+        ID3D11Query *begin[STATS_STAGES] = {};
+        ID3D11Query *end[STATS_STAGES] = {};
+        bool used[STATS_STAGES] = {};
+        bool pending = false;
+    };
+
+    bool create(ID3D11Device *device, Slot &s)
+    {
+        D3D11_QUERY_DESC qd = {D3D11_QUERY_TIMESTAMP_DISJOINT, 0};
+        if (FAILED(device->CreateQuery(&qd, &s.disjoint)))
+            return false;
+        qd.Query = D3D11_QUERY_TIMESTAMP;
+        for (uint32_t i = 0; i < STATS_STAGES; i++)
+        {
+            if (!gpuStage(TracePhase(i)))
+                continue;
+            if (FAILED(device->CreateQuery(&qd, &s.begin[i])) || FAILED(device->CreateQuery(&qd, &s.end[i])))
+                return false;
+        }
+        return true;
+    }
+
+    // never waits: queries that aren't done by now are dropped with their frame
+    void collect(ID3D11DeviceContext *ctx, Slot &s)
+    {
+        s.pending = false;
+        D3D11_QUERY_DATA_TIMESTAMP_DISJOINT dj = {};
+        if (ctx->GetData(s.disjoint, &dj, sizeof(dj), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK || dj.Disjoint ||
+            !dj.Frequency)
+            return;
+
+        uint64_t ns[STATS_STAGES] = {};
+        for (uint32_t i = 0; i < STATS_STAGES; i++)
+        {
+            UINT64 a = 0, b = 0;
+            if (!s.used[i] ||
+                ctx->GetData(s.begin[i], &a, sizeof(a), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK ||
+                ctx->GetData(s.end[i], &b, sizeof(b), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK || b < a)
+                continue;
+            ns[i] = uint64_t(double(b - a) * 1e9 / double(dj.Frequency));
+        }
+        g_Stats.setGpu(ns);
+    }
+
+    Slot m_slots[LATENCY];
+    Slot *m_active = nullptr;
+    ID3D11Device *m_device = nullptr;
+    uint64_t m_frame = 0;
+    bool m_failed = false;
+};
+
+// primary device only (the queries belong to g_Device)
+static GpuStageTimer g_GpuStages;
+
+// the stages of one Present call (they never nest)
+struct PresentStages
+{
+    explicit PresentStages(uint32_t context)
+        : context(context), presentStart(std::chrono::steady_clock::now()) {}
+
+    void begin(TracePhase stage)
+    {
+        traceBegin(stage, context);
+        if (gpu)
+            g_GpuStages.begin(gpu, stage);
+        start = std::chrono::steady_clock::now();
+    }
+
+    void end(TracePhase stage)
+    {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        g_Stats.addStage(stage, uint64_t(ns.count()));
+        if (gpu)
+            g_GpuStages.end(gpu, stage);
+        traceEnd(stage, context);
+    }
+
+    // GPU timestamps from here on (primary, once its context is known)
+    void timeGpu(ID3D11Device *device, ID3D11DeviceContext *ctx)
+    {
+        if (g_GpuStages.beginFrame(device, ctx))
+            gpu = ctx;
+    }
+
+    // before the context is released
+    void endGpu()
+    {
+        if (gpu)
+            g_GpuStages.endFrame(gpu);
+        gpu = nullptr;
+    }
+
+    uint64_t presentNs() const
+    {
+        return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(presentStart.time_since_epoch()).count());
+    }
+
+    uint32_t context;
+    ID3D11DeviceContext *gpu = nullptr;
+    std::chrono::steady_clock::time_point presentStart;
+    std::chrono::steady_clock::time_point start;
+};
+
+// shared textures + found clients of every context (once per primary frame)
+inline void publishStreams()
+{
+    uint32_t streams = 0, consumers = 0;
+    {
+        std::lock_guard<std::mutex> lock(g_PipelineLock);
+        for (const PipelineContext *pc : g_Pipelines)
+        {
+            uint32_t s = pc->statsStreams.load(std::memory_order_relaxed);
+            streams += s & 0xFF;
+            consumers += s >> 8;
+        }
+    }
+    g_Stats.setStreams(streams, consumers);
+}
+
+// the game's API calls since the last primary Present (into the trace too, the flight
+// recorder's snapshots carry them)
+inline void publishCensus(uint64_t traceFrame)
+{
+    CensusFrame frame;
+    g_Census.snapshot(frame);
+    g_Stats.setCensus(frame);
+    for (uint32_t c = 0; c < CENSUS_CALLS; c++)
+        if (frame.calls[c])
+            g_Trace.log(TraceEvent::Census, c, frame.calls[c], traceFrame);
+}
+
+// after the primary's frame was published: a frame over the hitch limit snapshots the
+// flight recorder (the trace writer writes it)
+inline void checkHitch(uint64_t frame, uint64_t nowNs)
+{
+    const FrameHistogram &times = g_Stats.frameTimes();
+    if (!g_Trace.flightSeconds() || !times.frames())
+        return;
+    uint32_t frameUs = times.lastUs();
+    uint32_t limitUs = g_Hitches.check(frameUs, times.last(FrameWindow::TenSeconds), nowNs);
+    if (limitUs && snapshotHitch(frame, frameUs, limitUs))
+        g_Hitches.taken(frame, nowNs);
+}
+
+// a QPC time as steady clock ns (steady_clock is QueryPerformanceCounter on windows)
+inline uint64_t qpcNs(int64_t qpc)
+{
+    static const int64_t frequency = []
+    {
+        LARGE_INTEGER f{};
+        QueryPerformanceFrequency(&f);
+        return f.QuadPart ? f.QuadPart : 1;
+    }();
+    return uint64_t(qpc / frequency) * 1000000000ull + uint64_t(qpc % frequency) * 1000000000ull / uint64_t(frequency);
+}
+
+// the primary's real Present of frame at presentNs returned: what reached the screen since,
+// then this Present's count
+inline void sampleDisplay(IDXGISwapChain *swapChain, uint64_t frame, uint64_t presentNs, UINT syncInterval)
+{
+    static HRESULT s_lastHr = S_OK; // logged on change only
+    DisplayTracker &display = g_Stats.display();
+
+    DXGI_FRAME_STATISTICS fs{};
+    HRESULT hr = swapChain->GetFrameStatistics(&fs);
+    if (SUCCEEDED(hr))
+    {
+        uint64_t nowNs = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                      std::chrono::steady_clock::now().time_since_epoch())
+                                      .count());
+        display.sample({fs.PresentCount, fs.PresentRefreshCount, fs.SyncRefreshCount, qpcNs(fs.SyncQPCTime.QuadPart)},
+                       nowNs);
+    }
+    else if (hr == DXGI_ERROR_FRAME_STATISTICS_DISJOINT)
+        display.reset();
+    if (hr != s_lastHr && hr != DXGI_ERROR_FRAME_STATISTICS_DISJOINT)
+    {
+        if (FAILED(hr))
+            LOG_INFO(SwapChain, "GetFrameStatistics unavailable (0x{:08x}), no present to display times",
+                     uint32_t(hr));
+        else
+            LOG_INFO(SwapChain, "GetFrameStatistics available, tracking present to display");
+        s_lastHr = hr;
+    }
+
+    UINT count = 0;
+    if (SUCCEEDED(swapChain->GetLastPresentCount(&count)))
+        display.presented(frame, presentNs, count, syncInterval, g_Stats.input().lastUs());
+}
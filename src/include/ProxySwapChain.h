@@ -3,7 +3,11 @@
 // enable/disable ImGui
 #define ENABLE_IMGUI 0
 
+// enable/disable the allocation audit (replaces operator new, reports allocations made in Present)
+#define ENABLE_ALLOC_AUDIT 0
+
 // c++ includes
+#include <cstdio>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
@@ -24,6 +28,36 @@
 #include <d3dcompiler.h> // shader compilation
 #pragma comment(lib, "d3dcompiler.lib")
 
+// layer event stream
+#include "LayerEvents.h"
+
+// staging / shared copies of the exported buffers
+#include "FrameExport.h"
+
+// allocation audit (ENABLE_ALLOC_AUDIT)
+#include "AllocAudit.h"
+
+// depth buffer detection (promotion) + msaa depth resolve + camera motion + per game profiles
+#include "ProxyDepth.h"
+#include "ProxyResolve.h"
+#include "ProxyMotion.h"
+#include "ProxyProfile.h"
+
+// API call capture (ENABLE_CAPTURE)
+#include "ProxyCapture.h"
+
+// binary trace of the hot paths + Present phases (DEBUG builds or once switched on)
+#include "ProxyTrace.h"
+
+// per swap chain resources + client streams
+#include "ProxyPipeline.h"
+
+// live statistics page (stage costs, frame times, streams)
+#include "ProxyStats.h"
+
+// pass graph of the sampled frames (per pass GPU times)
+#include "ProxyPasses.h"
+
 #if ENABLE_IMGUI
 // core imgui headers
 #include "imgui.h"
@@ -39,173 +73,115 @@ extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(
 #include "imstyle.h"
 #endif
 
-// helper decls (implemented in d3d11.cpp)
-extern std::string timeStamp();
-extern void output();
-extern int g_Width;                          // target width
-extern int g_Height;                         // target height
-extern ID3D11Texture2D *g_BackBufferTexture; // colour RT  (GetBuffer-0)
-extern ID3D11Texture2D *g_DepthTexture;      // live depth RT  (exported)
-extern ID3D11Device *g_Device;               // the real device
-
-extern ID3D11Texture2D *g_BackBufferStaging; // CPU-readable copy (colour)
-extern ID3D11Texture2D *g_DepthStaging;      // CPU-readable copy (depth)
-
-// shared back buffer texture
-extern ID3D11Texture2D *g_BackBufferShared;
-extern HANDLE g_BackBufferSharedHandle;
+// structured log (g_Log, the LOG_ macros) + its file
+#include "ProxyLog.h"
 
-// shared depth buffer texture
-extern ID3D11Texture2D *g_DepthShared;
-extern HANDLE g_DepthSharedHandle;
+// helper decls (implemented in d3d11.cpp)
+extern int g_Width;                                   // target width (primary context)
+extern int g_Height;                                  // target height (primary context)
+extern std::atomic<ID3D11Texture2D *> g_DepthTexture; // live depth RT  (exported, weak)
+extern ID3D11Device *g_Device;                        // the real device
+extern FrameTimeline g_FrameTimeline;                 // events of the current frame
 
 ///////////////////////////////////////////////////////////////////////////////////////////
-// helper function to create the shared texture for the back buffer and depth buffer
+// FrameExport.h backend for the real device (SoftApi is the software reference)
 ///////////////////////////////////////////////////////////////////////////////////////////
 
-inline void createSharedBackBuffer(ID3D11Device *device, int w, int h)
+struct D3D11Api
 {
-    // create a shared texture for the back buffer
-    D3D11_TEXTURE2D_DESC desc = {};
-    desc.Width = w;
-    desc.Height = h;
-    desc.MipLevels = 1;
-    desc.ArraySize = 1;
-    desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;    // standard back buffer format
-    desc.SampleDesc.Count = 1;                   // no MSAA
-    desc.SampleDesc.Quality = 0;                 // no MSAA quality
-    desc.Usage = D3D11_USAGE_DEFAULT;            // GPU usage
-    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE; // minimal bind flags for sharing
-    desc.MiscFlags = D3D11_RESOURCE_MISC_SHARED; // basic sharing without keyed mutex
-
-    HRESULT hr = device->CreateTexture2D(&desc, nullptr, &g_BackBufferShared);
-    if (FAILED(hr))
+    using Device = ID3D11Device;
+    using Context = ID3D11DeviceContext;
+    using Texture = ID3D11Texture2D;
+    using Desc = D3D11_TEXTURE2D_DESC;
+    using Format = DXGI_FORMAT;
+    using Handle = HANDLE;
+
+    static constexpr D3D11_USAGE UsageDefault = D3D11_USAGE_DEFAULT;
+    static constexpr D3D11_USAGE UsageStaging = D3D11_USAGE_STAGING;
+    static constexpr UINT BindShaderResource = D3D11_BIND_SHADER_RESOURCE;
+    static constexpr UINT BindUnorderedAccess = D3D11_BIND_UNORDERED_ACCESS;
+    static constexpr UINT CpuAccessRead = D3D11_CPU_ACCESS_READ;
+    static constexpr UINT MiscShared = D3D11_RESOURCE_MISC_SHARED;
+    static constexpr DXGI_FORMAT FormatR32Float = DXGI_FORMAT_R32_FLOAT;
+    static constexpr DXGI_FORMAT FormatR16G16Float = DXGI_FORMAT_R16G16_FLOAT;
+    static constexpr HANDLE NullHandle = nullptr;
+
+    static bool ok(HRESULT hr) { return SUCCEEDED(hr); }
+
+    static void release(ID3D11Texture2D *&tex)
     {
-#if DEBUG
-        std::cout << timeStamp() << "Failed to create shared back buffer texture! HRESULT: " << std::hex << hr << std::dec << std::endl;
-#endif
-        return;
+        if (tex)
+            tex->Release();
+        tex = nullptr;
     }
 
-    // get the shared handle
-    IDXGIResource *resource = nullptr;
-    hr = g_BackBufferShared->QueryInterface(__uuidof(IDXGIResource), (void **)&resource);
-    if (SUCCEEDED(hr))
+    static bool sharedHandle(ID3D11Texture2D *tex, HANDLE &handle)
     {
-        hr = resource->GetSharedHandle(&g_BackBufferSharedHandle);
-        resource->Release();
+        IDXGIResource *resource = nullptr;
+        HRESULT hr = tex->QueryInterface(__uuidof(IDXGIResource), (void **)&resource);
+        if (FAILED(hr))
+        {
+            LOG_ERROR(Ipc, "Failed to query IDXGIResource for shared texture! HRESULT: {:x}", hr);
+            return false;
+        }
 
+        hr = resource->GetSharedHandle(&handle);
+        resource->Release();
         if (FAILED(hr))
         {
-#if DEBUG
-            std::cout << timeStamp() << "Failed to get shared handle for back buffer texture! HRESULT: " << std::hex << hr << std::dec << std::endl;
-#endif
-            return;
+            LOG_ERROR(Ipc, "Failed to get shared handle for texture! HRESULT: {:x}", hr);
+            return false;
         }
+        return true;
     }
-    else
+
+    static bool resolveDepth(ID3D11Device *device, ID3D11DeviceContext *ctx, ID3D11Texture2D *src,
+                             ID3D11Texture2D *dst, DepthResolveMode mode)
     {
-#if DEBUG
-        std::cout << timeStamp() << "Failed to query IDXGIResource for back buffer texture! HRESULT: " << std::hex << hr << std::dec << std::endl;
-#endif
-        return;
+        return dispatchDepthResolve(device, ctx, src, dst, mode);
     }
 
-// print the shared handle address
-#if DEBUG
-    std::cout << timeStamp() << "Shared back buffer texture created! Handle: " << g_BackBufferSharedHandle << std::endl;
-#endif
-#if DEBUG
-    std::cout << timeStamp() << "Shared back buffer texture address: " << g_BackBufferShared << std::endl;
-#endif
-#if DEBUG
-    std::cout << timeStamp() << "Shared back buffer texture size: " << w << "x" << h << std::endl;
-#endif
-#if DEBUG
-    std::cout << timeStamp() << "Shared back buffer texture format: " << desc.Format << std::endl;
-#endif
-}
-
-inline void createSharedDepthBuffer(ID3D11Device *device, int w, int h)
-{
-    // create a shared texture for the depth buffer
-    D3D11_TEXTURE2D_DESC desc = {};
-    desc.Width = w;
-    desc.Height = h;
-    desc.MipLevels = 1;
-    desc.ArraySize = 1;
-    desc.Format = DXGI_FORMAT_R32_TYPELESS;      // depth format
-    desc.SampleDesc.Count = 1;                   // no MSAA
-    desc.SampleDesc.Quality = 0;                 // no MSAA quality
-    desc.Usage = D3D11_USAGE_DEFAULT;            // GPU usage
-    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE; // minimal bind flags for sharing
-    desc.MiscFlags = D3D11_RESOURCE_MISC_SHARED; // basic sharing without keyed mutex
-
-    HRESULT hr = device->CreateTexture2D(&desc, nullptr, &g_DepthShared);
-    if (FAILED(hr))
+    static bool motionVectors(ID3D11Device *device, ID3D11DeviceContext *ctx, ID3D11Texture2D *depth,
+                              ID3D11Texture2D *dst, const MotionParams &params)
     {
-#if DEBUG
-        std::cout << timeStamp() << "Failed to create shared depth buffer texture! HRESULT: " << std::hex << hr << std::dec << std::endl;
-#endif
-        return;
+        return dispatchCameraMotion(device, ctx, depth, dst, params);
     }
+};
 
-    // get the shared handle
-    IDXGIResource *resource = nullptr;
-    hr = g_DepthShared->QueryInterface(__uuidof(IDXGIResource), (void **)&resource);
-    if (SUCCEEDED(hr))
-    {
-        hr = resource->GetSharedHandle(&g_DepthSharedHandle);
-        resource->Release();
+// only single-sample R32 depth can be copied into the export targets as it is, msaa and
+// D24S8 / D16 / D32S8 depth go through exportResolvedDepth first
+inline bool needsDepthResolve(ID3D11Texture2D *tex)
+{
+    D3D11_TEXTURE2D_DESC d{};
+    tex->GetDesc(&d);
+    return d.SampleDesc.Count > 1 || depthTypelessFormat(uint32_t(d.Format)) != FMT_R32_TYPELESS;
+}
 
-        if (FAILED(hr))
-        {
-#if DEBUG
-            std::cout << timeStamp() << "Failed to get shared handle for depth buffer texture! HRESULT: " << std::hex << hr << std::dec << std::endl;
-#endif
-            return;
-        }
+// log what the export did to a shared texture (only recreation / failure is interesting)
+inline void logSharedExport(const char *name, ExportResult result, ID3D11Texture2D *tex, HANDLE handle)
+{
+    if (result == ExportResult::Failed)
+    {
+        LOG_ERROR(Ipc, "Failed to create shared {} texture!", name);
     }
-    else
+    else if (result == ExportResult::Recreated && LOG_ENABLED(Info, Ipc))
     {
-#if DEBUG
-        std::cout << timeStamp() << "Failed to query IDXGIResource for depth buffer texture! HRESULT: " << std::hex << hr << std::dec << std::endl;
-#endif
-        return;
+        D3D11_TEXTURE2D_DESC desc{};
+        tex->GetDesc(&desc);
+        LOG_INFO(Ipc, "Shared {} texture created! Handle: {} address: {} size: {}x{} format: {}", name, handle, tex,
+                 desc.Width, desc.Height, desc.Format);
     }
-
-// print the shared handle address
-#if DEBUG
-    std::cout << timeStamp() << "Shared depth buffer texture created! Handle: " << g_DepthSharedHandle << std::endl;
-#endif
-#if DEBUG
-    std::cout << timeStamp() << "Shared depth buffer texture address: " << g_DepthShared << std::endl;
-#endif
-#if DEBUG
-    std::cout << timeStamp() << "Shared depth buffer texture size: " << w << "x" << h << std::endl;
-#endif
-#if DEBUG
-    std::cout << timeStamp() << "Shared depth buffer texture format: " << desc.Format << std::endl;
-#endif
 }
 
-// Structure to send texture information with dimensions
-struct TextureInfo
-{
-    HANDLE handle;
-    UINT width;
-    UINT height;
-    DXGI_FORMAT format;
-};
-
-inline HANDLE createNamedPipe(const std::string &pipeName, bool isInbound = false, DWORD bufferSize = 32)
+inline HANDLE createNamedPipe(const char *pipeName, bool isInbound = false, DWORD bufferSize = 32)
 {
     // create the full pipe name with proper prefix
-    std::string fullPipeName = "\\\\.\\pipe\\" + pipeName;
+    char fullPipeName[256];
+    snprintf(fullPipeName, sizeof(fullPipeName), "\\\\.\\pipe\\%s", pipeName);
 
     // create a named pipe with proper settings for immediate use
     HANDLE hPipe = CreateNamedPipeA(
-        fullPipeName.c_str(),
+        fullPipeName,
         isInbound ? PIPE_ACCESS_INBOUND : PIPE_ACCESS_OUTBOUND, // inbound for confirmation, outbound for data
         PIPE_TYPE_BYTE | PIPE_NOWAIT,                           // non-blocking byte mode
         1,                                                      // max instances
@@ -216,142 +192,223 @@ inline HANDLE createNamedPipe(const std::string &pipeName, bool isInbound = fals
 
     if (hPipe == INVALID_HANDLE_VALUE)
     {
-#if DEBUG
-        std::cout << timeStamp() << "Failed to create named pipe: " << GetLastError() << std::endl;
-#endif
+        LOG_ERROR(Ipc, "Failed to create named pipe: {}", GetLastError());
         return INVALID_HANDLE_VALUE;
     }
 
-// print the pipe name
-#if DEBUG
-    std::cout << timeStamp() << "Named pipe created: " << fullPipeName << " (direction: " << (isInbound ? "inbound" : "outbound") << ")" << std::endl;
-#endif
+    LOG_INFO(Ipc, "Named pipe created: {} (direction: {})", fullPipeName, (isInbound ? "inbound" : "outbound"));
 
     return hPipe;
 }
 
-inline int duplicateHandleToClientProcess()
+// stream tag of the context, the pipe names are "<stream>" (primary) or "<stream>_<id>"
+inline HANDLE createPipelinePipe(const PipelineContext &pc, const char *stream, bool isInbound, DWORD bufferSize)
+{
+    char name[128];
+    pipelinePipeName(pc, stream, name, sizeof(name));
+    return createNamedPipe(name, isInbound, bufferSize);
+}
+
+// the camera goes out every frame it was written (and whenever it is found / lost), the
+// client matches it to the exported depth by frame id, no confirmation needed
+inline void sendCameraMatrices(PipelineTransport &t)
 {
-    // static variables to maintain state between calls
-    static DWORD lastFoundPID = 0;
-    static HANDLE backBufferPipe = INVALID_HANDLE_VALUE;
-    static HANDLE depthBufferPipe = INVALID_HANDLE_VALUE;
-    static HANDLE confirmationPipe = INVALID_HANDLE_VALUE;
-    static DWORD searchCooldown = 0; // wait a few frames between searches to avoid high CPU usage
-    static TextureInfo lastSentBackInfo = {nullptr, 0, 0, DXGI_FORMAT_UNKNOWN};
-    static TextureInfo lastSentDepthInfo = {nullptr, 0, 0, DXGI_FORMAT_UNKNOWN};
-    static DWORD lastSendTime = 0;
+    if (t.cameraPipe == INVALID_HANDLE_VALUE || g_CameraMatrices.frame == t.lastSentCameraFrame)
+        return;
+    if (!(g_CameraMatrices.flags & CAM_UPDATED) && g_CameraMatrices.flags == t.lastSentCameraFlags)
+        return;
+
+    DWORD bytesWritten = 0;
+    if (WriteFile(t.cameraPipe, &g_CameraMatrices, sizeof(g_CameraMatrices), &bytesWritten, nullptr) &&
+        bytesWritten == sizeof(g_CameraMatrices))
+    {
+        g_Trace.log(TraceEvent::PipeWrite, uint32_t(TracePipe::Camera), bytesWritten);
+        if ((g_CameraMatrices.flags ^ t.lastSentCameraFlags) & CAM_VALID)
+            LOG_INFO(Ipc, "Sent camera matrices: frame={} flags=0x{:x}", g_CameraMatrices.frame,
+                     g_CameraMatrices.flags);
+        t.lastSentCameraFrame = g_CameraMatrices.frame;
+        t.lastSentCameraFlags = g_CameraMatrices.flags & ~uint32_t(CAM_UPDATED);
+    }
+}
+
+// the primary's frames go out as they are resolved (a frame or two after their Present), a
+// client that doesn't keep up loses the oldest ones
+inline void sendFrameDisplay(PipelineTransport &t)
+{
+    const DisplayTracker &display = g_Stats.display();
+    if (t.displayPipe == INVALID_HANDLE_VALUE)
+        return;
+    uint64_t end = display.resolved();
+    if (end - t.lastSentDisplay > DISPLAY_RECORDS)
+        t.lastSentDisplay = end - DISPLAY_RECORDS;
+
+    while (t.lastSentDisplay < end)
+    {
+        const FrameDisplay &d = display.record(t.lastSentDisplay);
+        DWORD bytesWritten = 0;
+        if (!WriteFile(t.displayPipe, &d, sizeof(d), &bytesWritten, nullptr) || bytesWritten != sizeof(d))
+            return; // no client / pipe full, next frame
+        g_Trace.log(TraceEvent::PipeWrite, uint32_t(TracePipe::Display), bytesWritten);
+        t.lastSentDisplay++;
+    }
+}
+
+// state between calls lives in the context's transport (one set of pipes per swap chain)
+inline int duplicateHandleToClientProcess(PipelineContext &pc)
+{
+#if ENABLE_ALLOC_AUDIT
+    AllocScope allocScope("transport");
+#endif
+
+    PipelineTransport &t = pc.transport;
     static const DWORD CONFIRMATION_TIMEOUT_MS = 2000; // 2 second timeout for confirmation
-    static bool waitingForConfirmation = false;
 
-    if (searchCooldown > 0)
+    // per frame, not only between searches
+    sendCameraMatrices(t);
+    sendFrameDisplay(t);
+
+    if (t.searchCooldown > 0)
     {
-        searchCooldown--;
+        t.searchCooldown--;
 
         // check for confirmation from client
-        if (confirmationPipe != INVALID_HANDLE_VALUE && waitingForConfirmation)
+        if (t.confirmationPipe != INVALID_HANDLE_VALUE && t.waitingForConfirmation)
         {
             DWORD available = 0;
-            if (PeekNamedPipe(confirmationPipe, nullptr, 0, nullptr, &available, nullptr) && available >= 1)
+            if (PeekNamedPipe(t.confirmationPipe, nullptr, 0, nullptr, &available, nullptr) && available >= 1)
             {
                 BYTE confirmation = 0;
                 DWORD bytesRead = 0;
-                if (ReadFile(confirmationPipe, &confirmation, 1, &bytesRead, nullptr) && bytesRead == 1)
+                if (ReadFile(t.confirmationPipe, &confirmation, 1, &bytesRead, nullptr) && bytesRead == 1)
                 {
-#if DEBUG
-                    std::cout << timeStamp() << "Received texture creation confirmation from client!" << std::endl;
-#endif
-                    waitingForConfirmation = false;
-                    lastSendTime = 0; // reset timeout
+                    LOG_INFO(Ipc, "Received texture creation confirmation from client!");
+                    t.waitingForConfirmation = false;
+                    t.lastSendTime = 0; // reset timeout
                 }
             }
         } // check if we need to resend due to timeout
-        if (waitingForConfirmation && GetTickCount() - lastSendTime > CONFIRMATION_TIMEOUT_MS)
+        if (t.waitingForConfirmation && GetTickCount() - t.lastSendTime > CONFIRMATION_TIMEOUT_MS)
         {
-#if DEBUG
-            std::cout << timeStamp() << "Confirmation timeout - will resend texture info" << std::endl;
-#endif
-            waitingForConfirmation = false;
+            LOG_INFO(Ipc, "Confirmation timeout - will resend texture info");
+            t.waitingForConfirmation = false;
             // force resend by invalidating last sent info
-            lastSentBackInfo.handle = nullptr;
-            lastSentDepthInfo.handle = nullptr;
+            t.lastSentBackInfo.handle = nullptr;
+            t.lastSentDepthInfo.handle = nullptr;
+            t.lastSentMotionInfo.handle = nullptr;
+            t.lastSentProjection.flags = UINT32_MAX;
             // reduce search cooldown for faster retry
-            searchCooldown = 5;
+            t.searchCooldown = 5;
         }
 
         // prepare current texture info
         TextureInfo currentBackInfo = {nullptr, 0, 0, DXGI_FORMAT_UNKNOWN};
         TextureInfo currentDepthInfo = {nullptr, 0, 0, DXGI_FORMAT_UNKNOWN};
+        TextureInfo currentMotionInfo = {nullptr, 0, 0, DXGI_FORMAT_UNKNOWN};
+
+        if (pc.backBufferSharedHandle && pc.backBufferShared)
+        {
+            D3D11_TEXTURE2D_DESC desc;
+            pc.backBufferShared->GetDesc(&desc);
+            currentBackInfo = {pc.backBufferSharedHandle, desc.Width, desc.Height, desc.Format};
+        }
 
-        if (g_BackBufferSharedHandle && g_BackBufferShared)
+        if (pc.depthSharedHandle && pc.depthShared)
         {
             D3D11_TEXTURE2D_DESC desc;
-            g_BackBufferShared->GetDesc(&desc);
-            currentBackInfo = {g_BackBufferSharedHandle, desc.Width, desc.Height, desc.Format};
+            pc.depthShared->GetDesc(&desc);
+            currentDepthInfo = {pc.depthSharedHandle, desc.Width, desc.Height, desc.Format};
         }
 
-        if (g_DepthSharedHandle && g_DepthShared)
+        if (pc.motionSharedHandle && pc.motionShared)
         {
             D3D11_TEXTURE2D_DESC desc;
-            g_DepthShared->GetDesc(&desc);
-            currentDepthInfo = {g_DepthSharedHandle, desc.Width, desc.Height, desc.Format};
+            pc.motionShared->GetDesc(&desc);
+            currentMotionInfo = {pc.motionSharedHandle, desc.Width, desc.Height, desc.Format};
         }
 
         // check if we need to send new info
         bool shouldSendBack = (currentBackInfo.handle &&
-                               (currentBackInfo.handle != lastSentBackInfo.handle ||
-                                currentBackInfo.width != lastSentBackInfo.width ||
-                                currentBackInfo.height != lastSentBackInfo.height ||
-                                currentBackInfo.format != lastSentBackInfo.format));
+                               (currentBackInfo.handle != t.lastSentBackInfo.handle ||
+                                currentBackInfo.width != t.lastSentBackInfo.width ||
+                                currentBackInfo.height != t.lastSentBackInfo.height ||
+                                currentBackInfo.format != t.lastSentBackInfo.format));
 
         bool shouldSendDepth = (currentDepthInfo.handle &&
-                                (currentDepthInfo.handle != lastSentDepthInfo.handle ||
-                                 currentDepthInfo.width != lastSentDepthInfo.width ||
-                                 currentDepthInfo.height != lastSentDepthInfo.height ||
-                                 currentDepthInfo.format != lastSentDepthInfo.format));
+                                (currentDepthInfo.handle != t.lastSentDepthInfo.handle ||
+                                 currentDepthInfo.width != t.lastSentDepthInfo.width ||
+                                 currentDepthInfo.height != t.lastSentDepthInfo.height ||
+                                 currentDepthInfo.format != t.lastSentDepthInfo.format));
+
+        bool shouldSendMotion = (currentMotionInfo.handle &&
+                                 (currentMotionInfo.handle != t.lastSentMotionInfo.handle ||
+                                  currentMotionInfo.width != t.lastSentMotionInfo.width ||
+                                  currentMotionInfo.height != t.lastSentMotionInfo.height));
+
+        // inferred depth parameters go out whenever they change, no confirmation needed
+        if (t.depthParamsPipe != INVALID_HANDLE_VALUE &&
+            (g_DepthProjection.flags != t.lastSentProjection.flags ||
+             g_DepthProjection.nearPlane != t.lastSentProjection.nearPlane ||
+             g_DepthProjection.farPlane != t.lastSentProjection.farPlane))
+        {
+            DWORD bytesWritten = 0;
+            if (WriteFile(t.depthParamsPipe, &g_DepthProjection, sizeof(g_DepthProjection), &bytesWritten, nullptr) &&
+                bytesWritten == sizeof(g_DepthProjection))
+            {
+                t.lastSentProjection = g_DepthProjection;
+                g_Trace.log(TraceEvent::PipeWrite, uint32_t(TracePipe::DepthParams), bytesWritten);
+                LOG_INFO(Ipc, "Sent depth params: near={} far={} flags=0x{:x}", g_DepthProjection.nearPlane,
+                         g_DepthProjection.farPlane, g_DepthProjection.flags);
+            }
+        }
 
-        if (shouldSendBack || shouldSendDepth)
+        if (shouldSendBack || shouldSendDepth || shouldSendMotion)
         {
             // send updated texture info
-            if (shouldSendBack && backBufferPipe != INVALID_HANDLE_VALUE)
+            if (shouldSendBack && t.backBufferPipe != INVALID_HANDLE_VALUE)
             {
                 DWORD bytesWritten = 0;
-                if (WriteFile(backBufferPipe, &currentBackInfo, sizeof(currentBackInfo), &bytesWritten, nullptr) &&
+                if (WriteFile(t.backBufferPipe, &currentBackInfo, sizeof(currentBackInfo), &bytesWritten, nullptr) &&
                     bytesWritten == sizeof(currentBackInfo))
                 {
-                    lastSentBackInfo = currentBackInfo;
-#if DEBUG
-                    std::cout << timeStamp() << "Sent back buffer info: handle=" << currentBackInfo.handle
-                              << " size=" << currentBackInfo.width << "x" << currentBackInfo.height
-                              << " format=" << currentBackInfo.format << std::endl;
-#endif
+                    t.lastSentBackInfo = currentBackInfo;
+                    g_Trace.log(TraceEvent::PipeWrite, uint32_t(TracePipe::BackBuffer), bytesWritten);
+                    LOG_INFO(Ipc, "Sent back buffer info: handle={} size={}x{} format={}", currentBackInfo.handle,
+                             currentBackInfo.width, currentBackInfo.height, currentBackInfo.format);
                 }
             }
 
-            if (shouldSendDepth && depthBufferPipe != INVALID_HANDLE_VALUE)
+            if (shouldSendDepth && t.depthBufferPipe != INVALID_HANDLE_VALUE)
             {
                 DWORD bytesWritten = 0;
-                if (WriteFile(depthBufferPipe, &currentDepthInfo, sizeof(currentDepthInfo), &bytesWritten, nullptr) &&
+                if (WriteFile(t.depthBufferPipe, &currentDepthInfo, sizeof(currentDepthInfo), &bytesWritten, nullptr) &&
                     bytesWritten == sizeof(currentDepthInfo))
                 {
-                    lastSentDepthInfo = currentDepthInfo;
-#if DEBUG
-                    std::cout << timeStamp() << "Sent depth buffer info: handle=" << currentDepthInfo.handle
-                              << " size=" << currentDepthInfo.width << "x" << currentDepthInfo.height
-                              << " format=" << currentDepthInfo.format << std::endl;
-#endif
+                    t.lastSentDepthInfo = currentDepthInfo;
+                    g_Trace.log(TraceEvent::PipeWrite, uint32_t(TracePipe::DepthBuffer), bytesWritten);
+                    LOG_INFO(Ipc, "Sent depth buffer info: handle={} size={}x{} format={}", currentDepthInfo.handle,
+                             currentDepthInfo.width, currentDepthInfo.height, currentDepthInfo.format);
+                }
+            }
+            if (shouldSendMotion && t.motionPipe != INVALID_HANDLE_VALUE)
+            {
+                DWORD bytesWritten = 0;
+                if (WriteFile(t.motionPipe, &currentMotionInfo, sizeof(currentMotionInfo), &bytesWritten, nullptr) &&
+                    bytesWritten == sizeof(currentMotionInfo))
+                {
+                    t.lastSentMotionInfo = currentMotionInfo;
+                    g_Trace.log(TraceEvent::PipeWrite, uint32_t(TracePipe::Motion), bytesWritten);
+                    LOG_INFO(Ipc, "Sent motion info: handle={} size={}x{}", currentMotionInfo.handle,
+                             currentMotionInfo.width, currentMotionInfo.height);
                 }
             }
             // start waiting for confirmation
-            if (shouldSendBack || shouldSendDepth)
+            if (shouldSendBack || shouldSendDepth || shouldSendMotion)
             {
-                waitingForConfirmation = true;
-                lastSendTime = GetTickCount();
-#if DEBUG
-                std::cout << timeStamp() << "Waiting for client confirmation..." << std::endl;
-#endif
+                t.waitingForConfirmation = true;
+                t.lastSendTime = GetTickCount();
+                LOG_INFO(Ipc, "Waiting for client confirmation...");
                 // reduce cooldown for faster response
-                searchCooldown = 5;
+                t.searchCooldown = 5;
             }
         }
         else
@@ -361,27 +418,47 @@ inline int duplicateHandleToClientProcess()
     }
 
     // reset cooldown (check every ~30 calls)
-    if (searchCooldown == 0)
-        searchCooldown = 30;
+    if (t.searchCooldown == 0)
+        t.searchCooldown = 30;
 
     // create pipes if they don't exist yet
-    if (backBufferPipe == INVALID_HANDLE_VALUE && g_BackBufferSharedHandle)
+    if (t.backBufferPipe == INVALID_HANDLE_VALUE && pc.backBufferSharedHandle)
+    {
+        t.backBufferPipe = createPipelinePipe(pc, "dxpipe_backbuffer", false, sizeof(TextureInfo));
+    }
+
+    if (t.depthBufferPipe == INVALID_HANDLE_VALUE && pc.depthSharedHandle)
+    {
+        t.depthBufferPipe = createPipelinePipe(pc, "dxpipe_depthbuffer", false, sizeof(TextureInfo));
+    }
+
+    if (t.depthParamsPipe == INVALID_HANDLE_VALUE && pc.depthSharedHandle)
+    {
+        t.depthParamsPipe = createPipelinePipe(pc, "dxpipe_depthparams", false, sizeof(DepthProjection));
+    }
+
+    if (t.cameraPipe == INVALID_HANDLE_VALUE && pc.depthSharedHandle)
+    {
+        t.cameraPipe = createPipelinePipe(pc, "dxpipe_camera", false, sizeof(CameraMatrices) * 4);
+    }
+
+    if (t.motionPipe == INVALID_HANDLE_VALUE && pc.motionSharedHandle)
     {
-        backBufferPipe = createNamedPipe("dxpipe_backbuffer", false, sizeof(TextureInfo));
+        t.motionPipe = createPipelinePipe(pc, "dxpipe_motion", false, sizeof(TextureInfo));
     }
 
-    if (depthBufferPipe == INVALID_HANDLE_VALUE && g_DepthSharedHandle)
+    if (t.displayPipe == INVALID_HANDLE_VALUE && pc.primary && pc.backBufferSharedHandle)
     {
-        depthBufferPipe = createNamedPipe("dxpipe_depthbuffer", false, sizeof(TextureInfo));
+        t.displayPipe = createPipelinePipe(pc, "dxpipe_display", false, sizeof(FrameDisplay) * 16);
     }
 
-    if (confirmationPipe == INVALID_HANDLE_VALUE)
+    if (t.confirmationPipe == INVALID_HANDLE_VALUE)
     {
-        confirmationPipe = createNamedPipe("dxpipe_confirmation", true, 4); // inbound pipe for confirmation
+        t.confirmationPipe = createPipelinePipe(pc, "dxpipe_confirmation", true, 4); // inbound pipe for confirmation
     }
 
     // if we have no valid handles to share, wait until we do
-    if (!g_BackBufferSharedHandle && !g_DepthSharedHandle)
+    if (!pc.backBufferSharedHandle && !pc.depthSharedHandle)
     {
         return 0; // still waiting for valid handles
     }
@@ -390,9 +467,7 @@ inline int duplicateHandleToClientProcess()
     HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
     if (snapshot == INVALID_HANDLE_VALUE)
     {
-#if DEBUG
-        std::cout << timeStamp() << "Failed to create process snapshot: " << GetLastError() << std::endl;
-#endif
+        LOG_ERROR(Ipc, "Failed to create process snapshot: {}", GetLastError());
         return -1; // error
     }
 
@@ -412,11 +487,10 @@ inline int duplicateHandleToClientProcess()
             HANDLE targetProcess = OpenProcess(PROCESS_DUP_HANDLE, FALSE, processEntry.th32ProcessID);
             if (targetProcess != NULL)
             {
-// found bloxshade.exe process - we can proceed with sending handles
-#if DEBUG
-                std::cout << timeStamp() << "Found bloxshade.exe process (PID: " << processEntry.th32ProcessID << ")" << std::endl;
-#endif
-                lastFoundPID = processEntry.th32ProcessID;
+                LOG_INFO(Ipc, "Found bloxshade.exe process (PID: {})", processEntry.th32ProcessID);
+                t.lastFoundPID = processEntry.th32ProcessID;
+                if (pc.primary)
+                    g_DepthWanted = true; // start snapshotting the scene depth
                 CloseHandle(targetProcess);
                 CloseHandle(snapshot);
                 return 1; // client found
@@ -429,15 +503,30 @@ inline int duplicateHandleToClientProcess()
     CloseHandle(snapshot);
 
     // bloxshade.exe not found, will try again next call
+#if !ENABLE_IMGUI
+    if (pc.primary)
+        g_DepthWanted = false; // nobody reads depth, skip the snapshot copies
+#endif
     return 0; // still searching
 }
 
+#if ENABLE_ALLOC_AUDIT
+// log whatever Present allocated since the last frame (the report itself is untagged)
+inline void reportPresentAllocations(uint64_t frame)
+{
+    AllocScope untracked(nullptr);
+    uint64_t tagged = allocAuditDrain([](const AllocSite &site)
+                                      { LOG_WARN(SwapChain, "  {} bytes in {}", site.size, site.tag); });
+    if (tagged)
+        LOG_WARN(SwapChain, "Present allocated {} time(s) in frame {}", tagged, frame);
+}
+#endif
+
 ///////////////////////////////////////////////////////////////////////////////////////////
 // code end
 ///////////////////////////////////////////////////////////////////////////////////////////
 
 extern void replaceGlobal(ID3D11Texture2D *&dst, ID3D11Texture2D *src);
-extern void updateDimensionsFromBackBuffer();
 
 #if ENABLE_IMGUI
 // Declare a global GPU texture and SRV for ImGui rendering
@@ -476,13 +565,16 @@ static ID3D11Buffer *g_DepthConstantBuffer = nullptr;
 static float g_DepthFarPlane = 2000.0f;
 static float g_DepthNearPlane = 25.0f;
 static float g_DepthGamma = 0.5f;
+static bool g_DepthAutoParams = true; // use the inferred projection (g_DepthProjection) when known
 
 struct DepthParams
 {
     float FAR_PLANE;
     float NEAR_PLANE;
     float GAMMA;
-    float padding; // D3D11 constant buffer alignment
+    float REVERSED_Z;
+    float PERSPECTIVE;
+    float padding[3]; // D3D11 constant buffer alignment
 };
 #endif
 
@@ -497,9 +589,21 @@ cbuffer DepthParams : register(b0)
     float FAR_PLANE;
     float NEAR_PLANE;
     float GAMMA;
-    float padding;
+    float REVERSED_Z;  // 1 = near is depth 1
+    float PERSPECTIVE; // 1 = near / far are the game's planes (inferred), 0 = manual lerp
+    float3 padding;
 };
 
+// raw depth → view distance
+float LinearizeDepth(float raw)
+{
+    if (REVERSED_Z > 0.5)
+        raw = 1.0 - raw;
+    if (PERSPECTIVE > 0.5)
+        return NEAR_PLANE * FAR_PLANE / (FAR_PLANE - raw * (FAR_PLANE - NEAR_PLANE));
+    return lerp(NEAR_PLANE, FAR_PLANE, raw);
+}
+
 struct PSInput
 {
     float4 position : SV_POSITION;
@@ -512,7 +616,7 @@ float4 main(PSInput input) : SV_TARGET
     float depth = tex.Sample(sam, input.uv).r;
 
     // linearize depth
-    depth = lerp(NEAR_PLANE, FAR_PLANE, depth);
+    depth = LinearizeDepth(depth);
 
     // normalize depth
     depth = depth / (FAR_PLANE - NEAR_PLANE);
@@ -534,9 +638,21 @@ cbuffer DepthParams : register(b0)
     float FAR_PLANE;
     float NEAR_PLANE;
     float GAMMA;
-    float padding;
+    float REVERSED_Z;  // 1 = near is depth 1
+    float PERSPECTIVE; // 1 = near / far are the game's planes (inferred), 0 = manual lerp
+    float3 padding;
 };
 
+// raw depth → view distance
+float LinearizeDepth(float raw)
+{
+    if (REVERSED_Z > 0.5)
+        raw = 1.0 - raw;
+    if (PERSPECTIVE > 0.5)
+        return NEAR_PLANE * FAR_PLANE / (FAR_PLANE - raw * (FAR_PLANE - NEAR_PLANE));
+    return lerp(NEAR_PLANE, FAR_PLANE, raw);
+}
+
 struct PSInput
 {
     float4 position : SV_POSITION;
@@ -548,7 +664,7 @@ float GetDepth(float2 texcoord)
 {
     float rawDepth = tex.Sample(sam, texcoord).r;
     // linearize depth using same method as our depth shader
-    return lerp(NEAR_PLANE, FAR_PLANE, rawDepth);
+    return LinearizeDepth(rawDepth);
 }
 
 float4 main(PSInput input) : SV_TARGET
@@ -626,11 +742,7 @@ inline void compileDepthShader(ID3D11Device *device)
                             &shaderBlob, &errorBlob);
     if (FAILED(hr))
     {
-#if DEBUG
-        std::cout << timeStamp() << "Depth shader compile failed: "
-                  << (char *)(errorBlob ? errorBlob->GetBufferPointer() : "")
-                  << std::endl;
-#endif
+        LOG_ERROR(Overlay, "Depth shader compile failed: {}", (char *)(errorBlob ? errorBlob->GetBufferPointer() : ""));
         if (errorBlob)
             errorBlob->Release();
         return;
@@ -641,18 +753,13 @@ inline void compileDepthShader(ID3D11Device *device)
                                    nullptr, &g_DepthPS);
     if (FAILED(hr))
     {
-#if DEBUG
-        std::cout << timeStamp() << "CreatePixelShader(depth) failed!"
-                  << std::endl;
-#endif
+        LOG_ERROR(Overlay, "CreatePixelShader(depth) failed!");
         shaderBlob->Release();
         return;
     }
 
     g_DepthPSBlob = shaderBlob; // Keep a reference
-#if DEBUG
-    std::cout << timeStamp() << "Depth shader compiled and created." << std::endl;
-#endif
+    LOG_DEBUG(Overlay, "Depth shader compiled and created.");
 }
 
 // Compile the normal buffer shader if not already compiled
@@ -674,11 +781,8 @@ inline void compileNormalShader(ID3D11Device *device)
                             &shaderBlob, &errorBlob);
     if (FAILED(hr))
     {
-#if DEBUG
-        std::cout << timeStamp() << "Normal shader compile failed: "
-                  << (char *)(errorBlob ? errorBlob->GetBufferPointer() : "")
-                  << std::endl;
-#endif
+        LOG_ERROR(Overlay, "Normal shader compile failed: {}",
+                  (char *)(errorBlob ? errorBlob->GetBufferPointer() : ""));
         if (errorBlob)
             errorBlob->Release();
         return;
@@ -689,18 +793,13 @@ inline void compileNormalShader(ID3D11Device *device)
                                    nullptr, &g_NormalPS);
     if (FAILED(hr))
     {
-#if DEBUG
-        std::cout << timeStamp() << "CreatePixelShader(normal) failed!"
-                  << std::endl;
-#endif
+        LOG_ERROR(Overlay, "CreatePixelShader(normal) failed!");
         shaderBlob->Release();
         return;
     }
 
     g_NormalPSBlob = shaderBlob; // Keep a reference
-#if DEBUG
-    std::cout << timeStamp() << "Normal shader compiled and created." << std::endl;
-#endif
+    LOG_DEBUG(Overlay, "Normal shader compiled and created.");
 }
 
 // Compile our simple fullscreen VS once
@@ -720,11 +819,7 @@ inline void compileQuadVS(ID3D11Device *device)
                             &vsBlob, &err);
     if (FAILED(hr))
     {
-#if DEBUG
-        std::cout << timeStamp() << "Quad VS compile failed: "
-                  << (char *)(err ? err->GetBufferPointer() : "")
-                  << std::endl;
-#endif
+        LOG_ERROR(Overlay, "Quad VS compile failed: {}", (char *)(err ? err->GetBufferPointer() : ""));
         if (err)
             err->Release();
         return;
@@ -734,17 +829,12 @@ inline void compileQuadVS(ID3D11Device *device)
                                     nullptr, &g_QuadVS);
     if (FAILED(hr))
     {
-#if DEBUG
-        std::cout << timeStamp() << "CreateVertexShader(quad) failed!"
-                  << std::endl;
-#endif
+        LOG_ERROR(Overlay, "CreateVertexShader(quad) failed!");
         vsBlob->Release();
         return;
     }
     g_QuadVSBlob = vsBlob;
-#if DEBUG
-    std::cout << timeStamp() << "Quad VS compiled and created." << std::endl;
-#endif
+    LOG_DEBUG(Overlay, "Quad VS compiled and created.");
 }
 
 // Create depth constant buffer
@@ -764,9 +854,7 @@ inline void ensureDepthConstantBuffer(ID3D11Device *device)
 
     if (FAILED(device->CreateBuffer(&desc, nullptr, &g_DepthConstantBuffer)))
     {
-#if DEBUG
-        std::cout << timeStamp() << "CreateBuffer(DepthConstantBuffer) failed!" << std::endl;
-#endif
+        LOG_ERROR(Overlay, "CreateBuffer(DepthConstantBuffer) failed!");
     }
 }
 
@@ -778,11 +866,21 @@ inline void updateDepthConstantBuffer(ID3D11DeviceContext *ctx)
     D3D11_MAPPED_SUBRESOURCE mapped;
     if (SUCCEEDED(ctx->Map(g_DepthConstantBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
     {
+        // inferred planes replace the sliders while auto is on (the sliders show them)
+        uint32_t flags = g_DepthAutoParams ? g_DepthProjection.flags : 0;
+        if (flags & PROJ_VALID)
+        {
+            g_DepthNearPlane = g_DepthProjection.nearPlane;
+            g_DepthFarPlane = (flags & PROJ_INFINITE) ? g_DepthProjection.nearPlane * 1e5f : g_DepthProjection.farPlane;
+        }
+
         DepthParams *params = static_cast<DepthParams *>(mapped.pData);
         params->FAR_PLANE = g_DepthFarPlane;
         params->NEAR_PLANE = g_DepthNearPlane;
         params->GAMMA = g_DepthGamma;
-        params->padding = 0.0f;
+        params->REVERSED_Z = (flags & PROJ_REVERSED_Z) ? 1.0f : 0.0f;
+        params->PERSPECTIVE = (flags & PROJ_VALID) ? 1.0f : 0.0f;
+        params->padding[0] = params->padding[1] = params->padding[2] = 0.0f;
         ctx->Unmap(g_DepthConstantBuffer, 0);
     }
 }
@@ -836,26 +934,20 @@ inline void ensureDepthVis(ID3D11Device *device, int w, int h)
     desc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
     if (FAILED(device->CreateTexture2D(&desc, nullptr, &g_DepthVis)))
     {
-#if DEBUG
-        std::cout << timeStamp() << "CreateTexture2D(depthVis) failed!" << std::endl;
-#endif
+        LOG_ERROR(Overlay, "CreateTexture2D(depthVis) failed!");
         return;
     }
 
     // RTV
     if (FAILED(device->CreateRenderTargetView(g_DepthVis, nullptr, &g_DepthVisRTV)))
     {
-#if DEBUG
-        std::cout << timeStamp() << "CreateRenderTargetView(depthVis) failed!" << std::endl;
-#endif
+        LOG_ERROR(Overlay, "CreateRenderTargetView(depthVis) failed!");
     }
 
     // SRV for ImGui
     if (FAILED(device->CreateShaderResourceView(g_DepthVis, nullptr, &g_DepthVisSRV)))
     {
-#if DEBUG
-        std::cout << timeStamp() << "CreateShaderResourceView(depthVis) failed!" << std::endl;
-#endif
+        LOG_ERROR(Overlay, "CreateShaderResourceView(depthVis) failed!");
     }
 }
 
@@ -908,60 +1000,156 @@ inline void ensureNormalVis(ID3D11Device *device, int w, int h)
     desc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
     if (FAILED(device->CreateTexture2D(&desc, nullptr, &g_NormalVis)))
     {
-#if DEBUG
-        std::cout << timeStamp() << "CreateTexture2D(normalVis) failed!" << std::endl;
-#endif
+        LOG_ERROR(Overlay, "CreateTexture2D(normalVis) failed!");
         return;
     }
 
     // RTV
     if (FAILED(device->CreateRenderTargetView(g_NormalVis, nullptr, &g_NormalVisRTV)))
     {
-#if DEBUG
-        std::cout << timeStamp() << "CreateRenderTargetView(normalVis) failed!" << std::endl;
-#endif
+        LOG_ERROR(Overlay, "CreateRenderTargetView(normalVis) failed!");
     }
 
     // SRV for ImGui
     if (FAILED(device->CreateShaderResourceView(g_NormalVis, nullptr, &g_NormalVisSRV)))
     {
-#if DEBUG
-        std::cout << timeStamp() << "CreateShaderResourceView(normalVis) failed!" << std::endl;
-#endif
+        LOG_ERROR(Overlay, "CreateShaderResourceView(normalVis) failed!");
     }
 }
 #endif
 
 /* ------------------------------------------------------------------------
-   ImGui helpers (local to this translation unit)                          */
+   game window subclass (input ages, ImGui input when enabled)              */
+static std::atomic<HWND> s_hwnd{nullptr};                       // the primary's window, the one the layer serves
+static const wchar_t *const s_origProcProp = L"dxpipe.WndProc"; // window property: its proc before ours
+
 #if ENABLE_IMGUI
 static bool s_imguiInit = false; // one-time guard
-static HWND s_hwnd = nullptr;
-static WNDPROC s_origProc = nullptr;
 static ID3D11RenderTargetView *g_Rtv = nullptr;
 
 static bool showImGui = false;                                // toggled with <Home>
 static bool vk_gFps_c = true;                                 // fps overlay
 static ImVec4 fpsColor = ImVec4(1.0f, 1.0f, 0.784314f, 1.0f); // #fff7c8
 
+// frame time (us) as fps, 0 for an empty window
+static double fpsOf(uint32_t us)
+{
+    return us ? 1e6 / us : 0.0;
+}
+
 // dxpipe version
 #define VERSION "0.0.0"
 
-// Forwarded input for ImGui + <Home> hot-key
+#endif
+
+// the input a message carries, false for everything else
+static bool inputKindOf(UINT msg, LPARAM lParam, InputKind &kind)
+{
+    if (msg >= WM_MOUSEFIRST && msg <= WM_MOUSELAST)
+    {
+        kind = InputKind::Mouse;
+        return true;
+    }
+    if (msg == WM_KEYDOWN || msg == WM_KEYUP || msg == WM_SYSKEYDOWN || msg == WM_SYSKEYUP)
+    {
+        kind = InputKind::Keyboard;
+        return true;
+    }
+    if (msg == WM_INPUT)
+    {
+        // the header only, the game reads the data itself
+        RAWINPUTHEADER header{};
+        UINT size = sizeof(header);
+        if (GetRawInputData(HRAWINPUT(lParam), RID_HEADER, &header, &size, sizeof(header)) == UINT(-1))
+            return false;
+        if (header.dwType == RIM_TYPEMOUSE)
+            kind = InputKind::Mouse;
+        else if (header.dwType == RIM_TYPEKEYBOARD)
+            kind = InputKind::Keyboard;
+        else
+            return false;
+        return true;
+    }
+    return false;
+}
+
+// stamps input for the stats page, forwards to ImGui + <Home> hot-key when enabled; a
+// window the primary left that couldn't be unhooked only forwards
 static LRESULT CALLBACK WndProcHook(HWND hWnd, UINT msg,
                                     WPARAM wParam, LPARAM lParam)
 {
-    if (ImGui_ImplWin32_WndProcHandler(hWnd, msg, wParam, lParam))
-        return TRUE;
+    if (hWnd == s_hwnd.load(std::memory_order_acquire))
+    {
+        InputKind kind;
+        if (inputKindOf(msg, lParam, kind))
+            g_Stats.input().arrived(kind, uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                       std::chrono::steady_clock::now().time_since_epoch())
+                                                       .count()));
+
+#if ENABLE_IMGUI
+        if (ImGui_ImplWin32_WndProcHandler(hWnd, msg, wParam, lParam))
+            return TRUE;
 
-    if (msg == WM_KEYDOWN && wParam == VK_HOME)
+        if (msg == WM_KEYDOWN && wParam == VK_HOME)
+        {
+            showImGui = !showImGui;
+            return 0;
+        }
+#endif
+    }
+    // per window, each hooked window keeps its own original
+    WNDPROC orig = (WNDPROC)GetPropW(hWnd, s_origProcProp);
+    return orig ? CallWindowProcW(orig, hWnd, msg, wParam, lParam) : DefWindowProcW(hWnd, msg, wParam, lParam);
+}
+
+// put the window's original procedure back, unless someone subclassed it after us (that
+// would cut them off), then the hook stays in their chain and only forwards
+static void unhookWindow(HWND hwnd)
+{
+    WNDPROC orig = (WNDPROC)GetPropW(hwnd, s_origProcProp);
+    if (!orig || !IsWindow(hwnd))
+        return;
+    if ((WNDPROC)GetWindowLongPtrW(hwnd, GWLP_WNDPROC) != WndProcHook)
     {
-        showImGui = !showImGui;
-        return 0;
+        LOG_WARN(SwapChain, "Game window {} was subclassed after us, the hook stays in place", (void *)hwnd);
+        return;
     }
-    return CallWindowProc(s_origProc, hWnd, msg, wParam, lParam);
+    SetWindowLongPtrW(hwnd, GWLP_WNDPROC, (LONG_PTR)orig);
+    RemovePropW(hwnd, s_origProcProp);
+    LOG_INFO(SwapChain, "Restored the window procedure of {}", (void *)hwnd);
 }
+
+// subclass the primary's window (its Present thread), the hook moves along when the
+// primary presents to another window
+static void hookWindow(IDXGISwapChain1 *swapChain)
+{
+    HWND hwnd = nullptr;
+    HWND current = s_hwnd.load(std::memory_order_relaxed);
+    if (FAILED(swapChain->GetHwnd(&hwnd)) || !hwnd || hwnd == current)
+        return;
+
+    if (current)
+        unhookWindow(current);
+    s_hwnd.store(hwnd, std::memory_order_release);
+
+    // a window hooked before (the primary came back to it) is still in the chain; the
+    // property goes first, a message may come in on the window's thread right away
+    if (!GetPropW(hwnd, s_origProcProp))
+    {
+        SetPropW(hwnd, s_origProcProp, (HANDLE)GetWindowLongPtrW(hwnd, GWLP_WNDPROC));
+        SetWindowLongPtrW(hwnd, GWLP_WNDPROC, (LONG_PTR)WndProcHook);
+    }
+    LOG_INFO(SwapChain, "Subclassed the game window {} for input ages", (void *)hwnd);
+
+#if ENABLE_IMGUI
+    // ImGui's win32 backend keeps the window it was initialised with
+    if (s_imguiInit)
+    {
+        ImGui_ImplWin32_Shutdown();
+        ImGui_ImplWin32_Init(hwnd);
+    }
 #endif
+}
 
 /* helper to print a texture’s basic info */
 inline void printBufferDetails(const char *name, ID3D11Texture2D *tex)
@@ -970,32 +1158,39 @@ inline void printBufferDetails(const char *name, ID3D11Texture2D *tex)
     {
         D3D11_TEXTURE2D_DESC d{};
         tex->GetDesc(&d);
-#if DEBUG
-        std::cout << timeStamp() << name << ": "
-                  << d.Width << "x" << d.Height
-                  << " format=" << std::hex << d.Format
-                  << std::dec << std::endl;
-#endif
+        LOG_DEBUG(SwapChain, "{}: {}x{} format={:x}", name, d.Width, d.Height, d.Format);
     }
     else
     {
-#if DEBUG
-        std::cout << timeStamp() << name << ": nullptr" << std::endl;
-#endif
+        LOG_DEBUG(SwapChain, "{}: nullptr", name);
     }
 }
 
 // IDXGISwapChain proxy wrapper
-//  • logs Present / ResizeBuffers / GetBuffer(0)
-//  • keeps CPU-readable staging copies
-//  • renders ImGui in-place
+//  • logs Present / ResizeBuffers / GetBuffer(0), traces Present phase by phase (g_Trace)
+//  • keeps CPU-readable staging copies in its pipeline context (ProxyPipeline.h)
+//  • renders ImGui in-place (primary context)
 class ProxySwapChain : public IDXGISwapChain2
 {
 public:
     explicit ProxySwapChain(IDXGISwapChain2 *real)
-        : m_real(real), m_ref(1)
+        : m_real(real), m_ref(1), m_pipe(createPipelineContext(real))
     {
         m_real->AddRef();
+
+        // the back buffer tells the device, and with it whether this is the primary
+        ID3D11Texture2D *bb = nullptr;
+        if (SUCCEEDED(m_real->GetBuffer(0, __uuidof(ID3D11Texture2D), reinterpret_cast<void **>(&bb))) && bb)
+        {
+            setPipelineBackBuffer(*m_pipe, bb);
+            bb->Release();
+        }
+
+        // the game creates its depth buffer after this, the profile can pick it right away
+        DXGI_SWAP_CHAIN_DESC d{};
+        if (m_pipe->primary && SUCCEEDED(m_real->GetDesc(&d)))
+            applyDepthProfile(d.BufferDesc.Width, d.BufferDesc.Height);
+        m_pipe->retag = false; // streams don't exist yet
     }
 
     // -------- IUnknown ---------------------------------------------------
@@ -1018,6 +1213,17 @@ public:
         ULONG c = static_cast<ULONG>(--m_ref);
         if (!c)
         {
+            // the window outlives the swap chain, a hook on it goes with the swap chain
+            HWND hwnd = nullptr;
+            if (SUCCEEDED(m_real->GetHwnd(&hwnd)) && hwnd && s_hwnd.compare_exchange_strong(hwnd, nullptr))
+                unhookWindow(hwnd);
+
+            // our reference on its back buffer would keep the real swap chain alive, the
+            // context's streams close with it
+            destroyPipelineContext(m_pipe);
+            m_pipe = nullptr;
+            reportHeldResources("swap chain released");
+
             m_real->Release();
             delete this;
         }
@@ -1039,68 +1245,67 @@ public:
     // -------- IDXGISwapChain ---------------------------------------------
     HRESULT STDMETHODCALLTYPE Present(UINT si, UINT f) override
     {
-#if DEBUG
-        output();
-#endif
-#if DEBUG
-// std::cout << timeStamp() << "IDXGISwapChain::Present" << std::endl;
-#endif
-#if DEBUG
-// std::cout << timeStamp() << "Present(" << si << ", " << f << ")" << std::endl;
+#if ENABLE_ALLOC_AUDIT
+        AllocScope allocScope("Present");
 #endif
+        PipelineContext &pc = *m_pipe;
+        const uint64_t traceFrame = g_FrameTimeline.frame();
+        g_Trace.log(TraceEvent::Present, si | (f << 16), pc.id, traceFrame);
+        PresentStages stages(pc.id); // trace phases + stats page stage costs
+        uint64_t bytesCopied = 0;    // GPU bytes the export moved this frame (trace counter, stats page)
 
-        // Update dimensions from back buffer if available
-        updateDimensionsFromBackBuffer();
+        // this swap chain became / stopped being the primary, its streams change tag
+        if (pc.retag.exchange(false))
+        {
+            pc.transport.close();
+            if (pc.primary)
+                applyDepthProfile(UINT(pc.width), UINT(pc.height));
+            else
+                releasePipelineDepth(pc);
+        }
 
-        /* direct access to global variables */
-        // g_DepthTexture and g_Device are now directly accessible
-        // get the real device from d3d11.cpp global variables
-        ID3D11Device *realDevice = g_Device;
+        // Update dimensions from back buffer if available
+        updatePipelineSize(pc);
+
+        // depth detection, the frame timeline and the overlay belong to the primary, other
+        // swap chains only export their colour
+        const bool primary = pc.primary;
+        ID3D11Texture2D *depthHold = nullptr;
+        ID3D11Texture2D *depthSource = nullptr;
+        if (primary)
+        {
+            stages.begin(TracePhase::Detect);
 
-        // log current buffers
-        // printBufferDetails("Back buffer", g_BackBufferTexture);
-        // printBufferDetails("Depth buffer", g_DepthTexture);
+            // pick the scene depth from this frame's usage (may swap g_DepthTexture)
+            promoteDepthCandidate();
 
-        /* helper: create / resize CPU staging texture */
-        auto ensureStaging = [&](ID3D11Texture2D *src, ID3D11Texture2D *&dst)
-        {
-            if (!src || !realDevice)
-                return;
+            // near / far / reversed-Z of this frame (matrix scan results + depth test votes),
+            // the last launch's values until there is a matrix
+            inferProjection();
+            applyProfileProjection();
 
-            D3D11_TEXTURE2D_DESC d{};
-            src->GetDesc(&d);
-            bool recreate = false;
+            // view / projection of the locked camera buffer, stamped with the frame id
+            inferCamera();
 
-            if (!dst)
-                recreate = true;
-            else
-            {
-                D3D11_TEXTURE2D_DESC cur{};
-                dst->GetDesc(&cur);
-                recreate = (cur.Width != d.Width) ||
-                           (cur.Height != d.Height) ||
-                           (cur.Format != d.Format);
-            }
+            // remember what was picked for the next launch
+            updateDepthProfile();
 
-            if (!recreate)
-                return;
+            // the layer's reference on g_DepthTexture for this frame's copies, taken when the
+            // game bound / cleared it (nullptr if it didn't this frame)
+            depthHold = acquireDepthTexture();
 
-            replaceGlobal(dst, nullptr);
+            // the live depth buffer, or the copy taken before the game cleared / reused it
+            depthSource = depthExportSource(depthHold);
+            stages.end(TracePhase::Detect);
+        }
 
-            d.BindFlags = 0;
-            d.Usage = D3D11_USAGE_STAGING;
-            d.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
-            d.MiscFlags = 0;
-            d.ArraySize = 1;
-            d.MipLevels = 1;
+        // the device this swap chain presents with (g_Device for the primary), copies of
+        // its back buffer have to be made there
+        ID3D11Device *realDevice = pc.device;
 
-            if (FAILED(realDevice->CreateTexture2D(&d, nullptr, &dst)))
-            {
-#if DEBUG
-                std::cout << timeStamp() << "CreateTexture2D(STAGING) failed!" << std::endl;
-#endif
-            }
-        };
+        // log current buffers
+        // printBufferDetails("Back buffer", pc.backBuffer);
+        // printBufferDetails("Depth buffer", g_DepthTexture);
 
         /* helper: create / resize GPU texture + SRV */
         auto ensureGPUTexture = [&](ID3D11Texture2D *src, ID3D11Texture2D *&dst, ID3D11ShaderResourceView *&srv)
@@ -1144,9 +1349,7 @@ public:
             ID3D11Texture2D *tmp = nullptr;
             if (FAILED(realDevice->CreateTexture2D(&d, nullptr, &tmp)))
             {
-#if DEBUG
-                std::cout << timeStamp() << "CreateTexture2D(GPU) failed!" << std::endl;
-#endif
+                LOG_ERROR(SwapChain, "CreateTexture2D(GPU) failed!");
                 return;
             }
             replaceGlobal(dst, tmp);
@@ -1162,9 +1365,7 @@ public:
 
             if (FAILED(realDevice->CreateShaderResourceView(dst, &srvDesc, &srv)))
             {
-#if DEBUG
-                std::cout << timeStamp() << "CreateShaderResourceView failed!" << std::endl;
-#endif
+                LOG_ERROR(SwapChain, "CreateShaderResourceView failed!");
             }
         };
 
@@ -1173,124 +1374,129 @@ public:
         if (realDevice)
             realDevice->GetImmediateContext(&ctx);
 
-        /* ------------ colour staging ------------ */
-        ensureStaging(g_BackBufferTexture, g_BackBufferStaging);
-        if (ctx && g_BackBufferTexture && g_BackBufferStaging)
-            ctx->CopyResource(g_BackBufferStaging, g_BackBufferTexture);
-
-        /* ------------ depth staging  ------------ */
-        ensureStaging(g_DepthTexture, g_DepthStaging);
-        if (ctx && g_DepthTexture && g_DepthStaging)
-            ctx->CopyResource(g_DepthStaging, g_DepthTexture);
-
-#if ENABLE_IMGUI
-        /* re-create GPU texture (default usage + SRV) for the new back buffer */
-        ensureGPUTexture(g_BackBufferTexture, g_BackBufferGPU, g_BackBufferGPU_SRV);
-        if (ctx && g_BackBufferTexture && g_BackBufferGPU)
-            ctx->CopyResource(g_BackBufferGPU, g_BackBufferTexture); /* re-create GPU texture (default usage + SRV) for the depth buffer */
-        ensureGPUTexture(g_DepthTexture, g_DepthGPU, g_DepthGPU_SRV);
-        if (ctx && g_DepthTexture && g_DepthGPU)
-            ctx->CopyResource(g_DepthGPU, g_DepthTexture);
-#endif /* ------------ shared buffer management ------------ */
-        // create/update shared back buffer if needed
-        if (g_BackBufferTexture && realDevice)
+        // the stats page belongs to the primary, so do the GPU stage timestamps
+        if (primary)
         {
-            D3D11_TEXTURE2D_DESC desc{};
-            g_BackBufferTexture->GetDesc(&desc);
+            openStatsPage();
+            hookWindow(m_real);
 
-            // check if shared buffer needs recreation (size/format change or doesn't exist)
-            bool needsRecreation = !g_BackBufferShared;
-            if (g_BackBufferShared)
-            {
-                D3D11_TEXTURE2D_DESC sharedDesc{};
-                g_BackBufferShared->GetDesc(&sharedDesc);
-                if (sharedDesc.Width != desc.Width || sharedDesc.Height != desc.Height)
-                {
-#if DEBUG
-                    std::cout << timeStamp() << "Back buffer size changed - recreating shared buffer\n";
-#endif
-                    needsRecreation = true;
-                }
-            }
+            // the game's frame ends here, the sampled one's last pass closes before our work
+            g_PassSampler.endFrame(ctx);
+            stages.timeGpu(realDevice, ctx);
 
-            if (needsRecreation)
-            {
-                // release old shared buffer and handle
-                if (g_BackBufferShared)
-                {
-#if DEBUG
-                    std::cout << timeStamp() << "Releasing old back buffer shared texture\n";
-#endif
-                    g_BackBufferShared->Release();
-                    g_BackBufferShared = nullptr;
-                }
-                g_BackBufferSharedHandle = nullptr;
+            D3D11_TEXTURE2D_DESC dd{};
+            if (depthSource)
+                depthSource->GetDesc(&dd);
+            g_Stats.setDepth(dd.Width, dd.Height, uint32_t(dd.Format), dd.SampleDesc.Count);
+        }
 
-// create new shared back buffer
-#if DEBUG
-                std::cout << timeStamp() << "Creating new shared back buffer (" << desc.Width << "x" << desc.Height << ")\n";
-#endif
-                createSharedBackBuffer(realDevice, desc.Width, desc.Height);
+        /* ------------ depth resolve ------------ */
+        // an msaa or non-R32 depth buffer can't be copied into the export targets, it is
+        // resolved / converted to R32F first (one dispatch), and only while someone reads it
+        if (primary && g_DepthWanted.load(std::memory_order_relaxed))
+        {
+            stages.begin(TracePhase::Resolve);
+            ExportResult resolved = exportResolvedDepth<D3D11Api>(realDevice, ctx, depthSource,
+                                                                  g_DepthResolveMode, pc.depthResolved);
+            stages.end(TracePhase::Resolve);
+            bytesCopied += exportedBytes(resolved, pc.depthResolved);
+            if (resolved == ExportResult::Failed)
+            {
+                LOG_ERROR(SwapChain, "Depth resolve failed!");
+                depthSource = nullptr;
             }
+            else if (resolved != ExportResult::Skipped)
+                depthSource = pc.depthResolved;
+        }
+        else if (depthSource && needsDepthResolve(depthSource))
+            depthSource = nullptr;
 
-            // copy current back buffer to shared buffer
-            if (g_BackBufferShared && ctx)
-                ctx->CopyResource(g_BackBufferShared, g_BackBufferTexture);
+        /* ------------ colour staging ------------ */
+        stages.begin(TracePhase::Staging);
+        ExportResult stagedColour = exportStaging<D3D11Api>(realDevice, ctx, pc.backBuffer, pc.backBufferStaging);
+        if (stagedColour == ExportResult::Failed)
+        {
+            LOG_ERROR(SwapChain, "CreateTexture2D(STAGING) failed!");
         }
+        bytesCopied += exportedBytes(stagedColour, pc.backBufferStaging);
 
-        // create/update shared depth buffer if needed (prioritize depth buffer updates)
-        if (g_DepthTexture && realDevice)
+        /* ------------ depth staging  ------------ */
+        ExportResult stagedDepth = exportStaging<D3D11Api>(realDevice, ctx, depthSource, pc.depthStaging);
+        if (stagedDepth == ExportResult::Failed)
         {
-            D3D11_TEXTURE2D_DESC desc{};
-            g_DepthTexture->GetDesc(&desc);
+            LOG_ERROR(SwapChain, "CreateTexture2D(STAGING) failed!");
+        }
+        bytesCopied += exportedBytes(stagedDepth, pc.depthStaging);
+        stages.end(TracePhase::Staging);
 
-            // check if shared buffer needs recreation (size/format change or doesn't exist)
-            bool needsRecreation = !g_DepthShared;
-            if (g_DepthShared)
+#if ENABLE_IMGUI
+        /* re-create GPU texture (default usage + SRV) for the new back buffer */
+        if (primary)
+        {
+            ensureGPUTexture(pc.backBuffer, g_BackBufferGPU, g_BackBufferGPU_SRV);
+            if (ctx && pc.backBuffer && g_BackBufferGPU)
+                ctx->CopyResource(g_BackBufferGPU, pc.backBuffer); /* re-create GPU texture (default usage + SRV) for the depth buffer */
+            ensureGPUTexture(depthSource, g_DepthGPU, g_DepthGPU_SRV);
+            if (ctx && depthSource && g_DepthGPU)
+                ctx->CopyResource(g_DepthGPU, depthSource);
+        }
+#endif /* ------------ shared buffer management ------------ */
+        // create/update shared back buffer (recreated on size change, handle reset with it)
+        stages.begin(TracePhase::Shared);
+        ExportResult sharedColour = exportShared<D3D11Api>(realDevice, ctx, pc.backBuffer, DXGI_FORMAT_R8G8B8A8_UNORM,
+                                                           pc.backBufferShared, pc.backBufferSharedHandle);
+        logSharedExport("back buffer", sharedColour, pc.backBufferShared, pc.backBufferSharedHandle);
+
+        // create/update shared depth buffer
+        ExportResult sharedDepth = exportShared<D3D11Api>(realDevice, ctx, depthSource, DXGI_FORMAT_R32_TYPELESS,
+                                                          pc.depthShared, pc.depthSharedHandle);
+        logSharedExport("depth buffer", sharedDepth, pc.depthShared, pc.depthSharedHandle);
+        bytesCopied += exportedBytes(sharedColour, pc.backBufferShared) + exportedBytes(sharedDepth, pc.depthShared);
+        if (pc.transport.lastFoundPID && sharedColour != ExportResult::Copied && sharedColour != ExportResult::Recreated)
+            g_Stats.addDropped(); // the client is there, this frame isn't
+        stages.end(TracePhase::Shared);
+
+        /* ------------ camera motion ------------ */
+        // this frame's depth reprojected with the last and this frame's camera (half size
+        // R16G16F, one dispatch), only with a camera for both frames
+        MotionParams motionParams;
+        if (primary && depthSource && g_DepthWanted.load(std::memory_order_relaxed) && cameraMotionParams(motionParams))
+        {
+            stages.begin(TracePhase::Motion);
+            ExportResult motion = exportMotionVectors<D3D11Api>(realDevice, ctx, pc.depthShared, motionParams, pc.motion);
+            bytesCopied += exportedBytes(motion, pc.motion);
+            if (motion == ExportResult::Failed)
             {
-                D3D11_TEXTURE2D_DESC sharedDesc{};
-                g_DepthShared->GetDesc(&sharedDesc);
-                if (sharedDesc.Width != desc.Width || sharedDesc.Height != desc.Height)
-                {
-#if DEBUG
-                    std::cout << timeStamp() << "Depth buffer size changed - recreating shared buffer\n";
-#endif
-                    needsRecreation = true;
-                }
+                LOG_ERROR(SwapChain, "Camera motion pass failed!");
             }
-
-            if (needsRecreation)
+            else if (motion != ExportResult::Skipped)
             {
-                // release old shared buffer and handle
-                if (g_DepthShared)
-                {
-#if DEBUG
-                    std::cout << timeStamp() << "Releasing old depth buffer shared texture\n";
-#endif
-                    g_DepthShared->Release();
-                    g_DepthShared = nullptr;
-                }
-                g_DepthSharedHandle = nullptr;
-
-// create new shared depth buffer
-#if DEBUG
-                std::cout << timeStamp() << "Creating new shared depth buffer (" << desc.Width << "x" << desc.Height << ")\n";
-#endif
-                createSharedDepthBuffer(realDevice, desc.Width, desc.Height);
+                ExportResult sharedMotion = exportShared<D3D11Api>(realDevice, ctx, pc.motion, DXGI_FORMAT_R16G16_FLOAT,
+                                                                   pc.motionShared, pc.motionSharedHandle);
+                logSharedExport("motion", sharedMotion, pc.motionShared, pc.motionSharedHandle);
+                bytesCopied += exportedBytes(sharedMotion, pc.motionShared);
             }
-
-            // copy current depth buffer to shared buffer
-            if (g_DepthShared && ctx)
-                ctx->CopyResource(g_DepthShared, g_DepthTexture);
+            stages.end(TracePhase::Motion);
         }
 
+        // last use of the game's depth texture this frame, the reference goes with it
+        if (primary)
+            releaseDepthHold();
+
         /* ------------ handle duplication to client process ------------ */
         // attempt to duplicate handles to external client process
-        duplicateHandleToClientProcess();
+        stages.begin(TracePhase::Transport);
+        duplicateHandleToClientProcess(pc);
+        stages.end(TracePhase::Transport);
+        pc.statsStreams.store(uint32_t(pc.backBufferSharedHandle != nullptr) + uint32_t(pc.depthSharedHandle != nullptr) +
+                                  uint32_t(pc.motionSharedHandle != nullptr) + (pc.transport.lastFoundPID ? 0x100u : 0u),
+                              std::memory_order_relaxed);
 
 #if ENABLE_IMGUI
-        // Compile depth shader and quad VS if needed
-        if (realDevice)
+        stages.begin(TracePhase::Overlay);
+
+        // Compile depth shader and quad VS if needed (the overlay lives on the primary)
+        if (primary && realDevice)
         {
             compileDepthShader(realDevice);
             compileNormalShader(realDevice);
@@ -1299,7 +1505,7 @@ public:
         }
 
         // If we have a valid depth SRV, do a small pass to fill g_DepthVis
-        if (ctx && g_DepthPS && g_QuadVS && g_DepthGPU_SRV)
+        if (primary && ctx && g_DepthPS && g_QuadVS && g_DepthGPU_SRV)
         {
             // Make sure our "vis" texture is allocated
             ensureDepthVis(realDevice, g_Width, g_Height);
@@ -1344,7 +1550,7 @@ public:
         }
 
         // If we have a valid depth SRV, do a small pass to fill g_NormalVis
-        if (ctx && g_NormalPS && g_QuadVS && g_DepthGPU_SRV)
+        if (primary && ctx && g_NormalPS && g_QuadVS && g_DepthGPU_SRV)
         {
             // Make sure our "normal vis" texture is allocated
             ensureNormalVis(realDevice, g_Width, g_Height);
@@ -1389,14 +1595,12 @@ public:
         }
 #endif /* ---------- ImGui one-time initialisation ---------- */
 #if ENABLE_IMGUI
-        if (!s_imguiInit && realDevice && ctx)
+        if (!s_imguiInit && primary && realDevice && ctx && s_hwnd.load())
         {
-            m_real->GetHwnd(&s_hwnd);
-
             IMGUI_CHECKVERSION();
             ImGui::CreateContext();
             ImGui::StyleColorsDark();
-            ImGui_ImplWin32_Init(s_hwnd);
+            ImGui_ImplWin32_Init(s_hwnd.load());
             ImGui_ImplDX11_Init(realDevice, ctx);
             setImStyleTheme();
 
@@ -1410,10 +1614,7 @@ public:
                 bb->Release();
             }
 
-            // subclass window → ImGui + <Home> toggle
-            s_origProc = (WNDPROC)SetWindowLongPtrW(
-                s_hwnd, GWLP_WNDPROC, (LONG_PTR)WndProcHook);
-
+            // the window is already subclassed (hookWindow), WndProcHook feeds ImGui
             s_imguiInit = true;
         }
 
@@ -1421,10 +1622,10 @@ public:
         // create an interal imgui overlay that matches the back buffer size
         ////////////////////////////////////////////////////////////////////////
 
-        if (s_imguiInit && g_BackBufferTexture)
+        if (s_imguiInit && primary && pc.backBuffer)
         { // get back buffer size
             D3D11_TEXTURE2D_DESC d{};
-            g_BackBufferTexture->GetDesc(&d);
+            pc.backBuffer->GetDesc(&d);
             g_Width = int(d.Width);
             g_Height = int(d.Height);
 
@@ -1468,21 +1669,27 @@ public:
             ImGui::NewFrame();
 
             /* fps overlay ------------------------------------------------ */
-            static auto prevTime = std::chrono::high_resolution_clock::now();
-            static int counter = 0;
-            static std::string gFps_c;
+            static uint32_t frameTimesVersion = 0;
+            static char gFps_c[128] = "";
 
             if (vk_gFps_c)
             {
-                auto cur = std::chrono::high_resolution_clock::now();
-                double diff = std::chrono::duration<double>(cur - prevTime).count();
-                ++counter;
-                if (diff >= (1.0 / 30.0))
+                // the frame time histogram's windows, formatted again only when it republished
+                // (every FrameHistogram::SUMMARY_MS): fps over the last second, lows and p99
+                // over 10 s, hitches over the last minute
+                const FrameHistogram &frameTimes = g_Stats.frameTimes();
+                FrameTimeSummary ft[FRAME_WINDOWS];
+                uint32_t version = frameTimes.version();
+                if (version != frameTimesVersion && frameTimes.read(ft))
                 {
-                    gFps_c = std::to_string((1.0 / diff) * counter) + "fps / " +
-                             std::to_string((diff / counter) * 1000) + "ms";
-                    prevTime = cur;
-                    counter = 0;
+                    const FrameTimeSummary &sec = ft[uint32_t(FrameWindow::Second)];
+                    const FrameTimeSummary &ten = ft[uint32_t(FrameWindow::TenSeconds)];
+                    const FrameTimeSummary &minute = ft[uint32_t(FrameWindow::Minute)];
+                    snprintf(gFps_c, sizeof(gFps_c),
+                             "%.0f fps | 1%% low %.0f | 0.1%% low %.0f | p99 %.1f ms | %u hitches/min",
+                             fpsOf(sec.meanUs), fpsOf(ten.low1Us), fpsOf(ten.low01Us), ten.p99Us / 1000.0,
+                             minute.hitches);
+                    frameTimesVersion = version;
                 }
 
                 float windowHeight = 30.0f;
@@ -1508,10 +1715,10 @@ public:
                     ImVec2 pos = ImGui::GetCursorPos();
                     float lh = ImGui::GetTextLineHeight();
                     pos.y += ((ws.y - pos.y) / lh - 1) * lh;
-                    pos.x = ws.x - ImGui::CalcTextSize(gFps_c.c_str()).x - 10;
+                    pos.x = ws.x - ImGui::CalcTextSize(gFps_c).x - 10;
                     ImGui::SetCursorPos(pos);
                     ImGui::PushStyleColor(ImGuiCol_Text, fpsColor);
-                    ImGui::Text("%s", gFps_c.c_str());
+                    ImGui::Text("%s", gFps_c);
                     ImGui::PopStyleColor();
                     ImGui::End();
                 } // restore defaults
@@ -1997,7 +2204,7 @@ public:
                                 ImGui::Text("%dx%d", g_Width, g_Height);
                                 // back buffer
                                 D3D11_TEXTURE2D_DESC d_bb{}; // Renamed variable
-                                g_BackBufferTexture->GetDesc(&d_bb);
+                                pc.backBuffer->GetDesc(&d_bb);
                                 ImGui::Text("Format: %08X", d_bb.Format);
 
                                 // image scaling and positioning for back buffer
@@ -2051,7 +2258,8 @@ public:
                             if (g_DepthVisSRV)
                             {
                                 D3D11_TEXTURE2D_DESC d_depth{}; // Renamed variable
-                                g_DepthTexture->GetDesc(&d_depth);
+                                if (g_DepthGPU)
+                                    g_DepthGPU->GetDesc(&d_depth); // our copy, the game's texture may be gone
                                 ImGui::Text("Depth Buffer:");
                                 ImGui::SameLine();
                                 ImGui::Text("%dx%d", d_depth.Width, d_depth.Height);
@@ -2108,7 +2316,8 @@ public:
                             if (g_NormalVisSRV)
                             {
                                 D3D11_TEXTURE2D_DESC d_normal{};
-                                g_DepthTexture->GetDesc(&d_normal); // Normal buffer uses same size as depth
+                                if (g_DepthGPU)
+                                    g_DepthGPU->GetDesc(&d_normal); // Normal buffer uses same size as depth
                                 ImGui::Text("Normal Buffer:");
                                 ImGui::SameLine();
                                 ImGui::Text("%dx%d", d_normal.Width, d_normal.Height);
@@ -2161,6 +2370,23 @@ public:
                                 ImGui::Text("Depth Shader Controls (affects both depth and normal views)");
                                 ImGui::Separator();
 
+                                // inferred near / far / reversed-Z (overrides the sliders when known)
+                                ImGui::Checkbox("Infer from game", &g_DepthAutoParams);
+                                if (g_DepthProjection.flags & PROJ_VALID)
+                                    ImGui::Text("Inferred: near %.3f | far %.1f%s | fov %.1f%s", g_DepthProjection.nearPlane,
+                                                g_DepthProjection.farPlane, (g_DepthProjection.flags & PROJ_INFINITE) ? " (infinite)" : "",
+                                                g_DepthProjection.fovY * 57.29578f, (g_DepthProjection.flags & PROJ_REVERSED_Z) ? " | reversed-Z" : "");
+                                else if (g_DepthProjection.flags & PROJ_FROM_STATE)
+                                    ImGui::Text("Inferred: no projection matrix found%s", (g_DepthProjection.flags & PROJ_REVERSED_Z) ? " | reversed-Z" : "");
+                                else
+                                    ImGui::Text("Inferred: nothing yet");
+                                if (g_CameraMatrices.flags & CAM_VALID)
+                                    ImGui::Text("Camera: locked%s%s | view translation %.1f %.1f %.1f", (g_CameraMatrices.flags & CAM_CONFIRMED) ? " (view x projection)" : "",
+                                                (g_CameraMatrices.flags & CAM_TRANSPOSED) ? " | column-major" : "",
+                                                g_CameraMatrices.view[12], g_CameraMatrices.view[13], g_CameraMatrices.view[14]);
+                                else
+                                    ImGui::Text("Camera: searching");
+
                                 // Far Plane slider (completely independent)
                                 ImGui::SliderFloat("Far Plane", &g_DepthFarPlane, 1.1f, 3000.0f, "%.1f");
 
@@ -2169,6 +2395,12 @@ public:
 
                                 // Gamma slider (affects depth view only)
                                 ImGui::SliderFloat("Gamma (depth only)", &g_DepthGamma, 0.1f, 3.0f, "%.2f");
+
+                                // how msaa depth buffers are reduced to one sample (no effect without msaa)
+                                const char *resolveModes[] = {"Sample 0", "Min (standard Z)", "Max (reversed-Z)"};
+                                int resolveMode = int(g_DepthResolveMode);
+                                if (ImGui::Combo("MSAA depth resolve", &resolveMode, resolveModes, IM_ARRAYSIZE(resolveModes)))
+                                    g_DepthResolveMode = DepthResolveMode(resolveMode);
                                 ImGui::Spacing();
 
                                 // Reset button
@@ -2185,68 +2417,47 @@ public:
                                 if (ImGui::Button("Dump Buffers"))
                                 {
                                     // Get module directory
-                                    char modulePath[MAX_PATH];
+                                    char moduleDir[MAX_PATH];
                                     HMODULE hModule = GetModuleHandle(NULL);
-                                    GetModuleFileNameA(hModule, modulePath, MAX_PATH);
-                                    std::string moduleDir = std::string(modulePath);
-                                    size_t lastSlash = moduleDir.find_last_of("\\/");
-                                    if (lastSlash != std::string::npos)
-                                    {
-                                        moduleDir = moduleDir.substr(0, lastSlash + 1);
-                                    }
+                                    GetModuleFileNameA(hModule, moduleDir, MAX_PATH);
+                                    char *lastSlash = strrchr(moduleDir, '\\');
+                                    if (lastSlash)
+                                        lastSlash[1] = '\0';
 
                                     // Generate timestamp for unique filenames
-                                    auto now = std::chrono::system_clock::now();
-                                    auto time_t = std::chrono::system_clock::to_time_t(now);
-                                    std::stringstream ss;
-                                    ss << std::put_time(std::localtime(&time_t), "%Y%m%d_%H%M%S");
-                                    std::string timestamp = ss.str();
-
-                                    // Dump back buffer
-                                    if (g_BackBufferStaging && ctx)
+                                    char timestamp[32];
+                                    time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+                                    struct tm local;
+                                    localtime_s(&local, &now);
+                                    strftime(timestamp, sizeof(timestamp), "%Y%m%d_%H%M%S", &local);
+
+                                    // Dump one staging texture to <module dir><name>_<timestamp>.bin
+                                    auto dumpStaging = [&](ID3D11Texture2D *staging, const char *name)
                                     {
+                                        if (!staging || !ctx)
+                                            return;
+
                                         D3D11_MAPPED_SUBRESOURCE mapped;
-                                        if (SUCCEEDED(ctx->Map(g_BackBufferStaging, 0, D3D11_MAP_READ, 0, &mapped)))
-                                        {
-                                            D3D11_TEXTURE2D_DESC desc;
-                                            g_BackBufferStaging->GetDesc(&desc);
+                                        if (FAILED(ctx->Map(staging, 0, D3D11_MAP_READ, 0, &mapped)))
+                                            return;
 
-                                            std::string filename = moduleDir + "backbuffer_" + timestamp + ".bin";
-                                            std::ofstream file(filename, std::ios::binary);
-                                            if (file.is_open())
-                                            {
-                                                file.write(static_cast<const char *>(mapped.pData), mapped.RowPitch * desc.Height);
-                                                file.close();
-#if DEBUG
-                                                std::cout << timeStamp() << "Back buffer dumped to: " << filename << std::endl;
-#endif
-                                            }
-                                            ctx->Unmap(g_BackBufferStaging, 0);
-                                        }
-                                    }
+                                        D3D11_TEXTURE2D_DESC desc;
+                                        staging->GetDesc(&desc);
 
-                                    // Dump depth buffer
-                                    if (g_DepthStaging && ctx)
-                                    {
-                                        D3D11_MAPPED_SUBRESOURCE mapped;
-                                        if (SUCCEEDED(ctx->Map(g_DepthStaging, 0, D3D11_MAP_READ, 0, &mapped)))
+                                        char filename[MAX_PATH + 64];
+                                        snprintf(filename, sizeof(filename), "%s%s_%s.bin", moduleDir, name, timestamp);
+                                        FILE *file = nullptr;
+                                        if (fopen_s(&file, filename, "wb") == 0 && file)
                                         {
-                                            D3D11_TEXTURE2D_DESC desc;
-                                            g_DepthStaging->GetDesc(&desc);
-
-                                            std::string filename = moduleDir + "depthbuffer_" + timestamp + ".bin";
-                                            std::ofstream file(filename, std::ios::binary);
-                                            if (file.is_open())
-                                            {
-                                                file.write(static_cast<const char *>(mapped.pData), mapped.RowPitch * desc.Height);
-                                                file.close();
-#if DEBUG
-                                                std::cout << timeStamp() << "Depth buffer dumped to: " << filename << std::endl;
-#endif
-                                            }
-                                            ctx->Unmap(g_DepthStaging, 0);
+                                            fwrite(mapped.pData, 1, size_t(mapped.RowPitch) * desc.Height, file);
+                                            fclose(file);
+                                            LOG_INFO(Overlay, "{} dumped to: {}", name, filename);
                                         }
-                                    }
+                                        ctx->Unmap(staging, 0);
+                                    };
+
+                                    dumpStaging(pc.backBufferStaging, "backbuffer");
+                                    dumpStaging(pc.depthStaging, "depthbuffer");
                                 }
 
                                 ImGui::Spacing();
@@ -2282,6 +2493,197 @@ public:
                             ImGui::ColorEdit3("FPS Counter Colour", (float *)&fpsColor);
                             ImGui::Spacing();
 
+                            ImGui::Text("Frame Times");
+                            ImGui::Separator();
+                            FrameTimeSummary ft[FRAME_WINDOWS];
+                            uint64_t frames = 0, hitches = 0;
+                            if (g_Stats.frameTimes().read(ft, &frames, &hitches))
+                            {
+                                for (uint32_t w = 0; w < FRAME_WINDOWS; w++)
+                                    ImGui::Text("%-4s %6.1f fps  1%% low %6.1f  0.1%% low %6.1f  p50 %.2f  p99 %.2f  "
+                                                "p99.9 %.2f  max %.2f ms  %u hitches",
+                                                frameWindowName(w), fpsOf(ft[w].meanUs), fpsOf(ft[w].low1Us),
+                                                fpsOf(ft[w].low01Us), ft[w].p50Us / 1000.0, ft[w].p99Us / 1000.0,
+                                                ft[w].p999Us / 1000.0, ft[w].maxUs / 1000.0, ft[w].hitches);
+                                ImGui::Text("%llu frames, %llu hitches since start", (unsigned long long)frames,
+                                            (unsigned long long)hitches);
+                            }
+                            else
+                                ImGui::Text("No frames yet");
+                            ImGui::Spacing();
+
+                            ImGui::Text("Input Age At Present");
+                            ImGui::Separator();
+                            FrameTimeSummary ia[FRAME_WINDOWS];
+                            uint64_t inputFrames = 0;
+                            if (g_Stats.input().ages().read(ia, &inputFrames))
+                            {
+                                for (uint32_t w = 0; w < FRAME_WINDOWS; w++)
+                                    ImGui::Text("%-4s p50 %.2f  p99 %.2f  max %.2f ms  %u frames with input",
+                                                frameWindowName(w), ia[w].p50Us / 1000.0, ia[w].p99Us / 1000.0,
+                                                ia[w].maxUs / 1000.0, ia[w].frames);
+                                ImGui::Text("%llu mouse, %llu keyboard messages, %llu frames with input",
+                                            (unsigned long long)g_Stats.input().inputs(InputKind::Mouse),
+                                            (unsigned long long)g_Stats.input().inputs(InputKind::Keyboard),
+                                            (unsigned long long)inputFrames);
+                            }
+                            else
+                                ImGui::Text(s_hwnd.load() ? "No input yet" : "Window not subclassed");
+                            ImGui::Spacing();
+
+                            ImGui::Text("Present To Display");
+                            ImGui::Separator();
+                            const DisplayTracker &display = g_Stats.display();
+                            FrameTimeSummary dl[FRAME_WINDOWS], id[FRAME_WINDOWS];
+                            if (display.latency().read(dl))
+                            {
+                                bool withInput = display.inputLatency().read(id);
+                                for (uint32_t w = 0; w < FRAME_WINDOWS; w++)
+                                    ImGui::Text("%-4s p50 %.2f  p99 %.2f  max %.2f ms  input to display p50 %.2f  "
+                                                "p99 %.2f ms",
+                                                frameWindowName(w), dl[w].p50Us / 1000.0, dl[w].p99Us / 1000.0,
+                                                dl[w].maxUs / 1000.0, withInput ? id[w].p50Us / 1000.0 : 0.0,
+                                                withInput ? id[w].p99Us / 1000.0 : 0.0);
+                                ImGui::Text("refresh %.2f ms, %u queued, %llu shown, %llu unseen, %llu missed vblanks",
+                                            display.periodNs() / 1e6, display.queued(),
+                                            (unsigned long long)display.shown(), (unsigned long long)display.unseen(),
+                                            (unsigned long long)display.missed());
+                            }
+                            else
+                                ImGui::Text("No frame statistics (windowed blt model or not on screen yet)");
+                            ImGui::Spacing();
+
+                            ImGui::Text("Trace");
+                            ImGui::Separator();
+                            bool recording = g_Trace.isRecording();
+                            if (ImGui::Checkbox("Record trace", &recording))
+                                setTraceRecording(recording); // dxpipe_trace.dxtrace next to the game
+                            {
+                                // flight recorder, dxpipe_hitch_<frame>.dxtrace next to the game
+                                bool flight = g_Trace.flightSeconds() != 0;
+                                if (ImGui::Checkbox("Snapshot hitches", &flight))
+                                    setFlightRecorder(flight);
+                                int limitMs = int(g_Hitches.thresholdUs() / 1000);
+                                if (ImGui::SliderInt("Hitch over (ms, 0 = off)", &limitMs, 0, 1000))
+                                    g_Hitches.setThresholdUs(uint32_t(limitMs) * 1000);
+                                float factor = g_Hitches.factor();
+                                if (ImGui::SliderFloat("Or x median (0 = off)", &factor, 0.0f, 10.0f, "%.1f"))
+                                    g_Hitches.setFactor(factor);
+                                ImGui::Text("limit %.1f ms, %llu hitches, %llu of %u snapshots (last frame %llu)",
+                                            g_Hitches.limitUs(g_Stats.frameTimes().last(FrameWindow::TenSeconds)) / 1000.0,
+                                            (unsigned long long)g_Hitches.hitches(),
+                                            (unsigned long long)g_Hitches.snapshots(), g_Hitches.maxSnapshots(),
+                                            (unsigned long long)g_Hitches.lastFrame());
+                            }
+                            ImGui::Spacing();
+
+                            ImGui::Text("API Calls");
+                            ImGui::Separator();
+                            {
+                                bool counting = g_Census.enabled();
+                                if (ImGui::Checkbox("Count API calls", &counting))
+                                    g_Census.setEnabled(counting);
+
+                                // the last frame, by group and by method (only the ones called)
+                                const CensusFrame &census = g_Stats.census();
+                                uint64_t groups[CENSUS_GROUPS] = {};
+                                for (uint32_t c = 0; c < CENSUS_CALLS; c++)
+                                    groups[uint32_t(apiCallGroup(c))] += census.calls[c];
+                                for (uint32_t g = 0; g < CENSUS_GROUPS; g++)
+                                {
+                                    ImGui::Text("%-8s %6llu", apiGroupName(g), (unsigned long long)groups[g]);
+                                    if (g + 1 < CENSUS_GROUPS)
+                                        ImGui::SameLine();
+                                }
+                                ImGui::Text("UpdateSubresource %.1f KB, Map %.1f KB per frame",
+                                            census.bytes[uint32_t(ApiBytes::UpdateSubresource)] / 1024.0,
+                                            census.bytes[uint32_t(ApiBytes::Map)] / 1024.0);
+                                if (ImGui::TreeNode("Per method"))
+                                {
+                                    for (uint32_t c = 0; c < CENSUS_CALLS; c++)
+                                        if (census.calls[c])
+                                            ImGui::Text("%-26s %6u", apiCallName(c), census.calls[c]);
+                                    ImGui::TreePop();
+                                }
+                            }
+                            ImGui::Spacing();
+
+                            ImGui::Text("Pass Graph");
+                            ImGui::Separator();
+                            {
+                                int every = int(g_PassSampler.every());
+                                if (ImGui::SliderInt("Sample every N frames (0 = off)", &every, 0, 600))
+                                    g_PassSampler.setEvery(uint32_t(every));
+
+                                const PassGraph &graph = g_PassSampler.latest();
+                                if (!graph.passes.empty())
+                                {
+                                    ImGui::Text("Frame %llu: %zu passes, %zu edges, %zu resources",
+                                                (unsigned long long)graph.frame, graph.passes.size(),
+                                                graph.edges.size(), graph.resources.size());
+                                    if (graph.timed)
+                                        ImGui::Text("GPU %.2f ms", graph.gpuNs / 1e6);
+                                    else
+                                        ImGui::Text("GPU times not available");
+                                    if (ImGui::Button("Export JSON"))
+                                        g_PassSampler.exportJson(); // dxpipe_passes.json next to the game
+                                    if (ImGui::TreeNode("Passes"))
+                                    {
+                                        // one line per pass: what it did, its first target, where its inputs came from
+                                        size_t edge = 0;
+                                        for (uint32_t p = 0; p < graph.passes.size(); p++)
+                                        {
+                                            const Pass &pass = graph.passes[p];
+                                            char line[160];
+                                            int len = snprintf(line, sizeof(line), "#%-3u %-7s %5u dr %4u cs %7.3f ms",
+                                                               p, passKindName(uint32_t(passKind(pass))), pass.draws,
+                                                               pass.dispatches, pass.gpuNs / 1e6);
+                                            if (pass.writes)
+                                            {
+                                                const PassResource &r = graph.resources[graph.writes(pass)[0]];
+                                                len += snprintf(line + len, sizeof(line) - len, "  -> %ux%u fmt %u%s", r.width,
+                                                                r.height, r.format, pass.writes > 1 ? " +" : "");
+                                            }
+                                            while (edge < graph.edges.size() && graph.edges[edge].to < p)
+                                                edge++;
+                                            uint32_t last = PASS_NONE;
+                                            const char *sep = "  <- ";
+                                            for (; edge < graph.edges.size() && graph.edges[edge].to == p; edge++)
+                                            {
+                                                uint32_t from = graph.edges[edge].from;
+                                                if (from == last || len >= int(sizeof(line)) - 8)
+                                                    continue;
+                                                last = from;
+                                                len += snprintf(line + len, sizeof(line) - len, "%s#%u", sep, from);
+                                                sep = " ";
+                                            }
+                                            ImGui::TextUnformatted(line);
+                                        }
+                                        ImGui::TreePop();
+                                    }
+                                }
+                                else
+                                    ImGui::Text("No sampled frame yet");
+                            }
+                            ImGui::Spacing();
+
+                            ImGui::Text("Log");
+                            ImGui::Separator();
+                            {
+                                // only the levels this build compiled in (LOG_LEVEL)
+                                static const char *const levels[] = {"off", "error", "warn", "info", "debug"};
+                                for (uint32_t c = 0; c < uint32_t(LogCategory::Count); c++)
+                                {
+                                    int level = int(g_Log.level(LogCategory(c)));
+                                    if (ImGui::Combo(logCategoryName(c), &level, levels, LOG_LEVEL + 1))
+                                    {
+                                        g_Log.setLevel(LogCategory(c), LogLevel(level));
+                                        startLog(); // dxpipe_log.txt next to the game
+                                    }
+                                }
+                            }
+                            ImGui::Spacing();
+
                             ImGui::EndTabItem();
                         }
 
@@ -2310,12 +2712,70 @@ public:
 
             ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
         }
+        stages.end(TracePhase::Overlay);
 #endif
 
         /* ------------ release & present ------------------- */
+        stages.endGpu();
+
+        // the next frame is sampled from its first call on (arms the recorder when due)
+        if (primary)
+            g_PassSampler.beginFrame(realDevice, ctx, g_FrameTimeline.frame() + 1);
         if (ctx)
             ctx->Release();
-        return m_real->Present(si, f);
+
+#if ENABLE_ALLOC_AUDIT
+        reportPresentAllocations(g_FrameTimeline.frame());
+#endif
+
+        // per frame counters for the timeline (draws / uploads are the game's whole frame)
+        g_Trace.log(TraceEvent::Counter, uint32_t(TraceCounter::BytesCopied), bytesCopied, pc.id);
+        if (primary)
+        {
+            g_Trace.log(TraceEvent::Counter, uint32_t(TraceCounter::Draws), g_FrameTimeline.counters.draws, pc.id);
+            g_Trace.log(TraceEvent::Counter, uint32_t(TraceCounter::BytesUploaded),
+                        g_FrameTimeline.counters.bytesUploaded, pc.id);
+        }
+
+        // close the frame timeline, everything recorded so far belonged to this frame (an
+        // auxiliary window presenting in between is part of the game's frame)
+        if (primary)
+        {
+#if ENABLE_CAPTURE
+            g_Capture.writeFrame(g_FrameTimeline, si, f);
+#endif
+            g_FrameTimeline.endFrame();
+        }
+
+        // the oldest input since the last frame ages until here, display latency starts here
+        uint64_t realPresentNs = 0;
+        if (primary)
+        {
+            realPresentNs = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                         std::chrono::steady_clock::now().time_since_epoch())
+                                         .count());
+            g_Stats.input().presented(realPresentNs);
+        }
+
+        stages.begin(TracePhase::RealPresent);
+        HRESULT hr = m_real->Present(si, f);
+        stages.end(TracePhase::RealPresent);
+        g_Trace.log(TraceEvent::PresentEnd, uint32_t(hr), pc.id, traceFrame);
+
+        // what reached the screen so far, this frame joins the queue
+        if (primary && SUCCEEDED(hr) && !(f & DXGI_PRESENT_TEST))
+            sampleDisplay(m_real, traceFrame, realPresentNs, si);
+
+        // the primary's Present closes the stats page frame (auxiliary ones only add to it)
+        g_Stats.addBytes(bytesCopied);
+        if (primary)
+        {
+            publishStreams();
+            publishCensus(traceFrame);
+            g_Stats.publish(traceFrame, stages.presentNs());
+            checkHitch(traceFrame, stages.presentNs());
+        }
+        return hr;
     }
 
     // capture colour RT on GetBuffer(0)
@@ -2325,50 +2785,45 @@ public:
         if (SUCCEEDED(hr) && i == 0 && ppv && *ppv &&
             riid == __uuidof(ID3D11Texture2D))
         {
-#if DEBUG
-            output();
-#endif
-#if DEBUG
-            std::cout << timeStamp()
-                      << "IDXGISwapChain::GetBuffer(0) → back-buffer"
-                      << std::endl;
-#endif
-            replaceGlobal(g_BackBufferTexture,
-                          reinterpret_cast<ID3D11Texture2D *>(*ppv));
+            g_Trace.log(TraceEvent::GetBuffer, 0, uint64_t(reinterpret_cast<uintptr_t>(*ppv)), m_pipe->id);
+            LOG_INFO(SwapChain, "IDXGISwapChain::GetBuffer(0) → back-buffer");
+            // Update dimensions from the back buffer texture (and the device it lives on)
+            setPipelineBackBuffer(*m_pipe, reinterpret_cast<ID3D11Texture2D *>(*ppv));
 
-            // Update dimensions from the back buffer texture
-            updateDimensionsFromBackBuffer();
+#if ENABLE_CAPTURE
+            if (m_pipe->primary)
+            {
+                D3D11_TEXTURE2D_DESC d{};
+                m_pipe->backBuffer->GetDesc(&d);
+                captureTexture2D(CaptureOp::GetBuffer, m_pipe->backBuffer, d);
+            }
+#endif
         }
         return hr;
     } // intercepted – clear staging + RTV on resize
     HRESULT STDMETHODCALLTYPE ResizeBuffers(UINT n, UINT w, UINT h,
                                             DXGI_FORMAT fmt, UINT fl) override
     {
-#if DEBUG
-        output();
-#endif
-#if DEBUG
-        std::cout << timeStamp() << "IDXGISwapChain::ResizeBuffers → "
-                  << w << "x" << h << std::endl;
-#endif
+        g_Trace.log(TraceEvent::ResizeBuffers, uint32_t(fmt), uint64_t(w) | (uint64_t(h) << 32), m_pipe->id);
+        g_Stats.addResize();
+        LOG_INFO(SwapChain, "IDXGISwapChain::ResizeBuffers → {}x{}", w, h);
 
-        // Update global dimensions from resize parameters
-        g_Width = w;
-        g_Height = h;
-#if DEBUG
-        std::cout << timeStamp() << "Updated dimensions from ResizeBuffers: "
-                  << g_Width << "x" << g_Height << std::endl;
-#endif
+        PipelineContext &pc = *m_pipe;
 
-// print the g_BackBufferTexture address
-#if DEBUG
-        std::cout << timeStamp() << "g_BackBufferTexture: "
-                  << g_BackBufferTexture << std::endl;
-#endif
+        // the frames in flight are dropped with the buffers, vblank counts may start over
+        if (pc.primary)
+            g_Stats.display().reset();
+
+        // print the back buffer address
+        LOG_DEBUG(SwapChain, "Pipeline context {} back buffer: {}", pc.id, pc.backBuffer);
 
-        /* release colour */
-        replaceGlobal(g_BackBufferTexture, nullptr);
-        replaceGlobal(g_BackBufferStaging, nullptr); /* depth – staging is released elsewhere, shared copy handled here */
+        /* release colour + shared buffers and handles - they will be recreated */
+        releasePipelineBuffers(pc); /* depth – staging is released elsewhere, shared copy handled here */
+
+        // the game may release its depth buffer with the back buffers, the next bind of the
+        // promoted one takes the reference again
+        if (pc.primary)
+            releaseDepthHold();
 
         /* release RTV so it is recreated on next Present */
 #if ENABLE_IMGUI
@@ -2385,21 +2840,6 @@ public:
             g_DepthGPU_SRV->Release(), g_DepthGPU_SRV = nullptr;
 #endif
 
-        /* release shared buffers and handles - they will be recreated */
-        if (g_BackBufferShared)
-        {
-            g_BackBufferShared->Release();
-            g_BackBufferShared = nullptr;
-        }
-        g_BackBufferSharedHandle = nullptr;
-
-        if (g_DepthShared)
-        {
-            g_DepthShared->Release();
-            g_DepthShared = nullptr;
-        }
-        g_DepthSharedHandle = nullptr;
-
 #if ENABLE_IMGUI
         /* release depth visualization resources */
         if (g_DepthVisRTV)
@@ -2436,12 +2876,25 @@ public:
         }
 #endif
 
+        // everything the layer held on the old buffers is released by now
+        reportHeldResources("ResizeBuffers");
+
         HRESULT hr = m_real->ResizeBuffers(n, w, h, fmt, fl);
+#if ENABLE_CAPTURE
+        if (SUCCEEDED(hr) && pc.primary)
+            captureResize(w, h, fmt);
+#endif
 
+        // Update dimensions from resize parameters (the depth target follows the primary)
         if (SUCCEEDED(hr) && w && h)
+            setPipelineSize(pc, int(w), int(h));
+
+        // new size, new profile (0 x 0 = window size, read it back)
+        if (SUCCEEDED(hr) && pc.primary)
         {
-            g_Width = int(w);
-            g_Height = int(h);
+            DXGI_SWAP_CHAIN_DESC d{};
+            if (SUCCEEDED(m_real->GetDesc(&d)))
+                applyDepthProfile(d.BufferDesc.Width, d.BufferDesc.Height);
         }
 
         // reacquire new back buffer
@@ -2452,8 +2905,16 @@ public:
                                             reinterpret_cast<void **>(&tmp))) &&
                 tmp)
             {
-                replaceGlobal(g_BackBufferTexture, tmp);
+                setPipelineBackBuffer(pc, tmp);
                 tmp->Release();
+#if ENABLE_CAPTURE
+                if (pc.primary)
+                {
+                    D3D11_TEXTURE2D_DESC d{};
+                    pc.backBuffer->GetDesc(&d);
+                    captureTexture2D(CaptureOp::GetBuffer, pc.backBuffer, d);
+                }
+#endif
             }
         }
         return hr;
@@ -2474,12 +2935,7 @@ public:
     HRESULT STDMETHODCALLTYPE GetCoreWindow(REFIID riid, void **ppv) override { return m_real->GetCoreWindow(riid, ppv); }
     HRESULT STDMETHODCALLTYPE Present1(UINT si, UINT f, const DXGI_PRESENT_PARAMETERS *p) override
     {
-#if DEBUG
-        output();
-#endif
-#if DEBUG
-        std::cout << timeStamp() << "IDXGISwapChain1::Present1" << std::endl;
-#endif
+        g_Trace.log(TraceEvent::Present1, si | (f << 16));
         return m_real->Present1(si, f, p);
     }
     BOOL STDMETHODCALLTYPE IsTemporaryMonoSupported() override { return m_real->IsTemporaryMonoSupported(); }
@@ -2500,4 +2956,5 @@ public:
 private:
     IDXGISwapChain2 *m_real;
     std::atomic<uint32_t> m_ref;
+    PipelineContext *m_pipe; // resources + streams of this swap chain
 };
@@ -0,0 +1,118 @@
+#pragma once
+
+// record the trace from device creation in release builds too (DEBUG builds always do,
+// otherwise it starts with the overlay's "Record trace" box or setTraceRecording)
+#define ENABLE_TRACE 0
+
+// keep the last seconds of the trace in memory and write them out when a frame hitches
+// (HitchDetector.h), release builds too
+#define ENABLE_HITCH_SNAPSHOTS 1
+
+// c++ includes
+#include <iostream>
+#include <cstring>
+
+// windows headers
+#define NOMINMAX // disable min/max macros
+#include <Windows.h>
+
+// directx 11 headers
+#include <d3d11.h>
+
+// trace format + writer
+#include "TraceLog.h"
+#include "HitchDetector.h"
+#include "FrameExport.h"
+#include "LayerTypes.h"
+
+// structured log (g_Log, the LOG_ macros)
+#include "LayerLog.h"
+
+// the binary trace (closed until openTrace)
+extern TraceLog g_Trace;
+
+// when a frame is slow enough for a flight recorder snapshot
+extern HitchDetector g_Hitches;
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// trace glue
+//  • the file lives next to the game executable, opened on the first recording request
+//    (device creation in DEBUG / ENABLE_TRACE builds), never from DllMain (the writer
+//    is a thread)
+//  • Present is split into phases (Begin / End pairs) plus per frame counters, which
+//    dxpipe_trace --chrome turns into a timeline
+//  • the flight recorder starts with the device too (ENABLE_HITCH_SNAPSHOTS), a hitch
+//    snapshot is dxpipe_hitch_<frame>.dxtrace next to the trace
+///////////////////////////////////////////////////////////////////////////////////////////
+
+// a file next to the game executable
+inline void tracePath(char (&path)[MAX_PATH], const char *name)
+{
+    GetModuleFileNameA(GetModuleHandle(NULL), path, MAX_PATH);
+    char *lastSlash = strrchr(path, '\\');
+    if (lastSlash)
+        lastSlash[1] = '\0';
+    strncat_s(path, name, _TRUNCATE);
+}
+
+inline void openTrace()
+{
+    char path[MAX_PATH];
+    tracePath(path, "dxpipe_trace.dxtrace");
+
+    if (g_Trace.open(path))
+    {
+        LOG_INFO(Hooks, "Tracing to: {}", path);
+    }
+    else
+    {
+        LOG_ERROR(Hooks, "Failed to open trace file: {}", path);
+    }
+}
+
+// start / pause recording, the file stays open (and keeps its records) while paused
+inline void setTraceRecording(bool on)
+{
+    if (on && !g_Trace.isOpen())
+        openTrace();
+    g_Trace.setRecording(on);
+}
+
+// the last HitchDetector::FLIGHT_SECONDS in memory from now on (0 = off)
+inline void setFlightRecorder(bool on)
+{
+    g_Trace.setFlight(on ? HitchDetector::FLIGHT_SECONDS : 0);
+}
+
+// the primary's frame took frameUs over the limit in us it broke: snapshot the flight recorder
+inline bool snapshotHitch(uint64_t frame, uint32_t frameUs, uint32_t limitUs)
+{
+    char name[64], path[MAX_PATH];
+    snprintf(name, sizeof(name), "dxpipe_hitch_%llu.dxtrace", (unsigned long long)frame);
+    tracePath(path, name);
+    if (!g_Trace.snapshot(path, frame, frameUs, limitUs))
+        return false;
+    LOG_INFO(Hooks, "Hitch: frame {} took {} us (limit {} us), snapshot: {}", frame, frameUs, limitUs, path);
+    return true;
+}
+
+inline void traceBegin(TracePhase phase, uint32_t context)
+{
+    g_Trace.log(TraceEvent::Begin, uint32_t(phase), context);
+}
+
+inline void traceEnd(TracePhase phase, uint32_t context)
+{
+    g_Trace.log(TraceEvent::End, uint32_t(phase), context);
+}
+
+// bytes an export step moved on the GPU (the whole target, nothing when it was skipped)
+inline uint64_t exportedBytes(ExportResult result, ID3D11Texture2D *target)
+{
+    if (!target || (result != ExportResult::Copied && result != ExportResult::Recreated))
+        return 0;
+
+    D3D11_TEXTURE2D_DESC d{};
+    target->GetDesc(&d);
+    return uint64_t(formatSize(uint32_t(d.Format))) * d.Width * d.Height * d.SampleDesc.Count;
+}
@@ -0,0 +1,198 @@
+#pragma once
+
+// c++ includes
+#include <iostream>
+#include <atomic>
+
+// windows headers
+#define NOMINMAX // disable min/max macros
+#include <Windows.h>
+
+// directx 11 headers
+#include <d3d11.h>
+
+// weak registry + the state a destroyed resource is removed from
+#include "ResourceRegistry.h"
+#include "DepthCandidates.h"
+#include "DepthSnapshot.h"
+#include "LayerEvents.h"
+
+// structured log (g_Log, the LOG_ macros)
+#include "LayerLog.h"
+
+// helper decls (implemented in d3d11.cpp)
+extern ID3D11Device *g_Device;                        // the real device (weak)
+extern std::atomic<ID3D11Texture2D *> g_DepthTexture; // promoted depth texture (weak)
+extern std::atomic<ID3D11Texture2D *> g_DepthHeld;    // the layer's counted reference on it
+extern FrameTimeline g_FrameTimeline;
+extern DepthCandidates g_DepthCandidates;
+extern DepthSpanTracker g_DepthSpans;
+
+// every game object the layer remembers without owning
+extern ResourceRegistry g_Resources;
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// destruction notifications
+//  • a sentinel IUnknown is attached with SetPrivateDataInterface, d3d11 releases private
+//    data when the object is really destroyed (after the pipeline unbound it), the
+//    sentinel's last Release tells the registry
+//  • the registry clears the weak globals + the candidate table under its writer lock, on
+//    whatever thread the game released the object
+//  • g_DepthTexture itself is weak, AddRef on it could revive a texture whose last Release
+//    is already running: the layer's reference (g_DepthHeld) is taken from one of its
+//    views while the game binds / clears it (holdDepthFromView, ProxyDepth.h), Present
+//    only uses what is held (acquireDepthTexture)
+//  • the reference lasts one frame: Present drops it after its copies (releaseDepthHold),
+//    so a depth buffer the game let go of is destroyed at the latest one Present later,
+//    and a frame that never binds the promoted texture exports no depth
+///////////////////////////////////////////////////////////////////////////////////////////
+
+// {5D1F6A3E-4B7C-4E21-9A3F-6C1E8B207D44}
+static const GUID s_destructionSentinelGuid = {0x5d1f6a3e, 0x4b7c, 0x4e21, {0x9a, 0x3f, 0x6c, 0x1e, 0x8b, 0x20, 0x7d, 0x44}};
+
+// the object is gone, forget every weak pointer to it
+inline void onResourceDestroyed(const void *object)
+{
+    g_Resources.destroyed(object, [](const TrackedResource &r)
+                          {
+        switch (r.kind)
+        {
+        case TrackedKind::DepthCandidate:
+        {
+            // the span tracker belongs to the immediate context, depthExportSource resets it
+            ID3D11Texture2D *expected = static_cast<ID3D11Texture2D *>(const_cast<void *>(r.object));
+            g_DepthCandidates.removeTexture(r.object);
+            g_DepthTexture.compare_exchange_strong(expected, nullptr);
+            break;
+        }
+        case TrackedKind::Device:
+            if (r.object == g_Device)
+                g_Device = nullptr;
+            break;
+        default:
+            break;
+        }
+        if (r.holds)
+            LOG_WARN(Device, "Destroyed while held: {} {}", trackedKindName(r.kind), r.object);
+    });
+}
+
+class DestructionSentinel : public IUnknown
+{
+public:
+    explicit DestructionSentinel(const void *object) : m_object(object), m_ref(1) {}
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void **ppv) override
+    {
+        if (!ppv)
+            return E_POINTER;
+        if (riid == __uuidof(IUnknown))
+        {
+            *ppv = static_cast<IUnknown *>(this);
+            AddRef();
+            return S_OK;
+        }
+        *ppv = nullptr;
+        return E_NOINTERFACE;
+    }
+    ULONG STDMETHODCALLTYPE AddRef() override { return ++m_ref; }
+    ULONG STDMETHODCALLTYPE Release() override
+    {
+        ULONG c = --m_ref;
+        if (!c)
+        {
+            onResourceDestroyed(m_object);
+            delete this;
+        }
+        return c;
+    }
+
+private:
+    const void *m_object;
+    std::atomic<ULONG> m_ref;
+};
+
+// attach a sentinel to obj (ID3D11DeviceChild or ID3D11Device), once per object
+template <class T>
+inline void trackObject(T *obj, TrackedKind kind, uint32_t width, uint32_t height, uint64_t bytes)
+{
+    if (!obj || !g_Resources.track(obj, kind, width, height, bytes, g_FrameTimeline.frame()))
+        return;
+
+    DestructionSentinel *sentinel = new DestructionSentinel(obj);
+    HRESULT hr = obj->SetPrivateDataInterface(s_destructionSentinelGuid, sentinel);
+    sentinel->Release(); // the private data slot owns it now (or it is gone)
+    if (FAILED(hr))
+    {
+        // no notification would ever come, don't pretend to track it
+        g_Resources.destroyed(obj, [](const TrackedResource &) {});
+        LOG_ERROR(Device, "SetPrivateDataInterface failed for {} {}! HRESULT: {:x}", trackedKindName(kind), obj, hr);
+    }
+}
+
+inline void trackTexture(ID3D11Texture2D *tex, TrackedKind kind)
+{
+    if (!tex)
+        return;
+    D3D11_TEXTURE2D_DESC d{};
+    tex->GetDesc(&d);
+    uint64_t bytes = uint64_t(formatSize(uint32_t(d.Format))) * d.Width * d.Height * d.SampleDesc.Count * d.ArraySize;
+    trackObject(tex, kind, d.Width, d.Height, bytes);
+}
+
+inline void trackDevice(ID3D11Device *device)
+{
+    trackObject(device, TrackedKind::Device, 0, 0, 0);
+}
+
+// counted AddRef / Release on game objects the layer keeps (replaceGlobal)
+inline void holdResource(ID3D11Texture2D *tex)
+{
+    if (!tex)
+        return;
+    tex->AddRef();
+    g_Resources.hold(tex);
+}
+
+inline void dropResource(ID3D11Texture2D *tex)
+{
+    if (!tex)
+        return;
+    g_Resources.drop(tex);
+    tex->Release();
+}
+
+// drop the layer's reference on the depth texture (end of Present, demotion, ResizeBuffers,
+// the primary swap chain going away), the next bind / clear of the promoted one takes it again
+inline void releaseDepthHold()
+{
+    dropResource(g_DepthHeld.exchange(nullptr));
+}
+
+// this frame's depth texture, held until releaseDepthHold at the end of Present: nullptr
+// when the promoted one wasn't bound / cleared since the last Present
+inline ID3D11Texture2D *acquireDepthTexture()
+{
+    ID3D11Texture2D *held = g_DepthHeld.load(std::memory_order_acquire);
+    if (held && held != g_DepthTexture.load(std::memory_order_acquire))
+    {
+        releaseDepthHold(); // demoted, or taken by a context that raced the promotion
+        held = nullptr;
+    }
+    return held;
+}
+
+// game objects the layer still holds a reference to (device debug log)
+inline void reportHeldResources(const char *when)
+{
+    if (!LOG_ENABLED(Debug, Device))
+        return;
+    ResourceRegistryStats s = g_Resources.stats();
+    LOG_DEBUG(Device, "Resources ({}): {} tracked ({} MB), {} destroyed, {} held ({} MB)", when, s.live,
+              s.liveBytes >> 20, s.destroyed, s.held, s.heldBytes >> 20);
+    for (const TrackedResource &r : g_Resources.held())
+    {
+        LOG_DEBUG(Device, "  held: {} {} {}x{} {} KB, {} ref(s) since frame {}", trackedKindName(r.kind), r.object,
+                  r.width, r.height, r.bytes >> 10, r.holds, r.frame);
+    }
+}
@@ -0,0 +1,465 @@
+#pragma once
+
+// c++ includes
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <thread>
+
+// NOTE: platform independent, the destruction notifications come from ProxyTracking.h
+// (a private-data sentinel per resource)
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// weak resource registry
+//  • the layer remembers game resources (depth candidates, the back buffer, the device)
+//    without holding a reference, the game's final Release is what removes them
+//  • resources are created and destroyed on any thread (d3d11 devices are free-threaded),
+//    Present and the export path only read: lookups (alive / upgrade / hold / drop) take
+//    no lock, they run inside an epoch read section (EpochDomain)
+//  • writers (track / destroyed) serialize on a short lock, a destroyed entry is unlinked
+//    and only freed once every read section that might still see it has ended, so
+//    destroyed() returning means no reader touches the entry any more
+//  • that protects the registry, not the object: the notification comes after the
+//    object's count reached zero, an AddRef inside upgrade() can't revive a COM object,
+//    the layer takes its references from a live view instead (ProxyDepth.h)
+//  • references the layer does hold are counted (hold / drop), whatever is still held
+//    when it shouldn't be shows up in the leak report
+///////////////////////////////////////////////////////////////////////////////////////////
+
+enum class TrackedKind : uint8_t
+{
+    DepthCandidate,
+    BackBuffer,
+    Device,
+    Other
+};
+
+inline const char *trackedKindName(TrackedKind kind)
+{
+    switch (kind)
+    {
+    case TrackedKind::DepthCandidate:
+        return "depth candidate";
+    case TrackedKind::BackBuffer:
+        return "back buffer";
+    case TrackedKind::Device:
+        return "device";
+    default:
+        return "resource";
+    }
+}
+
+struct TrackedResource
+{
+    const void *object;
+    TrackedKind kind;
+    uint32_t width;
+    uint32_t height;
+    uint64_t bytes;     // estimated storage (0 for non-resources)
+    uint64_t frame;     // frame it was tracked at
+    uint32_t holds;     // references the layer holds (hold - drop)
+};
+
+struct ResourceRegistryStats
+{
+    uint64_t tracked;   // ever tracked
+    uint64_t destroyed; // destruction notifications
+    uint64_t live;      // currently tracked
+    uint64_t liveBytes;
+    uint64_t held;      // tracked resources the layer holds a reference to
+    uint64_t heldBytes;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// epoch read sections (process wide, shared by every registry)
+//  • a reading thread claims a record on first use and publishes the epoch it entered at,
+//    nested sections only count
+//  • synchronize() bumps the epoch and waits until no record is still inside a section
+//    entered before that, readers never wait
+//  • threads beyond the record count fall back to a shared lock synchronize() also takes
+///////////////////////////////////////////////////////////////////////////////////////////
+
+class EpochDomain
+{
+public:
+    static constexpr uint32_t Records = 64;
+
+    static EpochDomain &instance()
+    {
+        static EpochDomain s_domain;
+        return s_domain;
+    }
+
+    void enter()
+    {
+        Local &l = local();
+        if (l.depth++)
+            return;
+        if (l.record)
+            l.record->state.store((m_epoch.load() << 1) | 1); // before any read of the section
+        else
+            m_overflow.lock_shared();
+    }
+
+    void exit()
+    {
+        Local &l = local();
+        if (--l.depth)
+            return;
+        if (l.record)
+            l.record->state.store(0, std::memory_order_release);
+        else
+            m_overflow.unlock_shared();
+    }
+
+    // every read section that could have seen what the caller unlinked before has ended,
+    // the caller's own section (if any) is not waited for
+    void synchronize()
+    {
+        const uint64_t target = m_epoch.fetch_add(1) + 1;
+        const Local &self = local();
+        for (Record &r : m_records)
+        {
+            if (&r == self.record && self.depth)
+                continue;
+            for (uint32_t spins = 0;; spins++)
+            {
+                uint64_t state = r.state.load(); // seq_cst, pairs with the store in enter()
+                if (!(state & 1) || (state >> 1) >= target)
+                    break;
+                if (spins > 64)
+                    std::this_thread::yield();
+            }
+        }
+        if (self.record || !self.depth)
+        {
+            m_overflow.lock();
+            m_overflow.unlock();
+        }
+    }
+
+private:
+    struct alignas(64) Record
+    {
+        std::atomic<uint64_t> state{0}; // (epoch << 1) | inside
+        std::atomic<bool> owned{false};
+    };
+
+    struct Local
+    {
+        Record *record = nullptr;
+        uint32_t depth = 0;
+        bool claimed = false;
+
+        ~Local()
+        {
+            if (record)
+                record->owned.store(false, std::memory_order_release);
+        }
+    };
+
+    EpochDomain() = default;
+
+    Local &local()
+    {
+        thread_local Local t_local;
+        if (!t_local.claimed)
+        {
+            t_local.claimed = true;
+            for (Record &r : m_records)
+            {
+                bool expected = false;
+                if (!r.owned.load(std::memory_order_relaxed) && r.owned.compare_exchange_strong(expected, true))
+                {
+                    t_local.record = &r;
+                    break;
+                }
+            }
+        }
+        return t_local;
+    }
+
+    Record m_records[Records];
+    std::atomic<uint64_t> m_epoch{1};
+    std::shared_mutex m_overflow;
+};
+
+// scoped read section
+class EpochReadGuard
+{
+public:
+    EpochReadGuard() { EpochDomain::instance().enter(); }
+    ~EpochReadGuard() { EpochDomain::instance().exit(); }
+    EpochReadGuard(const EpochReadGuard &) = delete;
+    EpochReadGuard &operator=(const EpochReadGuard &) = delete;
+};
+
+class ResourceRegistry
+{
+public:
+    ResourceRegistry() : m_table(newTable(MinCapacity)) {}
+
+    ~ResourceRegistry()
+    {
+        Table *t = m_table.load();
+        for (uint32_t i = 0; i <= t->mask; i++)
+        {
+            Node *n = t->slots[i].load();
+            if (n && n != tombstone())
+                delete n;
+        }
+        delete t;
+    }
+
+    ResourceRegistry(const ResourceRegistry &) = delete;
+    ResourceRegistry &operator=(const ResourceRegistry &) = delete;
+
+    // start tracking, false if the object already is (the caller then skips the sentinel)
+    bool track(const void *object, TrackedKind kind, uint32_t width, uint32_t height, uint64_t bytes, uint64_t frame)
+    {
+        if (!object || alive(object)) // the common repeat (GetBuffer every frame) takes no lock
+            return false;
+
+        std::lock_guard<std::mutex> lock(m_write);
+        Table *t = m_table.load();
+        if (find(t, object))
+            return false;
+        if ((t->used + 1) * 2 > t->mask + 1)
+            t = grow(t);
+
+        Node *n = new Node();
+        n->info = {object, kind, width, height, bytes, frame, 0};
+        insert(t, n);
+        m_live.fetch_add(1, std::memory_order_relaxed);
+        m_tracked.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // the object is being destroyed, onDestroyed(const TrackedResource &) runs under the
+    // writer lock, after the return no reader holds its entry any more
+    template <class Fn>
+    void destroyed(const void *object, Fn onDestroyed)
+    {
+        Node *n = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(m_write);
+            Table *t = m_table.load();
+            uint32_t slot = 0;
+            n = find(t, object, &slot);
+            if (!n)
+                return;
+
+            // readers that load the node from here on see it gone
+            n->dead.store(true);
+            t->slots[slot].store(tombstone());
+
+            TrackedResource r = n->info;
+            r.holds = n->holds.load();
+            onDestroyed(r);
+            m_live.fetch_sub(1, std::memory_order_relaxed);
+            m_destroyed.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // wait out the readers that found it before (they only run their short upgrade)
+        EpochDomain::instance().synchronize();
+        delete n;
+    }
+
+    // run fn(object) while the object is still tracked, false if gone; its count may already
+    // have reached zero, fn may only take a reference that refuses a zero count
+    template <class Fn>
+    bool upgrade(const void *object, Fn fn) const
+    {
+        if (!object)
+            return false;
+        EpochReadGuard guard;
+        if (!find(m_table.load(), object))
+            return false;
+        fn(object);
+        return true;
+    }
+
+    bool alive(const void *object) const
+    {
+        if (!object)
+            return false;
+        EpochReadGuard guard;
+        return find(m_table.load(), object) != nullptr;
+    }
+
+    // the layer took / released a reference (untracked objects are ignored)
+    void hold(const void *object)
+    {
+        if (!object)
+            return;
+        EpochReadGuard guard;
+        if (Node *n = find(m_table.load(), object))
+            n->holds.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void drop(const void *object)
+    {
+        if (!object)
+            return;
+        EpochReadGuard guard;
+        if (Node *n = find(m_table.load(), object))
+        {
+            uint32_t holds = n->holds.load(std::memory_order_relaxed);
+            while (holds && !n->holds.compare_exchange_weak(holds, holds - 1, std::memory_order_relaxed))
+            {
+            }
+        }
+    }
+
+    // a consistent snapshot: the counters and the walk under the writer lock, so destroyed /
+    // live never run ahead of tracked (leak reports only, not a per-frame call)
+    ResourceRegistryStats stats() const
+    {
+        std::lock_guard<std::mutex> lock(m_write);
+        ResourceRegistryStats s = {m_tracked.load(std::memory_order_relaxed),
+                                   m_destroyed.load(std::memory_order_relaxed), 0, 0, 0, 0};
+        forEach([&](const TrackedResource &r)
+                {
+            s.live++;
+            s.liveBytes += r.bytes;
+            if (r.holds)
+            {
+                s.held++;
+                s.heldBytes += r.bytes;
+            } });
+        return s;
+    }
+
+    // the tracked resources the layer still holds references to
+    std::vector<TrackedResource> held() const
+    {
+        std::vector<TrackedResource> out;
+        forEach([&](const TrackedResource &r)
+                {
+            if (r.holds)
+                out.push_back(r); });
+        return out;
+    }
+
+private:
+    static constexpr uint32_t MinCapacity = 256;
+
+    struct Node
+    {
+        TrackedResource info = {};     // written once before the node is published
+        std::atomic<uint32_t> holds{0};
+        std::atomic<bool> dead{false};
+    };
+
+    // open addressing, linear probing, destroyed entries leave a tombstone until the
+    // next grow (the table is replaced, never resized in place)
+    struct Table
+    {
+        uint32_t mask;
+        uint32_t used; // live + tombstones, writer only
+        std::unique_ptr<std::atomic<Node *>[]> slots;
+    };
+
+    static Node *tombstone()
+    {
+        static Node s_tombstone;
+        return &s_tombstone;
+    }
+
+    static uint32_t hash(const void *object)
+    {
+        return uint32_t((uint64_t(reinterpret_cast<uintptr_t>(object)) * 0x9E3779B97F4A7C15ull) >> 32);
+    }
+
+    static Table *newTable(uint32_t capacity)
+    {
+        Table *t = new Table();
+        t->mask = capacity - 1;
+        t->used = 0;
+        t->slots.reset(new std::atomic<Node *>[capacity]);
+        for (uint32_t i = 0; i < capacity; i++)
+            t->slots[i].store(nullptr, std::memory_order_relaxed);
+        return t;
+    }
+
+    // live node of object (readers: inside a read section, writers: under m_write)
+    static Node *find(const Table *t, const void *object, uint32_t *slot = nullptr)
+    {
+        for (uint32_t i = hash(object) & t->mask, probes = 0; probes <= t->mask; i = (i + 1) & t->mask, probes++)
+        {
+            Node *n = t->slots[i].load();
+            if (!n)
+                return nullptr;
+            if (n != tombstone() && n->info.object == object && !n->dead.load())
+            {
+                if (slot)
+                    *slot = i;
+                return n;
+            }
+        }
+        return nullptr;
+    }
+
+    // writer only, the object isn't in t
+    static void insert(Table *t, Node *n)
+    {
+        for (uint32_t i = hash(n->info.object) & t->mask;; i = (i + 1) & t->mask)
+        {
+            Node *cur = t->slots[i].load(std::memory_order_relaxed);
+            if (!cur || cur == tombstone())
+            {
+                if (!cur)
+                    t->used++;
+                t->slots[i].store(n); // publishes the node's fields
+                return;
+            }
+        }
+    }
+
+    // writer only: a bigger table without the tombstones, the old one is freed once no
+    // reader can still be probing it
+    Table *grow(Table *old)
+    {
+        uint32_t live = uint32_t(m_live.load(std::memory_order_relaxed));
+        uint32_t capacity = MinCapacity;
+        while (capacity < (live + 1) * 4)
+            capacity *= 2;
+
+        Table *t = newTable(capacity);
+        for (uint32_t i = 0; i <= old->mask; i++)
+        {
+            Node *n = old->slots[i].load(std::memory_order_relaxed);
+            if (n && n != tombstone())
+                insert(t, n);
+        }
+        m_table.store(t);
+        EpochDomain::instance().synchronize();
+        delete old;
+        return t;
+    }
+
+    template <class Fn>
+    void forEach(Fn fn) const
+    {
+        EpochReadGuard guard;
+        const Table *t = m_table.load();
+        for (uint32_t i = 0; i <= t->mask; i++)
+        {
+            Node *n = t->slots[i].load();
+            if (!n || n == tombstone() || n->dead.load())
+                continue;
+            TrackedResource r = n->info;
+            r.holds = n->holds.load(std::memory_order_relaxed);
+            fn(r);
+        }
+    }
+
+    std::atomic<Table *> m_table;
+    mutable std::mutex m_write; // stats() counts under it
+    std::atomic<uint64_t> m_live{0};
+    std::atomic<uint64_t> m_tracked{0};
+    std::atomic<uint64_t> m_destroyed{0};
+};
@@ -0,0 +1,622 @@
+#pragma once
+
+// c++ includes
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <unordered_map>
+
+// layer headers (platform independent)
+#include "LayerTypes.h"
+#include "DepthResolve.h"
+#include "MotionVectors.h"
+
+// NOTE: platform independent, no GPU or d3d11 runtime needed (builds on Linux)
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// software reference device
+//  • the d3d11 / dxgi subset ProxySwapChain::Present exercises, in system memory
+//  • CreateTexture2D, GetDesc, CopyResource, CopySubresourceRegion, Map / Unmap,
+//    shared handles (GetSharedHandle / OpenSharedResource) and a swap chain with
+//    GetBuffer / ResizeBuffers / Present
+//  • ResolveDepth / MotionVectors stand in for the depth resolve and camera motion
+//    compute dispatches
+//  • method and desc field names mirror d3d11, so template code runs on both
+//  • copies are real memcpy over real sized storage, the bandwidth is representative
+//  • storage is zero filled and nothing depends on time, runs are deterministic
+//  • single threaded, like the immediate context it stands in for
+///////////////////////////////////////////////////////////////////////////////////////////
+
+typedef int32_t SoftResult;
+static const SoftResult SOFT_OK = 0;
+static const SoftResult SOFT_E_INVALIDARG = int32_t(0x80070057);
+static const SoftResult SOFT_E_OUTOFMEMORY = int32_t(0x8007000E);
+static const SoftResult SOFT_E_INVALID_CALL = int32_t(0x887A0001); // DXGI_ERROR_INVALID_CALL
+
+inline bool softSucceeded(SoftResult r) { return r >= 0; }
+
+struct SoftSampleDesc
+{
+    uint32_t Count;
+    uint32_t Quality;
+};
+
+// mirrors D3D11_TEXTURE2D_DESC
+struct SoftTextureDesc
+{
+    uint32_t Width;
+    uint32_t Height;
+    uint32_t MipLevels;
+    uint32_t ArraySize;
+    uint32_t Format;
+    SoftSampleDesc SampleDesc;
+    uint32_t Usage;
+    uint32_t BindFlags;
+    uint32_t CPUAccessFlags;
+    uint32_t MiscFlags;
+};
+
+// mirrors D3D11_SUBRESOURCE_DATA
+struct SoftSubresourceData
+{
+    const void *pSysMem;
+    uint32_t SysMemPitch;
+    uint32_t SysMemSlicePitch;
+};
+
+// mirrors D3D11_MAPPED_SUBRESOURCE
+struct SoftMappedSubresource
+{
+    void *pData;
+    uint32_t RowPitch;
+    uint32_t DepthPitch;
+};
+
+// mirrors D3D11_BOX
+struct SoftBox
+{
+    uint32_t left;
+    uint32_t top;
+    uint32_t front;
+    uint32_t right;
+    uint32_t bottom;
+    uint32_t back;
+};
+
+// what the device did, for benchmarks (calls ~ COM calls through the runtime)
+struct SoftDeviceStats
+{
+    uint64_t calls;         // every device / context / swap chain entry point
+    uint64_t creates;       // textures created
+    uint64_t copies;        // CopyResource + CopySubresourceRegion
+    uint64_t bytesCopied;   // bytes moved by copies
+    uint64_t maps;          // successful Map calls
+    uint64_t dispatches;    // compute passes (ResolveDepth, MotionVectors)
+    uint64_t errors;        // calls that failed or were dropped (d3d11 would warn)
+    uint64_t liveTextures;  // textures currently alive
+    uint64_t liveBytes;     // storage currently allocated
+};
+
+class SoftDevice;
+
+class SoftTexture2D
+{
+public:
+    uint32_t AddRef() { return ++m_ref; }
+    uint32_t Release();
+
+    void GetDesc(SoftTextureDesc *desc) const { *desc = m_desc; }
+
+    // raw access for tools (d3d11 has no equivalent, a shader would read it)
+    uint8_t *data(uint32_t sub = 0) { return m_storage + m_offsets[sub]; }
+    uint32_t rowPitch(uint32_t sub = 0) const { return mipWidth(sub) * m_texel; }
+    uint32_t rows(uint32_t sub = 0) const { return mipHeight(sub); }
+    uint64_t size() const { return m_size; }
+    uint32_t subresources() const { return m_desc.MipLevels * m_desc.ArraySize; }
+    SoftDevice *device() const { return m_device; }
+
+private:
+    friend class SoftDevice;
+    friend class SoftContext;
+    friend class SoftSwapChain;
+
+    SoftTexture2D(SoftDevice *device, const SoftTextureDesc &desc) : m_device(device), m_desc(desc) {}
+    ~SoftTexture2D()
+    {
+        std::free(m_storage);
+        delete[] m_offsets;
+    }
+
+    uint32_t mipWidth(uint32_t sub) const
+    {
+        uint32_t w = m_desc.Width >> (sub % m_desc.MipLevels);
+        return w ? w : 1;
+    }
+    uint32_t mipHeight(uint32_t sub) const
+    {
+        uint32_t h = m_desc.Height >> (sub % m_desc.MipLevels);
+        return h ? h : 1;
+    }
+
+    // one allocation for every subresource (mip + slice * MipLevels, like d3d11),
+    // msaa textures keep all samples of a texel together
+    bool allocate()
+    {
+        m_texel = formatSize(m_desc.Format) * m_desc.SampleDesc.Count;
+        uint32_t n = subresources();
+        m_offsets = new uint64_t[n];
+        m_size = 0;
+        for (uint32_t s = 0; s < n; s++)
+        {
+            m_offsets[s] = m_size;
+            m_size += uint64_t(rowPitch(s)) * rows(s);
+        }
+        m_storage = static_cast<uint8_t *>(std::calloc(size_t(m_size), 1));
+        return m_storage != nullptr;
+    }
+
+    SoftDevice *m_device;
+    SoftTextureDesc m_desc;
+    std::atomic<uint32_t> m_ref{1};
+    uint8_t *m_storage = nullptr;
+    uint64_t *m_offsets = nullptr;
+    uint64_t m_size = 0;
+    uint32_t m_texel = 0;
+    uint64_t m_sharedHandle = 0;
+    bool m_mapped = false;
+};
+
+class SoftContext
+{
+public:
+    // lives as long as its device, the count only keeps AddRef / Release balanced
+    uint32_t AddRef() { return ++m_ref; }
+    uint32_t Release() { return --m_ref; }
+
+    void CopyResource(SoftTexture2D *dst, SoftTexture2D *src);
+    void CopySubresourceRegion(SoftTexture2D *dst, uint32_t dstSub, uint32_t x, uint32_t y, uint32_t z,
+                               SoftTexture2D *src, uint32_t srcSub, const SoftBox *box);
+    SoftResult Map(SoftTexture2D *tex, uint32_t sub, uint32_t type, uint32_t flags, SoftMappedSubresource *mapped);
+    void Unmap(SoftTexture2D *tex, uint32_t sub);
+
+    // the resolve compute pass: src (depth format, any sample count) → dst (R32F, 1 sample, UAV)
+    void ResolveDepth(SoftTexture2D *dst, SoftTexture2D *src, DepthResolveMode mode);
+
+    // the camera motion compute pass: src (depth, 1 sample) → dst (R16G16F, half size, UAV)
+    void MotionVectors(SoftTexture2D *dst, SoftTexture2D *src, const MotionParams &params);
+
+private:
+    friend class SoftDevice;
+    explicit SoftContext(SoftDevice *device) : m_device(device) {}
+
+    SoftDevice *m_device;
+    std::atomic<uint32_t> m_ref{1};
+};
+
+class SoftDevice
+{
+public:
+    SoftDevice() : m_context(this) {}
+
+    uint32_t AddRef() { return ++m_ref; }
+    uint32_t Release()
+    {
+        uint32_t r = --m_ref;
+        if (!r)
+            delete this;
+        return r;
+    }
+
+    SoftResult CreateTexture2D(const SoftTextureDesc *desc, const SoftSubresourceData *init, SoftTexture2D **out)
+    {
+        m_stats.calls++;
+        if (!desc || !out || !desc->Width || !desc->Height || !desc->ArraySize ||
+            !desc->SampleDesc.Count || !formatSize(desc->Format))
+            return fail(SOFT_E_INVALIDARG);
+        if (desc->Usage == USAGE_STAGING && (desc->BindFlags || desc->SampleDesc.Count > 1))
+            return fail(SOFT_E_INVALIDARG);
+        if ((desc->CPUAccessFlags & CPU_ACCESS_READ) && desc->Usage != USAGE_STAGING)
+            return fail(SOFT_E_INVALIDARG);
+
+        // MipLevels 0 means the full chain
+        SoftTextureDesc d = *desc;
+        if (!d.MipLevels)
+        {
+            uint32_t big = d.Width > d.Height ? d.Width : d.Height;
+            while (big >> d.MipLevels)
+                d.MipLevels++;
+        }
+
+        SoftTexture2D *tex = new SoftTexture2D(this, d);
+        if (!tex->allocate())
+        {
+            delete tex;
+            return fail(SOFT_E_OUTOFMEMORY);
+        }
+
+        if (init)
+        {
+            for (uint32_t s = 0; s < tex->subresources(); s++)
+            {
+                const uint8_t *srcRow = static_cast<const uint8_t *>(init[s].pSysMem);
+                for (uint32_t r = 0; srcRow && r < tex->rows(s); r++)
+                    memcpy(tex->data(s) + uint64_t(r) * tex->rowPitch(s),
+                           srcRow + uint64_t(r) * init[s].SysMemPitch, tex->rowPitch(s));
+            }
+        }
+
+        AddRef(); // textures keep their device alive, like d3d11
+        m_stats.creates++;
+        m_stats.liveTextures++;
+        m_stats.liveBytes += tex->size();
+        *out = tex;
+        return SOFT_OK;
+    }
+
+    void GetImmediateContext(SoftContext **ctx)
+    {
+        m_stats.calls++;
+        m_context.AddRef();
+        *ctx = &m_context;
+    }
+
+    // IDXGIResource::GetSharedHandle, only for MISC_SHARED textures
+    SoftResult GetSharedHandle(SoftTexture2D *tex, uint64_t *handle)
+    {
+        m_stats.calls++;
+        if (!tex || !handle || !(tex->m_desc.MiscFlags & MISC_SHARED))
+            return fail(SOFT_E_INVALIDARG);
+        if (!tex->m_sharedHandle)
+        {
+            tex->m_sharedHandle = m_nextHandle++;
+            m_shared[tex->m_sharedHandle] = tex;
+        }
+        *handle = tex->m_sharedHandle;
+        return SOFT_OK;
+    }
+
+    // ID3D11Device::OpenSharedResource (the client side of the export)
+    SoftResult OpenSharedResource(uint64_t handle, SoftTexture2D **out)
+    {
+        m_stats.calls++;
+        auto it = m_shared.find(handle);
+        if (!out || it == m_shared.end())
+            return fail(SOFT_E_INVALIDARG);
+        it->second->AddRef();
+        *out = it->second;
+        return SOFT_OK;
+    }
+
+    const SoftDeviceStats &stats() const { return m_stats; }
+    void resetCounters()
+    {
+        uint64_t live = m_stats.liveTextures, bytes = m_stats.liveBytes;
+        m_stats = {};
+        m_stats.liveTextures = live;
+        m_stats.liveBytes = bytes;
+    }
+
+private:
+    friend class SoftTexture2D;
+    friend class SoftContext;
+    friend class SoftSwapChain;
+
+    ~SoftDevice() = default;
+
+    SoftResult fail(SoftResult r)
+    {
+        m_stats.errors++;
+        return r;
+    }
+
+    void destroy(SoftTexture2D *tex)
+    {
+        if (tex->m_sharedHandle)
+            m_shared.erase(tex->m_sharedHandle);
+        m_stats.liveTextures--;
+        m_stats.liveBytes -= tex->size();
+        delete tex;
+        Release();
+    }
+
+    std::atomic<uint32_t> m_ref{1};
+    SoftContext m_context;
+    SoftDeviceStats m_stats = {};
+    std::unordered_map<uint64_t, SoftTexture2D *> m_shared;
+    uint64_t m_nextHandle = 0x40000002; // looks like a kernel handle, never 0
+};
+
+inline uint32_t SoftTexture2D::Release()
+{
+    uint32_t r = --m_ref;
+    if (!r)
+        m_device->destroy(this);
+    return r;
+}
+
+// same subresource count / size / texel size, d3d11 additionally wants the same format group
+// (only told apart between two depth families: a D24S8 buffer doesn't copy into R32)
+inline bool softCopyCompatible(const SoftTextureDesc &a, const SoftTextureDesc &b)
+{
+    uint32_t fa = depthTypelessFormat(a.Format), fb = depthTypelessFormat(b.Format);
+    return a.Width == b.Width && a.Height == b.Height &&
+           a.MipLevels == b.MipLevels && a.ArraySize == b.ArraySize &&
+           a.SampleDesc.Count == b.SampleDesc.Count &&
+           formatSize(a.Format) == formatSize(b.Format) &&
+           (fa == FMT_UNKNOWN || fb == FMT_UNKNOWN || fa == fb);
+}
+
+inline void SoftContext::CopyResource(SoftTexture2D *dst, SoftTexture2D *src)
+{
+    SoftDeviceStats &st = m_device->m_stats;
+    st.calls++;
+    if (!dst || !src || dst == src || dst->m_mapped || src->m_mapped ||
+        dst->m_desc.Usage == USAGE_IMMUTABLE || !softCopyCompatible(dst->m_desc, src->m_desc))
+    {
+        st.errors++;
+        return;
+    }
+
+    memcpy(dst->m_storage, src->m_storage, size_t(src->m_size));
+    st.copies++;
+    st.bytesCopied += src->m_size;
+}
+
+inline void SoftContext::CopySubresourceRegion(SoftTexture2D *dst, uint32_t dstSub, uint32_t x, uint32_t y, uint32_t z,
+                                               SoftTexture2D *src, uint32_t srcSub, const SoftBox *box)
+{
+    SoftDeviceStats &st = m_device->m_stats;
+    st.calls++;
+    if (!dst || !src || z || dstSub >= dst->subresources() || srcSub >= src->subresources() ||
+        dst->m_texel != src->m_texel || dst->m_mapped || src->m_mapped)
+    {
+        st.errors++;
+        return;
+    }
+
+    SoftBox b = box ? *box : SoftBox{0, 0, 0, src->mipWidth(srcSub), src->mipHeight(srcSub), 1};
+    if (b.right > src->mipWidth(srcSub) || b.bottom > src->mipHeight(srcSub) ||
+        b.left >= b.right || b.top >= b.bottom ||
+        x + (b.right - b.left) > dst->mipWidth(dstSub) || y + (b.bottom - b.top) > dst->mipHeight(dstSub))
+    {
+        st.errors++;
+        return;
+    }
+
+    uint32_t rowBytes = (b.right - b.left) * src->m_texel;
+    uint8_t *d = dst->data(dstSub) + uint64_t(y) * dst->rowPitch(dstSub) + uint64_t(x) * dst->m_texel;
+    const uint8_t *s = src->data(srcSub) + uint64_t(b.top) * src->rowPitch(srcSub) + uint64_t(b.left) * src->m_texel;
+    for (uint32_t r = b.top; r < b.bottom; r++)
+    {
+        memcpy(d, s, rowBytes);
+        d += dst->rowPitch(dstSub);
+        s += src->rowPitch(srcSub);
+    }
+    st.copies++;
+    st.bytesCopied += uint64_t(rowBytes) * (b.bottom - b.top);
+}
+
+inline SoftResult SoftContext::Map(SoftTexture2D *tex, uint32_t sub, uint32_t type, uint32_t flags,
+                                   SoftMappedSubresource *mapped)
+{
+    (void)flags;
+    SoftDeviceStats &st = m_device->m_stats;
+    st.calls++;
+    if (!tex || !mapped || sub >= tex->subresources() || tex->m_mapped)
+        return m_device->fail(SOFT_E_INVALIDARG);
+
+    // the same access rules d3d11 enforces
+    bool read = type == MAP_READ || type == MAP_READ_WRITE;
+    bool write = type != MAP_READ;
+    uint32_t access = tex->m_desc.CPUAccessFlags;
+    if ((read && !(access & CPU_ACCESS_READ)) || (write && !(access & CPU_ACCESS_WRITE)) ||
+        (tex->m_desc.Usage != USAGE_STAGING && tex->m_desc.Usage != USAGE_DYNAMIC))
+        return m_device->fail(SOFT_E_INVALIDARG);
+
+    tex->m_mapped = true;
+    mapped->pData = tex->data(sub);
+    mapped->RowPitch = tex->rowPitch(sub);
+    mapped->DepthPitch = tex->rowPitch(sub) * tex->rows(sub);
+    st.maps++;
+    return SOFT_OK;
+}
+
+inline void SoftContext::Unmap(SoftTexture2D *tex, uint32_t sub)
+{
+    m_device->m_stats.calls++;
+    if (!tex || sub >= tex->subresources() || !tex->m_mapped)
+    {
+        m_device->m_stats.errors++;
+        return;
+    }
+    tex->m_mapped = false;
+}
+
+inline void SoftContext::ResolveDepth(SoftTexture2D *dst, SoftTexture2D *src, DepthResolveMode mode)
+{
+    SoftDeviceStats &st = m_device->m_stats;
+    st.calls++;
+    if (!dst || !src || dst->m_mapped || src->m_mapped || !depthTypelessFormat(src->m_desc.Format) ||
+        dst->m_desc.Format != FMT_R32_FLOAT || dst->m_desc.SampleDesc.Count != 1 ||
+        !(dst->m_desc.BindFlags & BIND_UNORDERED_ACCESS) ||
+        dst->m_desc.Width != src->m_desc.Width || dst->m_desc.Height != src->m_desc.Height)
+    {
+        st.errors++;
+        return;
+    }
+
+    resolveDepthCPU(src->data(0), src->rowPitch(0), src->m_desc.Format, src->m_desc.SampleDesc.Count,
+                    src->m_desc.Width, src->m_desc.Height, mode, dst->data(0), dst->rowPitch(0));
+    st.dispatches++;
+}
+
+inline void SoftContext::MotionVectors(SoftTexture2D *dst, SoftTexture2D *src, const MotionParams &params)
+{
+    SoftDeviceStats &st = m_device->m_stats;
+    st.calls++;
+    if (!dst || !src || dst->m_mapped || src->m_mapped || !depthTypelessFormat(src->m_desc.Format) ||
+        src->m_desc.SampleDesc.Count != 1 || dst->m_desc.Format != FMT_R16G16_FLOAT ||
+        !(dst->m_desc.BindFlags & BIND_UNORDERED_ACCESS) ||
+        dst->m_desc.Width != motionExtent(src->m_desc.Width) || dst->m_desc.Height != motionExtent(src->m_desc.Height))
+    {
+        st.errors++;
+        return;
+    }
+
+    motionVectorsCPU(src->data(0), src->rowPitch(0), src->m_desc.Format, src->m_desc.Width, src->m_desc.Height,
+                     params, dst->data(0), dst->rowPitch(0));
+    st.dispatches++;
+}
+
+// mirrors DXGI_SWAP_CHAIN_DESC (the fields the layer looks at)
+struct SoftSwapChainDesc
+{
+    uint32_t Width;
+    uint32_t Height;
+    uint32_t Format;
+    uint32_t BufferCount;
+};
+
+// swap chain with a single application visible back buffer (buffer 0), like the
+// DXGI_SWAP_EFFECT_DISCARD chains the game creates
+class SoftSwapChain
+{
+public:
+    SoftSwapChain(SoftDevice *device, const SoftSwapChainDesc &desc) : m_device(device), m_desc(desc)
+    {
+        m_device->AddRef();
+        createBuffer();
+    }
+    ~SoftSwapChain()
+    {
+        if (m_buffer)
+            m_buffer->Release();
+        m_device->Release();
+    }
+
+    SoftSwapChain(const SoftSwapChain &) = delete;
+    SoftSwapChain &operator=(const SoftSwapChain &) = delete;
+
+    SoftResult GetBuffer(uint32_t index, SoftTexture2D **out)
+    {
+        m_device->m_stats.calls++;
+        if (index || !out || !m_buffer)
+            return m_device->fail(SOFT_E_INVALIDARG);
+        m_buffer->AddRef();
+        *out = m_buffer;
+        return SOFT_OK;
+    }
+
+    // like dxgi, fails while anyone still holds a back buffer reference
+    SoftResult ResizeBuffers(uint32_t count, uint32_t w, uint32_t h, uint32_t fmt, uint32_t flags)
+    {
+        (void)flags;
+        m_device->m_stats.calls++;
+        if (m_buffer && m_buffer->m_ref.load() != 1)
+            return m_device->fail(SOFT_E_INVALID_CALL);
+
+        // zero keeps the current value
+        if (count)
+            m_desc.BufferCount = count;
+        if (w)
+            m_desc.Width = w;
+        if (h)
+            m_desc.Height = h;
+        if (fmt)
+            m_desc.Format = fmt;
+
+        if (m_buffer)
+            m_buffer->Release();
+        m_buffer = nullptr;
+        return createBuffer();
+    }
+
+    SoftResult Present(uint32_t syncInterval, uint32_t flags)
+    {
+        (void)syncInterval;
+        (void)flags;
+        m_device->m_stats.calls++;
+        m_presents++;
+        return SOFT_OK;
+    }
+
+    void GetDesc(SoftSwapChainDesc *desc) const { *desc = m_desc; }
+    uint64_t GetLastPresentCount() const { return m_presents; }
+
+private:
+    SoftResult createBuffer()
+    {
+        SoftTextureDesc d = {};
+        d.Width = m_desc.Width;
+        d.Height = m_desc.Height;
+        d.MipLevels = 1;
+        d.ArraySize = 1;
+        d.Format = m_desc.Format;
+        d.SampleDesc.Count = 1;
+        d.Usage = USAGE_DEFAULT;
+        d.BindFlags = BIND_RENDER_TARGET | BIND_SHADER_RESOURCE;
+        return m_device->CreateTexture2D(&d, nullptr, &m_buffer);
+    }
+
+    SoftDevice *m_device;
+    SoftSwapChainDesc m_desc;
+    SoftTexture2D *m_buffer = nullptr;
+    uint64_t m_presents = 0;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// FrameExport.h backend
+///////////////////////////////////////////////////////////////////////////////////////////
+
+struct SoftApi
+{
+    using Device = SoftDevice;
+    using Context = SoftContext;
+    using Texture = SoftTexture2D;
+    using Desc = SoftTextureDesc;
+    using Format = uint32_t;
+    using Handle = uint64_t;
+
+    static constexpr uint32_t UsageDefault = USAGE_DEFAULT;
+    static constexpr uint32_t UsageStaging = USAGE_STAGING;
+    static constexpr uint32_t BindShaderResource = BIND_SHADER_RESOURCE;
+    static constexpr uint32_t BindUnorderedAccess = BIND_UNORDERED_ACCESS;
+    static constexpr uint32_t FormatR32Float = FMT_R32_FLOAT;
+    static constexpr uint32_t FormatR16G16Float = FMT_R16G16_FLOAT;
+    static constexpr uint32_t CpuAccessRead = CPU_ACCESS_READ;
+    static constexpr uint32_t MiscShared = MISC_SHARED;
+    static constexpr uint64_t NullHandle = 0;
+
+    static bool ok(SoftResult r) { return softSucceeded(r); }
+
+    static void release(SoftTexture2D *&tex)
+    {
+        if (tex)
+            tex->Release();
+        tex = nullptr;
+    }
+
+    static bool sharedHandle(SoftTexture2D *tex, uint64_t &handle)
+    {
+        return softSucceeded(tex->device()->GetSharedHandle(tex, &handle));
+    }
+
+    static bool resolveDepth(SoftDevice *device, SoftContext *ctx, SoftTexture2D *src, SoftTexture2D *dst, DepthResolveMode mode)
+    {
+        if (!device || !ctx)
+            return false;
+        uint64_t errors = device->stats().errors;
+        ctx->ResolveDepth(dst, src, mode);
+        return device->stats().errors == errors;
+    }
+
+    static bool motionVectors(SoftDevice *device, SoftContext *ctx, SoftTexture2D *depth, SoftTexture2D *dst, const MotionParams &params)
+    {
+        if (!device || !ctx)
+            return false;
+        uint64_t errors = device->stats().errors;
+        ctx->MotionVectors(dst, depth, params);
+        return device->stats().errors == errors;
+    }
+};
@@ -0,0 +1,362 @@
+#pragma once
+
+// c++ includes
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+#include <type_traits>
+
+// stage ids / names (TracePhase), frame time windows, API call ids, input ages, display
+#include "TraceLog.h"
+#include "FrameHistogram.h"
+#include "ApiCensus.h"
+#include "InputLatency.h"
+#include "DisplayTiming.h"
+
+// NOTE: platform independent, shared by the layer (writer, ProxyStats.h) and
+// tools/dxpipe_stat (reader), the layout is the contract between them
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// live statistics page
+//  "Local\dxpipe_stats" (windows) / "/dxpipe_stats" (posix shm) – one StatsPage
+//  • the layer publishes once per primary Present, every field is an atomic store, the
+//    whole update is bracketed by a sequence number (odd while writing) so a reader
+//    retries instead of seeing half a frame (release stores / acquire loads, no fences:
+//    plain moves on x86)
+//  • readers check magic / version / size, a new layout bumps STATS_VERSION
+//  • values are the primary's frame: frame times per FrameWindow (1 s, 10 s, 60 s, as of
+//    the histogram's last summary, input ages and display latencies the same way), stage
+//    costs smoothed over ~16 frames, API calls of the last frame (every thread,
+//    ApiCensus.h), the display as of the last frame that reached the screen, everything
+//    else as of this frame
+///////////////////////////////////////////////////////////////////////////////////////////
+
+static const uint32_t STATS_MAGIC = 0x54535844; // "DXST"
+static const uint32_t STATS_VERSION = 5;
+static const uint32_t STATS_STAGES = uint32_t(TracePhase::Count);
+static const char *const STATS_NAME = "dxpipe_stats";
+
+struct StatsPage
+{
+    // written once, before the first update (this header never changes between versions)
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;   // sizeof(StatsPage)
+    uint32_t pid;    // the game
+    uint32_t stages; // STATS_STAGES (TracePhase order)
+    std::atomic<uint32_t> sequence; // 0 = nothing published yet, odd = update in progress
+
+    std::atomic<uint64_t> frame;
+    std::atomic<uint64_t> uptimeNs; // steady clock since the page was created
+
+    // Present to Present of the primary (FrameHistogram.h), per FrameWindow
+    FrameTimeFields frameTimes[FRAME_WINDOWS];
+    std::atomic<uint64_t> hitches; // since the first Present
+    std::atomic<uint32_t> resizes; // ResizeBuffers calls
+
+    // age of the oldest input at the primary's Present (InputLatency.h), per FrameWindow
+    // (frames = frames that had input)
+    FrameTimeFields inputAge[FRAME_WINDOWS];
+    std::atomic<uint32_t> inputAgeUs;          // this frame, 0 = no input
+    std::atomic<uint64_t> inputs[INPUT_KINDS]; // messages since the window was hooked
+
+    // the primary's frames on screen (DisplayTiming.h), latencies per FrameWindow (frames =
+    // frames shown / shown with input)
+    FrameTimeFields displayLatency[FRAME_WINDOWS]; // real Present to vblank
+    FrameTimeFields inputToDisplay[FRAME_WINDOWS]; // input age at Present + the above
+    std::atomic<uint64_t> displayFrame;            // the last frame shown, 0 = none yet
+    std::atomic<uint32_t> displayLatencyUs;        // its present to display
+    std::atomic<uint32_t> displayQueued;           // Presents queued ahead of this frame
+    std::atomic<uint32_t> refreshUs;               // measured vblank period, 0 = unknown
+    std::atomic<uint64_t> framesShown;             // since the first Present
+    std::atomic<uint64_t> framesUnseen;            // left the queue between two samples
+    std::atomic<uint64_t> missedVblanks;
+
+    // layer cost per Present stage, ns per frame (GPU 0 = no GPU work / not measured yet)
+    std::atomic<uint64_t> cpuNs[STATS_STAGES];
+    std::atomic<uint64_t> gpuNs[STATS_STAGES];
+
+    std::atomic<uint64_t> bytesCopied;      // by the exports, last frame (all contexts)
+    std::atomic<uint64_t> bytesCopiedTotal; // since the page was created
+    std::atomic<uint64_t> droppedFrames;    // frames a found client got no colour export for
+    std::atomic<uint32_t> streams;          // shared textures exported (all contexts)
+    std::atomic<uint32_t> consumers;        // contexts whose client was found
+
+    // depth exported this frame (0 x 0 = none)
+    std::atomic<uint32_t> depthWidth;
+    std::atomic<uint32_t> depthHeight;
+    std::atomic<uint32_t> depthFormat;
+    std::atomic<uint32_t> depthSamples;
+
+    // the game's calls in the last frame per ApiCall / bytes per ApiBytes (0 with the census off)
+    std::atomic<uint32_t> apiCalls[CENSUS_CALLS];
+    std::atomic<uint64_t> apiBytes[CENSUS_BYTES];
+};
+
+static_assert(std::is_standard_layout<StatsPage>::value, "shared between processes");
+static_assert(sizeof(std::atomic<uint64_t>) == 8 && sizeof(std::atomic<uint32_t>) == 4, "plain layout");
+
+// one consistent copy of the page (reader side)
+struct StatsSnapshot
+{
+    uint32_t pid;
+    uint64_t frame;
+    uint64_t uptimeNs;
+    FrameTimeSummary frameTimes[FRAME_WINDOWS];
+    uint64_t hitches;
+    uint32_t resizes;
+    FrameTimeSummary inputAge[FRAME_WINDOWS];
+    uint32_t inputAgeUs;
+    uint64_t inputs[INPUT_KINDS];
+    FrameTimeSummary displayLatency[FRAME_WINDOWS];
+    FrameTimeSummary inputToDisplay[FRAME_WINDOWS];
+    uint64_t displayFrame;
+    uint32_t displayLatencyUs;
+    uint32_t displayQueued;
+    uint32_t refreshUs;
+    uint64_t framesShown;
+    uint64_t framesUnseen;
+    uint64_t missedVblanks;
+    uint64_t cpuNs[STATS_STAGES];
+    uint64_t gpuNs[STATS_STAGES];
+    uint64_t bytesCopied, bytesCopiedTotal, droppedFrames;
+    uint32_t streams, consumers;
+    uint32_t depthWidth, depthHeight, depthFormat, depthSamples;
+    CensusFrame census;
+};
+
+enum class StatsRead
+{
+    Ok,
+    Empty,   // no layer wrote the page yet
+    Version, // different layout
+    Busy     // the writer kept updating while we read (try again)
+};
+
+inline StatsRead readStats(const StatsPage &page, StatsSnapshot &out)
+{
+    // the header was written before the first update was released
+    if (!page.sequence.load(std::memory_order_acquire) || page.magic != STATS_MAGIC)
+        return StatsRead::Empty;
+    if (page.version != STATS_VERSION || page.size != sizeof(StatsPage) || page.stages != STATS_STAGES)
+        return StatsRead::Version;
+
+    for (int attempt = 0; attempt < 64; attempt++)
+    {
+        uint32_t begin = page.sequence.load(std::memory_order_acquire);
+        if (begin & 1)
+            continue;
+
+        // a value from a later update carries its odd sequence number with it
+        const auto r = std::memory_order_acquire;
+        out.pid = page.pid;
+        out.frame = page.frame.load(r);
+        out.uptimeNs = page.uptimeNs.load(r);
+        for (uint32_t w = 0; w < FRAME_WINDOWS; w++)
+            page.frameTimes[w].load(out.frameTimes[w], r);
+        out.hitches = page.hitches.load(r);
+        out.resizes = page.resizes.load(r);
+        for (uint32_t w = 0; w < FRAME_WINDOWS; w++)
+            page.inputAge[w].load(out.inputAge[w], r);
+        out.inputAgeUs = page.inputAgeUs.load(r);
+        for (uint32_t k = 0; k < INPUT_KINDS; k++)
+            out.inputs[k] = page.inputs[k].load(r);
+        for (uint32_t w = 0; w < FRAME_WINDOWS; w++)
+        {
+            page.displayLatency[w].load(out.displayLatency[w], r);
+            page.inputToDisplay[w].load(out.inputToDisplay[w], r);
+        }
+        out.displayFrame = page.displayFrame.load(r);
+        out.displayLatencyUs = page.displayLatencyUs.load(r);
+        out.displayQueued = page.displayQueued.load(r);
+        out.refreshUs = page.refreshUs.load(r);
+        out.framesShown = page.framesShown.load(r);
+        out.framesUnseen = page.framesUnseen.load(r);
+        out.missedVblanks = page.missedVblanks.load(r);
+        for (uint32_t s = 0; s < STATS_STAGES; s++)
+        {
+            out.cpuNs[s] = page.cpuNs[s].load(r);
+            out.gpuNs[s] = page.gpuNs[s].load(r);
+        }
+        out.bytesCopied = page.bytesCopied.load(r);
+        out.bytesCopiedTotal = page.bytesCopiedTotal.load(r);
+        out.droppedFrames = page.droppedFrames.load(r);
+        out.streams = page.streams.load(r);
+        out.consumers = page.consumers.load(r);
+        out.depthWidth = page.depthWidth.load(r);
+        out.depthHeight = page.depthHeight.load(r);
+        out.depthFormat = page.depthFormat.load(r);
+        out.depthSamples = page.depthSamples.load(r);
+        for (uint32_t c = 0; c < CENSUS_CALLS; c++)
+            out.census.calls[c] = page.apiCalls[c].load(r);
+        for (uint32_t b = 0; b < CENSUS_BYTES; b++)
+            out.census.bytes[b] = page.apiBytes[b].load(r);
+
+        if (page.sequence.load(std::memory_order_relaxed) == begin)
+            return StatsRead::Ok;
+    }
+    return StatsRead::Busy;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// writer side
+//  • add* may be called from any Present / ResizeBuffers (auxiliary swap chains present
+//    on their own threads), they only touch atomics of the current frame
+//  • publish runs on the primary's Present, once per frame
+///////////////////////////////////////////////////////////////////////////////////////////
+
+class StatsWriter
+{
+public:
+    // page memory is zeroed by the mapping, readers ignore it until the first publish
+    void attach(StatsPage *page, uint32_t pid)
+    {
+        page->magic = STATS_MAGIC;
+        page->version = STATS_VERSION;
+        page->size = sizeof(StatsPage);
+        page->pid = pid;
+        page->stages = STATS_STAGES;
+        m_page = page;
+    }
+
+    bool attached() const { return m_page != nullptr; }
+
+    void addStage(TracePhase stage, uint64_t ns) { m_cpu[uint32_t(stage)].fetch_add(ns, std::memory_order_relaxed); }
+    void addBytes(uint64_t bytes) { m_bytes.fetch_add(bytes, std::memory_order_relaxed); }
+    void addDropped() { m_dropped.fetch_add(1, std::memory_order_relaxed); }
+    void addResize() { m_resizes.fetch_add(1, std::memory_order_relaxed); }
+
+    // the primary's GPU time per stage of an earlier frame (timestamp queries arrive late)
+    void setGpu(const uint64_t ns[STATS_STAGES])
+    {
+        for (uint32_t s = 0; s < STATS_STAGES; s++)
+            m_gpu[s] = smooth(m_gpu[s], double(ns[s]));
+    }
+
+    void setStreams(uint32_t streams, uint32_t consumers)
+    {
+        m_streams = streams;
+        m_consumers = consumers;
+    }
+
+    void setDepth(uint32_t width, uint32_t height, uint32_t format, uint32_t samples)
+    {
+        m_depth[0] = width;
+        m_depth[1] = height;
+        m_depth[2] = format;
+        m_depth[3] = samples;
+    }
+
+    // the API calls of the frame (ApiCensus::snapshot on the primary's Present)
+    void setCensus(const CensusFrame &frame) { m_census = frame; }
+
+    // the primary presented frame at nowNs (steady clock), publishes everything gathered
+    void publish(uint64_t frame, uint64_t nowNs)
+    {
+        m_frameTimes.record(nowNs);
+        if (!m_startNs)
+            m_startNs = nowNs;
+
+        for (uint32_t s = 0; s < STATS_STAGES; s++)
+            m_cpuSmooth[s] = smooth(m_cpuSmooth[s], double(m_cpu[s].exchange(0, std::memory_order_relaxed)));
+        uint64_t bytes = m_bytes.exchange(0, std::memory_order_relaxed);
+        m_bytesTotal += bytes;
+
+        if (!m_page)
+            return;
+        StatsPage &p = *m_page;
+        const auto r = std::memory_order_release; // each store publishes the odd sequence before it
+        uint32_t seq = p.sequence.load(std::memory_order_relaxed);
+        p.sequence.store(seq + 1, std::memory_order_relaxed);
+
+        p.frame.store(frame, r);
+        p.uptimeNs.store(nowNs - m_startNs, r);
+        for (uint32_t w = 0; w < FRAME_WINDOWS; w++)
+            p.frameTimes[w].store(m_frameTimes.last(FrameWindow(w)), r);
+        p.hitches.store(m_frameTimes.hitches(), r);
+        p.resizes.store(m_resizes.load(std::memory_order_relaxed), r);
+        for (uint32_t w = 0; w < FRAME_WINDOWS; w++)
+            p.inputAge[w].store(m_input.ages().last(FrameWindow(w)), r);
+        p.inputAgeUs.store(m_input.lastUs(), r);
+        for (uint32_t k = 0; k < INPUT_KINDS; k++)
+            p.inputs[k].store(m_input.inputs(InputKind(k)), r);
+        for (uint32_t w = 0; w < FRAME_WINDOWS; w++)
+        {
+            p.displayLatency[w].store(m_display.latency().last(FrameWindow(w)), r);
+            p.inputToDisplay[w].store(m_display.inputLatency().last(FrameWindow(w)), r);
+        }
+        const FrameDisplay &shown = m_display.last();
+        p.displayFrame.store(shown.frame, r);
+        p.displayLatencyUs.store(
+            shown.displayNs > shown.presentNs ? uint32_t((shown.displayNs - shown.presentNs) / 1000) : 0, r);
+        p.displayQueued.store(m_display.queued(), r);
+        p.refreshUs.store(uint32_t(m_display.periodNs() / 1000), r);
+        p.framesShown.store(m_display.shown(), r);
+        p.framesUnseen.store(m_display.unseen(), r);
+        p.missedVblanks.store(m_display.missed(), r);
+        for (uint32_t s = 0; s < STATS_STAGES; s++)
+        {
+            p.cpuNs[s].store(uint64_t(m_cpuSmooth[s]), r);
+            p.gpuNs[s].store(uint64_t(m_gpu[s]), r);
+        }
+        p.bytesCopied.store(bytes, r);
+        p.bytesCopiedTotal.store(m_bytesTotal, r);
+        p.droppedFrames.store(m_dropped.load(std::memory_order_relaxed), r);
+        p.streams.store(m_streams, r);
+        p.consumers.store(m_consumers, r);
+        p.depthWidth.store(m_depth[0], r);
+        p.depthHeight.store(m_depth[1], r);
+        p.depthFormat.store(m_depth[2], r);
+        p.depthSamples.store(m_depth[3], r);
+        for (uint32_t c = 0; c < CENSUS_CALLS; c++)
+            p.apiCalls[c].store(m_census.calls[c], r);
+        for (uint32_t b = 0; b < CENSUS_BYTES; b++)
+            p.apiBytes[b].store(m_census.bytes[b], r);
+
+        p.sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    // the primary's frame times, read() from any thread (the overlay, a hitch watcher)
+    const FrameHistogram &frameTimes() const { return m_frameTimes; }
+
+    // the last setCensus (primary Present only)
+    const CensusFrame &census() const { return m_census; }
+
+    // input ages: arrived() from the window's thread, presented() on the primary's Present
+    // right before the real one (publish() takes what it left)
+    InputLatency &input() { return m_input; }
+    const InputLatency &input() const { return m_input; }
+
+    // frames on screen: sampled after the primary's real Present (ProxyStats.h), the
+    // transport sends its records
+    DisplayTracker &display() { return m_display; }
+    const DisplayTracker &display() const { return m_display; }
+
+private:
+    // exponential moving average over ~16 frames, the first value is taken as is
+    static double smooth(double avg, double value)
+    {
+        return avg == 0.0 ? value : avg + (value - avg) / 16.0;
+    }
+
+    StatsPage *m_page = nullptr;
+
+    // any thread
+    std::atomic<uint64_t> m_cpu[STATS_STAGES] = {};
+    std::atomic<uint64_t> m_bytes{0};
+    std::atomic<uint64_t> m_dropped{0};
+    std::atomic<uint32_t> m_resizes{0};
+    InputLatency m_input; // arrived() any thread, the rest primary Present only
+    DisplayTracker m_display; // primary Present only
+
+    // primary Present only
+    FrameHistogram m_frameTimes;
+    uint64_t m_startNs = 0;
+    uint64_t m_bytesTotal = 0;
+    double m_cpuSmooth[STATS_STAGES] = {};
+    double m_gpu[STATS_STAGES] = {};
+    uint32_t m_streams = 0;
+    uint32_t m_consumers = 0;
+    uint32_t m_depth[4] = {};
+    CensusFrame m_census = {};
+};
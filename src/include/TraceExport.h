@@ -0,0 +1,225 @@
+#pragma once
+
+// c++ includes
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <utility>
+
+// trace format + reader, census call names
+#include "TraceLog.h"
+#include "ApiCensus.h"
+
+// NOTE: platform independent, used by tools/dxpipe_trace (the layer only writes .dxtrace)
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// chrome trace export (the JSON chrome://tracing and ui.perfetto.dev open as is)
+//  • Present → PresentEnd and the Present phases become nested slices (B / E) on the
+//    thread that logged them
+//  • a recording pause closes every open slice, an End whose Begin was not recorded is
+//    dropped, slices still open at the end of the file are closed there
+//  • counters become counter tracks, plus a Present to Present "frame time" per context
+//  • api calls and pipe writes are instants, DrawIndexed is left out (the draws counter
+//    carries the per frame total), census counts are one counter track per method
+//  • a hitch snapshot's marker is an instant on the frame that hitched
+///////////////////////////////////////////////////////////////////////////////////////////
+
+struct ChromeEvent
+{
+    char phase;       // 'B', 'E', 'C', 'i' or 'M' (thread name)
+    std::string name; // slice / counter / instant name, thread name for 'M'
+    const char *category;
+    double ts;        // us since the trace was opened
+    uint32_t tid;     // trace thread slot
+    std::vector<std::pair<std::string, double>> args;
+};
+
+inline std::vector<ChromeEvent> buildChromeTrace(const TraceReader &reader)
+{
+    std::vector<ChromeEvent> out;
+    std::vector<std::vector<std::string>> open; // per thread, names of the open slices
+    std::vector<double> lastPresent;            // per context id, ts of its last Present (<0 none)
+    uint32_t threads = 0;
+
+    auto closeAll = [&](double ts)
+    {
+        for (uint32_t t = 0; t < open.size(); t++)
+        {
+            while (!open[t].empty())
+            {
+                out.push_back({'E', open[t].back(), "layer", ts, t, {}});
+                open[t].pop_back();
+            }
+        }
+    };
+
+    for (const TraceRecord &r : reader.records())
+    {
+        if (r.event == uint16_t(TraceEvent::Clock))
+            continue;
+        const double ts = reader.ns(r.ticks) / 1000.0;
+        const uint32_t tid = r.thread;
+        if (tid >= open.size())
+            open.resize(tid + 1);
+        threads = open.size() > threads ? uint32_t(open.size()) : threads;
+        std::vector<std::string> &stack = open[tid];
+
+        // pops down to the matching Begin, a missing one means it was not recorded
+        auto end = [&](const std::string &name)
+        {
+            size_t depth = stack.size();
+            while (depth && stack[depth - 1] != name)
+                depth--;
+            if (!depth)
+                return;
+            while (stack.size() >= depth)
+            {
+                out.push_back({'E', stack.back(), "layer", ts, tid, {}});
+                stack.pop_back();
+            }
+        };
+
+        switch (TraceEvent(r.event))
+        {
+        case TraceEvent::Present:
+        {
+            // a frame starts from scratch, whatever was left open belonged to a lost End
+            while (!stack.empty())
+            {
+                out.push_back({'E', stack.back(), "layer", ts, tid, {}});
+                stack.pop_back();
+            }
+            out.push_back({'B', "Present", "frame", ts, tid,
+                           {{"context", double(r.arg0)}, {"frame", double(r.arg1)}, {"sync", double(r.a32 & 0xFFFF)}}});
+            stack.push_back("Present");
+
+            if (r.arg0 >= lastPresent.size())
+                lastPresent.resize(size_t(r.arg0) + 1, -1.0);
+            if (lastPresent[r.arg0] >= 0.0)
+                out.push_back({'C', "frame time " + std::to_string(r.arg0), "frame", ts, tid,
+                               {{"ms", (ts - lastPresent[r.arg0]) / 1000.0}}});
+            lastPresent[r.arg0] = ts;
+            break;
+        }
+        case TraceEvent::PresentEnd:
+            end("Present");
+            break;
+        case TraceEvent::Begin:
+            if (r.a32 < uint32_t(TracePhase::Count))
+            {
+                out.push_back({'B', tracePhaseName(r.a32), "layer", ts, tid, {}});
+                stack.push_back(tracePhaseName(r.a32));
+            }
+            break;
+        case TraceEvent::End:
+            if (r.a32 < uint32_t(TracePhase::Count))
+                end(tracePhaseName(r.a32));
+            break;
+        case TraceEvent::Counter:
+            if (r.a32 < uint32_t(TraceCounter::Count))
+                out.push_back({'C', std::string(traceCounterName(r.a32)) + " " + std::to_string(r.arg1), "frame", ts,
+                               tid, {{"value", double(r.arg0)}}});
+            break;
+        case TraceEvent::PipeWrite:
+            out.push_back({'i', r.a32 < uint32_t(TracePipe::Count) ? tracePipeName(r.a32) : "pipe", "ipc", ts, tid,
+                           {{"bytes", double(r.arg0)}}});
+            break;
+        case TraceEvent::ResizeBuffers:
+            out.push_back({'i', "ResizeBuffers", "api", ts, tid,
+                           {{"width", double(uint32_t(r.arg0))}, {"height", double(r.arg0 >> 32)},
+                            {"context", double(r.arg1)}}});
+            break;
+        case TraceEvent::GetBuffer:
+            out.push_back({'i', "GetBuffer", "api", ts, tid, {{"context", double(r.arg1)}}});
+            break;
+        case TraceEvent::CreateTexture2D:
+            out.push_back({'i', "CreateTexture2D", "api", ts, tid,
+                           {{"width", double(uint32_t(r.arg0))}, {"height", double(r.arg0 >> 32)},
+                            {"format", double(r.a32)}}});
+            break;
+        case TraceEvent::Present1:
+            out.push_back({'i', "Present1", "api", ts, tid, {{"sync", double(r.a32 & 0xFFFF)}}});
+            break;
+        case TraceEvent::Pause:
+            closeAll(ts);
+            lastPresent.assign(lastPresent.size(), -1.0); // no frame time across the gap
+            out.push_back({'i', "recording paused", "trace", ts, tid, {}});
+            break;
+        case TraceEvent::Resume:
+            out.push_back({'i', "recording resumed", "trace", ts, tid, {}});
+            break;
+        case TraceEvent::Census:
+            out.push_back({'C', std::string("calls ") + apiCallName(r.a32), "census", ts, tid,
+                           {{"calls", double(r.arg0)}}});
+            break;
+        case TraceEvent::Hitch:
+            out.push_back({'i', "hitch", "frame", ts, tid,
+                           {{"frame", double(r.arg0)}, {"ms", r.a32 / 1000.0}, {"limit ms", r.arg1 / 1000.0}}});
+            break;
+        default: // DrawIndexed, unknown events of newer layers
+            break;
+        }
+    }
+
+    if (!reader.records().empty())
+        closeAll(reader.ns(reader.records().back().ticks) / 1000.0);
+    for (uint32_t t = 0; t < threads; t++)
+        out.push_back({'M', "ring " + std::to_string(t), "trace", 0.0, t, {}});
+    return out;
+}
+
+// names are the layer's own, only quotes / backslashes / control characters need care
+inline void writeChromeString(FILE *file, const std::string &s)
+{
+    fputc('"', file);
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\')
+            fprintf(file, "\\%c", c);
+        else if (uint8_t(c) < 0x20)
+            fprintf(file, "\\u%04x", unsigned(uint8_t(c)));
+        else
+            fputc(c, file);
+    }
+    fputc('"', file);
+}
+
+inline bool writeChromeTrace(const std::vector<ChromeEvent> &events, FILE *file)
+{
+    fprintf(file, "{\"traceEvents\":[\n");
+    for (size_t i = 0; i < events.size(); i++)
+    {
+        const ChromeEvent &e = events[i];
+        if (e.phase == 'M')
+        {
+            fprintf(file, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", e.tid);
+            writeChromeString(file, e.name);
+            fprintf(file, "}}");
+        }
+        else
+        {
+            fprintf(file, "{\"ph\":\"%c\",\"name\":", e.phase);
+            writeChromeString(file, e.name);
+            fprintf(file, ",\"cat\":\"%s\",\"ts\":%.3f,\"pid\":1,\"tid\":%u", e.category, e.ts, e.tid);
+            if (e.phase == 'i')
+                fprintf(file, ",\"s\":\"t\"");
+            if (!e.args.empty())
+            {
+                fprintf(file, ",\"args\":{");
+                for (size_t a = 0; a < e.args.size(); a++)
+                {
+                    if (a)
+                        fputc(',', file);
+                    writeChromeString(file, e.args[a].first);
+                    fprintf(file, ":%.15g", e.args[a].second);
+                }
+                fprintf(file, "}");
+            }
+            fprintf(file, "}");
+        }
+        fprintf(file, i + 1 < events.size() ? ",\n" : "\n");
+    }
+    fprintf(file, "],\"displayTimeUnit\":\"ms\"}\n");
+    return !ferror(file);
+}
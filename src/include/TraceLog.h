@@ -0,0 +1,682 @@
+#pragma once
+
+// c++ includes
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <chrono>
+
+// timestamp counter
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// NOTE: platform independent, shared by the layer (writer) and tools/dxpipe_trace (reader)
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// binary trace log
+//  <name>.dxtrace – TraceHeader followed by fixed 32 byte TraceRecords
+//  • a log call is one record (event id, three args, timestamp counter) pushed into the
+//    calling thread's own ring: no lock, no formatting, no syscall
+//  • a full ring drops the record and counts it, the game's threads never wait on the disk
+//  • one background thread drains the rings every few milliseconds, each pass starts with
+//    a Clock record (ticks + steady clock) the decoder turns ticks into time with
+//  • records are in file order per thread only, the decoder sorts them by ticks
+//  • recording can be switched off and on while the file stays open, memory is the rings
+//    (fixed size per thread) whatever the trace's length
+//  • flight recorder: with or without a file the writer keeps the last few seconds of
+//    records (DrawIndexed left out) in memory, snapshot() writes them to their own file
+//    on the writer's next pass, marked with a Hitch record
+///////////////////////////////////////////////////////////////////////////////////////////
+
+static const uint32_t TRACE_MAGIC = 0x43525458; // "XTRC"
+static const uint32_t TRACE_VERSION = 1;
+
+enum class TraceEvent : uint16_t
+{
+    Clock,           // writer: arg0 = steady clock ns since open, arg1 = records dropped so far
+    Present,         // a32 = sync interval | flags << 16, arg0 = context id, arg1 = frame id
+    PresentEnd,      // a32 = HRESULT, arg0 = context id, arg1 = frame id
+    Present1,        // a32 = sync interval | flags << 16
+    ResizeBuffers,   // a32 = format, arg0 = width | height << 32, arg1 = context id
+    GetBuffer,       // arg0 = back buffer, arg1 = context id
+    CreateTexture2D, // a32 = format, arg0 = width | height << 32, arg1 = bind flags | sample count << 32
+    DrawIndexed,     // a32 = index count, arg0 = start index, arg1 = base vertex
+    Begin,           // a32 = TracePhase, arg0 = context id
+    End,             // a32 = TracePhase, arg0 = context id
+    Counter,         // a32 = TraceCounter, arg0 = value, arg1 = context id
+    PipeWrite,       // a32 = TracePipe, arg0 = bytes
+    Pause,           // recording switched off (the last record before the gap)
+    Resume,          // recording switched on again
+    Census,          // a32 = ApiCall, arg0 = calls in the frame, arg1 = frame id
+    Hitch,           // a32 = frame time us, arg0 = frame id, arg1 = limit us it broke (snapshot marker)
+    Count
+};
+
+static_assert(uint32_t(TraceEvent::Count) <= 32, "log() masks events in 32 bits");
+
+// sections of ProxySwapChain::Present (Begin / End)
+enum class TracePhase : uint32_t
+{
+    Detect,      // depth promotion, projection / camera inference
+    Resolve,     // msaa depth resolve
+    Staging,     // CPU-readable copies
+    Shared,      // shared colour / depth copies
+    Motion,      // camera motion pass
+    Transport,   // handles + parameters to the client
+    Overlay,     // ImGui
+    RealPresent, // the game's Present itself
+    Count
+};
+
+// per frame values (Counter)
+enum class TraceCounter : uint32_t
+{
+    BytesCopied,   // by the layer's exports this frame
+    Draws,         // the game's draw calls this frame
+    BytesUploaded, // the game's UpdateSubresource payload this frame
+    Count
+};
+
+// client pipes (PipeWrite)
+enum class TracePipe : uint32_t
+{
+    BackBuffer,
+    DepthBuffer,
+    DepthParams,
+    Camera,
+    Motion,
+    Display,
+    Count
+};
+
+inline const char *traceEventName(uint16_t event)
+{
+    static const char *const names[] = {"Clock", "Present", "PresentEnd", "Present1", "ResizeBuffers",
+                                        "GetBuffer", "CreateTexture2D", "DrawIndexed", "Begin", "End",
+                                        "Counter", "PipeWrite", "Pause", "Resume", "Census", "Hitch"};
+    static_assert(sizeof(names) / sizeof(names[0]) == size_t(TraceEvent::Count), "one name per event");
+    return event < uint16_t(TraceEvent::Count) ? names[event] : "?";
+}
+
+inline const char *tracePhaseName(uint32_t phase)
+{
+    static const char *const names[] = {"detect", "resolve", "staging", "shared", "motion",
+                                        "transport", "overlay", "real present"};
+    static_assert(sizeof(names) / sizeof(names[0]) == size_t(TracePhase::Count), "one name per phase");
+    return phase < uint32_t(TracePhase::Count) ? names[phase] : "?";
+}
+
+inline const char *traceCounterName(uint32_t counter)
+{
+    static const char *const names[] = {"bytes copied", "draws", "bytes uploaded"};
+    static_assert(sizeof(names) / sizeof(names[0]) == size_t(TraceCounter::Count), "one name per counter");
+    return counter < uint32_t(TraceCounter::Count) ? names[counter] : "?";
+}
+
+inline const char *tracePipeName(uint32_t pipe)
+{
+    static const char *const names[] = {"dxpipe_backbuffer", "dxpipe_depthbuffer", "dxpipe_depthparams",
+                                        "dxpipe_camera", "dxpipe_motion", "dxpipe_display"};
+    static_assert(sizeof(names) / sizeof(names[0]) == size_t(TracePipe::Count), "one name per pipe");
+    return pipe < uint32_t(TracePipe::Count) ? names[pipe] : "?";
+}
+
+struct TraceHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t reserved;
+};
+
+struct TraceRecord
+{
+    uint64_t ticks; // timestamp counter (rdtsc, steady clock elsewhere)
+    uint64_t arg0;
+    uint64_t arg1;
+    uint32_t a32;
+    uint16_t event;  // TraceEvent
+    uint16_t thread; // ring the record came through (one per thread at a time)
+};
+
+inline uint64_t traceTicks()
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    return __rdtsc();
+#elif defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return uint64_t(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// single producer (the owning thread) / single consumer (the writer) ring
+class TraceRing
+{
+public:
+    static constexpr uint32_t CAPACITY = 1u << 14; // records (512KB), a power of two
+
+    // touch every page now, not on the hot path
+    TraceRing() { memset(m_records, 0, sizeof(m_records)); }
+
+    // owning thread only
+    inline bool push(const TraceRecord &r)
+    {
+        uint32_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tailCache >= CAPACITY)
+        {
+            m_tailCache = m_tail.load(std::memory_order_acquire);
+            if (head - m_tailCache >= CAPACITY)
+            {
+                m_dropped.store(m_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+        m_records[head & (CAPACITY - 1)] = r;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // writer only, hands the waiting records to out (at most two contiguous spans)
+    template <class Sink>
+    uint32_t drain(Sink &&out)
+    {
+        uint32_t tail = m_tail.load(std::memory_order_relaxed);
+        uint32_t head = m_head.load(std::memory_order_acquire);
+        uint32_t n = head - tail;
+        if (!n)
+            return 0;
+        uint32_t first = tail & (CAPACITY - 1);
+        uint32_t span = CAPACITY - first < n ? CAPACITY - first : n;
+        out(m_records + first, span);
+        if (span < n)
+            out(m_records, n - span);
+        m_tail.store(head, std::memory_order_release);
+        return n;
+    }
+
+    bool empty() const
+    {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_relaxed);
+    }
+    uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    // slot life cycle: Free → Owned (a thread claimed it) → Retired (thread exited, the
+    // writer frees it once drained)
+    enum State : uint32_t
+    {
+        Free,
+        Owned,
+        Retired
+    };
+    std::atomic<uint32_t> state{Free};
+    uint16_t id = 0;
+
+private:
+    alignas(64) std::atomic<uint32_t> m_head{0};
+    uint32_t m_tailCache = 0; // producer's last look at m_tail
+    std::atomic<uint64_t> m_dropped{0};
+    alignas(64) std::atomic<uint32_t> m_tail{0};
+    alignas(64) TraceRecord m_records[CAPACITY];
+};
+
+// writes the trace, log() is safe to call from any thread
+class TraceLog
+{
+public:
+    static constexpr uint32_t MAX_THREADS = 64;         // threads logging at the same time
+    static constexpr uint32_t DRAIN_MS = 5;             // writer period
+    static constexpr uint32_t FLIGHT_RECORDS = 1u << 17; // flight recorder history (4MB)
+
+    // the rings are never freed, an exiting thread may still retire its ring after this
+    ~TraceLog()
+    {
+        close();
+        setFlight(0);
+    }
+
+    bool open(const char *path)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (m_file)
+            return true;
+
+        FILE *file = fopen(path, "wb");
+        if (!file)
+            return false;
+        setvbuf(file, nullptr, _IOFBF, 1 << 20);
+
+        TraceHeader h = {TRACE_MAGIC, TRACE_VERSION, sizeof(TraceRecord), 0};
+        fwrite(&h, sizeof(h), 1, file);
+
+        // the writer owns m_file while it runs
+        stopWriterLocked();
+        m_file = file;
+        m_fileStart = std::chrono::steady_clock::now();
+        switchFileLocked(m_recording);
+        startWriterLocked();
+        return true;
+    }
+
+    // stops the writer after a last pass (not from DllMain, the writer's exit needs the loader
+    // lock), it comes back without the file while the flight recorder is on
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (!m_file)
+            return;
+        if (m_recording) // a paused file already stopped taking records
+            switchFileLocked(false);
+        stopWriterLocked();
+        fclose(m_file);
+        m_file = nullptr;
+        if (m_flightNs.load(std::memory_order_relaxed))
+            startWriterLocked();
+    }
+
+    // keep the last `seconds` of records in memory for snapshot() (0 = off, frees the history)
+    void setFlight(uint32_t seconds)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        uint64_t ns = uint64_t(seconds) * 1000000000ull;
+        if (ns == m_flightNs.load(std::memory_order_relaxed))
+            return;
+
+        // the writer owns the history while it runs
+        stopWriterLocked();
+        if (ns && m_history.empty())
+        {
+            m_history.assign(FLIGHT_RECORDS, TraceRecord{});
+            m_historyHead = 0;
+            m_flightStart = std::chrono::steady_clock::now();
+        }
+        else if (!ns)
+        {
+            std::vector<TraceRecord>().swap(m_history);
+            m_historyHead = 0;
+            m_snapshotPending.store(false, std::memory_order_relaxed);
+        }
+        m_flightNs.store(ns, std::memory_order_relaxed);
+        updateEventsLocked(m_file && m_recording);
+        if (m_file || ns)
+            startWriterLocked();
+    }
+
+    uint32_t flightSeconds() const { return uint32_t(m_flightNs.load(std::memory_order_relaxed) / 1000000000ull); }
+
+    // freeze the flight history: a Hitch record marks the frame, the writer's next pass
+    // writes the last flightSeconds() to path; false if the recorder is off or the last
+    // snapshot is still pending
+    bool snapshot(const char *path, uint64_t frame, uint32_t frameUs, uint32_t limitUs)
+    {
+        std::lock_guard<std::mutex> lock(m_snapshotLock);
+        if (!m_flightNs.load(std::memory_order_relaxed) || m_snapshotPending.load(std::memory_order_acquire))
+            return false;
+        m_snapshotPath = path;
+        log(TraceEvent::Hitch, frameUs, frame, limitUs);
+        m_snapshotPending.store(true, std::memory_order_release); // after the marker is in the ring
+        return true;
+    }
+
+    bool snapshotPending() const { return m_snapshotPending.load(std::memory_order_acquire); }
+    uint64_t snapshots() const { return m_snapshots.load(std::memory_order_relaxed); } // written
+
+    bool isOpen()
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_file != nullptr;
+    }
+
+    // pause / resume without closing the file (on by default), log() is a flag test while off,
+    // the gap is marked with Pause / Resume so readers can cut the slices it interrupted
+    void setRecording(bool on)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (on == m_recording)
+            return;
+        if (!on && m_file)
+            log(TraceEvent::Pause);
+        m_recording = on;
+        if (m_file)
+            switchFileLocked(on);
+        if (on && m_file)
+            log(TraceEvent::Resume);
+    }
+
+    bool isRecording() const { return m_active.load(std::memory_order_relaxed); }
+
+    // the hot path: a mask test, the thread's ring, one timestamp and a 32 byte store
+    inline void log(TraceEvent event, uint32_t a32 = 0, uint64_t arg0 = 0, uint64_t arg1 = 0)
+    {
+        if (!(m_events.load(std::memory_order_relaxed) & (1u << uint32_t(event))))
+            return;
+        TraceRing *ring = threadRing();
+        if (!ring)
+        {
+            m_unowned.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        ring->push({traceTicks(), arg0, arg1, a32, uint16_t(event), ring->id});
+    }
+
+    // records lost to full rings / threads beyond MAX_THREADS
+    uint64_t dropped() const
+    {
+        uint64_t n = m_unowned.load(std::memory_order_relaxed);
+        for (const std::atomic<TraceRing *> &slot : m_rings)
+            if (const TraceRing *ring = slot.load(std::memory_order_acquire))
+                n += ring->dropped();
+        return n;
+    }
+
+    uint64_t written() const { return m_written.load(std::memory_order_relaxed); }
+
+private:
+    // what log() takes: everything for the file, everything but the draws for the history
+    void updateEventsLocked(bool toFile)
+    {
+        uint32_t all = (1u << uint32_t(TraceEvent::Count)) - 1;
+        uint32_t events = toFile ? all : 0;
+        if (m_flightNs.load(std::memory_order_relaxed))
+            events |= all & ~(1u << uint32_t(TraceEvent::DrawIndexed));
+        m_events.store(events, std::memory_order_release);
+    }
+
+    // the file starts / stops taking records now: records keep coming while the flight
+    // recorder is on (or racing the switch), the writer sorts them by the switch's ticks
+    void switchFileLocked(bool on)
+    {
+        m_fileSwitch.store(traceTicks() << 1 | (on ? 1 : 0), std::memory_order_release);
+        m_active.store(on, std::memory_order_release);
+        updateEventsLocked(on);
+    }
+
+    void startWriterLocked()
+    {
+        if (m_writer.joinable())
+            return;
+        m_stop.store(false, std::memory_order_relaxed);
+        m_writer = std::thread([this]
+                               { writerLoop(); });
+    }
+
+    // after a last pass
+    void stopWriterLocked()
+    {
+        if (!m_writer.joinable())
+            return;
+        m_stop.store(true, std::memory_order_release);
+        m_writer.join();
+    }
+
+    // the calling thread's ring, claimed on its first log call, retired when it exits
+    TraceRing *threadRing()
+    {
+        struct ThreadSlot
+        {
+            TraceLog *log = nullptr;
+            TraceRing *ring = nullptr;
+            ~ThreadSlot()
+            {
+                if (ring)
+                    ring->state.store(TraceRing::Retired, std::memory_order_release);
+            }
+        };
+        static thread_local ThreadSlot t_slot;
+        if (t_slot.log == this)
+            return t_slot.ring;
+
+        if (t_slot.ring)
+            t_slot.ring->state.store(TraceRing::Retired, std::memory_order_release);
+        t_slot.log = this;
+        t_slot.ring = claimRing();
+        return t_slot.ring;
+    }
+
+    TraceRing *claimRing()
+    {
+        for (uint32_t i = 0; i < MAX_THREADS; i++)
+        {
+            TraceRing *ring = m_rings[i].load(std::memory_order_acquire);
+            if (!ring)
+            {
+                // an empty slot, the first thread to publish a ring there owns it
+                TraceRing *fresh = new TraceRing();
+                fresh->id = uint16_t(i);
+                fresh->state.store(TraceRing::Owned, std::memory_order_relaxed);
+                if (m_rings[i].compare_exchange_strong(ring, fresh, std::memory_order_acq_rel))
+                    return fresh;
+                delete fresh;
+            }
+            uint32_t expected = TraceRing::Free;
+            if (ring->state.compare_exchange_strong(expected, TraceRing::Owned, std::memory_order_acq_rel))
+                return ring;
+        }
+        return nullptr;
+    }
+
+    void writerLoop()
+    {
+        while (!m_stop.load(std::memory_order_acquire))
+        {
+            drainAll();
+            std::this_thread::sleep_for(std::chrono::milliseconds(DRAIN_MS));
+        }
+        drainAll(); // whatever was logged before close()
+    }
+
+    // writer thread only
+    void drainAll()
+    {
+        // requested before this pass, so its marker is in a ring by now
+        bool snapshot = m_snapshotPending.load(std::memory_order_acquire);
+        uint64_t flightNs = m_flightNs.load(std::memory_order_relaxed);
+        bool flying = flightNs && !m_history.empty();
+        uint64_t fileSwitch = m_fileSwitch.load(std::memory_order_acquire);
+        bool fileOn = fileSwitch & 1;
+        uint64_t switchTicks = fileSwitch >> 1;
+
+        auto now = std::chrono::steady_clock::now();
+        uint64_t ticks = traceTicks(), dropped = this->dropped();
+        uint64_t flightNow = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_flightStart).count());
+        if (m_file)
+        {
+            uint64_t ns = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_fileStart).count());
+            TraceRecord clock = {ticks, ns, dropped, 0, uint16_t(TraceEvent::Clock), 0};
+            fwrite(&clock, sizeof(clock), 1, m_file);
+        }
+        if (flying)
+        {
+            TraceRecord clock = {ticks, flightNow, dropped, 0, uint16_t(TraceEvent::Clock), 0};
+            keep(&clock, 1);
+        }
+
+        uint64_t written = 0;
+        for (std::atomic<TraceRing *> &slot : m_rings)
+        {
+            TraceRing *ring = slot.load(std::memory_order_acquire);
+            if (!ring)
+                continue;
+            bool retired = ring->state.load(std::memory_order_acquire) == TraceRing::Retired;
+            ring->drain([&](const TraceRecord *r, uint32_t n)
+                        {
+                if (m_file)
+                    written += writeFiltered(r, n, fileOn, switchTicks);
+                if (flying)
+                    keep(r, n); });
+            // the thread that owned it is gone and nothing is left, the next thread may take it
+            if (retired && ring->empty())
+                ring->state.store(TraceRing::Free, std::memory_order_release);
+        }
+        m_written.fetch_add(written, std::memory_order_relaxed);
+
+        if (snapshot)
+            writeSnapshot(flightNow, flightNs);
+
+        // keep the file usable if the game is killed
+        if (m_file)
+            fflush(m_file);
+    }
+
+    // the file's share of a drained span: what was logged before a pause / after a resume
+    // (the flight recorder keeps taking records meanwhile)
+    uint64_t writeFiltered(const TraceRecord *r, uint32_t n, bool fileOn, uint64_t switchTicks)
+    {
+        uint64_t written = 0;
+        uint32_t run = 0;
+        for (uint32_t i = 0; i <= n; i++)
+        {
+            if (i < n && (fileOn ? r[i].ticks >= switchTicks : r[i].ticks <= switchTicks))
+            {
+                run++;
+                continue;
+            }
+            if (run)
+                written += fwrite(r + i - run, sizeof(TraceRecord), run, m_file);
+            run = 0;
+        }
+        return written;
+    }
+
+    void keep(const TraceRecord *r, uint32_t n)
+    {
+        for (uint32_t i = 0; i < n; i++)
+        {
+            if (r[i].event != uint16_t(TraceEvent::DrawIndexed))
+                m_history[m_historyHead++ % FLIGHT_RECORDS] = r[i];
+        }
+    }
+
+    // the history from the first Clock inside the window on, the reader sorts it by ticks
+    void writeSnapshot(uint64_t nowNs, uint64_t flightNs)
+    {
+        std::string path;
+        {
+            std::lock_guard<std::mutex> lock(m_snapshotLock);
+            path.swap(m_snapshotPath);
+            m_snapshotPending.store(false, std::memory_order_release);
+        }
+
+        uint64_t first = m_historyHead > FLIGHT_RECORDS ? m_historyHead - FLIGHT_RECORDS : 0;
+        for (uint64_t i = first; i < m_historyHead; i++)
+        {
+            const TraceRecord &r = m_history[i % FLIGHT_RECORDS];
+            if (r.event == uint16_t(TraceEvent::Clock) && r.arg0 + flightNs >= nowNs)
+            {
+                first = i;
+                break;
+            }
+        }
+
+        FILE *file = fopen(path.c_str(), "wb");
+        if (!file)
+            return;
+        TraceHeader h = {TRACE_MAGIC, TRACE_VERSION, sizeof(TraceRecord), 0};
+        bool ok = fwrite(&h, sizeof(h), 1, file) == 1;
+        for (uint64_t i = first; ok && i < m_historyHead;)
+        {
+            uint64_t at = i % FLIGHT_RECORDS;
+            uint64_t n = std::min<uint64_t>(m_historyHead - i, FLIGHT_RECORDS - at);
+            ok = fwrite(m_history.data() + at, sizeof(TraceRecord), size_t(n), file) == n;
+            i += n;
+        }
+        ok = fclose(file) == 0 && ok;
+        if (ok)
+            m_snapshots.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::mutex m_lock; // open / close / setFlight / setRecording
+    FILE *m_file = nullptr;
+    std::thread m_writer; // runs while the file is open or the flight recorder is on
+    std::chrono::steady_clock::time_point m_fileStart, m_flightStart;
+    bool m_recording = true;                   // wanted (m_lock)
+    std::atomic<bool> m_active{false};         // open and recording
+    std::atomic<uint32_t> m_events{0};         // TraceEvent bits log() takes
+    std::atomic<uint64_t> m_fileSwitch{0};     // ticks << 1 | on: the file takes records logged
+                                               // after (on) / before it
+    std::atomic<bool> m_stop{false};
+    std::atomic<uint64_t> m_unowned{0};
+    std::atomic<uint64_t> m_written{0};
+    std::atomic<TraceRing *> m_rings[MAX_THREADS] = {};
+
+    // flight recorder, the history belongs to the writer while it runs
+    std::atomic<uint64_t> m_flightNs{0};
+    std::vector<TraceRecord> m_history;
+    uint64_t m_historyHead = 0; // records kept so far
+    std::mutex m_snapshotLock;  // m_snapshotPath
+    std::string m_snapshotPath;
+    std::atomic<bool> m_snapshotPending{false};
+    std::atomic<uint64_t> m_snapshots{0};
+};
+
+// loads a trace into memory, records sorted by time
+class TraceReader
+{
+public:
+    bool open(const char *path)
+    {
+        FILE *f = fopen(path, "rb");
+        if (!f)
+            return false;
+        TraceHeader h = {};
+        bool ok = fread(&h, sizeof(h), 1, f) == 1 && h.magic == TRACE_MAGIC &&
+                  h.version == TRACE_VERSION && h.recordSize == sizeof(TraceRecord);
+        TraceRecord r;
+        while (ok && fread(&r, sizeof(r), 1, f) == 1)
+            m_records.push_back(r);
+        fclose(f);
+        if (!ok)
+            return false;
+
+        // drains interleave threads, ticks give the order (stable: a thread's own order stays)
+        std::stable_sort(m_records.begin(), m_records.end(), [](const TraceRecord &a, const TraceRecord &b)
+                         { return a.ticks < b.ticks; });
+
+        // ticks → ns from the first and last Clock record (one rate, the counter is invariant)
+        const TraceRecord *first = nullptr, *last = nullptr;
+        for (const TraceRecord &c : m_records)
+        {
+            if (c.event != uint16_t(TraceEvent::Clock))
+                continue;
+            if (!first)
+                first = &c;
+            last = &c;
+        }
+        if (first)
+        {
+            m_originTicks = first->ticks;
+            m_originNs = double(first->arg0);
+            if (last != first && last->ticks != first->ticks)
+                m_nsPerTick = (double(last->arg0) - double(first->arg0)) / double(last->ticks - first->ticks);
+            m_dropped = last->arg1;
+        }
+        return true;
+    }
+
+    const std::vector<TraceRecord> &records() const { return m_records; }
+
+    // ns since the trace was opened (0 ns per tick with fewer than two Clock records)
+    double ns(uint64_t ticks) const
+    {
+        return m_originNs + (double(ticks) - double(m_originTicks)) * m_nsPerTick;
+    }
+
+    double nsPerTick() const { return m_nsPerTick; }
+    uint64_t dropped() const { return m_dropped; }
+
+private:
+    std::vector<TraceRecord> m_records;
+    uint64_t m_originTicks = 0;
+    double m_originNs = 0.0;
+    double m_nsPerTick = 0.0;
+    uint64_t m_dropped = 0;
+};
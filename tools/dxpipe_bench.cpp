@@ -0,0 +1,527 @@
+// dxpipe_bench – layer overhead benchmark on a synthetic frame loop
+//
+//  usage: dxpipe_bench [--width W] [--height H] [--frames N] [--warmup N]
+//                      [--draws N] [--deferred N] [--resize-every N] [--storm N]
+//                      [--no-consumer] [--assert-zero-alloc] [--out file.json]
+//
+// drives the portable parts of the layer the way the game + client would:
+//  • game     – binds / draws through the event recorders (immediate + deferred lists)
+//  • export   – staging + shared copies (FrameExport.h) on the software reference device
+//  • consumer – the client opening the shared textures and reading them back
+//  • resize   – ResizeBuffers storms (release, resize, reacquire like ProxySwapChain)
+// every component is timed per frame, the result is JSON for regression comparison.
+// heap allocations are counted through operator new, COM calls through the soft device.
+//
+// --assert-zero-alloc runs the steady state audit: every measured frame is an AllocScope
+// (like Present with ENABLE_ALLOC_AUDIT) and any allocation inside one fails the run.
+// defaults to 10000 frames, resize storms are rejected (they allocate by design).
+
+// c++ includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <new>
+
+// layer headers (platform independent)
+#include "LayerEvents.h"
+#include "FrameExport.h"
+#include "SoftDevice.h"
+#include "AllocAudit.h"
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// allocation counter
+///////////////////////////////////////////////////////////////////////////////////////////
+
+// every replaceable form, so each new has its matching delete (plain / aligned, nothrow)
+static void *countedAlloc(size_t size, size_t align)
+{
+    allocAuditNote(size);
+    size = size ? size : 1;
+    if (align <= __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+        return std::malloc(size);
+#if defined(_MSC_VER)
+    return _aligned_malloc(size, align);
+#else
+    return std::aligned_alloc(align, (size + align - 1) / align * align);
+#endif
+}
+
+// out of line: inlined into a delete, gcc pairs the free() with the operator new call it
+// sees and reports a mismatch (-Wmismatched-new-delete)
+#if defined(_MSC_VER)
+__declspec(noinline)
+#else
+__attribute__((noinline))
+#endif
+static void countedFree(void *p, size_t align) noexcept
+{
+#if defined(_MSC_VER)
+    if (align > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+    {
+        _aligned_free(p);
+        return;
+    }
+#endif
+    (void)align;
+    std::free(p);
+}
+
+static void *countedNew(size_t size, size_t align)
+{
+    if (void *p = countedAlloc(size, align))
+        return p;
+    throw std::bad_alloc();
+}
+
+static const size_t PLAIN = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+void *operator new(size_t size) { return countedNew(size, PLAIN); }
+void *operator new[](size_t size) { return countedNew(size, PLAIN); }
+void *operator new(size_t size, std::align_val_t a) { return countedNew(size, size_t(a)); }
+void *operator new[](size_t size, std::align_val_t a) { return countedNew(size, size_t(a)); }
+void *operator new(size_t size, const std::nothrow_t &) noexcept { return countedAlloc(size, PLAIN); }
+void *operator new[](size_t size, const std::nothrow_t &) noexcept { return countedAlloc(size, PLAIN); }
+void *operator new(size_t size, std::align_val_t a, const std::nothrow_t &) noexcept { return countedAlloc(size, size_t(a)); }
+void *operator new[](size_t size, std::align_val_t a, const std::nothrow_t &) noexcept { return countedAlloc(size, size_t(a)); }
+
+void operator delete(void *p) noexcept { countedFree(p, PLAIN); }
+void operator delete[](void *p) noexcept { countedFree(p, PLAIN); }
+void operator delete(void *p, size_t) noexcept { countedFree(p, PLAIN); }
+void operator delete[](void *p, size_t) noexcept { countedFree(p, PLAIN); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { countedFree(p, PLAIN); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { countedFree(p, PLAIN); }
+void operator delete(void *p, std::align_val_t a) noexcept { countedFree(p, size_t(a)); }
+void operator delete[](void *p, std::align_val_t a) noexcept { countedFree(p, size_t(a)); }
+void operator delete(void *p, size_t, std::align_val_t a) noexcept { countedFree(p, size_t(a)); }
+void operator delete[](void *p, size_t, std::align_val_t a) noexcept { countedFree(p, size_t(a)); }
+void operator delete(void *p, std::align_val_t a, const std::nothrow_t &) noexcept { countedFree(p, size_t(a)); }
+void operator delete[](void *p, std::align_val_t a, const std::nothrow_t &) noexcept { countedFree(p, size_t(a)); }
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// config / results
+///////////////////////////////////////////////////////////////////////////////////////////
+
+struct BenchConfig
+{
+    uint32_t width = 1920;
+    uint32_t height = 1080;
+    uint32_t frames = 1000;
+    uint32_t warmup = 60;
+    uint32_t draws = 2000;      // draw calls per frame
+    uint32_t deferred = 0;      // deferred command lists per frame (draws are split across them)
+    uint32_t resizeEvery = 0;   // start a resize storm every N frames (0 = never)
+    uint32_t storm = 1;         // consecutive resizing frames per storm
+    bool consumer = true;       // client reading the shared textures
+    bool assertZeroAlloc = false; // fail on any allocation inside a measured frame
+    const char *out = nullptr;  // JSON file, stdout when null
+};
+
+enum Component
+{
+    CompGame,
+    CompExport,
+    CompConsumer,
+    CompResize,
+    CompFrame,
+    CompCount
+};
+
+static const char *s_componentNames[CompCount] = {"game", "export", "consumer", "resize", "frame"};
+
+struct BenchSamples
+{
+    std::vector<double> us[CompCount];
+    std::vector<double> allocations;
+    std::vector<double> calls;
+    std::vector<double> bytesCopied;
+    std::vector<double> events;
+};
+
+static double percentile(std::vector<double> v, double p)
+{
+    if (v.empty())
+        return 0.0;
+    std::sort(v.begin(), v.end());
+    size_t idx = size_t(p * double(v.size() - 1) + 0.5);
+    return v[std::min(idx, v.size() - 1)];
+}
+
+static double mean(const std::vector<double> &v)
+{
+    double total = 0.0;
+    for (double x : v)
+        total += x;
+    return v.empty() ? 0.0 : total / double(v.size());
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// the layer / game / client state (mirrors the globals in d3d11.cpp)
+///////////////////////////////////////////////////////////////////////////////////////////
+
+struct BenchLayer
+{
+    SoftDevice *device = nullptr;
+    SoftContext *ctx = nullptr;
+    SoftSwapChain *swapChain = nullptr;
+
+    // game side
+    SoftTexture2D *gameDepth = nullptr;
+
+    // layer side (the swap chain's PipelineContext + g_DepthTexture)
+    SoftTexture2D *backBuffer = nullptr;
+    SoftTexture2D *depth = nullptr;
+    SoftTexture2D *backBufferStaging = nullptr;
+    SoftTexture2D *depthStaging = nullptr;
+    SoftTexture2D *backBufferShared = nullptr;
+    SoftTexture2D *depthShared = nullptr;
+    uint64_t backBufferHandle = 0;
+    uint64_t depthHandle = 0;
+
+    // client side (opened through the shared handles)
+    SoftTexture2D *clientColour = nullptr;
+    SoftTexture2D *clientDepth = nullptr;
+    SoftTexture2D *clientReadback = nullptr;
+    uint64_t clientColourHandle = 0;
+    uint64_t clientDepthHandle = 0;
+
+    FrameTimeline timeline;
+    std::vector<EventRecorder *> lists;
+
+    // game creates its depth buffer, the layer keeps a reference (ProxyDevice::CreateTexture2D)
+    void createDepth(uint32_t w, uint32_t h)
+    {
+        SoftApi::release(gameDepth);
+        SoftApi::release(depth);
+
+        SoftTextureDesc d = {};
+        d.Width = w;
+        d.Height = h;
+        d.MipLevels = 1;
+        d.ArraySize = 1;
+        d.Format = FMT_R32_TYPELESS;
+        d.SampleDesc.Count = 1;
+        d.Usage = USAGE_DEFAULT;
+        d.BindFlags = BIND_DEPTH_STENCIL | BIND_SHADER_RESOURCE;
+        if (softSucceeded(device->CreateTexture2D(&d, nullptr, &gameDepth)))
+        {
+            gameDepth->AddRef();
+            depth = gameDepth;
+        }
+    }
+
+    // ProxySwapChain::ResizeBuffers: drop everything sized to the old back buffer first
+    void resize(uint32_t w, uint32_t h)
+    {
+        SoftApi::release(backBuffer);
+        SoftApi::release(backBufferStaging);
+        SoftApi::release(backBufferShared);
+        SoftApi::release(depthShared);
+        backBufferHandle = 0;
+        depthHandle = 0;
+
+        if (softSucceeded(swapChain->ResizeBuffers(0, w, h, 0, 0)))
+            swapChain->GetBuffer(0, &backBuffer);
+        createDepth(w, h);
+    }
+
+    void releaseAll()
+    {
+        SoftTexture2D **all[] = {&gameDepth, &backBuffer, &depth, &backBufferStaging, &depthStaging,
+                                 &backBufferShared, &depthShared, &clientColour, &clientDepth,
+                                 &clientReadback};
+        for (SoftTexture2D **t : all)
+            SoftApi::release(*t);
+        for (EventRecorder *l : lists)
+            delete l;
+        lists.clear();
+    }
+};
+
+// fake object identities for the recorded calls (never dereferenced)
+static const void *fakeObject(uintptr_t kind, uintptr_t index)
+{
+    return reinterpret_cast<const void *>((kind << 24) | (index << 4) | 0x10);
+}
+
+// one draw as the game issues it: state, resources, constants, draw
+static inline void recordDraw(EventRecorder &rec, uint32_t i)
+{
+    if ((i & 31) == 0)
+        rec.record(EventKind::SetRenderTargets, fakeObject(1, 0), uintptr_t(fakeObject(2, i >> 5)), 1);
+    if ((i & 7) == 0)
+    {
+        rec.record(EventKind::SetShader, fakeObject(3, i & 63), 0, StageVS);
+        rec.record(EventKind::SetShader, fakeObject(4, i & 63), 0, StagePS);
+    }
+    rec.record(EventKind::SetConstantBuffers, fakeObject(5, i & 15), 2, StageVS); // slots 0..1
+    rec.record(EventKind::SetShaderResources, fakeObject(6, i & 255), 4, StagePS); // slots 0..3
+    rec.record(EventKind::DrawIndexed, nullptr, 36 + (i & 1023), 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// frame loop
+///////////////////////////////////////////////////////////////////////////////////////////
+
+static void runFrame(BenchLayer &L, const BenchConfig &cfg, uint32_t frame, double us[CompCount], uint64_t &events)
+{
+    using clock = std::chrono::steady_clock;
+    auto elapsed = [](clock::time_point a, clock::time_point b)
+    {
+        return std::chrono::duration<double, std::micro>(b - a).count();
+    };
+
+    auto t0 = clock::now();
+
+    // ---- resize storm (ResizeBuffers between frames, allowed to allocate) ----
+    if (cfg.resizeEvery && (frame % cfg.resizeEvery) < cfg.storm && frame >= cfg.resizeEvery)
+    {
+        AllocScope untracked(nullptr);
+        bool small = (frame / cfg.resizeEvery + frame) & 1;
+        uint32_t w = small ? cfg.width * 2 / 3 : cfg.width;
+        uint32_t h = small ? cfg.height * 2 / 3 : cfg.height;
+        L.resize(w ? w : 1, h ? h : 1);
+    }
+    auto t1 = clock::now();
+
+    // ---- game: immediate draws + deferred lists spliced in order ----
+    {
+        AllocScope scope("game");
+        L.timeline.record(EventKind::ClearDepthStencil, L.depth, 0, 1);
+        uint32_t perList = cfg.deferred ? cfg.draws / (cfg.deferred + 1) : 0;
+        uint32_t immediate = cfg.draws - perList * cfg.deferred;
+        for (uint32_t i = 0; i < immediate; i++)
+            recordDraw(L.timeline, i);
+        for (EventRecorder *list : L.lists)
+        {
+            for (uint32_t i = 0; i < perList; i++)
+                recordDraw(*list, i);
+            L.timeline.splice(*list);
+            list->clear();
+        }
+    }
+    auto t2 = clock::now();
+
+    // ---- layer: ProxySwapChain::Present export ----
+    {
+        AllocScope scope("export");
+        exportStaging<SoftApi>(L.device, L.ctx, L.backBuffer, L.backBufferStaging);
+        exportStaging<SoftApi>(L.device, L.ctx, L.depth, L.depthStaging);
+        exportShared<SoftApi>(L.device, L.ctx, L.backBuffer, FMT_R8G8B8A8_UNORM, L.backBufferShared, L.backBufferHandle);
+        exportShared<SoftApi>(L.device, L.ctx, L.depth, FMT_R32_TYPELESS, L.depthShared, L.depthHandle);
+        events = L.timeline.events.size();
+        L.timeline.endFrame();
+        L.swapChain->Present(0, 0);
+    }
+    auto t3 = clock::now();
+
+    // ---- consumer: reopen on handle change, copy depth out and read it ----
+    if (cfg.consumer)
+    {
+        AllocScope scope("consumer");
+        if (L.clientColourHandle != L.backBufferHandle)
+        {
+            SoftApi::release(L.clientColour);
+            L.clientColourHandle = L.backBufferHandle;
+            if (L.backBufferHandle)
+                L.device->OpenSharedResource(L.backBufferHandle, &L.clientColour);
+        }
+        if (L.clientDepthHandle != L.depthHandle)
+        {
+            SoftApi::release(L.clientDepth);
+            L.clientDepthHandle = L.depthHandle;
+            if (L.depthHandle)
+                L.device->OpenSharedResource(L.depthHandle, &L.clientDepth);
+        }
+        if (L.clientDepth && exportStaging<SoftApi>(L.device, L.ctx, L.clientDepth, L.clientReadback) != ExportResult::Failed)
+        {
+            SoftMappedSubresource m = {};
+            if (softSucceeded(L.ctx->Map(L.clientReadback, 0, MAP_READ, 0, &m)))
+            {
+                volatile uint8_t sink = static_cast<uint8_t *>(m.pData)[0];
+                (void)sink;
+                L.ctx->Unmap(L.clientReadback, 0);
+            }
+        }
+    }
+    auto t4 = clock::now();
+
+    us[CompResize] = elapsed(t0, t1);
+    us[CompGame] = elapsed(t1, t2);
+    us[CompExport] = elapsed(t2, t3);
+    us[CompConsumer] = elapsed(t3, t4);
+    us[CompFrame] = elapsed(t0, t4);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// output
+///////////////////////////////////////////////////////////////////////////////////////////
+
+static void writeStats(FILE *f, const char *name, const std::vector<double> &v, bool last)
+{
+    fprintf(f, "    \"%s\": {\"mean\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f}%s\n",
+            name, mean(v), percentile(v, 0.50), percentile(v, 0.90), percentile(v, 0.99),
+            percentile(v, 1.00), last ? "" : ",");
+}
+
+static void writeJson(FILE *f, const BenchConfig &cfg, const BenchSamples &s)
+{
+    fprintf(f, "{\n");
+    fprintf(f, "  \"config\": {\"width\": %u, \"height\": %u, \"frames\": %u, \"warmup\": %u, "
+               "\"draws\": %u, \"deferred\": %u, \"resize_every\": %u, \"storm\": %u, \"consumer\": %s},\n",
+            cfg.width, cfg.height, cfg.frames, cfg.warmup, cfg.draws, cfg.deferred,
+            cfg.resizeEvery, cfg.storm, cfg.consumer ? "true" : "false");
+    fprintf(f, "  \"us\": {\n");
+    for (int c = 0; c < CompCount; c++)
+        writeStats(f, s_componentNames[c], s.us[c], c == CompCount - 1);
+    fprintf(f, "  },\n");
+    fprintf(f, "  \"per_frame\": {\n");
+    writeStats(f, "allocations", s.allocations, false);
+    writeStats(f, "com_calls", s.calls, false);
+    writeStats(f, "bytes_copied", s.bytesCopied, false);
+    writeStats(f, "events", s.events, true);
+    fprintf(f, "  }\n");
+    fprintf(f, "}\n");
+}
+
+static bool parseArgs(int argc, char **argv, BenchConfig &cfg)
+{
+    bool framesSet = false;
+    for (int i = 1; i < argc; i++)
+    {
+        const char *a = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(a, "--width") && hasValue)
+            cfg.width = uint32_t(strtoul(argv[++i], nullptr, 10));
+        else if (!strcmp(a, "--height") && hasValue)
+            cfg.height = uint32_t(strtoul(argv[++i], nullptr, 10));
+        else if (!strcmp(a, "--frames") && hasValue)
+        {
+            cfg.frames = uint32_t(strtoul(argv[++i], nullptr, 10));
+            framesSet = true;
+        }
+        else if (!strcmp(a, "--warmup") && hasValue)
+            cfg.warmup = uint32_t(strtoul(argv[++i], nullptr, 10));
+        else if (!strcmp(a, "--draws") && hasValue)
+            cfg.draws = uint32_t(strtoul(argv[++i], nullptr, 10));
+        else if (!strcmp(a, "--deferred") && hasValue)
+            cfg.deferred = uint32_t(strtoul(argv[++i], nullptr, 10));
+        else if (!strcmp(a, "--resize-every") && hasValue)
+            cfg.resizeEvery = uint32_t(strtoul(argv[++i], nullptr, 10));
+        else if (!strcmp(a, "--storm") && hasValue)
+            cfg.storm = uint32_t(strtoul(argv[++i], nullptr, 10));
+        else if (!strcmp(a, "--no-consumer"))
+            cfg.consumer = false;
+        else if (!strcmp(a, "--assert-zero-alloc"))
+            cfg.assertZeroAlloc = true;
+        else if (!strcmp(a, "--out") && hasValue)
+            cfg.out = argv[++i];
+        else
+            return false;
+    }
+
+    // the steady state audit: long run, no resizes
+    if (cfg.assertZeroAlloc)
+    {
+        if (!framesSet)
+            cfg.frames = 10000;
+        if (cfg.resizeEvery)
+            return false;
+    }
+    return cfg.width && cfg.height && cfg.frames;
+}
+
+int main(int argc, char **argv)
+{
+    BenchConfig cfg;
+    if (!parseArgs(argc, argv, cfg))
+    {
+        fprintf(stderr, "usage: %s [--width W] [--height H] [--frames N] [--warmup N] [--draws N]\n"
+                        "          [--deferred N] [--resize-every N] [--storm N] [--no-consumer]\n"
+                        "          [--assert-zero-alloc] [--out file.json]\n",
+                argv[0]);
+        return 1;
+    }
+
+    BenchLayer L;
+    L.device = new SoftDevice();
+    L.device->GetImmediateContext(&L.ctx);
+    L.swapChain = new SoftSwapChain(L.device, {cfg.width, cfg.height, FMT_R8G8B8A8_UNORM, 2});
+    L.swapChain->GetBuffer(0, &L.backBuffer);
+    L.createDepth(cfg.width, cfg.height);
+    for (uint32_t i = 0; i < cfg.deferred; i++)
+        L.lists.push_back(new EventRecorder(1024, uint16_t(i + 1)));
+
+    BenchSamples samples;
+    for (auto &v : samples.us)
+        v.reserve(cfg.frames);
+    samples.allocations.reserve(cfg.frames);
+    samples.calls.reserve(cfg.frames);
+    samples.bytesCopied.reserve(cfg.frames);
+    samples.events.reserve(cfg.frames);
+
+    double us[CompCount];
+    uint64_t events = 0;
+    for (uint32_t f = 0; f < cfg.warmup + cfg.frames; f++)
+    {
+        // warmup allocations are expected, start the audit clean
+        if (f == cfg.warmup)
+            allocAuditDrain([](const AllocSite &) {});
+
+        L.device->resetCounters();
+        uint64_t allocs = g_AllocAudit.total.load(std::memory_order_relaxed);
+
+        if (f < cfg.warmup)
+        {
+            runFrame(L, cfg, f, us, events);
+            continue;
+        }
+
+        {
+            AllocScope scope("Present");
+            runFrame(L, cfg, f, us, events);
+        }
+
+        const SoftDeviceStats &st = L.device->stats();
+        for (int c = 0; c < CompCount; c++)
+            samples.us[c].push_back(us[c]);
+        samples.allocations.push_back(double(g_AllocAudit.total.load(std::memory_order_relaxed) - allocs));
+        samples.calls.push_back(double(st.calls));
+        samples.bytesCopied.push_back(double(st.bytesCopied));
+        samples.events.push_back(double(events));
+    }
+
+    FILE *out = cfg.out ? fopen(cfg.out, "w") : stdout;
+    if (!out)
+    {
+        fprintf(stderr, "failed to open %s\n", cfg.out);
+        return 1;
+    }
+    writeJson(out, cfg, samples);
+    if (out != stdout)
+        fclose(out);
+
+    int result = 0;
+    if (cfg.assertZeroAlloc)
+    {
+        uint64_t tagged = allocAuditDrain([](const AllocSite &site)
+                                          { fprintf(stderr, "  %llu bytes in %s\n", (unsigned long long)site.size, site.tag); });
+        if (tagged)
+        {
+            fprintf(stderr, "FAIL: %llu allocation(s) in %u steady state frames\n", (unsigned long long)tagged, cfg.frames);
+            result = 2;
+        }
+        else
+        {
+            fprintf(stderr, "OK: no allocations in %u steady state frames\n", cfg.frames);
+        }
+    }
+
+    L.releaseAll();
+    L.ctx->Release();
+    delete L.swapChain;
+    L.device->Release();
+    return result;
+}
@@ -0,0 +1,215 @@
+// dxpipe_census – cost and correctness of the API call census (ApiCensus.h), builds on Linux
+//
+//  usage: dxpipe_census [--bench] [--calls N] [--threads N]
+//         dxpipe_census --selftest [--calls N]
+//
+// --bench (default) measures what counting costs the calling thread:
+//  • disabled        – the census switched off (one relaxed load)
+//  • census          – the thread's own block (relaxed load + store)
+//  • shared atomic   – one counter array for everyone (fetch_add), the obvious alternative
+// first on one thread, then on --threads threads at once (where the shared array's cache
+// lines bounce between cores and the census' don't), plus what a Present snapshot costs.
+// --selftest has waves of threads count a known pattern (blocks handed on as threads
+// exit, more threads than MAX_THREADS at once) while another thread snapshots flat out,
+// then checks that the snapshots add up to exactly what was counted. exits non-zero on
+// any mismatch.
+
+// c++ includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+// layer headers (platform independent)
+#include "ApiCensus.h"
+
+static ApiCensus g_Census;
+
+// the calls a frame loop would make, every method in turn
+static inline ApiCall callOf(uint64_t i)
+{
+    return ApiCall(uint32_t(i % CENSUS_CALLS));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// bench
+///////////////////////////////////////////////////////////////////////////////////////////
+
+struct alignas(64) SharedCounters
+{
+    std::atomic<uint64_t> calls[CENSUS_CALLS];
+};
+
+static SharedCounters s_shared;
+
+// ns per call on each of `threads` threads running f at the same time
+template <class F>
+static double nsPerCall(uint32_t threads, uint64_t calls, F &&f)
+{
+    std::atomic<uint32_t> ready{0};
+    std::vector<double> ns(threads, 0.0);
+    std::vector<std::thread> pool;
+    for (uint32_t t = 0; t < threads; t++)
+        pool.emplace_back([&, t]
+                          {
+            ready++;
+            while (ready.load() < threads)
+                std::this_thread::yield();
+            auto t0 = std::chrono::steady_clock::now();
+            for (uint64_t i = 0; i < calls; i++)
+                f(i);
+            ns[t] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count(); });
+    double sum = 0.0;
+    for (uint32_t t = 0; t < threads; t++)
+    {
+        pool[t].join();
+        sum += ns[t];
+    }
+    return sum / double(threads) / double(calls);
+}
+
+static int bench(uint64_t calls, uint32_t threads)
+{
+    auto census = [](uint64_t i)
+    { g_Census.count(callOf(i)); };
+    auto shared = [](uint64_t i)
+    { s_shared.calls[uint32_t(callOf(i))].fetch_add(1, std::memory_order_relaxed); };
+
+    g_Census.setEnabled(false);
+    double off = nsPerCall(1, calls, census);
+    double offN = nsPerCall(threads, calls, census);
+    g_Census.setEnabled(true);
+    double on = nsPerCall(1, calls, census);
+    double onN = nsPerCall(threads, calls, census);
+    double atomic = nsPerCall(1, calls, shared);
+    double atomicN = nsPerCall(threads, calls, shared);
+
+    CensusFrame frame;
+    const uint32_t snapshots = 100000;
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < snapshots; i++)
+        g_Census.snapshot(frame);
+    double snapshot = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() /
+                      snapshots;
+
+    printf("%-16s %10s %10s\n", "count", "1 thread", "threads");
+    printf("%-16s %10.2f %10.2f\n", "disabled", off, offN);
+    printf("%-16s %10.2f %10.2f\n", "census", on, onN);
+    printf("%-16s %10.2f %10.2f\n", "shared atomic", atomic, atomicN);
+    printf("ns per call, %llu calls per thread, %u threads (%u cores); snapshot %.0f ns, %zu byte blocks\n",
+           (unsigned long long)calls, threads, std::thread::hardware_concurrency(), snapshot, sizeof(CensusBlock));
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// selftest
+///////////////////////////////////////////////////////////////////////////////////////////
+
+static int selftest(uint64_t calls)
+{
+    // what the waves count: wave w has threads[w] threads of `calls` each, all alive at once
+    const uint32_t waves[] = {4, 8, ApiCensus::MAX_THREADS + 6, 3};
+    uint64_t expectCalls[CENSUS_CALLS] = {}, expectBytes = 0;
+
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> snapshots{0}, shrunk{0}; // a total below the previous one wraps to UINT32_MAX
+    uint64_t seenCalls[CENSUS_CALLS] = {}, seenBytes = 0;
+    std::thread snapshotter([&]
+                            {
+        while (!done.load())
+        {
+            CensusFrame frame;
+            g_Census.snapshot(frame);
+            for (uint32_t c = 0; c < CENSUS_CALLS; c++)
+            {
+                seenCalls[c] += frame.calls[c];
+                shrunk += frame.calls[c] == UINT32_MAX ? 1 : 0;
+            }
+            seenBytes += frame.bytes[uint32_t(ApiBytes::Map)];
+            snapshots++;
+        } });
+
+    // counts while the census is off must not show up
+    g_Census.setEnabled(false);
+    for (uint64_t i = 0; i < calls; i++)
+        g_Census.count(callOf(i));
+    g_Census.setEnabled(true);
+
+    for (uint32_t threads : waves)
+    {
+        std::atomic<uint32_t> claimed{0};
+        std::vector<std::thread> pool;
+        for (uint32_t t = 0; t < threads; t++)
+            pool.emplace_back([&, t]
+                              {
+                g_Census.count(callOf(t)); // claims the thread's block
+                claimed++;
+                while (claimed.load() < threads) // everyone holds a block at once
+                    std::this_thread::yield();
+                for (uint64_t i = 1; i < calls; i++)
+                {
+                    g_Census.count(callOf(t + i));
+                    if (i % 64 == 0)
+                        g_Census.addBytes(ApiBytes::Map, 3);
+                } });
+        for (std::thread &t : pool)
+            t.join();
+        for (uint32_t t = 0; t < threads; t++)
+        {
+            for (uint64_t i = 0; i < calls; i++)
+                expectCalls[uint32_t(callOf(t + i))]++;
+            expectBytes += 3 * ((calls - 1) / 64);
+        }
+    }
+    done = true;
+    snapshotter.join();
+
+    // what the snapshotter missed at the end
+    CensusFrame frame;
+    g_Census.snapshot(frame);
+    for (uint32_t c = 0; c < CENSUS_CALLS; c++)
+        seenCalls[c] += frame.calls[c];
+    seenBytes += frame.bytes[uint32_t(ApiBytes::Map)];
+
+    uint32_t wrong = 0;
+    for (uint32_t c = 0; c < CENSUS_CALLS; c++)
+        if (seenCalls[c] != expectCalls[c] && wrong++ < 4)
+            printf("%s: %llu, want %llu\n", apiCallName(c), (unsigned long long)seenCalls[c],
+                   (unsigned long long)expectCalls[c]);
+    bool ok = !wrong && seenBytes == expectBytes && !shrunk;
+    printf("%llu snapshots, %u calls wrong, map bytes %llu (want %llu), totals shrank %llu times: %s\n",
+           (unsigned long long)snapshots.load(), wrong, (unsigned long long)seenBytes,
+           (unsigned long long)expectBytes, (unsigned long long)shrunk.load(), ok ? "exact" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+    bool test = false;
+    uint64_t calls = 0;
+    uint32_t threads = 4;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--bench"))
+            test = false;
+        else if (!strcmp(argv[i], "--selftest"))
+            test = true;
+        else if (!strcmp(argv[i], "--calls") && i + 1 < argc)
+            calls = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+            threads = uint32_t(strtoul(argv[++i], nullptr, 10));
+        else
+        {
+            fprintf(stderr, "usage: %s [--bench] [--calls N] [--threads N]\n"
+                            "       %s --selftest [--calls N]\n",
+                    argv[0], argv[0]);
+            return 1;
+        }
+    }
+    if (test)
+        return selftest(calls ? calls : 20000);
+    return bench(calls ? calls : 20000000, threads ? threads : 1);
+}
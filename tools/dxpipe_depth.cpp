@@ -0,0 +1,420 @@
+// dxpipe_depth – runs a dxpipe API capture through the depth buffer detection
+//
+//  usage: dxpipe_depth <capture.dxcap> [--frames N] [--candidates] [--profile <file.dxprof>]
+//         dxpipe_depth --selftest
+//
+// feeds the recorded texture / DSV creations and context events into the same
+// DepthCandidates core the layer scores every Present with, then prints every
+// promotion (frame, texture, size, format) and optionally the final candidate table.
+// used to tune the scoring against recordings of real games, builds on Linux.
+// --profile runs with a depth profile store (DepthProfile.h) keyed by the capture's file
+// name: a second run over the same capture should promote at creation, before frame 0.
+// --selftest generates the frames instead (a back buffer sized scene depth, a cascaded
+// shadow map recorded on a deferred context with more draws, an allocation never bound)
+// and checks that the scene depth is promoted and kept, that a single odd frame can't
+// flip it, and that a buffer taking over is promoted exactly when it has beaten the
+// promoted one by MARGIN for HOLD_FRAMES frames in a row. exits non-zero on any mismatch.
+
+// c++ includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <vector>
+
+// layer headers (platform independent)
+#include "LayerEvents.h"
+#include "CaptureLog.h"
+#include "DepthCandidates.h"
+#include "DepthProfile.h"
+
+// whole profile file in memory (the layer maps it), zeroed if missing / wrong size
+static std::vector<uint8_t> loadProfiles(const char *path)
+{
+    std::vector<uint8_t> data(DepthProfileStore::bytes());
+    if (FILE *f = fopen(path, "rb"))
+    {
+        if (fread(data.data(), 1, data.size(), f) != data.size())
+            memset(data.data(), 0, data.size());
+        fclose(f);
+    }
+    return data;
+}
+
+static bool saveProfiles(const char *path, const std::vector<uint8_t> &data)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f)
+        return false;
+    bool ok = fwrite(data.data(), 1, data.size(), f) == data.size();
+    return fclose(f) == 0 && ok;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// selftest
+///////////////////////////////////////////////////////////////////////////////////////////
+
+static uint32_t s_failed = 0;
+
+static void check(bool ok, const char *what)
+{
+    if (!ok)
+    {
+        printf("FAILED: %s\n", what);
+        s_failed++;
+    }
+}
+
+// stand-ins for the game's textures and DSVs, only their addresses matter
+static char s_objects[64];
+enum : uint32_t
+{
+    SCENE, SHADOW, UNUSED, SCENE2, COLOUR,             // textures
+    SCENE_DSV = 16, SHADOW_DSV, UNUSED_DSV, SCENE2_DSV // their views
+};
+static const void *obj(uint32_t i)
+{
+    return &s_objects[i];
+}
+
+static const uint32_t WIDTH = 1920, HEIGHT = 1080;
+
+// one depth pass: bind, clear, draws (context 0 = immediate, else a deferred recording)
+static void depthPass(EventBuffer &frame, uint32_t dsv, uint32_t draws, uint16_t context = 0)
+{
+    frame.push({obj(dsv), 0, 0, EventKind::SetRenderTargets, context});
+    frame.push({obj(dsv), 0, 0, EventKind::ClearDepthStencil, context});
+    for (uint32_t i = 0; i < draws; i++)
+        frame.push({nullptr, 3, 0, EventKind::DrawIndexed, context});
+}
+
+static float scoreOf(const DepthCandidates &depth, uint32_t texture)
+{
+    for (const DepthCandidate &c : depth.snapshot())
+        if (c.texture == obj(texture))
+            return c.score;
+    return -1.0f;
+}
+
+// end the frame and check the promotion against the hysteresis rule: the best used
+// candidate has to beat the promoted one by MARGIN for HOLD_FRAMES frames in a row
+struct Hysteresis
+{
+    const void *promoted = nullptr;
+    uint32_t challenger = UINT32_MAX;
+    uint32_t streak = 0;
+    uint32_t longest = 0; // longest streak that didn't promote
+};
+
+static const void *endFrame(DepthCandidates &depth, EventBuffer &frame, uint64_t id, Hysteresis &h,
+                            std::initializer_list<uint32_t> used)
+{
+    const void *best = depth.endFrame(frame, id, WIDTH, HEIGHT);
+    frame.clear();
+
+    uint32_t challenger = UINT32_MAX;
+    for (uint32_t t : used)
+        if (challenger == UINT32_MAX || scoreOf(depth, t) > scoreOf(depth, challenger))
+            challenger = t;
+
+    const void *expected = h.promoted;
+    if (!h.promoted)
+    {
+        if (challenger != UINT32_MAX && scoreOf(depth, challenger) >= DepthCandidates::MIN_SCORE)
+            expected = obj(challenger);
+        h.streak = 0;
+    }
+    else if (challenger != UINT32_MAX && obj(challenger) != h.promoted &&
+             scoreOf(depth, challenger) > scoreOf(depth, uint32_t(static_cast<const char *>(h.promoted) - s_objects)) *
+                                              DepthCandidates::MARGIN)
+    {
+        h.streak = challenger == h.challenger ? h.streak + 1 : 1;
+        if (h.streak >= DepthCandidates::HOLD_FRAMES)
+        {
+            expected = obj(challenger);
+            h.streak = 0;
+        }
+        else if (h.streak > h.longest)
+            h.longest = h.streak;
+    }
+    else
+    {
+        h.streak = 0;
+    }
+    h.challenger = h.streak ? challenger : UINT32_MAX;
+
+    if (best != expected)
+        printf("frame %llu: promoted %p, expected %p (streak %u)\n", (unsigned long long)id, best, expected, h.streak);
+    check(best == expected, "promotion follows the hysteresis rule");
+    h.promoted = best;
+    return best;
+}
+
+static int selftest()
+{
+    DepthCandidates depth;
+    EventBuffer frame(4096);
+
+    const DepthTextureInfo scene = {WIDTH, HEIGHT, FMT_D24_UNORM_S8_UINT, 1, 1, BIND_DEPTH_STENCIL};
+    const DepthTextureInfo shadow = {2048, 2048, FMT_R32_TYPELESS, 1, 4, BIND_DEPTH_STENCIL | BIND_SHADER_RESOURCE};
+    const DepthTextureInfo unused = {WIDTH, HEIGHT, FMT_D32_FLOAT, 1, 1, BIND_DEPTH_STENCIL};
+    depth.resetOrdinals();
+    check(depth.addTexture(obj(SHADOW), shadow), "shadow map tracked");
+    check(depth.addTexture(obj(UNUSED), unused), "unused allocation tracked");
+    check(depth.addTexture(obj(SCENE), scene), "scene depth tracked");
+    check(!depth.addTexture(obj(COLOUR), {WIDTH, HEIGHT, FMT_R8G8B8A8_UNORM, 1, 1, BIND_RENDER_TARGET}),
+          "colour target not tracked");
+    depth.addView(obj(SHADOW_DSV), obj(SHADOW));
+    depth.addView(obj(UNUSED_DSV), obj(UNUSED));
+    depth.addView(obj(SCENE_DSV), obj(SCENE));
+    check(depth.textureOfView(obj(SCENE_DSV)) == obj(SCENE), "DSV maps to its texture");
+
+    // the usual frame: the shadow cascades have more draws than the scene, recorded on a
+    // deferred context that ends up between the scene's two halves
+    auto usual = [&]()
+    {
+        depthPass(frame, SCENE_DSV, 150);
+        depthPass(frame, SHADOW_DSV, 600, 1);
+        for (uint32_t i = 0; i < 150; i++)
+            frame.push({nullptr, 3, 0, EventKind::DrawIndexed, 0}); // still the scene on the immediate
+    };
+
+    Hysteresis h;
+    uint64_t id = 0;
+    usual();
+    check(endFrame(depth, frame, id++, h, {SCENE, SHADOW}) == obj(SCENE), "scene depth promoted on the first frame");
+
+    // 300 draws + a clear + a bind + the view bonus, back buffer sized, smoothed once
+    float expected = (300 * DepthCandidates::WEIGHT_DRAW + DepthCandidates::WEIGHT_CLEAR +
+                      DepthCandidates::WEIGHT_BIND + DepthCandidates::BONUS_VIEW) *
+                     DepthCandidates::SIZE_EXACT * DepthCandidates::SMOOTHING;
+    check(fabsf(scoreOf(depth, SCENE) - expected) < 1e-3f, "scene score counts the draws after the deferred pass");
+    check(scoreOf(depth, UNUSED) == 0.0f, "unused allocation scores nothing");
+
+    for (uint32_t i = 0; i < 60; i++)
+    {
+        usual();
+        endFrame(depth, frame, id++, h, {SCENE, SHADOW});
+    }
+    check(depth.promoted() == obj(SCENE), "scene depth kept over the shadow map");
+    check(scoreOf(depth, SCENE) > 10.0f * scoreOf(depth, SHADOW), "shadow map scores well below the scene");
+
+    // one frame that only renders shadows (a cutscene cut, a loading frame) beats the
+    // scene by far, it must not flip the promotion
+    depthPass(frame, SHADOW_DSV, 160000, 1);
+    endFrame(depth, frame, id++, h, {SHADOW});
+    check(h.streak > 0, "the odd frame challenges the scene depth");
+    for (uint32_t i = 0; i < 3 * DepthCandidates::HOLD_FRAMES; i++)
+    {
+        usual();
+        endFrame(depth, frame, id++, h, {SCENE, SHADOW});
+    }
+    check(depth.promoted() == obj(SCENE), "one odd frame doesn't flip the promotion");
+    check(h.longest > 0 && h.longest < DepthCandidates::HOLD_FRAMES, "the odd frame's challenge ran out");
+
+    // the game moves the scene into a new buffer, it is promoted once it has held the
+    // margin for HOLD_FRAMES frames, not on the first frame it is used
+    depth.addTexture(obj(SCENE2), unused);
+    depth.addView(obj(SCENE2_DSV), obj(SCENE2));
+    uint64_t switched = id, promotedAt = 0;
+    for (uint32_t i = 0; i < 60 && !promotedAt; i++)
+    {
+        depthPass(frame, SCENE2_DSV, 300);
+        depthPass(frame, SHADOW_DSV, 600, 1);
+        if (endFrame(depth, frame, id++, h, {SCENE2, SHADOW}) == obj(SCENE2))
+            promotedAt = id - 1;
+    }
+    check(promotedAt != 0, "the new scene depth is promoted");
+    check(promotedAt >= switched + DepthCandidates::HOLD_FRAMES - 1, "not before HOLD_FRAMES frames");
+    printf("scene depth moved at frame %llu, promoted at frame %llu\n", (unsigned long long)switched,
+           (unsigned long long)promotedAt);
+
+    // a released texture loses the promotion
+    depth.removeTexture(obj(SCENE2));
+    check(!depth.promoted() && !depth.textureOfView(obj(SCENE2_DSV)), "released texture demoted");
+    check(scoreOf(depth, UNUSED) == 0.0f, "unused allocation never scored");
+
+    for (const DepthCandidate &c : depth.snapshot())
+        printf("  %p %ux%u format %u array %u score %.2f\n", c.texture, c.info.width, c.info.height, c.info.format,
+               c.info.arraySize, c.score);
+    printf("%llu frames: %s\n", (unsigned long long)id, s_failed ? "FAILED" : "ok");
+    return s_failed ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc == 2 && !strcmp(argv[1], "--selftest"))
+        return selftest();
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <capture.dxcap> [--frames N] [--candidates] [--profile <file.dxprof>]\n"
+                        "       %s --selftest\n",
+                argv[0], argv[0]);
+        return 1;
+    }
+
+    const char *path = argv[1];
+    uint64_t maxFrames = UINT64_MAX;
+    bool listCandidates = false;
+    const char *profilePath = nullptr;
+    for (int i = 2; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--frames") && i + 1 < argc)
+            maxFrames = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--candidates"))
+            listCandidates = true;
+        else if (!strcmp(argv[i], "--profile") && i + 1 < argc)
+            profilePath = argv[++i];
+    }
+
+    std::vector<uint8_t> profileData;
+    DepthProfileStore profiles;
+    DepthProfile profile = {};
+    uint64_t exe = 0;
+    if (profilePath)
+    {
+        profileData = loadProfiles(profilePath);
+        profiles.attach(profileData.data(), profileData.size());
+        const char *name = strrchr(path, '/');
+        exe = depthProfileHash(name ? name + 1 : path);
+    }
+
+    CaptureReader reader;
+    if (!reader.open(path))
+    {
+        fprintf(stderr, "failed to open capture: %s\n", path);
+        return 1;
+    }
+
+    DepthCandidates depth;
+    EventBuffer frame(16384);
+    uint32_t width = 0, height = 0;
+    uint64_t frames = 0, promotions = 0;
+    const void *current = nullptr;
+
+    // the layer's applyDepthProfile: swap chain created / resized
+    auto applyProfile = [&]()
+    {
+        depth.resetOrdinals();
+        if (!profilePath)
+            return;
+        profile = {};
+        profile.exe = exe;
+        profile.width = width;
+        profile.height = height;
+        if (profiles.find(exe, width, height, profile))
+        {
+            profile.uses++;
+            profiles.store(profile);
+            depth.prefer(depthProfileTexture(profile), profile.ordinal);
+            printf("profile %ux%u: %ux%u format %u ordinal %u (used %u times)\n", width, height, profile.texWidth,
+                   profile.texHeight, profile.format, profile.ordinal, profile.uses);
+        }
+        else
+        {
+            depth.clearPreference();
+        }
+    };
+
+    for (const CaptureRecord &r : reader.records())
+    {
+        if (frames >= maxFrames)
+            break;
+
+        const void *handle = reinterpret_cast<const void *>(uintptr_t(r.handle));
+        switch (CaptureOp(r.op))
+        {
+        case CaptureOp::CreateTexture2D:
+        case CaptureOp::GetBuffer:
+        {
+            CaptureTextureDesc d = {};
+            if (const uint8_t *p = reader.blob(r.blob, sizeof(d)))
+                memcpy(&d, p, sizeof(d));
+            if (CaptureOp(r.op) == CaptureOp::GetBuffer && (d.width != width || d.height != height))
+            {
+                width = d.width;
+                height = d.height;
+                applyProfile();
+            }
+            if (depth.addTexture(handle, {d.width, d.height, d.format, d.sampleCount, d.arraySize, d.bindFlags}) &&
+                depth.promoted() == handle && handle != current)
+            {
+                printf("frame %llu: %p promoted at creation (profile)\n", (unsigned long long)frames, handle);
+                current = handle;
+                promotions++;
+            }
+            break;
+        }
+        case CaptureOp::CreateView:
+            if (r.a32 == CaptureViewDSV)
+                depth.addView(handle, reinterpret_cast<const void *>(uintptr_t(r.arg)));
+            break;
+        case CaptureOp::ResizeBuffers:
+            width = uint32_t(r.arg);
+            height = uint32_t(r.arg >> 32);
+            applyProfile();
+            break;
+        case CaptureOp::Present:
+        {
+            const void *best = depth.endFrame(frame, frames, width, height);
+            if (best != current)
+            {
+                DepthTextureInfo info = {};
+                uint32_t ordinal = 0;
+                depth.promotedInfo(info, &ordinal);
+                printf("frame %llu: promoted %p (%ux%u format %u samples %u ordinal %u)\n",
+                       (unsigned long long)frames, best, info.width, info.height, info.format, info.samples, ordinal);
+                current = best;
+                promotions++;
+
+                // the layer's updateDepthProfile (projection fields are left as they are)
+                if (profilePath && best && width && height)
+                {
+                    profile.exe = exe;
+                    profile.width = width;
+                    profile.height = height;
+                    profile.texWidth = info.width;
+                    profile.texHeight = info.height;
+                    profile.format = info.format;
+                    profile.samples = info.samples;
+                    profile.arraySize = info.arraySize;
+                    profile.bindFlags = info.bindFlags;
+                    profile.ordinal = ordinal;
+                    profiles.store(profile);
+                }
+            }
+            frame.clear();
+            frames++;
+            break;
+        }
+        default:
+            if (isContextOp(r.op))
+                frame.push({handle, r.arg, r.a32, EventKind(r.op - uint16_t(CaptureOp::ContextBase)), r.context});
+            break;
+        }
+    }
+
+    printf("frames: %llu, promotions: %llu, target %ux%u\n",
+           (unsigned long long)frames, (unsigned long long)promotions, width, height);
+
+    if (profilePath)
+    {
+        if (!saveProfiles(profilePath, profileData))
+        {
+            fprintf(stderr, "failed to write profiles: %s\n", profilePath);
+            return 1;
+        }
+        printf("profile %s: %s\n", profilePath, depth.preferenceHit() ? "hit, promoted at creation" : "stored");
+    }
+
+    if (listCandidates)
+    {
+        for (const DepthCandidate &c : depth.snapshot())
+        {
+            printf("  %p %ux%u format %u samples %u array %u views %u score %.2f last used %llu%s\n",
+                   c.texture, c.info.width, c.info.height, c.info.format, c.info.samples, c.info.arraySize,
+                   c.views, c.score, (unsigned long long)c.lastUsed, c.texture == current ? "  <- depth" : "");
+        }
+    }
+    return 0;
+}
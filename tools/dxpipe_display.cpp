@@ -0,0 +1,312 @@
+// dxpipe_display – cost and correctness of the present to display tracking (DisplayTiming.h), builds on Linux
+//
+//  usage: dxpipe_display [--bench] [--frames N]
+//         dxpipe_display --selftest [--frames N]
+//
+// both play a game against a model of a 60 Hz flip queue (sync interval 1, at most three
+// frames queued, Present blocks until one leaves): a frame goes on screen at the first
+// vblank after its GPU work is done and after the frame before it, GetFrameStatistics is
+// answered from the model when Present returns.
+// --bench (default) measures what the primary's Present pays per frame for sample() and
+// presented() (the latency histograms' summaries amortised in).
+// --selftest checks every resolved frame against the model: shown or unseen, the vblank
+// and its time (exact or extrapolated), the queue at its Present and the missed vblanks,
+// then the counts, the latency histogram, a reset in the middle (statistics disjoint) and
+// a swap chain without statistics (the pending frames must not grow). exits non-zero on
+// any mismatch.
+
+// c++ includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <vector>
+
+// layer headers (platform independent)
+#include "DisplayTiming.h"
+
+static const uint64_t MS = 1000000;         // ns
+static const uint64_t PERIOD_NS = 16666667; // 60 Hz
+static const uint64_t GPU_NS = 3 * MS;      // Present to the end of the frame's GPU work
+static const uint32_t MAX_QUEUED = 3;       // frames DXGI queues before Present blocks
+
+// deterministic frame times (xorshift), the same run every time
+static uint32_t s_random = 0x9E3779B9u;
+static uint32_t nextRandom()
+{
+    s_random ^= s_random << 13;
+    s_random ^= s_random >> 17;
+    s_random ^= s_random << 5;
+    return s_random;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// the display model
+///////////////////////////////////////////////////////////////////////////////////////////
+
+struct ModelFrame
+{
+    uint64_t presentNs;
+    uint32_t vblank; // it went on screen at
+    uint32_t queued; // frames ahead of it not on screen as of the statistics after its Present
+};
+
+class FlipModel
+{
+public:
+    // a Present called at nowNs (1-based present count = index + 1), returns when it returns
+    uint64_t present(uint64_t nowNs)
+    {
+        uint64_t ready = nowNs + GPU_NS;
+        uint32_t vblank = uint32_t((ready + PERIOD_NS - 1) / PERIOD_NS);
+        if (!frames.empty() && vblank <= frames.back().vblank)
+            vblank = frames.back().vblank + 1;
+        frames.push_back({nowNs, vblank, 0});
+
+        // blocks while too many frames are ahead of the screen
+        uint64_t returnNs = nowNs;
+        size_t waiting = frames.size();
+        while (waiting && frames[waiting - 1].vblank * PERIOD_NS > returnNs)
+            waiting--;
+        if (frames.size() - waiting > MAX_QUEUED)
+            returnNs = frames[frames.size() - MAX_QUEUED - 1].vblank * PERIOD_NS;
+        return returnNs;
+    }
+
+    // GetFrameStatistics at nowNs (right after a Present returned), false before the first
+    // frame reached the screen
+    bool statistics(uint64_t nowNs, DisplaySample &s)
+    {
+        size_t shown = frames.size();
+        while (shown && frames[shown - 1].vblank * PERIOD_NS > nowNs)
+            shown--;
+        if (shown)
+            m_sampled = shown;
+        if (m_sampled && !frames.empty())
+            frames.back().queued = uint32_t(frames.size() - 1 - m_sampled);
+        if (!shown)
+            return false;
+        s.presentCount = uint32_t(shown);
+        s.presentRefresh = frames[shown - 1].vblank;
+        s.syncRefresh = uint32_t(nowNs / PERIOD_NS);
+        s.syncNs = uint64_t(s.syncRefresh) * PERIOD_NS;
+        return true;
+    }
+
+    std::vector<ModelFrame> frames;
+
+private:
+    size_t m_sampled = 0; // frames on screen as of the last statistics
+};
+
+// 10..20 ms with an 80 ms hitch now and then (the queue runs dry, vblanks are missed) and
+// bursts of 4 ms frames
+static uint64_t frameNs(uint64_t f)
+{
+    if (f % 97 == 50)
+        return 80 * MS;
+    if (f % 211 < 6)
+        return 4 * MS;
+    return 10 * MS + nextRandom() % (10 * MS);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// bench
+///////////////////////////////////////////////////////////////////////////////////////////
+
+static int bench(uint64_t frames)
+{
+    // the model's answers first, so only the tracker is timed
+    FlipModel model;
+    std::vector<DisplaySample> samples(frames);
+    std::vector<bool> valid(frames);
+    uint64_t now = 0;
+    for (uint64_t f = 0; f < frames; f++)
+    {
+        now += frameNs(f);
+        uint64_t returned = model.present(now);
+        DisplaySample s{};
+        valid[f] = model.statistics(returned, s);
+        now = returned;
+        samples[f] = s;
+    }
+
+    DisplayTracker *display = new DisplayTracker();
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint64_t f = 0; f < frames; f++)
+    {
+        const ModelFrame &m = model.frames[f];
+        if (valid[f])
+            display->sample(samples[f], samples[f].syncNs);
+        display->presented(f, m.presentNs, uint32_t(f + 1), 1, f % 3 ? 5000 : 0);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / double(frames);
+
+    FrameTimeSummary s[FRAME_WINDOWS];
+    display->latency().read(s);
+    const FrameTimeSummary &m = s[uint32_t(FrameWindow::Minute)];
+    printf("%.1f ns per frame (sample + presented), %llu frames: %llu shown, %llu unseen, %llu missed vblanks\n", ns,
+           (unsigned long long)frames, (unsigned long long)display->shown(), (unsigned long long)display->unseen(),
+           (unsigned long long)display->missed());
+    printf("present to display over the last minute: p50 %.2f  p99 %.2f  max %.2f ms\n", m.p50Us / 1000.0,
+           m.p99Us / 1000.0, m.maxUs / 1000.0);
+    delete display;
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// selftest
+///////////////////////////////////////////////////////////////////////////////////////////
+
+// one run against the model from startNs on, every resolved frame checked (frame ids
+// from firstFrame on, present counts from 1), returns the failed checks
+static int checkRun(DisplayTracker &display, uint64_t frames, uint64_t firstFrame, uint64_t startNs,
+                    uint64_t &shownWithLatency)
+{
+    int failed = 0;
+    FlipModel model;
+    std::vector<uint32_t> sampledCount(frames, 0); // frames a sample named as the last one on screen
+    uint64_t now = 0, checked = display.resolved(), next = firstFrame;
+    uint64_t shown = 0, unseen = 0, missed = 0;
+    for (uint64_t f = 0; f < frames; f++)
+    {
+        now += frameNs(f);
+        uint64_t presentNs = now;
+        now = model.present(now);
+        DisplaySample s{};
+        if (model.statistics(now, s))
+        {
+            s.syncNs += startNs;
+            display.sample(s, startNs + now);
+            sampledCount[s.presentCount - 1] = 1;
+        }
+        display.presented(firstFrame + f, startNs + presentNs, uint32_t(f + 1), 1, f % 2 ? 2000 : 0);
+
+        // every record resolved by this sample against the model
+        for (; checked < display.resolved(); checked++)
+        {
+            const FrameDisplay &d = display.record(checked);
+            if (d.frame != next++)
+            {
+                printf("resolved frame %llu, want %llu\n", (unsigned long long)d.frame, (unsigned long long)(next - 1));
+                return failed + 1;
+            }
+            uint64_t i = d.frame - firstFrame;
+            const ModelFrame &m = model.frames[i];
+            bool seen = sampledCount[i] != 0;
+            uint32_t wantMissed = 0;
+            if (seen && i && sampledCount[i - 1])
+                wantMissed = m.vblank - model.frames[i - 1].vblank - 1;
+            bool ok = d.presentCount == i + 1 && d.presentNs == startNs + m.presentNs && d.queued == m.queued &&
+                      d.inputUs == (i % 2 ? 2000u : 0u);
+            if (seen)
+                ok = ok && d.flags & DISPLAY_SHOWN && !(d.flags & DISPLAY_UNSEEN) && d.refresh == m.vblank &&
+                     d.displayNs == startNs + m.vblank * PERIOD_NS && d.missed == wantMissed;
+            else
+                ok = ok && d.flags == DISPLAY_UNSEEN && !d.displayNs && !d.refresh;
+            if (!ok && failed++ < 4)
+                printf("frame %llu: flags %u vblank %u (want %u) display %llu (want %llu) queued %u (want %u) "
+                       "missed %u (want %u)\n",
+                       (unsigned long long)i, d.flags, d.refresh, m.vblank, (unsigned long long)d.displayNs,
+                       (unsigned long long)(startNs + m.vblank * PERIOD_NS), d.queued, m.queued, d.missed, wantMissed);
+            shown += seen ? 1 : 0;
+            unseen += seen ? 0 : 1;
+            missed += wantMissed;
+            shownWithLatency += seen ? 1 : 0;
+        }
+    }
+    // one more sample after the last frame reached the screen resolves everything
+    DisplaySample s{};
+    now += 10 * PERIOD_NS;
+    if (model.statistics(now, s) && s.presentCount == frames)
+    {
+        s.syncNs += startNs;
+        display.sample(s, startNs + now);
+    }
+    uint64_t left = firstFrame + frames - display.record(display.resolved() - 1).frame - 1;
+    if (left || !shown || !unseen || !missed)
+    {
+        printf("run of %llu frames: %llu left pending, %llu shown, %llu unseen, %llu missed (want 0 and some)\n",
+               (unsigned long long)frames, (unsigned long long)left, (unsigned long long)shown,
+               (unsigned long long)unseen, (unsigned long long)missed);
+        failed++;
+    }
+    shownWithLatency += 1; // the final sample's frame
+    return failed;
+}
+
+static int selftest(uint64_t frames)
+{
+    DisplayTracker *display = new DisplayTracker();
+    uint64_t shownWithLatency = 0;
+    int failed = checkRun(*display, frames, 0, 0, shownWithLatency);
+    if (display->periodNs() != PERIOD_NS)
+    {
+        printf("refresh period %llu ns, want %llu\n", (unsigned long long)display->periodNs(),
+               (unsigned long long)PERIOD_NS);
+        failed++;
+    }
+    uint64_t shown = display->shown(), unseen = display->unseen();
+    printf("%llu frames: %llu shown, %llu unseen, %llu missed vblanks, period %llu ns: %s\n", (unsigned long long)frames,
+           (unsigned long long)shown, (unsigned long long)unseen, (unsigned long long)display->missed(),
+           (unsigned long long)display->periodNs(), failed ? "FAILED" : "exact");
+
+    // statistics disjoint: the model starts over with count 1, the frame ids go on
+    display->presented(frames, 1, uint32_t(frames + 1), 1, 0); // lost with the reset
+    display->reset();
+    int again = checkRun(*display, frames / 2, frames + 1, uint64_t(frames) * 50 * MS, shownWithLatency);
+    printf("reset, %llu more frames: %s\n", (unsigned long long)(frames / 2), again ? "FAILED" : "exact");
+    failed += again;
+
+    // every shown frame's latency went into the histogram (latencies are all positive here)
+    FrameTimeSummary s[FRAME_WINDOWS];
+    uint64_t total = 0;
+    if (!display->latency().read(s, &total) || total != display->shown() || total != shownWithLatency)
+    {
+        printf("latency histogram: %llu frames, %llu shown (%llu checked)\n", (unsigned long long)total,
+               (unsigned long long)display->shown(), (unsigned long long)shownWithLatency);
+        failed++;
+    }
+
+    // no statistics at all: pending frames are capped, nothing is resolved
+    DisplayTracker *blind = new DisplayTracker();
+    for (uint64_t f = 0; f < 10 * DISPLAY_PENDING; f++)
+        blind->presented(f, (f + 1) * 16 * MS, uint32_t(f + 1), 1, 0);
+    DisplaySample late = {uint32_t(10 * DISPLAY_PENDING), 1000, 1000, 1000 * PERIOD_NS};
+    uint32_t n = blind->sample(late, 1000 * PERIOD_NS);
+    if (n != DISPLAY_PENDING || blind->shown() != 1 || blind->unseen() != DISPLAY_PENDING - 1 ||
+        blind->last().frame != 10 * DISPLAY_PENDING - 1)
+    {
+        printf("without statistics: %u resolved at once (want %u), %llu shown, last frame %llu\n", n, DISPLAY_PENDING,
+               (unsigned long long)blind->shown(), (unsigned long long)blind->last().frame);
+        failed++;
+    }
+    delete blind;
+    delete display;
+    return failed ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    bool test = false;
+    uint64_t frames = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--bench"))
+            test = false;
+        else if (!strcmp(argv[i], "--selftest"))
+            test = true;
+        else if (!strcmp(argv[i], "--frames") && i + 1 < argc)
+            frames = strtoull(argv[++i], nullptr, 10);
+        else
+        {
+            fprintf(stderr, "usage: %s [--bench] [--frames N]\n"
+                            "       %s --selftest [--frames N]\n",
+                    argv[0], argv[0]);
+            return 1;
+        }
+    }
+    if (test)
+        return selftest(frames ? frames : 20000);
+    return bench(frames ? frames : 1000000);
+}
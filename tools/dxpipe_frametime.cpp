@@ -0,0 +1,328 @@
+// dxpipe_frametime – cost and accuracy of the frame time histogram (FrameHistogram.h), builds on Linux
+//
+//  usage: dxpipe_frametime [--bench] [--frames N]
+//         dxpipe_frametime --selftest [--frames N]
+//
+// --bench (default) feeds a synthetic 144 fps Present loop with jitter and hitches and
+// measures what the primary's Present pays per frame (record(), a summary every
+// SUMMARY_MS amortised in), a summary on its own, an uncontended read() and reads
+// against a writer recording flat out on another thread.
+// --selftest checks every bucket boundary, compares each window's percentiles / lows /
+// maximum / hitches to an exact sort of the same intervals, checks a pause longer than
+// the longest window, and has two readers check every summary they copy while a writer
+// publishes (run it with TSan). exits non-zero on any mismatch.
+
+// c++ includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+// layer headers (platform independent)
+#include "FrameHistogram.h"
+
+static const uint64_t MS = 1000000; // ns
+
+// deterministic jitter (xorshift), the same run every time
+static uint32_t s_random = 0x9E3779B9u;
+static uint32_t nextRandom()
+{
+    s_random ^= s_random << 13;
+    s_random ^= s_random >> 17;
+    s_random ^= s_random << 5;
+    return s_random;
+}
+
+// a frame interval around `frameUs` (+-10 %), a hitch of 4-12 frames every `hitchEvery`
+static uint32_t syntheticUs(uint64_t f, uint32_t frameUs, uint32_t hitchEvery)
+{
+    if (hitchEvery && f % hitchEvery == hitchEvery - 1)
+        return frameUs * (4 + nextRandom() % 9);
+    return frameUs - frameUs / 10 + nextRandom() % (frameUs / 5 + 1);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// bench
+///////////////////////////////////////////////////////////////////////////////////////////
+
+static double nsSince(std::chrono::steady_clock::time_point t0)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static volatile uint32_t s_sink; // keeps the reads from being optimised out
+
+static int bench(uint64_t frames)
+{
+    FrameHistogram *h = new FrameHistogram();
+    std::vector<uint64_t> times(static_cast<size_t>(frames));
+    uint64_t ns = 1;
+    for (uint64_t f = 0; f < frames; f++)
+        times[size_t(f)] = ns += uint64_t(syntheticUs(f, 6944, 600)) * 1000;
+
+    auto t0 = std::chrono::steady_clock::now();
+    uint64_t hitches = 0;
+    for (uint64_t f = 0; f < frames; f++)
+        hitches += h->record(times[size_t(f)]) ? 1 : 0;
+    double record = nsSince(t0) / double(frames);
+
+    const uint32_t rounds = 1000;
+    t0 = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < rounds; i++)
+        h->summarize();
+    double summary = nsSince(t0) / rounds;
+
+    FrameTimeSummary out[FRAME_WINDOWS];
+    t0 = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < rounds * 100; i++)
+    {
+        h->read(out);
+        s_sink += out[0].p99Us;
+    }
+    double read = nsSince(t0) / (rounds * 100);
+
+    // readers against a writer publishing every 100 frames of 1 ms
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> reads{0}, misses{0};
+    auto reader = [&]
+    {
+        FrameTimeSummary s[FRAME_WINDOWS];
+        while (!done.load(std::memory_order_relaxed))
+        {
+            if (h->read(s))
+                reads.fetch_add(1, std::memory_order_relaxed);
+            else
+                misses.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+    std::thread r1(reader), r2(reader);
+    t0 = std::chrono::steady_clock::now();
+    for (uint64_t f = 0; f < frames; f++)
+        h->record(ns += MS);
+    double contended = nsSince(t0) / double(frames);
+    done = true;
+    r1.join();
+    r2.join();
+
+    const FrameTimeSummary &m = h->last(FrameWindow::Minute);
+    printf("%-22s %10s\n", "frame time histogram", "ns/call");
+    printf("%-22s %10.1f\n", "record (per Present)", record);
+    printf("%-22s %10.1f\n", "summary (3 windows)", summary);
+    printf("%-22s %10.1f\n", "read", read);
+    printf("%-22s %10.1f\n", "record, 2 readers", contended);
+    printf("%llu frames, %llu hitches, %llu reads under the writer (%llu retried out), %zu KB\n",
+           (unsigned long long)frames, (unsigned long long)hitches, (unsigned long long)reads.load(),
+           (unsigned long long)misses.load(), sizeof(FrameHistogram) / 1024);
+    printf("60 s window: %u frames, p99 %.2f ms, 1%% low %.1f fps\n", m.frames, m.p99Us / 1000.0,
+           m.low1Us ? 1e6 / m.low1Us : 0.0);
+    delete h;
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// selftest
+///////////////////////////////////////////////////////////////////////////////////////////
+
+// every interval lands in a bucket that contains it, buckets are ordered and narrow
+static int checkBuckets()
+{
+    uint32_t previous = 0;
+    for (uint32_t us = 0; us <= FRAME_MAX_US; us++)
+    {
+        uint32_t b = frameBucket(us), low = frameBucketLow(b), width = frameBucketWidth(b);
+        if (b >= FRAME_BUCKETS || b < previous || us < low || us >= low + width || uint64_t(width) * 64 > low + 64)
+        {
+            printf("interval %u us: bucket %u [%u, +%u)\n", us, b, low, width);
+            return 1;
+        }
+        previous = b;
+    }
+    if (frameBucket(UINT32_MAX) != FRAME_BUCKETS - 1)
+    {
+        printf("clamp: %u, want %u\n", frameBucket(UINT32_MAX), FRAME_BUCKETS - 1);
+        return 1;
+    }
+    return 0;
+}
+
+// within a bucket's width of the exact value
+static bool withinBucket(uint32_t got, double want)
+{
+    return std::fabs(double(got) - want) <= want / 64.0 + 1.0;
+}
+
+// the windows after `frames` synthetic Presents against the exact intervals they cover
+static int checkWindows(uint64_t frames)
+{
+    FrameHistogram *h = new FrameHistogram();
+    struct Sample
+    {
+        uint64_t slice;
+        uint32_t us;
+    };
+    std::vector<Sample> samples;
+    uint64_t start = 1000 * MS, ns = start, hitches = 0, injected = 0;
+    h->record(ns);
+    for (uint64_t f = 0; f < frames; f++)
+    {
+        // 60 fps, a hitch every 500 frames once the 10 s median is established
+        uint32_t us = syntheticUs(f, 16667, f > 1000 ? 500 : 0);
+        injected += f > 1000 && f % 500 == 499 ? 1 : 0;
+        ns += uint64_t(us) * 1000;
+        hitches += h->record(ns) ? 1 : 0;
+        samples.push_back({(ns - start) / (uint64_t(FRAME_SLICE_MS) * MS), us});
+    }
+    h->summarize();
+
+    int failed = 0;
+    if (hitches != injected || h->hitches() != injected)
+    {
+        printf("hitches: %llu (%llu counted), want %llu\n", (unsigned long long)hitches,
+               (unsigned long long)h->hitches(), (unsigned long long)injected);
+        failed++;
+    }
+
+    FrameTimeSummary read[FRAME_WINDOWS];
+    if (!h->read(read))
+    {
+        printf("nothing published\n");
+        failed++;
+    }
+    uint64_t current = samples.back().slice;
+    for (uint32_t w = 0; w < FRAME_WINDOWS; w++)
+    {
+        std::vector<uint32_t> exact;
+        double sum = 0.0;
+        for (const Sample &s : samples)
+            if (s.slice + FRAME_WINDOW_SLICES[w] >= current)
+            {
+                exact.push_back(s.us);
+                sum += s.us;
+            }
+        std::sort(exact.begin(), exact.end());
+        size_t n = exact.size();
+        auto rank = [&](double q)
+        { return double(exact[std::max<size_t>(1, size_t(std::ceil(q * double(n)))) - 1]); };
+        auto slowest = [&](double fraction)
+        {
+            size_t k = std::max<size_t>(1, size_t(std::ceil(fraction * double(n))));
+            double s = 0.0;
+            for (size_t i = n - k; i < n; i++)
+                s += exact[i];
+            return s / double(k);
+        };
+
+        const FrameTimeSummary &t = h->last(FrameWindow(w));
+        bool ok = t.frames == n && t.maxUs == exact.back() && withinBucket(t.meanUs, sum / double(n)) &&
+                  withinBucket(t.p50Us, rank(0.5)) && withinBucket(t.p99Us, rank(0.99)) &&
+                  withinBucket(t.p999Us, rank(0.999)) && withinBucket(t.low1Us, slowest(0.01)) &&
+                  withinBucket(t.low01Us, slowest(0.001)) &&
+                  !memcmp(&t, &read[w], sizeof(t));
+        printf("%-5s %6u frames  mean %8u (%8.0f)  p50 %6u (%6.0f)  p99 %6u (%6.0f)  p99.9 %6u (%6.0f)  max %6u "
+               "(%6u)  1%% %6u (%6.0f)  0.1%% %6u (%6.0f) us%s\n",
+               frameWindowName(w), t.frames, t.meanUs, sum / double(n), t.p50Us, rank(0.5), t.p99Us, rank(0.99),
+               t.p999Us, rank(0.999), t.maxUs, exact.back(), t.low1Us, slowest(0.01), t.low01Us, slowest(0.001),
+               ok ? "" : "  MISMATCH");
+        failed += ok ? 0 : 1;
+    }
+
+    // a pause longer than every window: only the interval across it is left
+    ns += 120000 * MS;
+    h->record(ns);
+    h->summarize();
+    for (uint32_t w = 0; w < FRAME_WINDOWS; w++)
+    {
+        const FrameTimeSummary &t = h->last(FrameWindow(w));
+        if (t.frames != 1 || t.maxUs != FRAME_MAX_US || !withinBucket(t.p50Us, FRAME_MAX_US))
+        {
+            printf("after a pause, %s: %u frames, max %u us (want 1, %u)\n", frameWindowName(w), t.frames, t.maxUs,
+                   FRAME_MAX_US);
+            failed++;
+        }
+    }
+    delete h;
+    return failed;
+}
+
+// a writer publishing every 100 frames against two readers, every copy must be one summary
+static int checkReaders(uint64_t frames)
+{
+    FrameHistogram *h = new FrameHistogram();
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> reads{0}, torn{0};
+    auto reader = [&]
+    {
+        uint64_t lastFrames = 0;
+        while (!done.load())
+        {
+            FrameTimeSummary s[FRAME_WINDOWS];
+            uint64_t total = 0, hitches = 0;
+            if (!h->read(s, &total, &hitches))
+                continue;
+            reads++;
+            bool ok = total >= lastFrames && hitches <= total;
+            for (uint32_t w = 0; w < FRAME_WINDOWS; w++)
+            {
+                const FrameTimeSummary &t = s[w];
+                ok = ok && t.frames <= total && t.hitches <= t.frames && t.p50Us <= t.p99Us &&
+                     t.p99Us <= t.p999Us && t.p999Us <= t.maxUs && t.p99Us <= t.low1Us && t.low1Us <= t.low01Us &&
+                     t.low01Us <= t.maxUs;
+            }
+            ok = ok && s[0].frames <= s[1].frames && s[1].frames <= s[2].frames;
+            lastFrames = total;
+            if (!ok && !torn++)
+                printf("torn summary at %llu frames\n", (unsigned long long)total);
+        }
+    };
+    std::thread r1(reader), r2(reader);
+
+    uint64_t ns = 1;
+    for (uint64_t f = 0; f < frames; f++)
+        h->record(ns += uint64_t(syntheticUs(f, 1000, 300)) * 1000);
+    done = true;
+    r1.join();
+    r2.join();
+
+    printf("%llu frames, %llu summaries read, %llu torn\n", (unsigned long long)frames,
+           (unsigned long long)reads.load(), (unsigned long long)torn.load());
+    delete h;
+    return torn ? 1 : 0;
+}
+
+static int selftest(uint64_t frames)
+{
+    int failed = checkBuckets();
+    printf("buckets: %u over 0..%u us%s\n", FRAME_BUCKETS, FRAME_MAX_US, failed ? ", FAILED" : "");
+    failed += checkWindows(frames);
+    failed += checkReaders(frames * 10);
+    printf("%s\n", failed ? "FAILED" : "ok");
+    return failed ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    bool test = false;
+    uint64_t frames = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--bench"))
+            test = false;
+        else if (!strcmp(argv[i], "--selftest"))
+            test = true;
+        else if (!strcmp(argv[i], "--frames") && i + 1 < argc)
+            frames = strtoull(argv[++i], nullptr, 10);
+        else
+        {
+            fprintf(stderr, "usage: %s [--bench] [--frames N]\n"
+                            "       %s --selftest [--frames N]\n",
+                    argv[0], argv[0]);
+            return 1;
+        }
+    }
+    return test ? selftest(frames ? frames : 20000) : bench(frames ? frames : 1000000);
+}
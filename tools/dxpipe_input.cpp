@@ -0,0 +1,238 @@
+// dxpipe_input – cost and correctness of the input age at present (InputLatency.h), builds on Linux
+//
+//  usage: dxpipe_input [--bench] [--frames N]
+//         dxpipe_input --selftest [--frames N]
+//
+// --bench (default) measures what the subclassed window procedure pays per input message
+// (arrived(), on its own and while another thread presents flat out) and what the
+// primary's Present pays per frame (presented() with and without input, the histogram's
+// summary every SUMMARY_MS amortised in).
+// --selftest plays frames on a synthetic clock with known input patterns (floods, gaps,
+// input older than FRAME_MAX_US) and checks every age, the counts and each window's
+// summary, then has an input thread stamp messages while a present thread takes them and
+// checks that none is lost or counted twice (run it with TSan). exits non-zero on any
+// mismatch.
+
+// c++ includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+// layer headers (platform independent)
+#include "InputLatency.h"
+
+static const uint64_t MS = 1000000; // ns
+
+static uint64_t steadyNs()
+{
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch())
+                        .count());
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// bench
+///////////////////////////////////////////////////////////////////////////////////////////
+
+template <class F>
+static double nsPer(uint64_t n, F &&f)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < n; i++)
+        f(i);
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / double(n);
+}
+
+static int bench(uint64_t frames)
+{
+    // a mouse flood: 8 messages per frame on a 144 fps synthetic clock
+    InputLatency *flood = new InputLatency();
+    const uint64_t frameNs = 6944444;
+    double arrived = nsPer(frames * 8, [&](uint64_t i)
+                           { flood->arrived(InputKind::Mouse, (i / 8) * frameNs + (i % 8) * 100000 + 1); });
+
+    InputLatency *input = new InputLatency();
+    double withInput = nsPer(frames, [&](uint64_t i)
+                             {
+        input->arrived(InputKind::Mouse, i * frameNs + 1);
+        input->presented(i * frameNs + 5 * MS); });
+    uint64_t base = frames * frameNs;
+    double withoutInput = nsPer(frames, [&](uint64_t i)
+                                { input->presented(base + i * frameNs); });
+
+    // arrived() against a thread presenting flat out (the cache line the two share bounces)
+    InputLatency *shared = new InputLatency();
+    std::atomic<bool> done{false};
+    std::thread presenter([&]
+                          {
+        while (!done.load(std::memory_order_relaxed))
+            shared->presented(steadyNs()); });
+    double contended = nsPer(frames * 8, [&](uint64_t)
+                             { shared->arrived(InputKind::Mouse, steadyNs()); });
+    done = true;
+    presenter.join();
+
+    printf("%-28s %8.2f ns\n", "arrived (flood)", arrived);
+    printf("%-28s %8.2f ns\n", "arrived (presenting thread)", contended);
+    printf("%-28s %8.2f ns\n", "presented (input)", withInput);
+    printf("%-28s %8.2f ns\n", "presented (no input)", withoutInput);
+    printf("%llu frames, %llu messages; the contended case includes two clock reads\n", (unsigned long long)frames,
+           (unsigned long long)(frames * 8));
+    delete flood;
+    delete input;
+    delete shared;
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// selftest
+///////////////////////////////////////////////////////////////////////////////////////////
+
+// frames on a synthetic 100 fps clock: every frame f gets input aged 1 + f % 8 ms (the
+// oldest of a flood), every fifth frame none; returns the number of failed checks
+static int checkAges(uint64_t frames)
+{
+    int failed = 0;
+    InputLatency *input = new InputLatency();
+    uint64_t expectInputs[INPUT_KINDS] = {}, withInput = 0;
+    for (uint64_t f = 1; f <= frames; f++)
+    {
+        uint64_t now = f * 10 * MS;
+        uint32_t want = 0;
+        if (f % 5)
+        {
+            want = uint32_t(1 + f % 8) * 1000;
+            input->arrived(InputKind::Mouse, now - want * 1000ull);
+            for (uint32_t i = 0; i < 5; i++) // the flood behind the first message
+                input->arrived(i % 2 ? InputKind::Keyboard : InputKind::Mouse, now - want * 1000ull + (i + 1) * 10000);
+            expectInputs[uint32_t(InputKind::Mouse)] += 4;
+            expectInputs[uint32_t(InputKind::Keyboard)] += 2;
+            withInput++;
+        }
+        uint32_t got = input->presented(now);
+        if ((got != want || input->lastUs() != want) && failed++ < 4)
+            printf("frame %llu: age %u us, want %u\n", (unsigned long long)f, got, want);
+    }
+    for (uint32_t k = 0; k < INPUT_KINDS; k++)
+        if (input->inputs(InputKind(k)) != expectInputs[k] && failed++ < 8)
+            printf("%s: %llu messages, want %llu\n", inputKindName(k),
+                   (unsigned long long)input->inputs(InputKind(k)), (unsigned long long)expectInputs[k]);
+
+    // the minute window holds the last 60 s of frames with input, ages 1..8 ms evenly
+    input->presented((frames + 1) * 10 * MS);
+    FrameTimeSummary s[FRAME_WINDOWS];
+    uint64_t total = 0;
+    const FrameTimeSummary &m = s[uint32_t(FrameWindow::Minute)];
+    if (!input->ages().read(s, &total) || total != withInput || m.maxUs != 8000 || m.p50Us < 4000 ||
+        m.p50Us > 5000 || m.hitches)
+    {
+        printf("summary: %llu frames with input (want %llu), p50 %u us, max %u us, %u hitches\n",
+               (unsigned long long)total, (unsigned long long)withInput, m.p50Us, m.maxUs, m.hitches);
+        failed++;
+    }
+
+    // input older than the histogram's range is clamped, a stamp after Present counts as 1 us
+    uint64_t now = (frames + 2) * 10 * MS;
+    input->arrived(InputKind::Keyboard, now - 100000ull * MS);
+    uint32_t stale = input->presented(now);
+    input->arrived(InputKind::Keyboard, now + 20 * MS);
+    uint32_t early = input->presented(now + 10 * MS);
+    if (stale != FRAME_MAX_US || early != 1)
+    {
+        printf("clamped ages: %u and %u us (want %u and 1)\n", stale, early, FRAME_MAX_US);
+        failed++;
+    }
+
+    // two minutes without input empty every window
+    for (uint64_t t = 1; t <= 12000; t++)
+        input->presented(now + 10 * MS + t * 10 * MS);
+    if (!input->ages().read(s) || s[uint32_t(FrameWindow::Minute)].frames || input->lastUs())
+    {
+        printf("idle: %u frames left in the minute window, last %u us (want 0, 0)\n",
+               s[uint32_t(FrameWindow::Minute)].frames, input->lastUs());
+        failed++;
+    }
+    delete input;
+    return failed;
+}
+
+// an input thread stamps messages on the real clock while a present thread takes them:
+// every message is counted once, every frame with input got an age
+static int checkThreads(uint64_t frames)
+{
+    InputLatency *input = new InputLatency();
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> sent{0};
+    std::thread window([&]
+                       {
+        for (uint64_t i = 0; !done.load(std::memory_order_relaxed); i++)
+        {
+            input->arrived(i % 3 ? InputKind::Mouse : InputKind::Keyboard, steadyNs());
+            sent.fetch_add(1, std::memory_order_relaxed);
+            if (i % 64 == 0)
+                std::this_thread::yield();
+        } });
+
+    uint64_t withInput = 0, zeroAges = 0, start = steadyNs();
+    for (uint64_t f = 0; f < frames; f++)
+    {
+        if (f % 16 == 0)
+            std::this_thread::yield();
+        withInput += input->presented(steadyNs()) ? 1 : 0;
+    }
+    done = true;
+    window.join();
+    // what came in after the last Present
+    withInput += input->presented(steadyNs()) ? 1 : 0;
+    zeroAges += input->presented(steadyNs()) ? 0 : 1; // nothing is left
+
+    uint64_t counted = input->inputs(InputKind::Mouse) + input->inputs(InputKind::Keyboard);
+    FrameTimeSummary s[FRAME_WINDOWS];
+    uint64_t total = 0;
+    input->ages().read(s, &total);
+    uint64_t elapsedUs = (steadyNs() - start) / 1000 + 1;
+    const FrameTimeSummary &m = s[uint32_t(FrameWindow::Minute)];
+    bool ok = counted == sent.load() && withInput && zeroAges == 1 && total <= withInput && m.maxUs <= elapsedUs;
+    printf("%llu messages sent, %llu counted; %llu of %llu frames had input: %s\n", (unsigned long long)sent.load(),
+           (unsigned long long)counted, (unsigned long long)withInput, (unsigned long long)frames,
+           ok ? "exact" : "FAILED");
+    delete input;
+    return ok ? 0 : 1;
+}
+
+static int selftest(uint64_t frames)
+{
+    int failed = checkAges(frames);
+    printf("%llu synthetic frames: %s\n", (unsigned long long)frames, failed ? "FAILED" : "exact");
+    failed += checkThreads(frames);
+    return failed ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    bool test = false;
+    uint64_t frames = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--bench"))
+            test = false;
+        else if (!strcmp(argv[i], "--selftest"))
+            test = true;
+        else if (!strcmp(argv[i], "--frames") && i + 1 < argc)
+            frames = strtoull(argv[++i], nullptr, 10);
+        else
+        {
+            fprintf(stderr, "usage: %s [--bench] [--frames N]\n"
+                            "       %s --selftest [--frames N]\n",
+                    argv[0], argv[0]);
+            return 1;
+        }
+    }
+    if (test)
+        return selftest(frames ? frames : 20000);
+    return bench(frames ? frames : 2000000);
+}
@@ -0,0 +1,217 @@
+// dxpipe_log – cost and correctness of the structured log (LayerLog.h), builds on Linux
+//
+//  usage: dxpipe_log [--bench] [--calls N]
+//         dxpipe_log --selftest [--threads N] [--records N]
+//
+// --bench (default) measures what a log call costs the calling thread:
+//  • compiled out  – a level above LOG_LEVEL (nothing, the baseline)
+//  • disabled      – a compiled level whose category is off at runtime
+//  • enabled       – queued for the writer thread (writing to the null device)
+//  • formatted     – what formatting on the calling thread would cost (snprintf)
+// --selftest has several threads log numbered records with every argument kind while the
+// writer drains to a temporary file, then checks that each line came out exactly once
+// and intact (or was counted as dropped): first paced in short bursts, where at most 1%
+// may drop, then flat out, where the queue overflows and only the count has to add up.
+// exits non-zero on any mismatch.
+
+// c++ includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+// layer headers (platform independent), the tool's own threshold: debug is compiled out
+#undef LOG_LEVEL
+#define LOG_LEVEL 3
+#include "LayerLog.h"
+
+LayerLog g_Log;
+
+#ifdef _WIN32
+static const char *NULL_DEVICE = "NUL";
+#else
+static const char *NULL_DEVICE = "/dev/null";
+#endif
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// bench
+///////////////////////////////////////////////////////////////////////////////////////////
+
+template <class F>
+static double nsPerCall(uint64_t calls, F &&f)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < calls; i++)
+        f(i);
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / double(calls);
+}
+
+static volatile uint64_t s_sink; // keeps the formatted baseline from being optimised out
+
+static int bench(uint64_t calls)
+{
+    const char *path = "C:\\Games\\Roblox\\RobloxPlayerBeta.exe";
+    void *handle = &calls;
+
+    g_Log.configure("all=off,ipc=info");
+    if (!g_Log.open(NULL_DEVICE))
+    {
+        fprintf(stderr, "can't open %s\n", NULL_DEVICE);
+        return 1;
+    }
+
+    double out = nsPerCall(calls, [&]([[maybe_unused]] uint64_t i)
+                           { LOG_DEBUG(Ipc, "Sent depth buffer info: handle={} frame={}", handle, i); });
+    double off = nsPerCall(calls, [&](uint64_t i)
+                           { LOG_INFO(SwapChain, "Sent depth buffer info: handle={} frame={}", handle, i); });
+
+    // the writer keeps up with one call per microsecond or so, pace the enabled run to
+    // what the queue holds so it measures queuing, not dropping
+    uint64_t queued = 0;
+    double on = 0.0;
+    for (uint64_t done = 0; done < calls; done += LogQueue::CAPACITY / 2)
+    {
+        uint64_t n = calls - done < LogQueue::CAPACITY / 2 ? calls - done : LogQueue::CAPACITY / 2;
+        on += nsPerCall(n, [&](uint64_t i)
+                        { LOG_INFO(Ipc, "Sent depth buffer info: handle={} frame={} path={} near={:.3f}", handle,
+                                   done + i, path, 0.1 * double(i)); }) *
+              double(n);
+        queued += n;
+        std::this_thread::sleep_for(std::chrono::milliseconds(LayerLog::DRAIN_MS * 2));
+    }
+    on /= double(queued);
+
+    double formatted = nsPerCall(calls, [&](uint64_t i)
+                                 {
+        char line[256];
+        s_sink += uint64_t(snprintf(line, sizeof(line), "Sent depth buffer info: handle=%p frame=%llu path=%s near=%.3f",
+                                    handle, (unsigned long long)i, path, 0.1 * double(i))); });
+    g_Log.close();
+
+    printf("%-14s %10s\n", "log call", "ns/call");
+    printf("%-14s %10.2f\n", "compiled out", out);
+    printf("%-14s %10.2f\n", "disabled", off);
+    printf("%-14s %10.2f\n", "enabled", on);
+    printf("%-14s %10.2f\n", "formatted", formatted);
+    printf("%llu calls, %llu written, %llu dropped\n", (unsigned long long)calls,
+           (unsigned long long)g_Log.written(), (unsigned long long)g_Log.dropped());
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// selftest
+///////////////////////////////////////////////////////////////////////////////////////////
+
+static bool logRun(uint32_t threads, uint64_t records, bool paced)
+{
+    FILE *file = tmpfile();
+    if (!file)
+    {
+        fprintf(stderr, "can't create a temporary file\n");
+        return false;
+    }
+
+    const uint64_t droppedBefore = g_Log.dropped();
+    g_Log.configure("all=info");
+    g_Log.open(file);
+
+    std::vector<std::thread> loggers;
+    for (uint32_t t = 0; t < threads; t++)
+        loggers.emplace_back([t, records, paced]
+                             {
+            std::string name = "thread-" + std::to_string(t);
+            for (uint64_t i = 0; i < records; i++)
+            {
+                LOG_INFO(Device, "rec {} {} {:x} {} {:.2f} {} {}", t, i, uint32_t(0x80070057u), name,
+                         double(i) / 4.0, i % 2 == 0, int32_t(-int32_t(i)));
+                LOG_DEBUG(Device, "never {}", i); // compiled out
+                if (paced && i % 64 == 63) // bursts the writer is woken for, well under the queue
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            } });
+    for (std::thread &t : loggers)
+        t.join();
+    g_Log.close();
+
+    // every record is either a line or counted as dropped
+    std::vector<std::vector<uint8_t>> seen(threads, std::vector<uint8_t>(size_t(records), 0));
+    uint64_t lines = 0, bad = 0, duplicates = 0, dropped = 0;
+    char line[1024];
+    rewind(file);
+    while (fgets(line, sizeof(line), file))
+    {
+        unsigned long long n = 0;
+        if (sscanf(line, "[log] %llu record(s) dropped", &n) == 1)
+        {
+            dropped += n;
+            continue;
+        }
+        const char *msg = strstr(line, "device    rec ");
+        unsigned t = 0;
+        unsigned long long i = 0;
+        char expect[256];
+        if (!msg || sscanf(msg, "device    rec %u %llu", &t, &i) != 2 || t >= threads || i >= records)
+        {
+            bad++;
+            continue;
+        }
+        snprintf(expect, sizeof(expect), "device    rec %u %llu 80070057 thread-%u %.2f %s %lld\n", t, i, t,
+                 double(i) / 4.0, i % 2 == 0 ? "true" : "false", -(long long)i);
+        if (strcmp(msg, expect))
+        {
+            if (bad++ < 4)
+                fprintf(stderr, "mismatch:\n  got  %s  want %s", msg, expect);
+            continue;
+        }
+        duplicates += seen[t][size_t(i)]++ ? 1 : 0;
+        lines++;
+    }
+    fclose(file);
+
+    const uint64_t total = uint64_t(threads) * records;
+    bool ok = !bad && !duplicates && lines + dropped == total && dropped == g_Log.dropped() - droppedBefore &&
+              (!paced || dropped * 100 <= total);
+    printf("%-6s %u threads x %llu records: %llu lines, %llu dropped, %llu malformed, %llu duplicates%s\n",
+           paced ? "paced" : "flood", threads, (unsigned long long)records, (unsigned long long)lines,
+           (unsigned long long)dropped, (unsigned long long)bad, (unsigned long long)duplicates, ok ? "" : ", FAILED");
+    return ok;
+}
+
+static int selftest(uint32_t threads, uint64_t records)
+{
+    bool ok = logRun(threads, records, true);
+    ok = logRun(threads, records, false) && ok;
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+    bool test = false;
+    uint64_t calls = 1000000;
+    uint32_t threads = 4;
+    uint64_t records = 20000;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--bench"))
+            test = false;
+        else if (!strcmp(argv[i], "--selftest"))
+            test = true;
+        else if (!strcmp(argv[i], "--calls") && i + 1 < argc)
+            calls = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+            threads = uint32_t(strtoul(argv[++i], nullptr, 10));
+        else if (!strcmp(argv[i], "--records") && i + 1 < argc)
+            records = strtoull(argv[++i], nullptr, 10);
+        else
+        {
+            fprintf(stderr, "usage: %s [--bench] [--calls N]\n"
+                            "       %s --selftest [--threads N] [--records N]\n",
+                    argv[0], argv[0]);
+            return 1;
+        }
+    }
+    return test ? selftest(threads, records) : bench(calls ? calls : 1);
+}
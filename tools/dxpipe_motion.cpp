@@ -0,0 +1,325 @@
+// dxpipe_motion – camera motion vectors on the software reference device, builds on Linux
+//
+//  usage: dxpipe_motion [--seed N] [--size WxH]
+//
+// renders random depth images (D32 / D24S8 copies, standard and reversed-Z) for a camera
+// pair a frame apart, runs them through exportMotionVectors<SoftApi> (the same template the
+// layer runs with D3D11Api) and checks each R16G16F texel against the motion worked out in
+// double: closest depth of the 2x2 footprint → world point with this frame's camera →
+// last frame's camera → uv now - uv last, within half precision. texels the last camera
+// can't see (w <= 0) must be 0. exits non-zero on any mismatch.
+
+// c++ includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <vector>
+
+// layer headers (platform independent)
+#include "SoftDevice.h"
+#include "FrameExport.h"
+
+static uint32_t s_rng = 1;
+static uint32_t rnd()
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static float rndf(float lo, float hi)
+{
+    return lo + (hi - lo) * float(rnd() & 0xFFFFFF) / 16777215.0f;
+}
+
+static const float s_near = 0.1f, s_far = 1000.0f;
+
+// D3D perspective (row vectors), reversed-Z swaps near and far
+static void perspective(float fovY, float aspect, bool reversed, float *m)
+{
+    float n = reversed ? s_far : s_near, f = reversed ? s_near : s_far;
+    float ys = 1.0f / tanf(fovY * 0.5f);
+    memset(m, 0, 16 * sizeof(float));
+    m[0] = ys / aspect;
+    m[5] = ys;
+    m[10] = f / (f - n);
+    m[11] = 1.0f;
+    m[14] = -n * f / (f - n);
+}
+
+// rigid view: yaw then pitch, then the eye moved to the origin
+static void lookFrom(float yaw, float pitch, const float *eye, float *m)
+{
+    float cy = cosf(yaw), sy = sinf(yaw), cp = cosf(pitch), sp = sinf(pitch);
+    // world → view rotation (rows are the world axes in view space)
+    float r[9] = {cy, sy * sp, sy * cp,
+                  0.0f, cp, -sp,
+                  -sy, cy * sp, cy * cp};
+    memset(m, 0, 16 * sizeof(float));
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            m[i * 4 + j] = r[i * 3 + j];
+    for (int j = 0; j < 3; j++)
+        m[12 + j] = -(eye[0] * r[j] + eye[1] * r[3 + j] + eye[2] * r[6 + j]);
+    m[15] = 1.0f;
+}
+
+static void viewProjection(const CameraMatrices &c, double *out)
+{
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++)
+        {
+            double s = 0.0;
+            for (int k = 0; k < 4; k++)
+                s += double(c.view[i * 4 + k]) * c.projection[k * 4 + j];
+            out[i * 4 + j] = s;
+        }
+}
+
+// depth the projection gives a point at view distance z
+static float projectDepth(const float *proj, float z)
+{
+    return (z * proj[10] + proj[14]) / z;
+}
+
+static void encodeDepth(uint32_t fmt, float d, uint8_t *texel)
+{
+    if (fmt == FMT_R24G8_TYPELESS)
+    {
+        uint32_t bits = uint32_t(lrintf(d * 16777215.0f)) | (rnd() << 24);
+        memcpy(texel, &bits, 4);
+    }
+    else
+        memcpy(texel, &d, 4);
+}
+
+struct Case
+{
+    const char *name;
+    uint32_t fmt;
+    bool reversed;
+    float turn; // yaw between the two frames (radians), large ones put points behind the last camera
+    float move; // eye distance between the two frames
+};
+
+// one depth format / camera pair, returns the number of wrong texels
+static uint64_t runCase(SoftDevice &device, SoftContext *ctx, const Case &c, uint32_t width, uint32_t height)
+{
+    float aspect = float(width) / float(height);
+    CameraMatrices last = {}, now = {};
+    float eye[3] = {rndf(-10.0f, 10.0f), rndf(0.0f, 5.0f), rndf(-10.0f, 10.0f)};
+    float yaw = rndf(-3.0f, 3.0f), pitch = rndf(-0.3f, 0.3f);
+    lookFrom(yaw, pitch, eye, last.view);
+    eye[0] += rndf(-c.move, c.move);
+    eye[1] += rndf(-c.move, c.move) * 0.25f;
+    eye[2] += rndf(-c.move, c.move);
+    lookFrom(yaw + c.turn, pitch + rndf(-0.02f, 0.02f), eye, now.view);
+    perspective(1.0f, aspect, c.reversed, last.projection);
+    perspective(1.0f, aspect, c.reversed, now.projection);
+    last.frame = 41;
+    now.frame = 42;
+    last.flags = now.flags = CAM_VALID;
+
+    MotionParams params = {};
+    if (!motionReprojection(last, now, params.reprojection))
+    {
+        printf("%-22s: singular view-projection\n", c.name);
+        return 1;
+    }
+    params.flags = c.reversed ? uint32_t(MOTION_REVERSED_Z) : 0u;
+
+    // depth: a ground of random distances, some texels on a far sky
+    uint32_t size = formatSize(c.fmt);
+    uint32_t pitchBytes = width * size;
+    std::vector<uint8_t> init(size_t(pitchBytes) * height);
+    for (uint32_t y = 0; y < height; y++)
+        for (uint32_t x = 0; x < width; x++)
+        {
+            float z = (rnd() & 15) ? rndf(s_near * 2.0f, 300.0f) : s_far;
+            encodeDepth(c.fmt, projectDepth(now.projection, z), &init[size_t(y) * pitchBytes + size_t(x) * size]);
+        }
+
+    SoftTextureDesc d = {};
+    d.Width = width;
+    d.Height = height;
+    d.MipLevels = 1;
+    d.ArraySize = 1;
+    d.Format = c.fmt;
+    d.SampleDesc.Count = 1;
+    d.Usage = USAGE_DEFAULT;
+    d.BindFlags = BIND_SHADER_RESOURCE;
+    SoftSubresourceData data = {init.data(), pitchBytes, 0};
+
+    SoftTexture2D *depth = nullptr;
+    if (!softSucceeded(device.CreateTexture2D(&d, &data, &depth)))
+    {
+        printf("%-22s: CreateTexture2D failed\n", c.name);
+        return 1;
+    }
+
+    SoftTexture2D *motion = nullptr, *readback = nullptr;
+    SoftMappedSubresource mapped = {};
+    ExportResult r = exportMotionVectors<SoftApi>(&device, ctx, depth, params, motion);
+    if (r != ExportResult::Recreated || !motion ||
+        exportMotionVectors<SoftApi>(&device, ctx, depth, params, motion) != ExportResult::Copied ||
+        exportStaging<SoftApi>(&device, ctx, motion, readback) == ExportResult::Failed ||
+        !softSucceeded(ctx->Map(readback, 0, MAP_READ, 0, &mapped)))
+    {
+        printf("%-22s: motion export failed\n", c.name);
+        SoftApi::release(readback);
+        SoftApi::release(motion);
+        depth->Release();
+        return 1;
+    }
+
+    double vpLast[16], vpNow[16], inv[16];
+    viewProjection(last, vpLast);
+    viewProjection(now, vpNow);
+    invertMatrix(vpNow, inv);
+
+    uint64_t bad = 0, hidden = 0;
+    double worst = 0.0;
+    for (uint32_t y = 0; y < motionExtent(height); y++)
+    {
+        const uint16_t *row = reinterpret_cast<const uint16_t *>(static_cast<const uint8_t *>(mapped.pData) + uint64_t(y) * mapped.RowPitch);
+        for (uint32_t x = 0; x < motionExtent(width); x++)
+        {
+            // closest texel of the footprint, the first one wins a tie
+            uint32_t bx = 0, by = 0;
+            float closest = 0.0f;
+            bool first = true;
+            for (uint32_t sy = y * 2; sy < y * 2 + 2 && sy < height; sy++)
+                for (uint32_t sx = x * 2; sx < x * 2 + 2 && sx < width; sx++)
+                {
+                    float v = decodeDepth(c.fmt, &init[size_t(sy) * pitchBytes + size_t(sx) * size]);
+                    if (first || (c.reversed ? v > closest : v < closest))
+                    {
+                        closest = v;
+                        bx = sx;
+                        by = sy;
+                        first = false;
+                    }
+                }
+
+            // world point, then the last frame's clip position
+            double u = (bx + 0.5) / width, v = (by + 0.5) / height;
+            double ndc[4] = {u * 2.0 - 1.0, 1.0 - v * 2.0, double(closest), 1.0}, world[4] = {}, clip[4] = {};
+            for (int j = 0; j < 4; j++)
+                for (int k = 0; k < 4; k++)
+                    world[j] += ndc[k] * inv[k * 4 + j];
+            for (int j = 0; j < 4; j++)
+                for (int k = 0; k < 4; k++)
+                    clip[j] += world[k] / world[3] * vpLast[k * 4 + j];
+
+            // right at the old camera's plane float and double may disagree, nothing to check
+            if (fabs(clip[3]) < 1e-2)
+                continue;
+            double ex = 0.0, ey = 0.0;
+            if (clip[3] > 0.0)
+            {
+                ex = u - (clip[0] / clip[3] * 0.5 + 0.5);
+                ey = v - (0.5 - clip[1] / clip[3] * 0.5);
+            }
+            else
+                hidden++;
+
+            double gx = halfToFloat(row[x * 2]), gy = halfToFloat(row[x * 2 + 1]);
+            double error = fmax(fabs(gx - ex) - fabs(ex) / 1024.0, fabs(gy - ey) - fabs(ey) / 1024.0);
+            worst = fmax(worst, error);
+            if (error > 1e-4)
+            {
+                if (!bad)
+                    printf("%-22s: (%u, %u) got (%.6f, %.6f) expected (%.6f, %.6f)\n", c.name, x, y, gx, gy, ex, ey);
+                bad++;
+            }
+        }
+    }
+    ctx->Unmap(readback, 0);
+
+    printf("%-22s: %s (%llu behind the last camera, worst %.2e)", c.name, bad ? "FAIL" : "ok",
+           (unsigned long long)hidden, worst);
+    if (bad)
+        printf(" (%llu texels)", (unsigned long long)bad);
+    printf("\n");
+
+    SoftApi::release(readback);
+    SoftApi::release(motion);
+    depth->Release();
+    return bad;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t width = 97, height = 61; // odd sizes exercise the clamped footprints + partial 8x8 groups
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+            s_rng = uint32_t(strtoul(argv[++i], nullptr, 10)) | 1;
+        else if (!strcmp(argv[i], "--size") && i + 1 < argc)
+        {
+            if (sscanf(argv[++i], "%ux%u", &width, &height) != 2 || !width || !height)
+            {
+                fprintf(stderr, "bad size '%s'\n", argv[i]);
+                return 1;
+            }
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--seed N] [--size WxH]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    SoftDevice *device = new SoftDevice();
+    SoftContext *ctx = nullptr;
+    device->GetImmediateContext(&ctx);
+    const Case cases[] = {
+        {"D32 tilt", FMT_R32_TYPELESS, false, 0.0f, 0.0f},
+        {"D32 strafe", FMT_R32_TYPELESS, false, 0.0f, 0.5f},
+        {"D32 turn", FMT_R32_TYPELESS, false, 0.05f, 0.2f},
+        {"D32 reversed turn", FMT_R32_TYPELESS, true, -0.05f, 0.2f},
+        {"D32 reversed behind", FMT_R32_TYPELESS, true, 2.5f, 1.0f},
+        {"D32 behind", FMT_R32_TYPELESS, false, 2.5f, 1.0f},
+        {"D24S8 turn", FMT_R24G8_TYPELESS, false, 0.03f, 0.3f},
+        {"D24S8 reversed strafe", FMT_R24G8_TYPELESS, true, 0.0f, 0.5f},
+    };
+
+    uint64_t wrong = 0;
+    for (const Case &c : cases)
+        wrong += runCase(*device, ctx, c, width, height);
+
+    // msaa depth has to be resolved first, the pass refuses it
+    SoftTextureDesc d = {};
+    d.Width = width;
+    d.Height = height;
+    d.MipLevels = 1;
+    d.ArraySize = 1;
+    d.Format = FMT_R32_TYPELESS;
+    d.SampleDesc.Count = 4;
+    d.Usage = USAGE_DEFAULT;
+    d.BindFlags = BIND_SHADER_RESOURCE;
+    SoftTexture2D *msaa = nullptr, *motion = nullptr;
+    if (softSucceeded(device->CreateTexture2D(&d, nullptr, &msaa)))
+    {
+        MotionParams params = {};
+        if (exportMotionVectors<SoftApi>(device, ctx, msaa, params, motion) != ExportResult::Failed)
+        {
+            printf("msaa source was not refused\n");
+            wrong++;
+        }
+        SoftApi::release(motion);
+        msaa->Release();
+    }
+
+    // the msaa rejection above is the only expected device error
+    SoftDeviceStats st = device->stats();
+    ctx->Release();
+    device->Release();
+
+    printf("\n%llu dispatches, %llu device errors, %llu live textures, %s\n",
+           (unsigned long long)st.dispatches, (unsigned long long)st.errors,
+           (unsigned long long)st.liveTextures, wrong || st.liveTextures ? "FAILED" : "all motion vectors match");
+    return wrong || st.liveTextures ? 1 : 0;
+}
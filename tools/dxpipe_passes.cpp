@@ -0,0 +1,473 @@
+// dxpipe_passes – cost and correctness of the frame pass graph (PassGraph.h), builds on Linux
+//
+//  usage: dxpipe_passes [--bench] [--frames N]
+//         dxpipe_passes --selftest
+//         dxpipe_passes --json
+//
+// --bench (default) records a synthetic frame (60 passes of 50 draws, 8 shader resources
+// rebound per draw out of 500 resources) and measures what the context proxy pays per
+// call on a sampled frame and on every other frame (the active() test), plus what
+// closing and linking the graph costs the Present.
+// --selftest records a small deferred shading frame (shadow, G-buffer, compute AO,
+// lighting, post, a command list, a copy) and checks its passes, reads, writes, edges and
+// the pass indices handed out for the timestamps, then the boundary rules, PASS_MAX, a
+// command list that resets the context, recorder reuse and the JSON export. exits
+// non-zero on any mismatch.
+// --json writes the deferred shading frame's graph as the overlay's export would.
+
+// c++ includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <vector>
+
+// layer headers (platform independent)
+#include "PassGraph.h"
+
+// stand-ins for the game's resources, only their addresses matter
+static char s_objects[1024];
+static const void *res(uint32_t i)
+{
+    return &s_objects[i];
+}
+
+// what the layer's describe step does with a real resource
+static void describe(PassRecorder &rec)
+{
+    while (PassResource *r = rec.nextUndescribed())
+    {
+        uint32_t i = uint32_t(static_cast<const char *>(r->object) - s_objects);
+        r->dimension = 3; // texture2d
+        r->width = 1920 >> (i % 4);
+        r->height = 1080 >> (i % 4);
+        r->format = 28; // R8G8B8A8_UNORM
+        r->samples = 1;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// the deferred shading frame
+///////////////////////////////////////////////////////////////////////////////////////////
+
+enum Resource : uint32_t
+{
+    Constants,
+    Shadow,
+    Albedo,
+    Normal,
+    Depth,
+    Material,
+    Ao,
+    Light,
+    BackBuffer,
+    Readback,
+    Resources
+};
+
+static const char *s_names[Resources] = {"constants", "shadow", "albedo", "normal", "depth",
+                                         "material", "ao", "light", "backbuffer", "readback"};
+
+// records the frame, `opened` gets every pass index handed out (the timestamps)
+static void deferredFrame(PassRecorder &rec, std::vector<uint32_t> &opened)
+{
+    auto mark = [&](uint32_t pass)
+    {
+        if (pass != PASS_NONE)
+            opened.push_back(pass);
+        describe(rec);
+    };
+    auto targets = [&](std::initializer_list<uint32_t> rts, const void *dsv)
+    {
+        const void *t[PASS_TARGETS] = {};
+        uint32_t n = 0;
+        for (uint32_t r : rts)
+            t[n++] = res(r);
+        mark(rec.targets(t, n, dsv));
+    };
+    auto draws = [&](uint32_t n)
+    {
+        for (uint32_t i = 0; i < n; i++)
+            mark(rec.draw());
+    };
+
+    rec.begin(42);
+
+    // per frame constants, then the shadow map (depth only, joins the upload's pass)
+    mark(rec.copy(res(Constants), nullptr));
+    targets({}, res(Shadow));
+    mark(rec.clear(res(Shadow)));
+    draws(10);
+
+    // G-buffer: two targets + depth, both cleared after binding (same pass)
+    targets({Albedo, Normal}, res(Depth));
+    mark(rec.clearTarget(res(Albedo)));
+    mark(rec.clearTarget(res(Normal)));
+    mark(rec.clear(res(Depth)));
+    const void *material = res(Material);
+    rec.bind(StagePS, 0, 1, &material);
+    draws(20);
+
+    // ambient occlusion in a compute shader, targets unbound first
+    mark(rec.targets(nullptr, 0, nullptr));
+    const void *depth = res(Depth), *ao = res(Ao);
+    rec.bind(StageCS, 0, 1, &depth);
+    rec.bindUavs(true, 0, 1, &ao);
+    mark(rec.dispatch());
+
+    // lighting reads the G-buffer, the AO and the shadow map (material's slot is reused)
+    targets({Light}, nullptr);
+    const void *inputs[5] = {res(Albedo), res(Normal), res(Depth), res(Ao), res(Shadow)};
+    rec.bind(StagePS, 0, 5, inputs);
+    draws(1);
+    targets({Light}, nullptr); // the same targets again, no pass
+
+    // post into the back buffer, the other inputs unbound
+    targets({BackBuffer}, nullptr);
+    const void *post[5] = {res(Light), nullptr, nullptr, nullptr, nullptr};
+    rec.bind(StagePS, 0, 5, post);
+    draws(1);
+
+    // a recorded command list (state restored), then the UI and a readback copy
+    mark(rec.commandList(true, 7, 0, 0, 0));
+    draws(3);
+    mark(rec.copy(res(Readback), res(BackBuffer)));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// selftest
+///////////////////////////////////////////////////////////////////////////////////////////
+
+static uint32_t s_failed = 0;
+
+static void check(bool ok, const char *what)
+{
+    if (!ok)
+    {
+        printf("FAILED: %s\n", what);
+        s_failed++;
+    }
+}
+
+// index of a stand-in in the graph's resource table
+static uint32_t indexOf(const PassGraph &g, uint32_t r)
+{
+    for (uint32_t i = 0; i < g.resources.size(); i++)
+        if (g.resources[i].object == res(r))
+            return i;
+    return PASS_NONE;
+}
+
+// the stand-ins a pass reads / writes, as a sorted bit set
+static uint32_t setOf(const PassGraph &g, const uint32_t *refs, uint32_t n)
+{
+    uint32_t bits = 0;
+    for (uint32_t i = 0; i < n; i++)
+        bits |= 1u << uint32_t(static_cast<const char *>(g.resources[refs[i]].object) - s_objects);
+    return bits;
+}
+
+static uint32_t bits(std::initializer_list<uint32_t> rs)
+{
+    uint32_t b = 0;
+    for (uint32_t r : rs)
+        b |= 1u << r;
+    return b;
+}
+
+static void checkDeferred(const PassGraph &g, const std::vector<uint32_t> &opened)
+{
+    struct Expect
+    {
+        PassKind kind;
+        PassOpen open;
+        uint32_t draws, dispatches, clears, copies;
+        uint32_t reads, writes;
+    };
+    const Expect expect[] = {
+        {PassKind::Render, PassOpen::Start, 10, 0, 1, 1, 0, bits({Constants, Shadow})},
+        {PassKind::Render, PassOpen::Targets, 20, 0, 3, 0, bits({Material}), bits({Albedo, Normal, Depth})},
+        {PassKind::Compute, PassOpen::Targets, 0, 1, 0, 0, bits({Depth}), bits({Ao})},
+        {PassKind::Render, PassOpen::Targets, 1, 0, 0, 0, bits({Albedo, Normal, Depth, Ao, Shadow}), bits({Light})},
+        {PassKind::Render, PassOpen::Targets, 1, 0, 0, 0, bits({Light}), bits({BackBuffer})},
+        {PassKind::CommandList, PassOpen::CommandList, 7, 0, 0, 0, 0, 0},
+        {PassKind::Render, PassOpen::Resume, 3, 0, 0, 1, bits({Light, BackBuffer}), bits({BackBuffer, Readback})},
+    };
+    const uint32_t passes = sizeof(expect) / sizeof(expect[0]);
+
+    check(g.frame == 42, "frame id");
+    check(g.passes.size() == passes, "pass count");
+    check(g.resources.size() == Resources, "every resource once");
+    for (uint32_t p = 0; p < passes && p < g.passes.size(); p++)
+    {
+        const Pass &pass = g.passes[p];
+        const Expect &e = expect[p];
+        char what[64];
+        snprintf(what, sizeof(what), "pass %u kind / opened / counts", p);
+        check(passKind(pass) == e.kind && pass.opened == e.open && pass.draws == e.draws &&
+                  pass.dispatches == e.dispatches && pass.clears == e.clears && pass.copies == e.copies,
+              what);
+        snprintf(what, sizeof(what), "pass %u reads", p);
+        check(setOf(g, g.reads(pass), pass.reads) == e.reads, what);
+        snprintf(what, sizeof(what), "pass %u writes", p);
+        check(setOf(g, g.writes(pass), pass.writes) == e.writes, what);
+    }
+
+    // every pass opened exactly once, in order (one timestamp each)
+    bool sequential = opened.size() == g.passes.size();
+    for (uint32_t i = 0; sequential && i < opened.size(); i++)
+        sequential = opened[i] == i;
+    check(sequential, "pass indices handed out in order");
+
+    // who feeds whom (a copy reading its own pass' write links to the previous writer)
+    const PassEdge edges[] = {
+        {1, 2, indexOf(g, Depth)},  {1, 3, indexOf(g, Albedo)},     {1, 3, indexOf(g, Normal)},
+        {1, 3, indexOf(g, Depth)},  {2, 3, indexOf(g, Ao)},         {0, 3, indexOf(g, Shadow)},
+        {3, 4, indexOf(g, Light)},  {3, 6, indexOf(g, Light)},      {4, 6, indexOf(g, BackBuffer)},
+    };
+    const uint32_t count = sizeof(edges) / sizeof(edges[0]);
+    bool same = g.edges.size() == count;
+    for (uint32_t i = 0; same && i < count; i++)
+    {
+        bool found = false;
+        for (const PassEdge &e : g.edges)
+            found |= e.from == edges[i].from && e.to == edges[i].to && e.resource == edges[i].resource;
+        same = found;
+    }
+    check(same, "edges");
+}
+
+static void checkBoundaries()
+{
+    PassRecorder rec;
+    const void *a = res(0), *b = res(1);
+
+    // a clear of a bound target after drawing starts a pass, a clear of another before drawing doesn't
+    rec.begin(1);
+    check(rec.targets(&a, 1, nullptr) == 0, "first targets open pass 0");
+    check(rec.clearTarget(b) == PASS_NONE, "clear before the first draw joins");
+    check(rec.draw() == PASS_NONE, "draw in the open pass");
+    check(rec.clearTarget(a) == 1, "clear after drawing opens a pass");
+    check(rec.targets(&b, 1, nullptr) == PASS_NONE, "targets before the first draw join");
+    rec.draw();
+    PassGraph g;
+    rec.end(g);
+    check(g.passes.size() == 2 && g.passes[1].opened == PassOpen::Clear, "clear pass");
+    check(g.edges.empty(), "no reads, no edges");
+    check(!rec.active(), "end() stops recording");
+
+    // boundaries past PASS_MAX join the last pass
+    rec.begin(2);
+    uint32_t opened = 0;
+    for (uint32_t i = 0; i < PASS_MAX + 44; i++)
+    {
+        const void *t = res(i % 2);
+        opened += rec.targets(&t, 1, nullptr) != PASS_NONE;
+        rec.draw();
+    }
+    rec.end(g);
+    check(g.passes.size() == PASS_MAX && opened == PASS_MAX && g.joined == 44, "PASS_MAX");
+    check(g.passes.back().draws == 45, "the last pass takes the rest");
+
+    // a command list that doesn't restore the state leaves nothing bound
+    rec.begin(3);
+    rec.bind(StagePS, 0, 1, &a);
+    rec.targets(&b, 1, nullptr);
+    rec.draw();
+    check(rec.commandList(false, 0, 0, 0, 0) == 1, "command list opens a pass");
+    check(rec.draw() == 2, "work after a command list opens a pass");
+    rec.end(g);
+    check(g.passes.size() == 3 && !g.passes[2].reads && !g.passes[2].writes, "command list resets the bindings");
+
+    // an untouched pass becomes the command list
+    rec.begin(4);
+    rec.targets(&a, 1, nullptr);
+    check(rec.commandList(true, 2, 0, 0, 0) == PASS_NONE, "idle pass becomes the command list");
+    rec.end(g);
+    check(g.passes.size() == 1 && passKind(g.passes[0]) == PassKind::CommandList, "command list kind");
+
+    // many resources (the recorder's map grows)
+    rec.begin(5);
+    rec.targets(&a, 1, nullptr);
+    for (uint32_t i = 0; i < 1000; i++)
+    {
+        const void *r = res(i);
+        rec.bind(StagePS, 0, 1, &r);
+        rec.draw();
+    }
+    rec.end(g);
+    check(g.resources.size() == 1000 && g.passes[0].reads == 1000, "1000 resources");
+}
+
+// brackets balance and the sections are there
+static void checkJson(const PassGraph &g)
+{
+    FILE *file = tmpfile();
+    if (!file)
+    {
+        check(false, "tmpfile");
+        return;
+    }
+    check(writePassGraphJson(g, file), "json write");
+    long size = ftell(file);
+    std::vector<char> text(size_t(size > 0 ? size : 0) + 1, 0);
+    rewind(file);
+    size_t n = fread(text.data(), 1, text.size() - 1, file);
+    fclose(file);
+
+    int depth = 0;
+    bool balanced = n > 0;
+    for (size_t i = 0; i < n && balanced; i++)
+    {
+        depth += (text[i] == '{' || text[i] == '[') - (text[i] == '}' || text[i] == ']');
+        balanced = depth >= 0;
+    }
+    check(balanced && depth == 0, "json brackets balance");
+    check(strstr(text.data(), "\"passes\":[") && strstr(text.data(), "\"edges\":[") &&
+              strstr(text.data(), "\"kind\":\"compute\""),
+          "json sections");
+}
+
+static int selftest()
+{
+    PassRecorder rec;
+    PassGraph g;
+    std::vector<uint32_t> opened;
+    deferredFrame(rec, opened);
+    check(rec.active(), "recording until end()");
+    rec.end(g);
+    checkDeferred(g, opened);
+
+    // the same recorder again, storage reused, same graph
+    opened.clear();
+    deferredFrame(rec, opened);
+    PassGraph again;
+    rec.end(again);
+    checkDeferred(again, opened);
+
+    checkBoundaries();
+    checkJson(g);
+
+    printf("%zu passes, %zu edges, %zu resources: %s\n", g.passes.size(), g.edges.size(), g.resources.size(),
+           s_failed ? "FAILED" : "ok");
+    for (uint32_t p = 0; p < g.passes.size(); p++)
+    {
+        const Pass &pass = g.passes[p];
+        printf("  #%u %-8s %-12s", p, passKindName(uint32_t(passKind(pass))), passOpenName(uint32_t(pass.opened)));
+        for (uint32_t i = 0; i < pass.writes; i++)
+            printf(" %s%s", i ? "" : "-> ", s_names[static_cast<const char *>(g.resources[g.writes(pass)[i]].object) - s_objects]);
+        printf("\n");
+    }
+    return s_failed ? 1 : 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// bench
+///////////////////////////////////////////////////////////////////////////////////////////
+
+static const uint32_t BENCH_PASSES = 60;
+static const uint32_t BENCH_DRAWS = 50;
+static const uint32_t BENCH_BINDS = 8;
+static const uint32_t BENCH_RESOURCES = 500;
+
+// one frame of the synthetic game, returns the recorder calls made
+static uint64_t benchFrame(PassRecorder &rec, uint64_t frame)
+{
+    uint64_t calls = 0;
+    for (uint32_t p = 0; p < BENCH_PASSES; p++)
+    {
+        const void *t[2] = {res(p % 16), res(16 + p % 4)};
+        rec.targets(t, 1, t[1]);
+        rec.clearTarget(t[0]);
+        calls += 2;
+        for (uint32_t d = 0; d < BENCH_DRAWS; d++)
+        {
+            const void *srv[BENCH_BINDS];
+            for (uint32_t i = 0; i < BENCH_BINDS; i++)
+                srv[i] = res(uint32_t((frame + p * 31 + d * 7 + i * 13) % BENCH_RESOURCES));
+            rec.bind(StagePS, 0, BENCH_BINDS, srv);
+            rec.draw();
+            calls += 2;
+        }
+    }
+    return calls;
+}
+
+static int bench(uint32_t frames)
+{
+    PassRecorder rec;
+    PassGraph g;
+    uint64_t calls = 0;
+    double recordNs = 0.0, endNs = 0.0;
+    for (uint32_t f = 0; f < frames; f++)
+    {
+        rec.begin(f);
+        auto t0 = std::chrono::steady_clock::now();
+        calls += benchFrame(rec, f);
+        auto t1 = std::chrono::steady_clock::now();
+        rec.end(g);
+        auto t2 = std::chrono::steady_clock::now();
+        recordNs += std::chrono::duration<double, std::nano>(t1 - t0).count();
+        endNs += std::chrono::duration<double, std::nano>(t2 - t1).count();
+    }
+
+    // every other frame: the proxy's test of the switch
+    const uint64_t tests = calls;
+    volatile uint32_t taken = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < tests; i++)
+        if (rec.active())
+            taken = taken + 1;
+    double idleNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+
+    printf("sampled frame   %8.2f ns per call (%llu calls per frame)\n", recordNs / double(calls),
+           (unsigned long long)(calls / frames));
+    printf("other frames    %8.2f ns per call\n", idleNs / double(tests));
+    printf("end + link      %8.2f us per sampled frame (%zu passes, %zu edges, %zu resources)\n",
+           endNs / frames / 1000.0, g.passes.size(), g.edges.size(), g.resources.size());
+    printf("sampled frame   %8.3f ms in total, every 60 frames %.1f us per frame amortised\n",
+           (recordNs + endNs) / frames / 1e6, (recordNs + endNs) / frames / 60.0 / 1000.0);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    enum
+    {
+        Bench,
+        Selftest,
+        Json
+    } mode = Bench;
+    uint32_t frames = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--bench"))
+            mode = Bench;
+        else if (!strcmp(argv[i], "--selftest"))
+            mode = Selftest;
+        else if (!strcmp(argv[i], "--json"))
+            mode = Json;
+        else if (!strcmp(argv[i], "--frames") && i + 1 < argc)
+            frames = uint32_t(strtoul(argv[++i], nullptr, 10));
+        else
+        {
+            fprintf(stderr, "usage: %s [--bench] [--frames N]\n"
+                            "       %s --selftest\n"
+                            "       %s --json\n",
+                    argv[0], argv[0], argv[0]);
+            return 1;
+        }
+    }
+    if (mode == Selftest)
+        return selftest();
+    if (mode == Json)
+    {
+        PassRecorder rec;
+        PassGraph g;
+        std::vector<uint32_t> opened;
+        deferredFrame(rec, opened);
+        rec.end(g);
+        return writePassGraphJson(g, stdout) ? 0 : 1;
+    }
+    return bench(frames ? frames : 200);
+}
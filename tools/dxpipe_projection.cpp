@@ -0,0 +1,542 @@
+// dxpipe_projection – projection inference on the CPU, builds on Linux
+//
+//  usage: dxpipe_projection --corpus [--seed N]
+//         dxpipe_projection <capture.dxcap> [--frames N]
+//
+// --corpus runs the matrix scanner and the depth test votes over a generated corpus
+// (left / right handed, reversed-Z, infinite far, transposed, TAA jitter, plus shadow,
+// orthographic, view-projection and noise buffers that must not match), then the camera
+// extraction (view next to world matrices, with and without view × projection, binding
+// gate, lock and shadowing) and exits non-zero if any answer was wrong.
+// with a capture, the recorded constant buffer writes and depth-stencil states are fed
+// through the same ProjectionInference / CameraInference the layer runs every Present and
+// every change of the inferred parameters or the camera lock is printed.
+
+// c++ includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <unordered_set>
+
+// layer headers (platform independent)
+#include "LayerEvents.h"
+#include "CaptureLog.h"
+#include "DepthCandidates.h"
+#include "ProjectionInference.h"
+#include "CameraInference.h"
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// corpus
+///////////////////////////////////////////////////////////////////////////////////////////
+
+struct Matrix
+{
+    float m[16];
+};
+
+// d3d style perspective, reversed swaps near / far, far = 0 means infinite
+static Matrix perspective(float fovY, float aspect, float n, float f, bool rightHanded, bool reversed)
+{
+    float ys = 1.0f / tanf(fovY * 0.5f);
+    float xs = ys / aspect;
+    float A, B;
+    if (f == 0.0f)
+    {
+        A = reversed ? 0.0f : 1.0f;
+        B = reversed ? n : -n;
+    }
+    else
+    {
+        float zn = reversed ? f : n, zf = reversed ? n : f;
+        A = zf / (zf - zn);
+        B = -zn * zf / (zf - zn);
+    }
+    float s = rightHanded ? -1.0f : 1.0f;
+    Matrix r = {{xs, 0, 0, 0,
+                 0, ys, 0, 0,
+                 0, 0, A * s, s,
+                 0, 0, B, 0}};
+    return r;
+}
+
+static Matrix transpose(const Matrix &a)
+{
+    Matrix r;
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++)
+            r.m[i * 4 + j] = a.m[j * 4 + i];
+    return r;
+}
+
+static Matrix multiply(const Matrix &a, const Matrix &b)
+{
+    Matrix r = {};
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++)
+            for (int k = 0; k < 4; k++)
+                r.m[i * 4 + j] += a.m[i * 4 + k] * b.m[k * 4 + j];
+    return r;
+}
+
+static uint32_t s_rng = 1;
+static uint32_t rnd()
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+static float rndf(float lo, float hi)
+{
+    return lo + (hi - lo) * float(rnd() & 0xFFFFFF) / float(0xFFFFFF);
+}
+
+// a constant buffer with the matrix at a random register between noise (colours, times, ...)
+static std::vector<float> embed(const Matrix *mat, uint32_t &offset)
+{
+    size_t regs = 4 + rnd() % 60;
+    std::vector<float> buf(regs * 4);
+    for (float &v : buf)
+        v = (rnd() & 3) ? rndf(-10.0f, 10.0f) : 0.0f;
+    if (mat)
+    {
+        size_t reg = rnd() % (regs - 3);
+        memcpy(&buf[reg * 4], mat->m, sizeof(mat->m));
+        offset = uint32_t(reg * 16);
+    }
+    return buf;
+}
+
+static bool closeTo(float a, float b, float tolerance = 1e-3f)
+{
+    return fabsf(a - b) <= fabsf(b) * tolerance + 1e-5f;
+}
+
+// rigid transform: yaw / pitch rotation + translation (a camera's view or an object's world)
+static Matrix rigid(float yaw, float pitch, float tx, float ty, float tz)
+{
+    float cy = cosf(yaw), sy = sinf(yaw), cp = cosf(pitch), sp = sinf(pitch);
+    Matrix r = {{cy, sy * sp, -sy * cp, 0,
+                 0, cp, sp, 0,
+                 sy, -cy * sp, cy * cp, 0,
+                 tx, ty, tz, 1}};
+    return r;
+}
+
+// a camera constant buffer: noise, a world matrix, view, projection, maybe view × projection
+struct CameraBuffer
+{
+    std::vector<float> data;
+    uint32_t viewOffset;
+    uint32_t projOffset;
+};
+
+static CameraBuffer cameraBuffer(const Matrix &view, const Matrix &proj, bool transposed, bool withViewProj)
+{
+    Matrix world = rigid(rndf(0.1f, 3.0f), rndf(-1.0f, 1.0f), rndf(-100.0f, 100.0f), rndf(-100.0f, 100.0f), rndf(-100.0f, 100.0f));
+    Matrix viewProj = multiply(view, proj);
+    Matrix v = transposed ? transpose(view) : view, p = transposed ? transpose(proj) : proj;
+    Matrix w = transposed ? transpose(world) : world, vp = transposed ? transpose(viewProj) : viewProj;
+
+    // registers: noise | world | noise | (view proj)/(proj view) | viewProj? | noise
+    size_t lead = rnd() % 6, gap = 4 + rnd() % 8, tail = rnd() % 6;
+    size_t regs = lead + 4 + gap + 8 + (withViewProj ? 4 : 0) + tail;
+    CameraBuffer b;
+    b.data.resize(regs * 4);
+    for (float &x : b.data)
+        x = (rnd() & 3) ? rndf(-10.0f, 10.0f) : 0.0f;
+
+    // the world matrix only loses without view × projection when the view sits closer
+    size_t reg = lead;
+    memcpy(&b.data[reg * 4], w.m, sizeof(w.m));
+    reg += 4 + gap;
+    bool viewFirst = withViewProj ? (rnd() & 1) != 0 : false;
+    b.viewOffset = uint32_t((viewFirst ? reg : reg + 4) * 16);
+    b.projOffset = uint32_t((viewFirst ? reg + 4 : reg) * 16);
+    memcpy(&b.data[b.viewOffset / 4], v.m, sizeof(v.m));
+    memcpy(&b.data[b.projOffset / 4], p.m, sizeof(p.m));
+    reg += 8;
+    if (withViewProj)
+        memcpy(&b.data[reg * 4], vp.m, sizeof(vp.m));
+    return b;
+}
+
+static bool sameMatrix(const float *a, const float *b)
+{
+    for (int i = 0; i < 16; i++)
+        if (fabsf(a[i] - b[i]) > 1e-5f)
+            return false;
+    return true;
+}
+
+static int runCorpus()
+{
+    const float aspect = 16.0f / 9.0f;
+    uint32_t cases = 0, failures = 0;
+
+    // positives: every layout the scanner has to understand
+    for (int i = 0; i < 2000; i++)
+    {
+        bool rh = rnd() & 1, reversed = rnd() & 1, transposed = rnd() & 1, infinite = (rnd() % 5) == 0;
+        float n = rndf(0.01f, 50.0f), f = infinite ? 0.0f : n * rndf(10.0f, 1e5f);
+        float fov = rndf(0.35f, 2.2f);
+        Matrix p = perspective(fov, aspect, n, f, rh, reversed);
+        if (rnd() & 1)
+        {
+            // TAA jitter lives in the z row / column
+            p.m[8] = rndf(-0.001f, 0.001f);
+            p.m[9] = rndf(-0.001f, 0.001f);
+        }
+        if (transposed)
+            p = transpose(p);
+
+        // a standard-Z far plane comes out of 1 - A, which keeps only ~n/f of the float's precision
+        float farTolerance = reversed ? 1e-3f : 1e-3f + 2.4e-7f * (f / n);
+
+        uint32_t offset = 0;
+        std::vector<float> buf = embed(&p, offset);
+        ProjectionMatch match = {};
+        bool found = scanProjection(buf.data(), buf.size() * sizeof(float), aspect, match);
+        bool ok = found && match.offset == offset && match.reversedZ == reversed &&
+                  match.transposed == transposed && closeTo(match.nearPlane, n) &&
+                  (infinite ? match.farPlane == 0.0f : closeTo(match.farPlane, f, farTolerance)) && closeTo(match.fovY, fov);
+        // noise registers ahead of the matrix can form a match of their own, rare but legal
+        if (found && match.offset < offset && !ok)
+            continue;
+
+        cases++;
+        if (!ok)
+        {
+            failures++;
+            printf("FAIL positive %d: rh %d reversed %d transposed %d n %g f %g -> found %d n %g f %g offset %u/%u\n",
+                   i, rh, reversed, transposed, n, f, found, match.nearPlane, match.farPlane, match.offset, offset);
+        }
+    }
+
+    // negatives: things that sit in constant buffers next to the projection
+    for (int i = 0; i < 2000; i++)
+    {
+        Matrix m;
+        switch (i % 5)
+        {
+        case 0: // orthographic (shadow cascades, UI)
+            m = {{rndf(0.001f, 1.0f), 0, 0, 0, 0, rndf(0.001f, 1.0f), 0, 0, 0, 0, rndf(0.001f, 1.0f), 0,
+                  rndf(-1.0f, 1.0f), rndf(-1.0f, 1.0f), rndf(-1.0f, 1.0f), 1}};
+            break;
+        case 1: // square spot light / cube face projection, not the screen
+            m = perspective(1.5707963f, 1.0f, rndf(0.1f, 1.0f), rndf(10.0f, 100.0f), rnd() & 1, rnd() & 1);
+            break;
+        case 2: // view * projection, the camera rotation fills the zeros
+        {
+            float yaw = rndf(0.1f, 3.0f);
+            Matrix view = {{cosf(yaw), 0, -sinf(yaw), 0, 0, 1, 0, 0, sinf(yaw), 0, cosf(yaw), 0,
+                            rndf(-100.0f, 100.0f), rndf(-100.0f, 100.0f), rndf(-100.0f, 100.0f), 1}};
+            m = multiply(view, perspective(1.0f, aspect, 0.1f, 1000.0f, false, false));
+            break;
+        }
+        case 3: // identity / world matrices
+            m = {{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, rndf(-100.0f, 100.0f), rndf(-100.0f, 100.0f), rndf(-100.0f, 100.0f), 1}};
+            break;
+        default: // noise only
+            break;
+        }
+
+        uint32_t offset = 0;
+        std::vector<float> buf = embed(i % 5 == 4 ? nullptr : &m, offset);
+        ProjectionMatch match = {};
+        cases++;
+        if (scanProjection(buf.data(), buf.size() * sizeof(float), aspect, match))
+        {
+            failures++;
+            printf("FAIL negative %d (kind %d): matched n %g f %g at %u\n", i, i % 5, match.nearPlane, match.farPlane, match.offset);
+        }
+    }
+
+    // depth test votes without any matrix: GREATER draws + clears to 0 into the scene depth
+    {
+        ProjectionInference inference;
+        int state = 0, dsv = 0;
+        inference.addDepthState(&state, true, CMP_GREATER_EQUAL);
+
+        EventBuffer events(256);
+        DepthProjection p = {};
+        for (uint64_t frame = 0; frame < 30; frame++)
+        {
+            events.clear();
+            float zero = 0.0f;
+            uint32_t bits;
+            memcpy(&bits, &zero, sizeof(bits));
+            events.push({&dsv, 0, 0, EventKind::SetRenderTargets, 0});
+            events.push({&dsv, bits, CLEAR_DEPTH, EventKind::ClearDepthStencil, 0});
+            events.push({&state, 0, 0, EventKind::SetDepthStencilState, 0});
+            for (int d = 0; d < 50; d++)
+                events.push({nullptr, 36, 1, EventKind::DrawIndexed, 0});
+            p = inference.endFrame(events, frame, 1920, 1080, [&](const void *v) { return v == &dsv; });
+        }
+        cases++;
+        if (!(p.flags & PROJ_REVERSED_Z) || !(p.flags & PROJ_FROM_STATE) || (p.flags & PROJ_VALID))
+        {
+            failures++;
+            printf("FAIL votes: flags 0x%x\n", p.flags);
+        }
+    }
+
+    // camera layout: the view is told from the world matrix next to it
+    for (int i = 0; i < 1000; i++)
+    {
+        bool transposed = rnd() & 1, withViewProj = rnd() & 1;
+        Matrix view = rigid(rndf(0.1f, 3.0f), rndf(-1.2f, 1.2f), rndf(-500.0f, 500.0f), rndf(-50.0f, 50.0f), rndf(-500.0f, 500.0f));
+        Matrix proj = perspective(rndf(0.5f, 1.8f), aspect, rndf(0.05f, 1.0f), rndf(500.0f, 5000.0f), rnd() & 1, rnd() & 1);
+        CameraBuffer b = cameraBuffer(view, proj, transposed, withViewProj);
+
+        CameraMatch match = {};
+        bool found = scanCamera(b.data.data(), b.data.size() * sizeof(float), aspect, match);
+        bool ok = found && match.projection.offset == b.projOffset && match.viewOffset == b.viewOffset &&
+                  match.confirmed == withViewProj && match.projection.transposed == transposed;
+        // noise registers can form a projection of their own ahead of the real one, rare but legal
+        if (found && match.projection.offset < b.projOffset && !ok)
+            continue;
+
+        cases++;
+        if (!ok)
+        {
+            failures++;
+            printf("FAIL camera %d: transposed %d viewProj %d -> found %d view %u/%u proj %u/%u confirmed %d\n",
+                   i, transposed, withViewProj, found, match.viewOffset, b.viewOffset, match.projection.offset,
+                   b.projOffset, match.confirmed);
+        }
+    }
+
+    // camera lock: only vertex shader buffers are searched, then only the camera buffer is shadowed
+    {
+        CameraInference camera;
+        int cameraBufferId = 0, otherBufferId = 0;
+        const void *cb = &cameraBufferId, *other = &otherBufferId;
+        camera.endFrame(0, 1920, 1080);
+
+        Matrix view = rigid(0.7f, 0.2f, 10.0f, 5.0f, -30.0f);
+        Matrix proj = perspective(1.0f, aspect, 0.1f, 1000.0f, false, true);
+        CameraBuffer b = cameraBuffer(view, proj, true, true);
+        size_t bytes = b.data.size() * sizeof(float);
+
+        // written before any VSSetConstantBuffers: ignored
+        camera.onConstants(cb, b.data.data(), bytes);
+        CameraMatrices c = camera.endFrame(1, 1920, 1080);
+        cases++;
+        if (c.flags & CAM_VALID)
+        {
+            failures++;
+            printf("FAIL camera lock: unbound buffer was searched\n");
+        }
+
+        // bound, written: locked, published row-major with the frame id
+        camera.onBind(&cb, 1);
+        camera.onConstants(cb, b.data.data(), bytes);
+        c = camera.endFrame(2, 1920, 1080);
+        cases++;
+        if (!(c.flags & CAM_VALID) || !(c.flags & CAM_UPDATED) || !(c.flags & CAM_TRANSPOSED) || c.frame != 2 ||
+            !sameMatrix(c.view, view.m) || !sameMatrix(c.projection, proj.m))
+        {
+            failures++;
+            printf("FAIL camera lock: flags 0x%x frame %llu\n", c.flags, (unsigned long long)c.frame);
+        }
+
+        // another buffer with another camera is not shadowed once locked, the next frame
+        // repeats the matrices without CAM_UPDATED
+        Matrix otherView = rigid(2.0f, -0.3f, 1.0f, 2.0f, 3.0f);
+        CameraBuffer o = cameraBuffer(otherView, proj, true, true);
+        camera.onBind(&other, 1);
+        camera.onConstants(other, o.data.data(), o.data.size() * sizeof(float));
+        c = camera.endFrame(3, 1920, 1080);
+        cases++;
+        if (!(c.flags & CAM_VALID) || (c.flags & CAM_UPDATED) || c.frame != 3 || !sameMatrix(c.view, view.m))
+        {
+            failures++;
+            printf("FAIL camera shadow: flags 0x%x\n", c.flags);
+        }
+
+        // the camera moves, a shadow pass reuses the slot with an orthographic matrix
+        Matrix moved = rigid(0.8f, 0.1f, 12.0f, 5.0f, -28.0f);
+        Matrix movedT = transpose(moved);
+        memcpy(&b.data[b.viewOffset / 4], movedT.m, sizeof(movedT.m));
+        camera.onConstants(cb, b.data.data(), bytes);
+        std::vector<float> shadowPass = b.data;
+        Matrix ortho = {{0.01f, 0, 0, 0, 0, 0.01f, 0, 0, 0, 0, 0.001f, 0, 0, 0, 0.5f, 1}};
+        memcpy(&shadowPass[b.projOffset / 4], ortho.m, sizeof(ortho.m));
+        camera.onConstants(cb, shadowPass.data(), bytes);
+        c = camera.endFrame(4, 1920, 1080);
+        cases++;
+        if (!(c.flags & CAM_UPDATED) || !sameMatrix(c.view, moved.m) || !sameMatrix(c.projection, proj.m))
+        {
+            failures++;
+            printf("FAIL camera update: flags 0x%x\n", c.flags);
+        }
+    }
+
+    printf("%u cases, %u failures\n", cases, failures);
+    return failures ? 2 : 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// capture replay
+///////////////////////////////////////////////////////////////////////////////////////////
+
+static int runCapture(const char *path, uint64_t maxFrames)
+{
+    CaptureReader reader;
+    if (!reader.open(path))
+    {
+        fprintf(stderr, "failed to open capture: %s\n", path);
+        return 1;
+    }
+
+    DepthCandidates depth;
+    ProjectionInference inference;
+    CameraInference camera;
+    uint32_t lastCamera = 0;
+    std::unordered_set<uint64_t> constantBuffers;
+    EventBuffer frame(16384);
+    uint32_t width = 0, height = 0;
+    uint64_t frames = 0, changes = 0, scannedBytes = 0;
+    DepthProjection last = {};
+
+    for (const CaptureRecord &r : reader.records())
+    {
+        if (frames >= maxFrames)
+            break;
+
+        const void *handle = reinterpret_cast<const void *>(uintptr_t(r.handle));
+        switch (CaptureOp(r.op))
+        {
+        case CaptureOp::CreateTexture2D:
+        case CaptureOp::GetBuffer:
+        {
+            CaptureTextureDesc d = {};
+            if (const uint8_t *p = reader.blob(r.blob, sizeof(d)))
+                memcpy(&d, p, sizeof(d));
+            if (CaptureOp(r.op) == CaptureOp::GetBuffer)
+            {
+                width = d.width;
+                height = d.height;
+            }
+            depth.addTexture(handle, {d.width, d.height, d.format, d.sampleCount, d.arraySize, d.bindFlags});
+            break;
+        }
+        case CaptureOp::CreateBuffer:
+        {
+            CaptureBufferDesc d = {};
+            if (const uint8_t *p = reader.blob(r.blob, sizeof(d)))
+                memcpy(&d, p, sizeof(d));
+            if (d.bindFlags & BIND_CONSTANT_BUFFER)
+                constantBuffers.insert(r.handle);
+            else
+                constantBuffers.erase(r.handle);
+            break;
+        }
+        case CaptureOp::CreateDepthStencilState:
+            inference.addDepthState(handle, (r.a32 >> 8) & 1, r.a32 & 0xFF);
+            break;
+        case CaptureOp::CreateView:
+            if (r.a32 == CaptureViewDSV)
+                depth.addView(handle, reinterpret_cast<const void *>(uintptr_t(r.arg)));
+            break;
+        case CaptureOp::ResizeBuffers:
+            width = uint32_t(r.arg);
+            height = uint32_t(r.arg >> 32);
+            break;
+        case CaptureOp::Present:
+        {
+            const void *scene = depth.endFrame(frame, frames, width, height);
+            DepthProjection p = inference.endFrame(frame, frames, width, height, [&](const void *view)
+                                                   { return scene && depth.textureOfView(view) == scene; });
+            if (p.flags != last.flags || p.nearPlane != last.nearPlane || p.farPlane != last.farPlane)
+            {
+                uint32_t offset = 0;
+                const void *buffer = inference.lockedBuffer(offset);
+                printf("frame %llu: near %g far %g%s fov %.1f%s%s%s (buffer %p +%u)\n",
+                       (unsigned long long)frames, p.nearPlane, p.farPlane,
+                       (p.flags & PROJ_INFINITE) ? " (infinite)" : "", p.fovY * 57.29578f,
+                       (p.flags & PROJ_REVERSED_Z) ? " reversed-Z" : "",
+                       (p.flags & PROJ_FROM_MATRIX) ? " [matrix]" : "",
+                       (p.flags & PROJ_FROM_STATE) ? " [depth test]" : "", buffer, offset);
+                last = p;
+                changes++;
+            }
+            CameraMatrices c = camera.endFrame(frames, width, height);
+            if ((c.flags ^ lastCamera) & (CAM_VALID | CAM_CONFIRMED))
+            {
+                uint32_t viewOffset = 0, projOffset = 0;
+                const void *buffer = camera.lockedBuffer(viewOffset, projOffset);
+                printf("frame %llu: camera %s%s (buffer %p view +%u projection +%u)\n", (unsigned long long)frames,
+                       (c.flags & CAM_VALID) ? "locked" : "lost", (c.flags & CAM_CONFIRMED) ? " [view x projection]" : "",
+                       buffer, viewOffset, projOffset);
+                changes++;
+            }
+            lastCamera = c.flags;
+            frame.clear();
+            frames++;
+            break;
+        }
+        default:
+            if (!isContextOp(r.op))
+                break;
+            if (EventKind(r.op - uint16_t(CaptureOp::ContextBase)) == EventKind::Payload)
+            {
+                // the bytes of the Unmap / UpdateSubresource that was just recorded
+                if (!constantBuffers.count(r.handle))
+                    break;
+                if (const uint8_t *p = reader.blob(r.arg, r.a32))
+                {
+                    inference.onConstants(handle, p, r.a32);
+                    camera.onConstants(handle, p, r.a32);
+                    scannedBytes += r.a32;
+                }
+                break;
+            }
+            // the capture keeps the first buffer of a VSSetConstantBuffers
+            if (EventKind(r.op - uint16_t(CaptureOp::ContextBase)) == EventKind::SetConstantBuffers && r.a32 == StageVS)
+                camera.onBind(&handle, 1);
+            frame.push({handle, r.arg, r.a32, EventKind(r.op - uint16_t(CaptureOp::ContextBase)), r.context});
+            break;
+        }
+    }
+
+    printf("frames: %llu, changes: %llu, constant bytes written: %llu\n",
+           (unsigned long long)frames, (unsigned long long)changes, (unsigned long long)scannedBytes);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s --corpus [--seed N]\n       %s <capture.dxcap> [--frames N]\n", argv[0], argv[0]);
+        return 1;
+    }
+
+    bool corpus = false;
+    const char *path = nullptr;
+    uint64_t maxFrames = UINT64_MAX;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--corpus"))
+            corpus = true;
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+            s_rng = uint32_t(strtoul(argv[++i], nullptr, 10)) | 1;
+        else if (!strcmp(argv[i], "--frames") && i + 1 < argc)
+            maxFrames = strtoull(argv[++i], nullptr, 10);
+        else
+            path = argv[i];
+    }
+
+    if (corpus)
+        return runCorpus();
+    if (!path)
+    {
+        fprintf(stderr, "no capture given\n");
+        return 1;
+    }
+    return runCapture(path, maxFrames);
+}
@@ -0,0 +1,207 @@
+// dxpipe_registry – concurrency stress of the weak resource registry, builds on Linux
+//
+//  usage: dxpipe_registry [--threads N] [--iterations N] [--readers N]
+//
+// creator threads do what worker threads of a game do to the layer: create textures,
+// track them (CreateTexture2D / GetBuffer), hold / drop references (replaceGlobal),
+// publish some as the depth texture (promoteDepthCandidate's publish-then-check) and
+// release them again, the last Release running the destruction notification. reader
+// threads play Present: upgrade the depth texture to a reference, use it, release it,
+// and poll alive / stats. every object carries a tag derived from its address, a reader
+// seeing a wrong tag used freed memory. exits non-zero on any mismatch or leak.
+//
+// meant to be built with ThreadSanitizer (-DDXPIPE_TSAN=ON), which checks the epoch
+// read sections against the writers.
+
+// c++ includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// layer headers (platform independent)
+#include "ResourceRegistry.h"
+
+// stand-in for a d3d11 texture: refcount + something to read
+struct FakeTexture
+{
+    std::atomic<uint32_t> refs{1};
+    uint64_t tag;
+};
+
+static uint64_t tagOf(const FakeTexture *t)
+{
+    return uint64_t(reinterpret_cast<uintptr_t>(t)) * 0x9E3779B97F4A7C15ull;
+}
+
+static ResourceRegistry s_registry;
+static std::atomic<FakeTexture *> s_depth{nullptr}; // g_DepthTexture
+
+static std::atomic<uint64_t> s_created{0};
+static std::atomic<uint64_t> s_upgrades{0};
+static std::atomic<uint64_t> s_misses{0};
+static std::atomic<uint64_t> s_errors{0};
+
+// the layer's onResourceDestroyed (sentinel), then the runtime frees the object
+static void destroy(FakeTexture *t)
+{
+    s_registry.destroyed(t, [](const TrackedResource &r)
+                         {
+        FakeTexture *expected = static_cast<FakeTexture *>(const_cast<void *>(r.object));
+        s_depth.compare_exchange_strong(expected, nullptr); });
+    delete t;
+}
+
+static void release(FakeTexture *t)
+{
+    if (t->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        destroy(t);
+}
+
+// a reference only while the object isn't already on its way out (see the notes in
+// ProxyTracking.h, this checks the registry's own memory safety)
+static bool tryAddRef(FakeTexture *t)
+{
+    uint32_t refs = t->refs.load(std::memory_order_relaxed);
+    while (refs)
+    {
+        if (t->refs.compare_exchange_weak(refs, refs + 1, std::memory_order_acq_rel))
+            return true;
+    }
+    return false;
+}
+
+static uint32_t xorshift(uint32_t &s)
+{
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    return s;
+}
+
+static void creator(uint32_t seed, uint64_t iterations)
+{
+    uint32_t rng = seed * 2654435761u + 1;
+    FakeTexture *live[16] = {};
+
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        FakeTexture *t = new FakeTexture();
+        t->tag = tagOf(t);
+        s_created.fetch_add(1, std::memory_order_relaxed);
+
+        if (!s_registry.track(t, TrackedKind::DepthCandidate, 1920, 1080, 1920 * 1080 * 4, i))
+            s_errors.fetch_add(1, std::memory_order_relaxed); // fresh object already tracked
+        if (s_registry.track(t, TrackedKind::DepthCandidate, 1920, 1080, 1920 * 1080 * 4, i))
+            s_errors.fetch_add(1, std::memory_order_relaxed); // tracked twice
+
+        uint32_t r = xorshift(rng);
+        if ((r & 3) == 0)
+        {
+            // promoteDepthCandidate: publish, take it back if it is gone already
+            s_depth.store(t);
+            if (!s_registry.alive(t))
+            {
+                FakeTexture *expected = t;
+                s_depth.compare_exchange_strong(expected, nullptr);
+            }
+        }
+        if (r & 4)
+        {
+            s_registry.hold(t);
+            s_registry.drop(t);
+        }
+
+        // keep a few alive so lifetimes overlap the readers
+        FakeTexture *&slot = live[(r >> 8) & 15];
+        if (slot)
+            release(slot);
+        slot = t;
+    }
+
+    for (FakeTexture *t : live)
+        if (t)
+            release(t);
+}
+
+static void reader(const std::atomic<bool> &done)
+{
+    uint64_t n = 0;
+    while (!done.load(std::memory_order_acquire))
+    {
+        // weak → strong through the registry, the reference has to refuse a zero count
+        // (d3d11 textures can't, the layer references its depth through a live view)
+        FakeTexture *depth = s_depth.load();
+        FakeTexture *held = nullptr;
+        s_registry.upgrade(depth, [&](const void *)
+                           {
+            if (tryAddRef(depth))
+                held = depth; });
+
+        if (held)
+        {
+            if (held->tag != tagOf(held))
+                s_errors.fetch_add(1, std::memory_order_relaxed);
+            s_upgrades.fetch_add(1, std::memory_order_relaxed);
+            release(held); // the frame's reference, may be the last one
+        }
+        else
+        {
+            s_misses.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if ((++n & 1023) == 0)
+        {
+            ResourceRegistryStats s = s_registry.stats();
+            if (s.destroyed > s.tracked || s.live > s.tracked)
+                s_errors.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t threads = 8;
+    uint32_t readers = 2;
+    uint64_t iterations = 100000;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+            threads = uint32_t(strtoul(argv[++i], nullptr, 10));
+        else if (!strcmp(argv[i], "--readers") && i + 1 < argc)
+            readers = uint32_t(strtoul(argv[++i], nullptr, 10));
+        else if (!strcmp(argv[i], "--iterations") && i + 1 < argc)
+            iterations = strtoull(argv[++i], nullptr, 10);
+        else
+        {
+            fprintf(stderr, "usage: %s [--threads N] [--iterations N] [--readers N]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::atomic<bool> done{false};
+    std::vector<std::thread> presenters;
+    for (uint32_t i = 0; i < readers; i++)
+        presenters.emplace_back(reader, std::cref(done));
+
+    std::vector<std::thread> creators;
+    for (uint32_t i = 0; i < threads; i++)
+        creators.emplace_back(creator, i + 1, iterations);
+    for (std::thread &t : creators)
+        t.join();
+
+    done.store(true, std::memory_order_release);
+    for (std::thread &t : presenters)
+        t.join();
+
+    ResourceRegistryStats s = s_registry.stats();
+    bool leaked = s.live || s.tracked != s_created.load() || s.destroyed != s.tracked || s_depth.load();
+
+    printf("%u creators x %llu, %u readers: %llu tracked, %llu destroyed, %llu live, %llu upgrades, %llu misses, %llu errors%s\n",
+           threads, (unsigned long long)iterations, readers, (unsigned long long)s.tracked,
+           (unsigned long long)s.destroyed, (unsigned long long)s.live, (unsigned long long)s_upgrades.load(),
+           (unsigned long long)s_misses.load(), (unsigned long long)s_errors.load(), leaked ? ", LEAK" : "");
+    return s_errors.load() || leaked ? 1 : 0;
+}
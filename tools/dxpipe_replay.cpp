@@ -0,0 +1,220 @@
+// dxpipe_replay – replays a dxpipe API capture through the layer's event path
+//
+//  usage: dxpipe_replay <capture.dxcap> [--frames N] [--per-frame]
+//
+// the capture holds the device / context / swap chain call stream recorded by the
+// layer (ENABLE_CAPTURE). every frame is decoded first, then pushed back through the
+// same recorders the proxies use (immediate timeline + one recorder per deferred
+// context, spliced on ExecuteCommandList) and timed. the number is the cost of the event
+// path alone: the proxies themselves (forwarding to d3d11, whatever they do besides
+// recording, Present's copies) are not in it.
+// no GPU or d3d11 runtime is needed, this builds on Linux.
+
+// c++ includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <memory>
+
+// layer headers (platform independent)
+#include "LayerEvents.h"
+#include "CaptureLog.h"
+
+// a resource as far as the replay is concerned
+struct ReplayResource
+{
+    bool isBuffer = false;
+    CaptureTextureDesc tex = {};
+    CaptureBufferDesc buf = {};
+    std::vector<uint8_t> shadow; // last uploaded contents
+};
+
+struct ReplayStats
+{
+    std::vector<double> frameUs; // event path time per frame
+    uint64_t events = 0;
+    uint64_t payloadBytes = 0;
+    uint64_t resources = 0;
+    uint64_t views = 0;
+    uint64_t resizes = 0;
+};
+
+static double percentile(std::vector<double> v, double p)
+{
+    if (v.empty())
+        return 0.0;
+    std::sort(v.begin(), v.end());
+    size_t idx = size_t(p * double(v.size() - 1) + 0.5);
+    return v[std::min(idx, v.size() - 1)];
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <capture.dxcap> [--frames N] [--per-frame]\n", argv[0]);
+        return 1;
+    }
+
+    const char *path = argv[1];
+    uint64_t maxFrames = UINT64_MAX;
+    bool perFrame = false;
+    for (int i = 2; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--frames") && i + 1 < argc)
+            maxFrames = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--per-frame"))
+            perFrame = true;
+    }
+
+    CaptureReader reader;
+    if (!reader.open(path))
+    {
+        fprintf(stderr, "failed to open capture: %s\n", path);
+        return 1;
+    }
+
+    const std::vector<CaptureRecord> &records = reader.records();
+    std::unordered_map<uint64_t, ReplayResource> resources;
+    std::unordered_map<uint64_t, uint64_t> views; // view → resource
+    std::unordered_map<uint16_t, std::unique_ptr<EventRecorder>> deferred;
+    FrameTimeline timeline;
+    ReplayStats stats;
+
+    // events of the frame being decoded, replayed once its Present is reached
+    std::vector<CaptureRecord> frame;
+    frame.reserve(16384);
+
+    auto recorderFor = [&](uint16_t id) -> EventRecorder &
+    {
+        std::unique_ptr<EventRecorder> &rec = deferred[id];
+        if (!rec)
+            rec.reset(new EventRecorder(1024, id));
+        return *rec;
+    };
+
+    // push one decoded frame through the recorders and time it
+    auto replayFrame = [&]()
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < frame.size(); i++)
+        {
+            const CaptureRecord &r = frame[i];
+            EventKind kind = EventKind(r.op - uint16_t(CaptureOp::ContextBase));
+            const void *object = reinterpret_cast<const void *>(uintptr_t(r.handle));
+
+            // a spliced command list: the next arg records were recorded on a deferred context
+            if (kind == EventKind::ExecuteCommandList)
+            {
+                EventRecorder &rec = recorderFor(uint16_t(r.a32));
+                size_t end = std::min(frame.size(), i + 1 + size_t(r.arg));
+                for (i = i + 1; i < end; i++)
+                {
+                    const CaptureRecord &d = frame[i];
+                    rec.record(EventKind(d.op - uint16_t(CaptureOp::ContextBase)),
+                               reinterpret_cast<const void *>(uintptr_t(d.handle)), d.arg, d.a32);
+                }
+                i--;
+                timeline.splice(rec);
+                rec.clear();
+                continue;
+            }
+
+            timeline.record(kind, object, r.arg, r.a32);
+        }
+
+        stats.events += timeline.events.size();
+        timeline.endFrame();
+
+        auto end = std::chrono::steady_clock::now();
+        stats.frameUs.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+    };
+
+    for (const CaptureRecord &r : records)
+    {
+        if (stats.frameUs.size() >= maxFrames)
+            break;
+
+        switch (CaptureOp(r.op))
+        {
+        case CaptureOp::CreateTexture2D:
+        case CaptureOp::GetBuffer:
+        {
+            ReplayResource &res = resources[r.handle];
+            res = ReplayResource();
+            if (const uint8_t *p = reader.blob(r.blob, sizeof(CaptureTextureDesc)))
+                memcpy(&res.tex, p, sizeof(res.tex));
+            stats.resources++;
+            break;
+        }
+        case CaptureOp::CreateBuffer:
+        {
+            ReplayResource &res = resources[r.handle];
+            res = ReplayResource();
+            res.isBuffer = true;
+            if (const uint8_t *p = reader.blob(r.blob, sizeof(CaptureBufferDesc)))
+                memcpy(&res.buf, p, sizeof(res.buf));
+            stats.resources++;
+            break;
+        }
+        case CaptureOp::CreateView:
+            views[r.handle] = r.arg;
+            stats.views++;
+            break;
+        case CaptureOp::ResizeBuffers:
+            stats.resizes++;
+            break;
+        case CaptureOp::Present:
+            replayFrame();
+            frame.clear();
+            break;
+        default:
+            if (!isContextOp(r.op))
+                break;
+
+            // uploads: the game's write is applied outside the timed section
+            if (EventKind(r.op - uint16_t(CaptureOp::ContextBase)) == EventKind::Payload)
+            {
+                const uint8_t *p = reader.blob(r.arg, r.a32);
+                auto it = resources.find(r.handle);
+                if (p && it != resources.end())
+                {
+                    it->second.shadow.assign(p, p + r.a32);
+                    stats.payloadBytes += r.a32;
+                }
+            }
+            frame.push_back(r);
+            break;
+        }
+    }
+
+    if (perFrame)
+    {
+        for (size_t i = 0; i < stats.frameUs.size(); i++)
+            printf("frame %zu: %.2f us\n", i, stats.frameUs[i]);
+    }
+
+    double total = 0.0;
+    for (double us : stats.frameUs)
+        total += us;
+    size_t frames = stats.frameUs.size();
+
+    printf("capture:        %s\n", path);
+    printf("frames:         %zu\n", frames);
+    printf("events:         %llu (%.1f / frame)\n", (unsigned long long)stats.events,
+           frames ? double(stats.events) / frames : 0.0);
+    printf("resources:      %llu (%llu views, %llu resizes)\n", (unsigned long long)stats.resources,
+           (unsigned long long)stats.views, (unsigned long long)stats.resizes);
+    printf("payload bytes:  %llu\n", (unsigned long long)stats.payloadBytes);
+    printf("event path us/frame: mean %.2f  p50 %.2f  p99 %.2f  max %.2f\n",
+           frames ? total / frames : 0.0,
+           percentile(stats.frameUs, 0.50),
+           percentile(stats.frameUs, 0.99),
+           percentile(stats.frameUs, 1.00));
+    return 0;
+}
@@ -0,0 +1,276 @@
+// dxpipe_resolve – msaa depth resolve on the software reference device, builds on Linux
+//
+//  usage: dxpipe_resolve [--seed N] [--size WxH]
+//
+// fills multisampled depth buffers (D32, D32S8, D24S8, D16 at 2x / 4x / 8x) with random
+// surfaces and silhouette edges where the samples disagree, runs them through
+// exportResolvedDepth<SoftApi> (the same template the layer runs with D3D11Api) in every
+// DepthResolveMode and checks each R32F texel against sample 0 / min / max of the depths
+// that were written, within the format's quantisation. single-sample D32S8 / D24S8 / D16
+// buffers are converted to R32F the same way, single-sample D32 is exported as it is.
+// exits non-zero on any mismatch.
+
+// c++ includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <vector>
+
+// layer headers (platform independent)
+#include "SoftDevice.h"
+#include "FrameExport.h"
+
+static uint32_t s_rng = 1;
+static uint32_t rnd()
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static float rndf(float lo, float hi)
+{
+    return lo + (hi - lo) * float(rnd() & 0xFFFFFF) / 16777215.0f;
+}
+
+// store one depth value the way the depth format holds it (stencil bits get noise)
+static void encodeDepth(uint32_t fmt, float d, uint8_t *texel)
+{
+    switch (fmt)
+    {
+    case FMT_D32_FLOAT:
+        memcpy(texel, &d, 4);
+        break;
+    case FMT_D32_FLOAT_S8X24_UINT:
+    {
+        uint32_t stencil = rnd();
+        memcpy(texel, &d, 4);
+        memcpy(texel + 4, &stencil, 4);
+        break;
+    }
+    case FMT_D24_UNORM_S8_UINT:
+    {
+        uint32_t bits = uint32_t(lrintf(d * 16777215.0f)) | (rnd() << 24);
+        memcpy(texel, &bits, 4);
+        break;
+    }
+    case FMT_D16_UNORM:
+    {
+        uint16_t bits = uint16_t(lrintf(d * 65535.0f));
+        memcpy(texel, &bits, 2);
+        break;
+    }
+    }
+}
+
+static float quantum(uint32_t fmt)
+{
+    switch (fmt)
+    {
+    case FMT_D24_UNORM_S8_UINT:
+        return 1.0f / 16777215.0f;
+    case FMT_D16_UNORM:
+        return 1.0f / 65535.0f;
+    default:
+        return 0.0f;
+    }
+}
+
+static const char *formatName(uint32_t fmt)
+{
+    switch (fmt)
+    {
+    case FMT_D32_FLOAT:
+        return "D32_FLOAT";
+    case FMT_D32_FLOAT_S8X24_UINT:
+        return "D32_FLOAT_S8X24";
+    case FMT_D24_UNORM_S8_UINT:
+        return "D24_UNORM_S8";
+    case FMT_D16_UNORM:
+        return "D16_UNORM";
+    default:
+        return "?";
+    }
+}
+
+// one format / sample count, returns the number of wrong texels
+static uint64_t runCase(SoftDevice &device, SoftContext *ctx, uint32_t fmt, uint32_t samples, uint32_t width, uint32_t height)
+{
+    // depths per sample: a background plane, a nearer disc whose edge cuts through texels
+    std::vector<float> depths(size_t(width) * height * samples);
+    float cx = rndf(0.3f, 0.7f) * width, cy = rndf(0.3f, 0.7f) * height;
+    float radius = rndf(0.2f, 0.4f) * (width < height ? width : height);
+    float back = rndf(0.6f, 1.0f), front = rndf(0.0f, 0.4f);
+    for (uint32_t y = 0; y < height; y++)
+        for (uint32_t x = 0; x < width; x++)
+            for (uint32_t s = 0; s < samples; s++)
+            {
+                // sample positions spread over the texel, the edge lands between them
+                float sx = x + (s + 0.5f) / samples, sy = y + float((s * 5 + 3) % samples + 0.5f) / samples;
+                float dx = sx - cx, dy = sy - cy;
+                bool inside = dx * dx + dy * dy < radius * radius;
+                float d = inside ? front + 0.0001f * dx : back - 0.0001f * dy;
+                depths[(size_t(y) * width + x) * samples + s] = fminf(fmaxf(d, 0.0f), 1.0f);
+            }
+
+    uint32_t size = formatSize(fmt);
+    uint32_t pitch = width * samples * size;
+    std::vector<uint8_t> init(size_t(pitch) * height);
+    for (size_t i = 0; i < depths.size(); i++)
+        encodeDepth(fmt, depths[i], &init[i * size]);
+
+    SoftTextureDesc d = {};
+    d.Width = width;
+    d.Height = height;
+    d.MipLevels = 1;
+    d.ArraySize = 1;
+    d.Format = fmt;
+    d.SampleDesc.Count = samples;
+    d.Usage = USAGE_DEFAULT;
+    d.BindFlags = BIND_DEPTH_STENCIL;
+    SoftSubresourceData data = {init.data(), pitch, 0};
+
+    SoftTexture2D *depth = nullptr;
+    if (!softSucceeded(device.CreateTexture2D(&d, &data, &depth)))
+    {
+        printf("%-16s %ux: CreateTexture2D failed\n", formatName(fmt), samples);
+        return 1;
+    }
+
+    uint64_t wrong = 0;
+
+    // msaa can't go through the staging copy (d3d11 rejects it as well)
+    SoftTexture2D *staging = nullptr;
+    if (samples > 1 && exportStaging<SoftApi>(&device, ctx, depth, staging) != ExportResult::Failed)
+    {
+        printf("%-16s %ux: staging export of an msaa source did not fail\n", formatName(fmt), samples);
+        wrong++;
+    }
+    SoftApi::release(staging);
+
+    SoftTexture2D *resolved = nullptr;
+    for (uint32_t m = 0; m < uint32_t(DepthResolveMode::Count); m++)
+    {
+        DepthResolveMode mode = DepthResolveMode(m);
+        ExportResult r = exportResolvedDepth<SoftApi>(&device, ctx, depth, mode, resolved);
+        if (r == ExportResult::Failed || r == ExportResult::Skipped || !resolved)
+        {
+            printf("%-16s %ux %-7s: resolve failed\n", formatName(fmt), samples, depthResolveModeName(mode));
+            wrong++;
+            continue;
+        }
+
+        SoftMappedSubresource mapped = {};
+        SoftTexture2D *readback = nullptr;
+        if (exportStaging<SoftApi>(&device, ctx, resolved, readback) == ExportResult::Failed ||
+            !softSucceeded(ctx->Map(readback, 0, MAP_READ, 0, &mapped)))
+        {
+            printf("%-16s %ux %-7s: readback failed\n", formatName(fmt), samples, depthResolveModeName(mode));
+            SoftApi::release(readback);
+            wrong++;
+            continue;
+        }
+
+        uint64_t bad = 0;
+        float tolerance = quantum(fmt) * 0.5f + 1e-7f;
+        for (uint32_t y = 0; y < height; y++)
+        {
+            const float *row = reinterpret_cast<const float *>(static_cast<const uint8_t *>(mapped.pData) + uint64_t(y) * mapped.RowPitch);
+            for (uint32_t x = 0; x < width; x++)
+            {
+                const float *s = &depths[(size_t(y) * width + x) * samples];
+                float expect = s[0];
+                for (uint32_t i = 1; mode != DepthResolveMode::Sample0 && i < samples; i++)
+                    expect = mode == DepthResolveMode::Min ? fminf(expect, s[i]) : fmaxf(expect, s[i]);
+                if (fabsf(row[x] - expect) > tolerance)
+                {
+                    if (!bad)
+                        printf("%-16s %ux %-7s: (%u, %u) got %.9f expected %.9f\n", formatName(fmt), samples,
+                               depthResolveModeName(mode), x, y, row[x], expect);
+                    bad++;
+                }
+            }
+        }
+        ctx->Unmap(readback, 0);
+        SoftApi::release(readback);
+
+        printf("%-16s %ux %-7s: %s", formatName(fmt), samples, depthResolveModeName(mode), bad ? "FAIL" : "ok");
+        if (bad)
+            printf(" (%llu texels)", (unsigned long long)bad);
+        printf("\n");
+        wrong += bad;
+    }
+
+    SoftApi::release(resolved);
+    depth->Release();
+    return wrong;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t width = 97, height = 61; // odd sizes exercise the partial 8x8 groups
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+            s_rng = uint32_t(strtoul(argv[++i], nullptr, 10)) | 1;
+        else if (!strcmp(argv[i], "--size") && i + 1 < argc)
+        {
+            if (sscanf(argv[++i], "%ux%u", &width, &height) != 2 || !width || !height)
+            {
+                fprintf(stderr, "bad size '%s'\n", argv[i]);
+                return 1;
+            }
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--seed N] [--size WxH]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    SoftDevice *device = new SoftDevice();
+    SoftContext *ctx = nullptr;
+    device->GetImmediateContext(&ctx);
+    const uint32_t formats[] = {FMT_D32_FLOAT, FMT_D32_FLOAT_S8X24_UINT, FMT_D24_UNORM_S8_UINT, FMT_D16_UNORM};
+    const uint32_t counts[] = {1, 2, 4, 8};
+
+    uint64_t wrong = 0;
+    for (uint32_t fmt : formats)
+        for (uint32_t samples : counts)
+            if (samples > 1 || fmt != FMT_D32_FLOAT) // single-sample D32 isn't converted, below
+                wrong += runCase(*device, ctx, fmt, samples, width, height);
+
+    // single-sample R32 sources are exported as they are
+    SoftTextureDesc d = {};
+    d.Width = width;
+    d.Height = height;
+    d.MipLevels = 1;
+    d.ArraySize = 1;
+    d.Format = FMT_D32_FLOAT;
+    d.SampleDesc.Count = 1;
+    d.Usage = USAGE_DEFAULT;
+    d.BindFlags = BIND_DEPTH_STENCIL;
+    SoftTexture2D *single = nullptr, *resolved = nullptr;
+    if (softSucceeded(device->CreateTexture2D(&d, nullptr, &single)))
+    {
+        if (exportResolvedDepth<SoftApi>(device, ctx, single, DepthResolveMode::Max, resolved) != ExportResult::Skipped)
+        {
+            printf("single-sample D32 source was resolved\n");
+            wrong++;
+        }
+        SoftApi::release(resolved);
+        single->Release();
+    }
+
+    // the staging rejections above are the only expected device errors
+    SoftDeviceStats st = device->stats();
+    ctx->Release();
+    device->Release();
+
+    printf("\n%llu dispatches, %llu device errors, %llu live textures, %s\n",
+           (unsigned long long)st.dispatches, (unsigned long long)st.errors,
+           (unsigned long long)st.liveTextures, wrong || st.liveTextures ? "FAILED" : "all resolves match");
+    return wrong || st.liveTextures ? 1 : 0;
+}
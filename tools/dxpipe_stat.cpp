@@ -0,0 +1,476 @@
+// dxpipe_stat – live view of the layer's statistics page (StatsPage.h), builds on Linux
+//
+//  usage: dxpipe_stat [--once] [--interval ms]
+//         dxpipe_stat --publish [--frames N]
+//         dxpipe_stat --selftest [--frames N]
+//
+// attaches to "Local\dxpipe_stats" (windows) / "/dxpipe_stats" (posix shm) read-only and
+// redraws it like top: frame times per window (fps, lows, percentiles, hitches) with a p99
+// history graph, the age of the oldest input at Present, present / input to display
+// latency with the queue and missed vblanks, CPU / GPU cost per
+// Present stage, bytes copied, streams, consumers, dropped frames, resizes, the depth
+// being exported and the game's API calls per frame. --once prints a single snapshot (exits non-zero without a page).
+// --publish plays a layer: it creates the page and publishes a synthetic 60 fps frame loop
+// with hitches, so the monitor can be tried without a game. --selftest runs a writer and
+// two readers on one page and checks that no snapshot mixes two frames.
+
+// c++ includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <vector>
+
+// platform shared memory
+#ifdef _WIN32
+#define NOMINMAX // disable min/max macros
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// layer headers (platform independent)
+#include "StatsPage.h"
+
+// the page the layer publishes, created (zeroed) for --publish, read-only otherwise
+static StatsPage *mapStats(bool create)
+{
+#ifdef _WIN32
+    char name[64];
+    snprintf(name, sizeof(name), "Local\\%s", STATS_NAME);
+    HANDLE mapping = create ? CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0,
+                                                 DWORD(sizeof(StatsPage)), name)
+                            : OpenFileMappingA(FILE_MAP_READ, FALSE, name);
+    if (!mapping)
+        return nullptr;
+    void *view = MapViewOfFile(mapping, create ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, 0, sizeof(StatsPage));
+    if (!view)
+    {
+        CloseHandle(mapping);
+        return nullptr;
+    }
+    return static_cast<StatsPage *>(view); // the mapping lives as long as the process
+#else
+    char name[64];
+    snprintf(name, sizeof(name), "/%s", STATS_NAME);
+    int fd = shm_open(name, create ? O_CREAT | O_RDWR : O_RDONLY, 0644);
+    if (fd < 0)
+        return nullptr;
+    if (create && ftruncate(fd, sizeof(StatsPage)) != 0)
+    {
+        close(fd);
+        return nullptr;
+    }
+    void *view = mmap(nullptr, sizeof(StatsPage), create ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    return view == MAP_FAILED ? nullptr : static_cast<StatsPage *>(view);
+#endif
+}
+
+static void unlinkStats()
+{
+#ifndef _WIN32
+    char name[64];
+    snprintf(name, sizeof(name), "/%s", STATS_NAME);
+    shm_unlink(name);
+#endif
+}
+
+static void sleepMs(uint32_t ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+static double megabytes(uint64_t bytes)
+{
+    return double(bytes) / (1024.0 * 1024.0);
+}
+
+// one row per value, scaled to the largest (the top of the graph is labelled)
+static void printGraph(const std::vector<uint32_t> &history)
+{
+    static const char levels[] = " .:-=+*#%@";
+    uint32_t top = 1;
+    for (uint32_t v : history)
+        top = v > top ? v : top;
+    printf("p99 history (top %.2f ms) |", top / 1000.0);
+    for (uint32_t v : history)
+        putchar(levels[size_t(v) * 9 / top]);
+    printf("|\n");
+}
+
+static double fps(uint32_t us)
+{
+    return us ? 1e6 / us : 0.0;
+}
+
+// API calls of the last frame: per group, then the methods called, three to a line
+static void printCensus(const CensusFrame &census)
+{
+    uint64_t groups[CENSUS_GROUPS] = {};
+    for (uint32_t c = 0; c < CENSUS_CALLS; c++)
+        groups[uint32_t(apiCallGroup(c))] += census.calls[c];
+    printf("\napi calls/frame");
+    for (uint32_t g = 0; g < CENSUS_GROUPS; g++)
+        printf("  %s %llu", apiGroupName(g), (unsigned long long)groups[g]);
+    printf("\nupdated %.1f KB/frame  mapped %.1f KB/frame\n",
+           census.bytes[uint32_t(ApiBytes::UpdateSubresource)] / 1024.0, census.bytes[uint32_t(ApiBytes::Map)] / 1024.0);
+    uint32_t column = 0;
+    for (uint32_t c = 0; c < CENSUS_CALLS; c++)
+    {
+        if (!census.calls[c])
+            continue;
+        printf("%-24s %7u%s", apiCallName(c), census.calls[c], ++column % 3 ? "   " : "\n");
+    }
+    if (column % 3)
+        printf("\n");
+}
+
+static void printStats(const StatsSnapshot &s, const std::vector<uint32_t> &history)
+{
+    uint64_t up = s.uptimeNs / 1000000000ull;
+    printf("dxpipe_stat - pid %u, frame %llu, up %02llu:%02llu:%02llu, %llu hitches\n\n", s.pid,
+           (unsigned long long)s.frame, (unsigned long long)(up / 3600), (unsigned long long)(up / 60 % 60),
+           (unsigned long long)(up % 60), (unsigned long long)s.hitches);
+    printf("%-6s %7s %7s %7s %8s %8s %8s %8s %8s %8s\n", "window", "frames", "fps", "1% low", "0.1% low", "p50 ms",
+           "p99 ms", "p99.9 ms", "max ms", "hitches");
+    for (uint32_t w = 0; w < FRAME_WINDOWS; w++)
+    {
+        const FrameTimeSummary &t = s.frameTimes[w];
+        printf("%-6s %7u %7.1f %7.1f %8.1f %8.2f %8.2f %8.2f %8.2f %8u\n", frameWindowName(w), t.frames,
+               fps(t.meanUs), fps(t.low1Us), fps(t.low01Us), t.p50Us / 1000.0, t.p99Us / 1000.0, t.p999Us / 1000.0,
+               t.maxUs / 1000.0, t.hitches);
+    }
+    printf("\n%-6s %7s %8s %8s %8s %8s   input age at present, %llu mouse / %llu keyboard messages\n", "window",
+           "frames", "p50 ms", "p99 ms", "max ms", "last ms", (unsigned long long)s.inputs[uint32_t(InputKind::Mouse)],
+           (unsigned long long)s.inputs[uint32_t(InputKind::Keyboard)]);
+    for (uint32_t w = 0; w < FRAME_WINDOWS; w++)
+    {
+        const FrameTimeSummary &t = s.inputAge[w];
+        printf("%-6s %7u %8.2f %8.2f %8.2f %8.2f\n", frameWindowName(w), t.frames, t.p50Us / 1000.0,
+               t.p99Us / 1000.0, t.maxUs / 1000.0, s.inputAgeUs / 1000.0);
+    }
+    printf("\n%-6s %7s %8s %8s %8s %8s   present to display (input to display p50 / p99 ms)\n", "window", "frames",
+           "p50 ms", "p99 ms", "max ms", "last ms");
+    for (uint32_t w = 0; w < FRAME_WINDOWS; w++)
+    {
+        const FrameTimeSummary &t = s.displayLatency[w];
+        const FrameTimeSummary &i = s.inputToDisplay[w];
+        printf("%-6s %7u %8.2f %8.2f %8.2f %8.2f   %.2f / %.2f\n", frameWindowName(w), t.frames, t.p50Us / 1000.0,
+               t.p99Us / 1000.0, t.maxUs / 1000.0, s.displayLatencyUs / 1000.0, i.p50Us / 1000.0, i.p99Us / 1000.0);
+    }
+    printf("frame %llu on screen, refresh %.2f ms, %u queued, %llu shown, %llu unseen, %llu missed vblanks\n",
+           (unsigned long long)s.displayFrame, s.refreshUs / 1000.0, s.displayQueued,
+           (unsigned long long)s.framesShown, (unsigned long long)s.framesUnseen, (unsigned long long)s.missedVblanks);
+    if (!history.empty())
+        printGraph(history);
+
+    printf("\n%-14s %10s %10s\n", "stage", "cpu us", "gpu us");
+    uint64_t cpu = 0, gpu = 0;
+    for (uint32_t i = 0; i < STATS_STAGES; i++)
+    {
+        if (i != uint32_t(TracePhase::RealPresent)) // the game's, not the layer's
+        {
+            cpu += s.cpuNs[i];
+            gpu += s.gpuNs[i];
+        }
+        if (s.gpuNs[i])
+            printf("%-14s %10.1f %10.1f\n", tracePhaseName(i), s.cpuNs[i] / 1000.0, s.gpuNs[i] / 1000.0);
+        else
+            printf("%-14s %10.1f %10s\n", tracePhaseName(i), s.cpuNs[i] / 1000.0, "-");
+    }
+    printf("%-14s %10.1f %10.1f\n\n", "layer total", cpu / 1000.0, gpu / 1000.0);
+
+    printf("copied %.1f MB/frame (%.1f GB total)  streams %u  consumers %u  dropped %llu  resizes %u\n",
+           megabytes(s.bytesCopied), megabytes(s.bytesCopiedTotal) / 1024.0, s.streams, s.consumers,
+           (unsigned long long)s.droppedFrames, s.resizes);
+    if (s.depthWidth && s.depthHeight)
+        printf("depth %ux%u format %u x%u\n", s.depthWidth, s.depthHeight, s.depthFormat, s.depthSamples);
+    else
+        printf("depth none\n");
+    printCensus(s.census);
+}
+
+static const char *readError(StatsRead r)
+{
+    switch (r)
+    {
+    case StatsRead::Empty:
+        return "the stats page is empty (no layer published yet)";
+    case StatsRead::Version:
+        return "the stats page has a different layout (layer and dxpipe_stat versions differ)";
+    case StatsRead::Busy:
+        return "the stats page kept changing while it was read";
+    default:
+        return "";
+    }
+}
+
+static int monitor(bool once, uint32_t interval)
+{
+    StatsPage *page = mapStats(false);
+    if (!page)
+    {
+        fprintf(stderr, "no stats page '%s' (is a game with the layer running?)\n", STATS_NAME);
+        return 1;
+    }
+
+    std::vector<uint32_t> history;
+    uint64_t lastFrame = ~0ull;
+    for (;;)
+    {
+        StatsSnapshot s;
+        StatsRead r = readStats(*page, s);
+        if (once)
+        {
+            if (r != StatsRead::Ok)
+            {
+                fprintf(stderr, "%s\n", readError(r));
+                return 1;
+            }
+            printStats(s, history);
+            return 0;
+        }
+
+        printf("\x1b[H\x1b[2J"); // home + clear, like top
+        if (r == StatsRead::Ok)
+        {
+            if (s.frame != lastFrame)
+            {
+                history.push_back(s.frameTimes[uint32_t(FrameWindow::Second)].p99Us);
+                if (history.size() > 60)
+                    history.erase(history.begin());
+                lastFrame = s.frame;
+            }
+            printStats(s, history);
+        }
+        else
+            printf("%s\n", readError(r));
+        fflush(stdout);
+        sleepMs(interval);
+    }
+}
+
+// a fake 60 fps game: stage costs, copies, a hitch every 120 frames, a resize now and then
+static void fakeFrame(StatsWriter &stats, uint64_t f)
+{
+    for (uint32_t i = 0; i < STATS_STAGES; i++)
+        stats.addStage(TracePhase(i), 2000 + 500 * i + (f * 37 + i * 11) % 300);
+    uint64_t gpu[STATS_STAGES] = {};
+    for (uint32_t i = 0; i < STATS_STAGES; i++)
+        gpu[i] = (i == uint32_t(TracePhase::Shared) || i == uint32_t(TracePhase::Staging)) ? 150000 + f % 5000 : 0;
+    stats.setGpu(gpu);
+    stats.addBytes(1920ull * 1080 * 8 + 960 * 540 * 4);
+    if (f % 500 == 250)
+        stats.addResize();
+    if (f % 200 == 100)
+        stats.addDropped();
+    stats.setStreams(3, 1);
+    stats.setDepth(1920, 1080, 40, 1);
+
+    // a deferred renderer's frame: ~1500 draws, their binds, a few uploads
+    CensusFrame census = {};
+    auto calls = [&](ApiCall c, uint32_t n) { census.calls[uint32_t(c)] = n + uint32_t(f % 17); };
+    calls(ApiCall::DrawIndexed, 1400);
+    calls(ApiCall::DrawIndexedInstanced, 120);
+    calls(ApiCall::Dispatch, 24);
+    calls(ApiCall::SetShaderResources, 2900);
+    calls(ApiCall::SetConstantBuffers, 1800);
+    calls(ApiCall::SetShader, 700);
+    calls(ApiCall::SetRenderTargets, 30);
+    calls(ApiCall::Map, 260);
+    calls(ApiCall::Unmap, 260);
+    calls(ApiCall::UpdateSubresource, 40);
+    calls(ApiCall::CopyResource, 6);
+    calls(ApiCall::ClearRenderTargetView, 12);
+    calls(ApiCall::ClearDepthStencilView, 4);
+    census.bytes[uint32_t(ApiBytes::Map)] = 260 * 4096;
+    census.bytes[uint32_t(ApiBytes::UpdateSubresource)] = 40 * 1024;
+    stats.setCensus(census);
+}
+
+static int publish(uint32_t frames)
+{
+    StatsPage *page = mapStats(true);
+    if (!page)
+    {
+        fprintf(stderr, "can't create the stats page '%s'\n", STATS_NAME);
+        return 1;
+    }
+    StatsWriter *stats = new StatsWriter();
+    stats->attach(page, 0);
+
+    printf("publishing %u synthetic frames to '%s' (run dxpipe_stat in another terminal)\n", frames, STATS_NAME);
+    auto start = std::chrono::steady_clock::now();
+    auto next = start;
+    for (uint64_t f = 0; f < frames; f++)
+    {
+        next += std::chrono::microseconds(f % 120 == 119 ? 50000 : 16667);
+        std::this_thread::sleep_until(next);
+        fakeFrame(*stats, f);
+        uint64_t ns = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now().time_since_epoch())
+                                   .count());
+        // mouse moves on three frames out of four, arriving 4..20 ms before Present
+        if (f % 4)
+            stats->input().arrived(InputKind::Mouse, ns - 4000000 - (f * 7919 % 16) * 1000000);
+        if (f % 90 == 0)
+            stats->input().arrived(InputKind::Keyboard, ns - 9000000);
+        stats->input().presented(ns);
+        // a 60 Hz display, the last frame went on screen 4 ms ago, the hitches miss two vblanks
+        if (f)
+        {
+            uint32_t refresh = uint32_t(f + f / 120 * 2);
+            stats->display().sample({uint32_t(f), refresh, refresh, ns - 4000000}, ns);
+        }
+        stats->display().presented(f, ns, uint32_t(f + 1), 1, stats->input().lastUs());
+        stats->publish(f, ns);
+    }
+    delete stats;
+    unlinkStats();
+    return 0;
+}
+
+// a writer publishing flat out against two readers, every field is a function of the
+// frame so a torn snapshot shows, returns the number of failed checks
+static int selftest(uint32_t frames)
+{
+    StatsPage *page = new StatsPage();
+    memset(static_cast<void *>(page), 0, sizeof(StatsPage));
+    StatsWriter *stats = new StatsWriter();
+    stats->attach(page, 1234);
+
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> reads{0}, busy{0}, torn{0};
+    auto reader = [&]
+    {
+        while (!done.load())
+        {
+            StatsSnapshot s;
+            StatsRead r = readStats(*page, s);
+            if (r == StatsRead::Busy)
+            {
+                busy++;
+                continue;
+            }
+            if (r == StatsRead::Empty) // before the first publish
+                continue;
+            if (r != StatsRead::Ok)
+            {
+                torn++;
+                continue;
+            }
+            reads++;
+            uint64_t f = s.frame;
+            bool ok = s.pid == 1234 && s.depthWidth == uint32_t(f) && s.depthHeight == uint32_t(f) + 1 &&
+                      s.census.calls[uint32_t(ApiCall::DrawIndexed)] == uint32_t(f) &&
+                      s.census.bytes[uint32_t(ApiBytes::Map)] == f * 3 &&
+                      s.bytesCopied == 1000 * (f % 7 + 1) && s.droppedFrames == f / 10 + 1 &&
+                      s.resizes == f / 100 + 1 && s.streams == uint32_t(f % 5) && s.consumers == uint32_t(f % 2) &&
+                      s.inputAgeUs == (f % 4 ? 1000 * uint32_t(f % 3 + 1) : 0) &&
+                      s.inputs[uint32_t(InputKind::Mouse)] == f + 1 - (f / 4 + 1) &&
+                      s.displayFrame == (f ? f - 1 : 0) && s.framesShown == f && !s.framesUnseen &&
+                      s.displayLatencyUs == (f ? uint32_t(1000 * (f % 10 + 1) - 500) : 0) && !s.displayQueued &&
+                      !s.missedVblanks;
+            for (const FrameTimeSummary &t : s.frameTimes)
+                ok = ok && t.p50Us <= t.p99Us && t.p99Us <= t.p999Us && t.p999Us <= t.maxUs && t.p99Us <= t.low1Us &&
+                     t.low1Us <= t.low01Us && t.low01Us <= t.maxUs;
+            if (!ok && !torn++)
+                printf("torn snapshot at frame %llu\n", (unsigned long long)f);
+        }
+    };
+    std::thread r1(reader), r2(reader);
+
+    // frame times cycle 1..10 ms, so the windows' percentiles are known once they are full
+    uint64_t ns = 1;
+    for (uint64_t f = 0; f < frames; f++)
+    {
+        ns += 1000000 * (f % 10 + 1);
+        stats->addBytes(1000 * (f % 7 + 1));
+        if (f % 10 == 0)
+            stats->addDropped();
+        if (f % 100 == 0)
+            stats->addResize();
+        stats->setStreams(uint32_t(f % 5), uint32_t(f % 2));
+        stats->setDepth(uint32_t(f), uint32_t(f) + 1, 40, 1);
+        CensusFrame census = {};
+        census.calls[uint32_t(ApiCall::DrawIndexed)] = uint32_t(f);
+        census.bytes[uint32_t(ApiBytes::Map)] = f * 3;
+        stats->setCensus(census);
+        if (f % 4) // input aged 1..3 ms on three frames out of four
+            stats->input().arrived(InputKind::Mouse, ns - 1000000 * (f % 3 + 1));
+        stats->input().presented(ns);
+        // frame f - 1 reaches the screen 0.5 ms before this Present, one vblank per frame
+        if (f)
+            stats->display().sample({uint32_t(f), uint32_t(f), uint32_t(f), ns - 500000}, ns);
+        stats->display().presented(f, ns, uint32_t(f + 1), 1, stats->input().lastUs());
+        stats->publish(f, ns);
+    }
+    done = true;
+    r1.join();
+    r2.join();
+
+    int failed = torn ? 1 : 0;
+    StatsSnapshot s;
+    const FrameTimeSummary &t = s.frameTimes[uint32_t(FrameWindow::Minute)];
+    if (readStats(*page, s) != StatsRead::Ok || s.frame != frames - 1 || t.frames < 10000 || t.p50Us < 5000 ||
+        t.p50Us > 6000 || t.maxUs != 10000 || s.hitches)
+    {
+        printf("final page: frame %llu, %u frames, p50 %u us, max %u us, %llu hitches (want %u, 10000+, 5000-6000, "
+               "10000, 0)\n",
+               (unsigned long long)s.frame, t.frames, t.p50Us, t.maxUs, (unsigned long long)s.hitches, frames - 1);
+        failed++;
+    }
+    const FrameTimeSummary &ia = s.inputAge[uint32_t(FrameWindow::Minute)];
+    if (ia.frames < 7500 || ia.p50Us < 1000 || ia.p50Us > 3000 || ia.maxUs != 3000)
+    {
+        printf("final input ages: %u frames, p50 %u us, max %u us (want 7500+, 1000-3000, 3000)\n", ia.frames, ia.p50Us,
+               ia.maxUs);
+        failed++;
+    }
+    printf("%u frames, %llu snapshots read, %llu retried, %llu torn: %s\n", frames, (unsigned long long)reads.load(),
+           (unsigned long long)busy.load(), (unsigned long long)torn.load(), failed ? "FAILED" : "consistent");
+    delete stats;
+    delete page;
+    return failed;
+}
+
+int main(int argc, char **argv)
+{
+    bool once = false, publishing = false, selfTest = false, usage = false;
+    uint32_t interval = 500, frames = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--once"))
+            once = true;
+        else if (!strcmp(argv[i], "--publish"))
+            publishing = true;
+        else if (!strcmp(argv[i], "--selftest"))
+            selfTest = true;
+        else if (!strcmp(argv[i], "--interval") && i + 1 < argc)
+            interval = uint32_t(strtoul(argv[++i], nullptr, 10));
+        else if (!strcmp(argv[i], "--frames") && i + 1 < argc)
+            frames = uint32_t(strtoul(argv[++i], nullptr, 10));
+        else
+            usage = true;
+    }
+
+    if (usage || (publishing && selfTest) || !interval)
+    {
+        fprintf(stderr, "usage: %s [--once] [--interval ms]\n"
+                        "       %s --publish [--frames N]\n"
+                        "       %s --selftest [--frames N (%u+)]\n",
+                argv[0], argv[0], argv[0], 20000u);
+        return 1;
+    }
+    if (publishing)
+        return publish(frames ? frames : 3600);
+    if (selfTest)
+        return selftest(frames >= 20000 ? frames : 200000) ? 1 : 0;
+    return monitor(once, interval);
+}
@@ -0,0 +1,615 @@
+// dxpipe_trace – decodes the layer's binary trace (TraceLog.h), builds on Linux
+//
+//  usage: dxpipe_trace <trace.dxtrace> [--summary] [--chrome out.json]
+//         dxpipe_trace --stress [--threads N] [--records N] [--out path]
+//         dxpipe_trace --synthetic [--frames N] [--flight] [--out path] [--chrome out.json]
+//         dxpipe_trace --hitch [--frames N] [--out path]
+//
+// decoding prints one line per record (time since the trace was opened, thread, event,
+// arguments), --summary prints per event counts and the Present → PresentEnd durations,
+// --chrome writes the timeline chrome://tracing / ui.perfetto.dev open (TraceExport.h).
+// --stress logs from N threads at once through a real TraceLog (rings + writer thread),
+// reports the cost of a log call, then decodes the file and checks that every thread's
+// records arrived in order and that written + dropped accounts for every call.
+// --synthetic runs a fake Present loop (phases, counters, pipe writes, a loading thread)
+// with recording paused for a stretch, then checks the exported slices are balanced, in
+// time order and cover exactly the recorded frames; --flight keeps the flight recorder on
+// meanwhile (the file then takes its records by the pause's ticks).
+// --hitch runs a fake Present loop with the flight recorder on and the file paused, slows
+// two frames down and checks that HitchDetector asked for one snapshot (the second hitch
+// is in the cooldown), that it holds the last second up to the marked frame without the
+// draws, and that nothing reached the paused file.
+// exits non-zero on a bad file or a failed check.
+
+// c++ includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <string>
+
+// layer headers (platform independent)
+#include "TraceLog.h"
+#include "TraceExport.h"
+#include "HitchDetector.h"
+
+static void printRecord(const TraceReader &reader, const TraceRecord &r)
+{
+    printf("%14.3f us  t%-2u %-16s", reader.ns(r.ticks) / 1000.0, r.thread, traceEventName(r.event));
+    switch (TraceEvent(r.event))
+    {
+    case TraceEvent::Clock:
+        printf("steady=%.3f us dropped=%llu", double(r.arg0) / 1000.0, (unsigned long long)r.arg1);
+        break;
+    case TraceEvent::Present:
+    case TraceEvent::Present1:
+        printf("sync=%u flags=0x%x", r.a32 & 0xFFFF, r.a32 >> 16);
+        if (TraceEvent(r.event) == TraceEvent::Present)
+            printf(" context=%llu frame=%llu", (unsigned long long)r.arg0, (unsigned long long)r.arg1);
+        break;
+    case TraceEvent::PresentEnd:
+        printf("hr=0x%08x context=%llu frame=%llu", r.a32, (unsigned long long)r.arg0, (unsigned long long)r.arg1);
+        break;
+    case TraceEvent::ResizeBuffers:
+        printf("%ux%u format=%u context=%llu", uint32_t(r.arg0), uint32_t(r.arg0 >> 32), r.a32,
+               (unsigned long long)r.arg1);
+        break;
+    case TraceEvent::GetBuffer:
+        printf("buffer=0x%llx context=%llu", (unsigned long long)r.arg0, (unsigned long long)r.arg1);
+        break;
+    case TraceEvent::CreateTexture2D:
+        printf("%ux%u format=%u bind=0x%x samples=%u", uint32_t(r.arg0), uint32_t(r.arg0 >> 32), r.a32,
+               uint32_t(r.arg1), uint32_t(r.arg1 >> 32));
+        break;
+    case TraceEvent::DrawIndexed:
+        printf("indices=%u start=%llu base=%lld", r.a32, (unsigned long long)r.arg0, (long long)int64_t(r.arg1));
+        break;
+    case TraceEvent::Begin:
+    case TraceEvent::End:
+        printf("%s context=%llu", tracePhaseName(r.a32), (unsigned long long)r.arg0);
+        break;
+    case TraceEvent::Counter:
+        printf("%s=%llu context=%llu", traceCounterName(r.a32), (unsigned long long)r.arg0, (unsigned long long)r.arg1);
+        break;
+    case TraceEvent::PipeWrite:
+        printf("%s %llu bytes", tracePipeName(r.a32), (unsigned long long)r.arg0);
+        break;
+    case TraceEvent::Pause:
+    case TraceEvent::Resume:
+        break;
+    case TraceEvent::Census:
+        printf("%s=%llu frame=%llu", apiCallName(r.a32), (unsigned long long)r.arg0, (unsigned long long)r.arg1);
+        break;
+    case TraceEvent::Hitch:
+        printf("frame=%llu %.3f ms limit=%.3f ms", (unsigned long long)r.arg0, r.a32 / 1000.0, r.arg1 / 1000.0);
+        break;
+    default:
+        printf("a32=%u arg0=%llu arg1=%llu", r.a32, (unsigned long long)r.arg0, (unsigned long long)r.arg1);
+        break;
+    }
+    printf("\n");
+}
+
+static void printSummary(const TraceReader &reader)
+{
+    const std::vector<TraceRecord> &records = reader.records();
+    uint64_t counts[size_t(TraceEvent::Count)] = {};
+    uint64_t unknown = 0;
+    for (const TraceRecord &r : records)
+    {
+        if (r.event < uint16_t(TraceEvent::Count))
+            counts[r.event]++;
+        else
+            unknown++;
+    }
+
+    // Present → PresentEnd of the same thread is the layer's work plus the real Present
+    std::vector<double> durations;
+    double open[TraceLog::MAX_THREADS] = {}; // per ring, 0 = no Present open
+    for (const TraceRecord &r : records)
+    {
+        // a recording pause cuts the frame it happened in
+        if (r.event == uint16_t(TraceEvent::Pause))
+            std::fill(open, open + TraceLog::MAX_THREADS, 0.0);
+        if (r.thread >= TraceLog::MAX_THREADS)
+            continue;
+        if (r.event == uint16_t(TraceEvent::Present))
+            open[r.thread] = reader.ns(r.ticks);
+        else if (r.event == uint16_t(TraceEvent::PresentEnd) && open[r.thread] > 0.0)
+        {
+            durations.push_back(reader.ns(r.ticks) - open[r.thread]);
+            open[r.thread] = 0.0;
+        }
+    }
+
+    double span = records.empty() ? 0.0 : reader.ns(records.back().ticks) - reader.ns(records.front().ticks);
+    printf("%llu records over %.3f ms, %.3f ns per tick, %llu dropped\n", (unsigned long long)records.size(),
+           span / 1e6, reader.nsPerTick(), (unsigned long long)reader.dropped());
+    for (uint16_t e = 0; e < uint16_t(TraceEvent::Count); e++)
+    {
+        if (counts[e])
+            printf("  %-16s %10llu\n", traceEventName(e), (unsigned long long)counts[e]);
+    }
+    if (unknown)
+        printf("  %-16s %10llu\n", "?", (unsigned long long)unknown);
+
+    if (!durations.empty())
+    {
+        std::sort(durations.begin(), durations.end());
+        double sum = 0.0;
+        for (double d : durations)
+            sum += d;
+        printf("Present: %zu frames, mean %.3f us, p50 %.3f us, p99 %.3f us, max %.3f us\n", durations.size(),
+               sum / durations.size() / 1000.0, durations[durations.size() / 2] / 1000.0,
+               durations[size_t(durations.size() * 0.99)] / 1000.0, durations.back() / 1000.0);
+    }
+}
+
+// N threads logging flat out, returns the number of failed checks
+static int stress(uint32_t threads, uint32_t records, const char *path)
+{
+    TraceLog *log = new TraceLog();
+    if (!log->open(path))
+    {
+        fprintf(stderr, "can't write '%s'\n", path);
+        return 1;
+    }
+
+    std::vector<double> cost(threads);
+    std::vector<std::thread> workers;
+    for (uint32_t t = 0; t < threads; t++)
+    {
+        workers.emplace_back([log, t, records, &cost]
+                             {
+            // the first call claims the thread's ring, the rest is the steady state
+            log->log(TraceEvent::DrawIndexed, t, 0, ~uint64_t(0));
+            auto start = std::chrono::steady_clock::now();
+            for (uint32_t i = 1; i < records; i++)
+                log->log(TraceEvent::DrawIndexed, t, i, ~uint64_t(i));
+            double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            cost[t] = records > 1 ? ns / (records - 1) : 0.0; });
+    }
+    for (std::thread &w : workers)
+        w.join();
+    log->close();
+    uint64_t written = log->written(), dropped = log->dropped();
+    delete log;
+
+    double mean = 0.0;
+    for (double c : cost)
+        mean += c / threads;
+    printf("%u threads x %u records: %.1f ns per log call, %llu written, %llu dropped (full rings)\n", threads,
+           records, mean, (unsigned long long)written, (unsigned long long)dropped);
+
+    TraceReader reader;
+    if (!reader.open(path))
+    {
+        printf("can't read the trace back\n");
+        return 1;
+    }
+
+    int failed = 0;
+    std::vector<int64_t> next(threads, -1);
+    uint64_t seen = 0;
+    for (const TraceRecord &r : reader.records())
+    {
+        if (r.event == uint16_t(TraceEvent::Clock))
+            continue;
+        seen++;
+        if (r.event != uint16_t(TraceEvent::DrawIndexed) || r.a32 >= threads || r.arg1 != ~r.arg0)
+        {
+            if (!failed++)
+                printf("corrupt record: event %u a32 %u\n", r.event, r.a32);
+            continue;
+        }
+        // drops leave gaps, never repeats or reordering
+        if (int64_t(r.arg0) <= next[r.a32])
+        {
+            if (!failed++)
+                printf("thread %u: record %llu after %lld\n", r.a32, (unsigned long long)r.arg0, (long long)next[r.a32]);
+        }
+        next[r.a32] = int64_t(r.arg0);
+    }
+    if (seen != written || written + dropped != uint64_t(threads) * records)
+    {
+        printf("accounting: %llu in the file, %llu written, %llu dropped, %llu logged\n", (unsigned long long)seen,
+               (unsigned long long)written, (unsigned long long)dropped, (unsigned long long)threads * records);
+        failed++;
+    }
+    printf("%s\n", failed ? "FAILED" : "every record accounted for");
+    return failed;
+}
+
+static bool writeChrome(const TraceReader &reader, const char *json)
+{
+    std::vector<ChromeEvent> events = buildChromeTrace(reader);
+    FILE *file = fopen(json, "w");
+    bool ok = file && writeChromeTrace(events, file);
+    if (file)
+        fclose(file);
+    if (ok)
+        printf("%zu timeline events written to %s\n", events.size(), json);
+    else
+        fprintf(stderr, "can't write '%s'\n", json);
+    return ok;
+}
+
+static void spin(double us)
+{
+    auto start = std::chrono::steady_clock::now();
+    while (std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() < us)
+        ;
+}
+
+// a fake Present loop, recording paused halfway through one frame and resumed halfway
+// through a later one, returns the number of failed checks
+static int synthetic(uint32_t frames, const char *path, const char *json, bool flight)
+{
+    TraceLog *log = new TraceLog();
+    if (flight)
+        log->setFlight(1);
+    if (!log->open(path))
+    {
+        fprintf(stderr, "can't write '%s'\n", path);
+        return 1;
+    }
+
+    // resource creation on a loading thread, between the render thread's frames
+    std::atomic<bool> done{false};
+    std::thread loader([log, &done]
+                       {
+        while (!done.load())
+        {
+            log->log(TraceEvent::CreateTexture2D, 28, 1920 | (uint64_t(1080) << 32), 0x20 | (uint64_t(1) << 32));
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        } });
+
+    const uint32_t pauseAt = frames / 3, resumeAt = frames / 2;
+    auto phase = [log](TracePhase p, double us)
+    {
+        log->log(TraceEvent::Begin, uint32_t(p), 0);
+        spin(us);
+        log->log(TraceEvent::End, uint32_t(p), 0);
+    };
+    for (uint32_t f = 0; f < frames; f++)
+    {
+        log->log(TraceEvent::Present, 1, 0, f);
+        phase(TracePhase::Detect, 20.0);
+        phase(TracePhase::Staging, 40.0);
+
+        log->log(TraceEvent::Begin, uint32_t(TracePhase::Shared), 0);
+        if (f == pauseAt)
+            log->setRecording(false);
+        if (f == resumeAt)
+            log->setRecording(true);
+        spin(40.0);
+        log->log(TraceEvent::End, uint32_t(TracePhase::Shared), 0);
+
+        phase(TracePhase::Motion, 20.0);
+        log->log(TraceEvent::Begin, uint32_t(TracePhase::Transport), 0);
+        log->log(TraceEvent::PipeWrite, uint32_t(TracePipe::Camera), 272);
+        log->log(TraceEvent::End, uint32_t(TracePhase::Transport), 0);
+        if (f == frames * 3 / 4)
+            log->log(TraceEvent::ResizeBuffers, 28, 1280 | (uint64_t(720) << 32), 0);
+
+        log->log(TraceEvent::Counter, uint32_t(TraceCounter::BytesCopied), 1920 * 1080 * 8, 0);
+        log->log(TraceEvent::Counter, uint32_t(TraceCounter::Draws), 1000 + f % 100, 0);
+        log->log(TraceEvent::Counter, uint32_t(TraceCounter::BytesUploaded), 65536, 0);
+        phase(TracePhase::RealPresent, 200.0);
+        log->log(TraceEvent::PresentEnd, 0, 0, f);
+    }
+    done = true;
+    loader.join();
+    log->close();
+    log->setFlight(0);
+    uint64_t dropped = log->dropped();
+    delete log;
+
+    TraceReader reader;
+    if (!reader.open(path))
+    {
+        printf("can't read the trace back\n");
+        return 1;
+    }
+    std::vector<ChromeEvent> events = buildChromeTrace(reader);
+
+    // every E closes the innermost open B of its thread, time never goes backwards
+    int failed = 0;
+    std::vector<std::vector<std::string>> open;
+    uint64_t presents = 0, draws = 0, frameTimes = 0;
+    double last = 0.0;
+    for (const ChromeEvent &e : events)
+    {
+        if (e.phase == 'M')
+            continue;
+        if (e.ts < last)
+        {
+            if (!failed++)
+                printf("'%s' at %.3f us after %.3f us\n", e.name.c_str(), e.ts, last);
+        }
+        last = e.ts;
+        if (e.tid >= open.size())
+            open.resize(e.tid + 1);
+        if (e.phase == 'B')
+            open[e.tid].push_back(e.name);
+        else if (e.phase == 'E')
+        {
+            if (open[e.tid].empty() || open[e.tid].back() != e.name)
+            {
+                if (!failed++)
+                    printf("thread %u: '%s' ends without its begin\n", e.tid, e.name.c_str());
+            }
+            else
+                open[e.tid].pop_back();
+        }
+        presents += e.phase == 'B' && e.name == "Present";
+        draws += e.phase == 'C' && e.name == "draws 0";
+        frameTimes += e.phase == 'C' && e.name == "frame time 0";
+    }
+    for (uint32_t t = 0; t < open.size(); t++)
+    {
+        if (!open[t].empty() && !failed++)
+            printf("thread %u: '%s' never ends\n", t, open[t].back().c_str());
+    }
+
+    // frames up to the paused one begin, the resumed one is cut until its next Present
+    uint64_t wantPresents = pauseAt + 1 + (frames - resumeAt - 1);
+    uint64_t wantDraws = pauseAt + (frames - resumeAt);
+    uint64_t wantFrameTimes = wantPresents - 2;
+    if (dropped || presents != wantPresents || draws != wantDraws || frameTimes != wantFrameTimes)
+    {
+        printf("frames: %llu / %llu presents, %llu / %llu draw counters, %llu / %llu frame times, %llu dropped\n",
+               (unsigned long long)presents, (unsigned long long)wantPresents, (unsigned long long)draws,
+               (unsigned long long)wantDraws, (unsigned long long)frameTimes, (unsigned long long)wantFrameTimes,
+               (unsigned long long)dropped);
+        failed++;
+    }
+    if (json && !writeChrome(reader, json))
+        failed++;
+    printf("%u frames, recording paused for %u%s: %s\n", frames, resumeAt - pauseAt,
+           flight ? " (flight recorder on)" : "", failed ? "FAILED" : "timeline balanced");
+    return failed;
+}
+
+static uint64_t steadyNs()
+{
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch())
+                        .count());
+}
+
+// the limit of HitchDetector's settings against a 10 s summary, returns 1 on a mismatch
+static int checkLimit(uint32_t thresholdUs, float factor, uint32_t frames, uint32_t p50Us, uint32_t want)
+{
+    HitchDetector detector;
+    detector.setThresholdUs(thresholdUs);
+    detector.setFactor(factor);
+    FrameTimeSummary s = {};
+    s.frames = frames;
+    s.p50Us = p50Us;
+    uint32_t limit = detector.limitUs(s);
+    if (limit == want)
+        return 0;
+    printf("limit over %u us or %.1fx a %u us median of %u frames: %u us, want %u\n", thresholdUs, factor, p50Us,
+           frames, limit, want);
+    return 1;
+}
+
+// a fake Present loop (2 ms frames, two of them 60 ms) with the flight recorder on and the
+// file paused throughout, returns the number of failed checks
+static int hitch(uint32_t frames, const char *path)
+{
+    int failed = checkLimit(0, 3.0f, 60, 10000, 30000) + checkLimit(20000, 3.0f, 60, 10000, 20000) +
+                 checkLimit(20000, 3.0f, 10, 10000, 20000) + checkLimit(0, 3.0f, 10, 10000, 0) +
+                 checkLimit(0, 3.0f, 60, 1000, FrameHistogram::HITCH_MIN_US) + checkLimit(0, 0.0f, 60, 1000, 0);
+
+    std::string snapshotPath = std::string(path) + ".hitch";
+    remove(snapshotPath.c_str());
+    TraceLog *log = new TraceLog();
+    log->setRecording(false);
+    log->setFlight(1);
+    if (!log->open(path))
+    {
+        fprintf(stderr, "can't write '%s'\n", path);
+        return 1;
+    }
+
+    // a fixed limit, scheduling noise stays far below it
+    FrameHistogram *times = new FrameHistogram();
+    HitchDetector detector;
+    detector.setThresholdUs(40000);
+    detector.setFactor(0.0f);
+    const uint32_t slowAt = frames * 2 / 3, resizeAt = slowAt - 100;
+    uint64_t marked = 0;
+    for (uint32_t f = 1; f <= frames; f++)
+    {
+        uint64_t now = steadyNs();
+        times->record(now);
+        uint32_t limit = f > 1 ? detector.check(times->lastUs(), times->last(FrameWindow::TenSeconds), now) : 0;
+        if (limit && log->snapshot(snapshotPath.c_str(), f, times->lastUs(), limit))
+        {
+            detector.taken(f, now);
+            marked = f;
+        }
+
+        log->log(TraceEvent::Present, 1, 0, f);
+        log->log(TraceEvent::Begin, uint32_t(TracePhase::Detect), 0);
+        for (uint32_t d = 0; d < 10; d++)
+            log->log(TraceEvent::DrawIndexed, 36, d * 36, 0);
+        log->log(TraceEvent::End, uint32_t(TracePhase::Detect), 0);
+        log->log(TraceEvent::PipeWrite, uint32_t(TracePipe::Camera), 272);
+        if (f == resizeAt)
+            log->log(TraceEvent::ResizeBuffers, 28, 1280 | (uint64_t(720) << 32), 0);
+        log->log(TraceEvent::Census, uint32_t(ApiCall::DrawIndexed), 10, f);
+        log->log(TraceEvent::PresentEnd, 0, 0, f);
+        std::this_thread::sleep_for(std::chrono::milliseconds(f == slowAt || f == slowAt + 10 ? 60 : 2));
+    }
+    while (log->snapshotPending())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    log->close();
+    log->setFlight(0);
+    uint64_t written = log->snapshots();
+    delete log;
+    delete times;
+
+    if (marked != slowAt + 1 || detector.hitches() != 2 || detector.snapshots() != 1 || written != 1)
+    {
+        printf("snapshots: marked frame %llu (want %u), %llu hitches (want 2), %llu asked for, %llu written (want 1)\n",
+               (unsigned long long)marked, slowAt + 1, (unsigned long long)detector.hitches(),
+               (unsigned long long)detector.snapshots(), (unsigned long long)written);
+        failed++;
+    }
+
+    // the paused file got its clock and nothing else
+    TraceReader paused;
+    uint64_t leaked = 0;
+    if (paused.open(path))
+        for (const TraceRecord &r : paused.records())
+            leaked += r.event != uint16_t(TraceEvent::Clock);
+    else
+        leaked = ~uint64_t(0);
+    if (leaked)
+    {
+        printf("the paused file holds %llu records\n", (unsigned long long)leaked);
+        failed++;
+    }
+
+    TraceReader reader;
+    if (!reader.open(snapshotPath.c_str()))
+    {
+        printf("can't read the snapshot back\n");
+        return failed + 1;
+    }
+
+    // one marker, consecutive frames from about a second before it, no draws
+    uint64_t markers = 0, draws = 0, resizes = 0, census = 0, firstFrame = 0, lastFrame = 0, gaps = 0;
+    double markerNs = 0.0, firstNs = -1.0;
+    for (const TraceRecord &r : reader.records())
+    {
+        if (r.event == uint16_t(TraceEvent::Clock))
+            continue;
+        if (firstNs < 0.0)
+            firstNs = reader.ns(r.ticks);
+        draws += r.event == uint16_t(TraceEvent::DrawIndexed);
+        resizes += r.event == uint16_t(TraceEvent::ResizeBuffers);
+        census += r.event == uint16_t(TraceEvent::Census);
+        if (r.event == uint16_t(TraceEvent::Hitch))
+        {
+            markers++;
+            markerNs = reader.ns(r.ticks);
+            if (r.arg0 != marked || r.arg1 != 40000 || r.a32 < 60000)
+            {
+                printf("marker: frame %llu, %u us over %llu us\n", (unsigned long long)r.arg0, r.a32,
+                       (unsigned long long)r.arg1);
+                failed++;
+            }
+        }
+        if (r.event == uint16_t(TraceEvent::Present))
+        {
+            gaps += lastFrame && r.arg1 != lastFrame + 1;
+            firstFrame = firstFrame ? firstFrame : r.arg1;
+            lastFrame = r.arg1;
+        }
+    }
+    double spanMs = (markerNs - firstNs) / 1e6;
+    if (markers != 1 || draws || resizes != 1 || gaps || lastFrame < marked - 1 || spanMs < 800.0 || spanMs > 1100.0 ||
+        census != lastFrame - firstFrame + 1)
+    {
+        printf("snapshot: %llu markers, %llu draws, %llu resizes, %llu census, frames %llu..%llu with %llu gaps, "
+               "%.1f ms before the marker\n",
+               (unsigned long long)markers, (unsigned long long)draws, (unsigned long long)resizes,
+               (unsigned long long)census, (unsigned long long)firstFrame, (unsigned long long)lastFrame,
+               (unsigned long long)gaps, spanMs);
+        failed++;
+    }
+
+    uint64_t instants = 0, counters = 0;
+    for (const ChromeEvent &e : buildChromeTrace(reader))
+    {
+        instants += e.phase == 'i' && e.name == "hitch";
+        counters += e.phase == 'C' && e.name == "calls DrawIndexed";
+    }
+    if (instants != 1 || counters != census)
+    {
+        printf("timeline: %llu hitch instants, %llu census counters (want 1, %llu)\n", (unsigned long long)instants,
+               (unsigned long long)counters, (unsigned long long)census);
+        failed++;
+    }
+    printf("%u frames, snapshot of frames %llu..%llu, %.1f ms before the hitch: %s\n", frames,
+           (unsigned long long)firstFrame, (unsigned long long)lastFrame, spanMs, failed ? "FAILED" : "exact");
+    return failed;
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = nullptr;
+    const char *out = nullptr;
+    const char *json = nullptr;
+    bool summary = false, stressTest = false, syntheticTest = false, hitchTest = false, flight = false, usage = false;
+    uint32_t threads = 4, records = 1000000, frames = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--summary"))
+            summary = true;
+        else if (!strcmp(argv[i], "--stress"))
+            stressTest = true;
+        else if (!strcmp(argv[i], "--synthetic"))
+            syntheticTest = true;
+        else if (!strcmp(argv[i], "--hitch"))
+            hitchTest = true;
+        else if (!strcmp(argv[i], "--flight"))
+            flight = true;
+        else if (!strcmp(argv[i], "--frames") && i + 1 < argc)
+            frames = uint32_t(strtoul(argv[++i], nullptr, 10));
+        else if (!strcmp(argv[i], "--chrome") && i + 1 < argc)
+            json = argv[++i];
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+            threads = uint32_t(strtoul(argv[++i], nullptr, 10));
+        else if (!strcmp(argv[i], "--records") && i + 1 < argc)
+            records = uint32_t(strtoul(argv[++i], nullptr, 10));
+        else if (!strcmp(argv[i], "--out") && i + 1 < argc)
+            out = argv[++i];
+        else if (argv[i][0] != '-' && !path)
+            path = argv[i];
+        else
+            usage = true;
+    }
+
+    int modes = int(stressTest) + int(syntheticTest) + int(hitchTest);
+    if (!usage && modes == 1 && stressTest && threads && threads <= TraceLog::MAX_THREADS && records)
+        return stress(threads, records, out ? out : "dxpipe_stress.dxtrace") ? 1 : 0;
+    if (!usage && modes == 1 && syntheticTest && (!frames || frames >= 8))
+        return synthetic(frames ? frames : 600, out ? out : "dxpipe_synthetic.dxtrace", json, flight) ? 1 : 0;
+    if (!usage && modes == 1 && hitchTest && (!frames || frames >= 700))
+        return hitch(frames ? frames : 900, out ? out : "dxpipe_hitch.dxtrace") ? 1 : 0;
+    if (usage || !path || modes || flight)
+    {
+        fprintf(stderr, "usage: %s <trace.dxtrace> [--summary] [--chrome out.json]\n"
+                        "       %s --stress [--threads N (1-%u)] [--records N] [--out path]\n"
+                        "       %s --synthetic [--frames N (8+)] [--flight] [--out path] [--chrome out.json]\n"
+                        "       %s --hitch [--frames N (700+)] [--out path]\n",
+                argv[0], argv[0], TraceLog::MAX_THREADS, argv[0], argv[0]);
+        return 1;
+    }
+
+    TraceReader reader;
+    if (!reader.open(path))
+    {
+        fprintf(stderr, "'%s' is not a dxpipe trace\n", path);
+        return 1;
+    }
+    if (json)
+        return writeChrome(reader, json) ? 0 : 1;
+    if (summary)
+        printSummary(reader);
+    else
+    {
+        for (const TraceRecord &r : reader.records())
+            printRecord(reader, r);
+    }
+    return 0;
+}